@@ -0,0 +1,417 @@
+// Allows file systems implemented in Dart to be used from other isolates.
+//
+// This file is not compiled on its own. When SQLite is compiled from source,
+// the build hook includes it in the same translation unit as the SQLite
+// amalgamation.
+//
+// Methods of a Dart file system can only be called on the isolate that has
+// registered it. The proxy VFS created here wraps such a file system: calls
+// made while the owning isolate is active on the current thread are forwarded
+// directly. Other threads (e.g. isolates using a connection through
+// `package:sqlite3_connection_pool`) post the call to a port of the owning
+// isolate and block until it has been handled there, by
+// dart_sqlite3_vfs_proxy_run.
+//
+// To tell whether the owning isolate is active, the proxy needs
+// Dart_CurrentIsolate, which is looked up in the table returned by
+// NativeApi.initializeApiDLData. That also gives us Dart_PostInteger to post
+// calls without depending on the Dart SDK headers.
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+typedef struct DartProxyApiEntry {
+  const char* name;
+  void (*function)(void);
+} DartProxyApiEntry;
+
+// The layout of the struct returned by Dart_InitializeApiDL.
+typedef struct DartProxyApi {
+  const int major;
+  const int minor;
+  const DartProxyApiEntry* const functions;
+} DartProxyApi;
+
+typedef void* DartProxyIsolate;
+typedef int64_t DartProxyPort;
+
+typedef struct DartVfsProxy DartVfsProxy;
+typedef struct DartVfsProxyFile DartVfsProxyFile;
+typedef struct DartVfsProxyCall DartVfsProxyCall;
+
+struct DartVfsProxy {
+  sqlite3_vfs base;
+  sqlite3_vfs* real;
+  DartProxyIsolate owner;
+  DartProxyPort port;
+  DartProxyIsolate (*currentIsolate)(void);
+  int8_t (*postInteger)(DartProxyPort, int64_t);
+};
+
+// Files of the proxy VFS are followed by the file of the real VFS.
+struct DartVfsProxyFile {
+  sqlite3_file base;
+  DartVfsProxy* vfs;
+  sqlite3_file* real;
+};
+
+enum {
+  PROXY_OPEN,
+  PROXY_DELETE,
+  PROXY_ACCESS,
+  PROXY_FULL_PATHNAME,
+  PROXY_RANDOMNESS,
+  PROXY_SLEEP,
+  PROXY_CURRENT_TIME,
+  PROXY_CLOSE,
+  PROXY_READ,
+  PROXY_WRITE,
+  PROXY_TRUNCATE,
+  PROXY_SYNC,
+  PROXY_FILE_SIZE,
+  PROXY_LOCK,
+  PROXY_UNLOCK,
+  PROXY_CHECK_RESERVED_LOCK,
+  PROXY_FILE_CONTROL,
+  PROXY_SECTOR_SIZE,
+  PROXY_DEVICE_CHARACTERISTICS,
+};
+
+// A call to a method of the real VFS or one of its files, along with its
+// arguments.
+struct DartVfsProxyCall {
+  DartVfsProxy* vfs;
+  int op;
+  sqlite3_file* file;
+  const char* zName;
+  void* pArg;
+  int iArg;
+  sqlite3_int64 iArg64;
+  int rc;
+
+  int done;
+#ifdef _WIN32
+  SRWLOCK lock;
+  CONDITION_VARIABLE cond;
+#else
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+#endif
+};
+
+static int proxyExecute(DartVfsProxyCall* c) {
+  sqlite3_vfs* v = c->vfs->real;
+  sqlite3_file* f = c->file;
+
+  switch (c->op) {
+    case PROXY_OPEN:
+      return v->xOpen(v, c->zName, f, c->iArg, (int*)c->pArg);
+    case PROXY_DELETE:
+      return v->xDelete(v, c->zName, c->iArg);
+    case PROXY_ACCESS:
+      return v->xAccess(v, c->zName, c->iArg, (int*)c->pArg);
+    case PROXY_FULL_PATHNAME:
+      return v->xFullPathname(v, c->zName, c->iArg, (char*)c->pArg);
+    case PROXY_RANDOMNESS:
+      return v->xRandomness(v, c->iArg, (char*)c->pArg);
+    case PROXY_SLEEP:
+      return v->xSleep(v, c->iArg);
+    case PROXY_CURRENT_TIME:
+      return v->xCurrentTimeInt64(v, (sqlite3_int64*)c->pArg);
+    case PROXY_CLOSE:
+      return f->pMethods->xClose(f);
+    case PROXY_READ:
+      return f->pMethods->xRead(f, c->pArg, c->iArg, c->iArg64);
+    case PROXY_WRITE:
+      return f->pMethods->xWrite(f, c->pArg, c->iArg, c->iArg64);
+    case PROXY_TRUNCATE:
+      return f->pMethods->xTruncate(f, c->iArg64);
+    case PROXY_SYNC:
+      return f->pMethods->xSync(f, c->iArg);
+    case PROXY_FILE_SIZE:
+      return f->pMethods->xFileSize(f, (sqlite3_int64*)c->pArg);
+    case PROXY_LOCK:
+      return f->pMethods->xLock(f, c->iArg);
+    case PROXY_UNLOCK:
+      return f->pMethods->xUnlock(f, c->iArg);
+    case PROXY_CHECK_RESERVED_LOCK:
+      return f->pMethods->xCheckReservedLock(f, (int*)c->pArg);
+    case PROXY_FILE_CONTROL:
+      return f->pMethods->xFileControl(f, c->iArg, c->pArg);
+    case PROXY_SECTOR_SIZE:
+      return f->pMethods->xSectorSize(f);
+    case PROXY_DEVICE_CHARACTERISTICS:
+      return f->pMethods->xDeviceCharacteristics(f);
+  }
+
+  return SQLITE_MISUSE;
+}
+
+// Runs the call on the owning isolate, waiting for it if it's not active on
+// this thread.
+//
+// errorRc is returned if the call can't be posted to the owning isolate,
+// which happens after it has exited.
+static int proxyDispatch(DartVfsProxyCall* c, int errorRc) {
+  DartVfsProxy* proxy = c->vfs;
+  if (proxy->currentIsolate() == proxy->owner) {
+    return proxyExecute(c);
+  }
+
+  c->done = 0;
+#ifdef _WIN32
+  InitializeSRWLock(&c->lock);
+  InitializeConditionVariable(&c->cond);
+#else
+  pthread_mutex_init(&c->lock, NULL);
+  pthread_cond_init(&c->cond, NULL);
+#endif
+
+  if (!proxy->postInteger(proxy->port, (int64_t)(intptr_t)c)) {
+    c->rc = errorRc;
+  } else {
+#ifdef _WIN32
+    AcquireSRWLockExclusive(&c->lock);
+    while (!c->done) {
+      SleepConditionVariableSRW(&c->cond, &c->lock, INFINITE, 0);
+    }
+    ReleaseSRWLockExclusive(&c->lock);
+#else
+    pthread_mutex_lock(&c->lock);
+    while (!c->done) {
+      pthread_cond_wait(&c->cond, &c->lock);
+    }
+    pthread_mutex_unlock(&c->lock);
+#endif
+  }
+
+#ifndef _WIN32
+  pthread_cond_destroy(&c->cond);
+  pthread_mutex_destroy(&c->lock);
+#endif
+  return c->rc;
+}
+
+// Called by the owning isolate for calls posted to its port.
+void dart_sqlite3_vfs_proxy_run(DartVfsProxyCall* c) {
+  int rc = proxyExecute(c);
+
+#ifdef _WIN32
+  AcquireSRWLockExclusive(&c->lock);
+  c->rc = rc;
+  c->done = 1;
+  WakeConditionVariable(&c->cond);
+  ReleaseSRWLockExclusive(&c->lock);
+#else
+  pthread_mutex_lock(&c->lock);
+  c->rc = rc;
+  c->done = 1;
+  pthread_cond_signal(&c->cond);
+  pthread_mutex_unlock(&c->lock);
+#endif
+}
+
+static int proxyFileCall(sqlite3_file* pFile, int op, void* pArg, int iArg,
+                         sqlite3_int64 iArg64, int errorRc) {
+  DartVfsProxyFile* p = (DartVfsProxyFile*)pFile;
+  DartVfsProxyCall c;
+  c.vfs = p->vfs;
+  c.op = op;
+  c.file = p->real;
+  c.zName = 0;
+  c.pArg = pArg;
+  c.iArg = iArg;
+  c.iArg64 = iArg64;
+  return proxyDispatch(&c, errorRc);
+}
+
+static int proxyClose(sqlite3_file* pFile) {
+  return proxyFileCall(pFile, PROXY_CLOSE, 0, 0, 0, SQLITE_IOERR_CLOSE);
+}
+
+static int proxyRead(sqlite3_file* pFile, void* pBuf, int amt,
+                     sqlite3_int64 offset) {
+  return proxyFileCall(pFile, PROXY_READ, pBuf, amt, offset, SQLITE_IOERR_READ);
+}
+
+static int proxyWrite(sqlite3_file* pFile, const void* pBuf, int amt,
+                      sqlite3_int64 offset) {
+  return proxyFileCall(pFile, PROXY_WRITE, (void*)pBuf, amt, offset,
+                       SQLITE_IOERR_WRITE);
+}
+
+static int proxyTruncate(sqlite3_file* pFile, sqlite3_int64 size) {
+  return proxyFileCall(pFile, PROXY_TRUNCATE, 0, 0, size,
+                       SQLITE_IOERR_TRUNCATE);
+}
+
+static int proxySync(sqlite3_file* pFile, int flags) {
+  return proxyFileCall(pFile, PROXY_SYNC, 0, flags, 0, SQLITE_IOERR_FSYNC);
+}
+
+static int proxyFileSize(sqlite3_file* pFile, sqlite3_int64* pSize) {
+  return proxyFileCall(pFile, PROXY_FILE_SIZE, pSize, 0, 0,
+                       SQLITE_IOERR_FSTAT);
+}
+
+static int proxyLock(sqlite3_file* pFile, int lock) {
+  return proxyFileCall(pFile, PROXY_LOCK, 0, lock, 0, SQLITE_IOERR_LOCK);
+}
+
+static int proxyUnlock(sqlite3_file* pFile, int lock) {
+  return proxyFileCall(pFile, PROXY_UNLOCK, 0, lock, 0, SQLITE_IOERR_UNLOCK);
+}
+
+static int proxyCheckReservedLock(sqlite3_file* pFile, int* pResOut) {
+  return proxyFileCall(pFile, PROXY_CHECK_RESERVED_LOCK, pResOut, 0, 0,
+                       SQLITE_IOERR_CHECKRESERVEDLOCK);
+}
+
+static int proxyFileControl(sqlite3_file* pFile, int op, void* pArg) {
+  return proxyFileCall(pFile, PROXY_FILE_CONTROL, pArg, op, 0, SQLITE_NOTFOUND);
+}
+
+static int proxySectorSize(sqlite3_file* pFile) {
+  return proxyFileCall(pFile, PROXY_SECTOR_SIZE, 0, 0, 0, 4096);
+}
+
+static int proxyDeviceCharacteristics(sqlite3_file* pFile) {
+  return proxyFileCall(pFile, PROXY_DEVICE_CHARACTERISTICS, 0, 0, 0, 0);
+}
+
+static const sqlite3_io_methods proxyIoMethods = {
+    1,  // iVersion
+    proxyClose,
+    proxyRead,
+    proxyWrite,
+    proxyTruncate,
+    proxySync,
+    proxyFileSize,
+    proxyLock,
+    proxyUnlock,
+    proxyCheckReservedLock,
+    proxyFileControl,
+    proxySectorSize,
+    proxyDeviceCharacteristics,
+};
+
+static int proxyVfsCall(sqlite3_vfs* pVfs, int op, sqlite3_file* file,
+                        const char* zName, void* pArg, int iArg) {
+  DartVfsProxyCall c;
+  c.vfs = (DartVfsProxy*)pVfs;
+  c.op = op;
+  c.file = file;
+  c.zName = zName;
+  c.pArg = pArg;
+  c.iArg = iArg;
+  c.iArg64 = 0;
+  return proxyDispatch(&c, SQLITE_IOERR);
+}
+
+static int proxyOpen(sqlite3_vfs* pVfs, const char* zName,
+                     sqlite3_file* pFile, int flags, int* pOutFlags) {
+  DartVfsProxyFile* p = (DartVfsProxyFile*)pFile;
+  int rc;
+
+  p->base.pMethods = 0;
+  p->vfs = (DartVfsProxy*)pVfs;
+  p->real = (sqlite3_file*)&p[1];
+  p->real->pMethods = 0;
+
+  rc = proxyVfsCall(pVfs, PROXY_OPEN, p->real, zName, pOutFlags, flags);
+  if (p->real->pMethods) {
+    p->base.pMethods = &proxyIoMethods;
+  }
+  return rc;
+}
+
+static int proxyDelete(sqlite3_vfs* pVfs, const char* zName, int syncDir) {
+  return proxyVfsCall(pVfs, PROXY_DELETE, 0, zName, 0, syncDir);
+}
+
+static int proxyAccess(sqlite3_vfs* pVfs, const char* zName, int flags,
+                       int* pResOut) {
+  return proxyVfsCall(pVfs, PROXY_ACCESS, 0, zName, pResOut, flags);
+}
+
+static int proxyFullPathname(sqlite3_vfs* pVfs, const char* zName, int nOut,
+                             char* zOut) {
+  return proxyVfsCall(pVfs, PROXY_FULL_PATHNAME, 0, zName, zOut, nOut);
+}
+
+static int proxyRandomness(sqlite3_vfs* pVfs, int nByte, char* zOut) {
+  return proxyVfsCall(pVfs, PROXY_RANDOMNESS, 0, 0, zOut, nByte);
+}
+
+static int proxySleep(sqlite3_vfs* pVfs, int microseconds) {
+  return proxyVfsCall(pVfs, PROXY_SLEEP, 0, 0, 0, microseconds);
+}
+
+static int proxyCurrentTimeInt64(sqlite3_vfs* pVfs, sqlite3_int64* pOut) {
+  return proxyVfsCall(pVfs, PROXY_CURRENT_TIME, 0, 0, pOut, 0);
+}
+
+static void (*proxyLookup(const DartProxyApi* api, const char* name))(void) {
+  const DartProxyApiEntry* entry;
+
+  for (entry = api->functions; entry->name; entry++) {
+    if (strcmp(entry->name, name) == 0) {
+      return entry->function;
+    }
+  }
+  return 0;
+}
+
+// Creates a VFS forwarding calls to `real`, which must only be called on the
+// current isolate. Calls made on other threads are posted to `port`, whose
+// handler must pass them to dart_sqlite3_vfs_proxy_run.
+//
+// `dartApi` is the result of NativeApi.initializeApiDLData. Returns null if
+// the Dart API doesn't provide the functions we need.
+sqlite3_vfs* dart_sqlite3_vfs_proxy_create(sqlite3_vfs* real, void* dartApi,
+                                           int64_t port) {
+  const DartProxyApi* api = (const DartProxyApi*)dartApi;
+  DartVfsProxy* proxy;
+  void (*currentIsolate)(void);
+  void (*postInteger)(void);
+
+  if (api->major != 2) return 0;
+  currentIsolate = proxyLookup(api, "Dart_CurrentIsolate");
+  postInteger = proxyLookup(api, "Dart_PostInteger");
+  if (!currentIsolate || !postInteger) return 0;
+
+  proxy = (DartVfsProxy*)sqlite3_malloc(sizeof(DartVfsProxy));
+  if (!proxy) return 0;
+  memset(proxy, 0, sizeof(DartVfsProxy));
+
+  proxy->real = real;
+  proxy->currentIsolate = (DartProxyIsolate(*)(void))currentIsolate;
+  proxy->postInteger = (int8_t(*)(DartProxyPort, int64_t))postInteger;
+  proxy->owner = proxy->currentIsolate();
+  proxy->port = port;
+
+  proxy->base.iVersion = real->iVersion < 2 ? real->iVersion : 2;
+  proxy->base.szOsFile = (int)sizeof(DartVfsProxyFile) + real->szOsFile;
+  proxy->base.mxPathname = real->mxPathname;
+  proxy->base.zName = real->zName;
+  proxy->base.xOpen = proxyOpen;
+  proxy->base.xDelete = proxyDelete;
+  proxy->base.xAccess = proxyAccess;
+  proxy->base.xFullPathname = proxyFullPathname;
+  proxy->base.xRandomness = proxyRandomness;
+  proxy->base.xSleep = proxySleep;
+  if (proxy->base.iVersion >= 2 && real->xCurrentTimeInt64) {
+    proxy->base.xCurrentTimeInt64 = proxyCurrentTimeInt64;
+  }
+  return &proxy->base;
+}
+
+void dart_sqlite3_vfs_proxy_destroy(sqlite3_vfs* proxy) {
+  sqlite3_free(proxy);
+}
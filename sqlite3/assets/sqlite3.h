@@ -7,6 +7,7 @@ typedef struct sqlite3_char sqlite3_char;
 typedef struct sqlite3 sqlite3;
 typedef struct sqlite3_stmt sqlite3_stmt;
 typedef struct sqlite3_backup sqlite3_backup;
+typedef struct sqlite3_blob sqlite3_blob;
 typedef struct sqlite3_api_routines sqlite3_api_routines;
 typedef struct sqlite3_session sqlite3_session;
 typedef struct sqlite3_changeset_iter sqlite3_changeset_iter;
@@ -140,6 +141,16 @@ int sqlite3_backup_finish(sqlite3_backup* p);
 int sqlite3_backup_remaining(sqlite3_backup* p);
 int sqlite3_backup_pagecount(sqlite3_backup* p);
 
+// Incremental BLOB I/O
+int sqlite3_blob_open(sqlite3* db, const sqlite3_char* zDb,
+                      const sqlite3_char* zTable, const sqlite3_char* zColumn,
+                      int64_t iRow, int flags, sqlite3_blob** ppBlob);
+int sqlite3_blob_reopen(sqlite3_blob* pBlob, int64_t iRow);
+int sqlite3_blob_close(sqlite3_blob* pBlob);
+int sqlite3_blob_bytes(sqlite3_blob* pBlob);
+int sqlite3_blob_read(sqlite3_blob* pBlob, void* Z, int N, int iOffset);
+int sqlite3_blob_write(sqlite3_blob* pBlob, const void* z, int n, int iOffset);
+
 // Extensions
 int sqlite3_auto_extension(void* xEntryPoint);
 
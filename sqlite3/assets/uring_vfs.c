@@ -0,0 +1,848 @@
+// An optional VFS for Linux using io_uring to read, write and sync database
+// files.
+//
+// This file is not compiled on its own. When the `uring_vfs` user define is
+// set, the build hook compiles it in the same translation unit as the SQLite
+// amalgamation, which gives it access to the internals of the unix VFS.
+//
+// The "unix-uring" VFS wraps the default "unix" VFS, which stays responsible
+// for opening files, locking and shared memory. File handles keep the memory
+// layout of unix files, followed by a UringFile. Main database files and WAL
+// files get an io_uring instance used to:
+//
+//  - read pages. For main database files, larger blocks are read ahead when
+//    SQLite reads sequentially.
+//  - queue writes to main database files outside of checkpoints, which are
+//    submitted as one batch before any other operation on the file.
+//  - sync files.
+//
+// `PRAGMA uring_submissions` reports how many operations on a database file
+// have been submitted through its ring.
+//
+// If io_uring_enter fails, a file stops using its ring and runs later
+// operations with synchronous system calls.
+//
+// Other files, and all files when io_uring is unavailable (e.g. because it's
+// blocked by a seccomp filter), use the unix VFS directly.
+#if defined(__linux__) && SQLITE_OS_UNIX
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define URING_VFS_NAME "unix-uring"
+
+// Amount of submission queue entries per file.
+#define URING_ENTRIES 64
+// Maximum amount of pending writes before they're submitted.
+#define URING_MAX_WRITES 32
+// Maximum size of a pending write after merging adjacent writes.
+#define URING_MAX_WRITE_SIZE (1024 * 1024)
+// Size of blocks read ahead after sequential reads.
+#define URING_PREFETCH_SIZE (128 * 1024)
+// Amount of adjacent reads after which we start prefetching.
+#define URING_SEQUENTIAL_READS 2
+
+#define URING_TAG_OP 1
+#define URING_TAG_WRITE 2
+#define URING_TAG_PREFETCH 3
+
+#define URING_FD(pFile) (((unixFile*)(pFile))->h)
+#define URING_NEEDS_DIRSYNC(pFile) \
+  ((((unixFile*)(pFile))->ctrlFlags & UNIXFILE_DIRSYNC) != 0)
+
+#if defined(HAVE_FDATASYNC) && HAVE_FDATASYNC
+#define URING_FSYNC_FLAGS IORING_FSYNC_DATASYNC
+#else
+#define URING_FSYNC_FLAGS 0
+#endif
+
+typedef struct UringRing UringRing;
+typedef struct UringWrite UringWrite;
+typedef struct UringFile UringFile;
+
+struct UringRing {
+  int fd;
+  unsigned sqeTail;  // Tail of submission queue entries we've prepared.
+  unsigned sqEntries;
+  unsigned* sqHead;
+  unsigned* sqTail;
+  unsigned* sqMask;
+  unsigned* sqArray;
+  struct io_uring_sqe* sqes;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned* cqMask;
+  struct io_uring_cqe* cqes;
+  void* sqRing;
+  size_t sqRingSize;
+  void* cqRing;  // Null if the completion queue shares the sqRing mapping.
+  size_t cqRingSize;
+  size_t sqesSize;
+  sqlite3_uint64 nSubmitted;  // Entries consumed by the kernel.
+};
+
+struct UringWrite {
+  unsigned char* buffer;
+  int capacity;
+  int amount;
+  sqlite3_int64 offset;
+  int result;
+};
+
+struct UringFile {
+  const sqlite3_io_methods* pReal;  // Methods of the unix file.
+  int isMainDb;  // Whether writes are batched and reads are prefetched.
+  int broken;  // Whether io_uring_enter has failed, see uringAbandon.
+  int inCheckpoint;  // Between SQLITE_FCNTL_CKPT_START and _CKPT_DONE.
+  UringRing ring;
+
+  // Submitted operations we're waiting for, excluding prefetches.
+  int nOutstanding;
+  int opResult;
+
+  int nWrite;
+  UringWrite aWrite[URING_MAX_WRITES];
+
+  sqlite3_int64 lastReadEnd;
+  int nSequentialReads;
+  unsigned char* prefetchBuffer;
+  sqlite3_int64 prefetchOffset;
+  int prefetchResult;
+  int prefetchInFlight;
+  int prefetchValid;
+};
+
+static sqlite3_vfs* uringRealVfs;
+static int uringUnavailable;
+
+static UringFile* uringFile(sqlite3_file* pFile) {
+  return (UringFile*)(((char*)pFile) + uringRealVfs->szOsFile);
+}
+
+static void uringRingFree(UringRing* r) {
+  if (r->sqes) munmap(r->sqes, r->sqesSize);
+  if (r->cqRing) munmap(r->cqRing, r->cqRingSize);
+  if (r->sqRing) munmap(r->sqRing, r->sqRingSize);
+  if (r->fd >= 0) close(r->fd);
+  memset(r, 0, sizeof(*r));
+  r->fd = -1;
+}
+
+static int uringRingInit(UringRing* r) {
+  struct io_uring_params p;
+  void* mapped;
+  int fd;
+
+  memset(r, 0, sizeof(*r));
+  memset(&p, 0, sizeof(p));
+  r->fd = -1;
+
+  fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+  if (fd < 0) {
+    if (errno == ENOSYS || errno == EPERM || errno == EACCES) {
+      // io_uring is not supported or blocked, don't try again.
+      uringUnavailable = 1;
+    }
+    return SQLITE_CANTOPEN;
+  }
+  r->fd = fd;
+
+  r->sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  r->cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if ((p.features & IORING_FEAT_SINGLE_MMAP) &&
+      r->cqRingSize > r->sqRingSize) {
+    r->sqRingSize = r->cqRingSize;
+  }
+
+  mapped = mmap(0, r->sqRingSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (mapped == MAP_FAILED) goto failed;
+  r->sqRing = mapped;
+
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    mapped = r->sqRing;
+  } else {
+    mapped = mmap(0, r->cqRingSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (mapped == MAP_FAILED) goto failed;
+    r->cqRing = mapped;
+  }
+
+  r->cqHead = (unsigned*)((char*)mapped + p.cq_off.head);
+  r->cqTail = (unsigned*)((char*)mapped + p.cq_off.tail);
+  r->cqMask = (unsigned*)((char*)mapped + p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe*)((char*)mapped + p.cq_off.cqes);
+
+  r->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+  mapped = mmap(0, r->sqesSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (mapped == MAP_FAILED) goto failed;
+  r->sqes = (struct io_uring_sqe*)mapped;
+
+  r->sqHead = (unsigned*)((char*)r->sqRing + p.sq_off.head);
+  r->sqTail = (unsigned*)((char*)r->sqRing + p.sq_off.tail);
+  r->sqMask = (unsigned*)((char*)r->sqRing + p.sq_off.ring_mask);
+  r->sqArray = (unsigned*)((char*)r->sqRing + p.sq_off.array);
+  r->sqEntries = p.sq_entries;
+  r->sqeTail = *r->sqTail;
+  return SQLITE_OK;
+
+failed:
+  uringRingFree(r);
+  return SQLITE_CANTOPEN;
+}
+
+// Prepares a submission queue entry, which is submitted with the next call to
+// uringEnter.
+//
+// We never prepare more entries than fit into the queue: At most
+// URING_MAX_WRITES writes, a sync, a read and a prefetch are in the queue at
+// the same time.
+static struct io_uring_sqe* uringPrepare(UringRing* r, __u8 opcode, int fd,
+                                         const void* addr, unsigned len,
+                                         sqlite3_int64 offset, __u64 tag) {
+  unsigned index = r->sqeTail & *r->sqMask;
+  struct io_uring_sqe* sqe = &r->sqes[index];
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = (__u64)(uintptr_t)addr;
+  sqe->len = len;
+  sqe->off = (__u64)offset;
+  sqe->user_data = tag;
+  r->sqArray[index] = index;
+  r->sqeTail++;
+  return sqe;
+}
+
+// Submits prepared entries and waits for at least one completion if wait is
+// set.
+static int uringEnter(UringRing* r, int wait) {
+  __atomic_store_n(r->sqTail, r->sqeTail, __ATOMIC_RELEASE);
+
+  while (1) {
+    unsigned toSubmit = r->sqeTail - __atomic_load_n(r->sqHead, __ATOMIC_ACQUIRE);
+    unsigned ready = __atomic_load_n(r->cqTail, __ATOMIC_ACQUIRE) - *r->cqHead;
+    int minComplete = (wait && ready == 0) ? 1 : 0;
+    int rc;
+
+    if (toSubmit == 0 && minComplete == 0) return SQLITE_OK;
+
+    rc = (int)syscall(__NR_io_uring_enter, r->fd, toSubmit, minComplete,
+                      minComplete ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    if (rc < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      return SQLITE_IOERR;
+    }
+    if (rc > 0) r->nSubmitted += (unsigned)rc;
+  }
+}
+
+static void uringComplete(UringFile* p, struct io_uring_cqe* cqe) {
+  __u64 tag = cqe->user_data;
+
+  switch (tag >> 32) {
+    case URING_TAG_PREFETCH:
+      p->prefetchInFlight = 0;
+      p->prefetchResult = cqe->res;
+      return;
+    case URING_TAG_WRITE:
+      p->aWrite[tag & 0xffffffff].result = cqe->res;
+      break;
+    default:
+      p->opResult = cqe->res;
+      break;
+  }
+
+  p->nOutstanding--;
+}
+
+static void uringDrain(UringFile* p) {
+  UringRing* r = &p->ring;
+  unsigned head = *r->cqHead;
+  unsigned tail = __atomic_load_n(r->cqTail, __ATOMIC_ACQUIRE);
+
+  while (head != tail) {
+    uringComplete(p, &r->cqes[head & *r->cqMask]);
+    head++;
+  }
+  __atomic_store_n(r->cqHead, head, __ATOMIC_RELEASE);
+}
+
+// Submits prepared entries and waits for all operations apart from prefetches
+// to complete.
+static int uringWait(UringFile* p) {
+  int rc = uringEnter(&p->ring, 0);
+  while (rc == SQLITE_OK && p->nOutstanding > 0) {
+    rc = uringEnter(&p->ring, 1);
+    uringDrain(p);
+  }
+  return rc;
+}
+
+// Called after io_uring_enter has failed. The kernel only consumes entries in
+// io_uring_enter, so we take back those it hasn't picked up (they would
+// otherwise be submitted with the next operation) and stop using the ring.
+//
+// Entries consumed before the failure may still complete, so nOutstanding and
+// prefetchInFlight only account for those afterwards.
+static void uringAbandon(UringFile* p) {
+  UringRing* r = &p->ring;
+  unsigned head = __atomic_load_n(r->sqHead, __ATOMIC_ACQUIRE);
+
+  while (r->sqeTail != head) {
+    __u64 tag;
+    r->sqeTail--;
+    tag = r->sqes[r->sqArray[r->sqeTail & *r->sqMask]].user_data;
+    if ((tag >> 32) == URING_TAG_PREFETCH) {
+      p->prefetchInFlight = 0;
+    } else {
+      p->nOutstanding--;
+    }
+  }
+  __atomic_store_n(r->sqTail, r->sqeTail, __ATOMIC_RELEASE);
+
+  p->broken = 1;
+  p->prefetchValid = 0;
+}
+
+// Runs an operation with a blocking system call, returning its result like
+// io_uring would.
+static int uringRunSync(sqlite3_file* pFile, __u8 opcode, const void* addr,
+                        unsigned len, sqlite3_int64 offset) {
+  ssize_t n;
+
+  do {
+    switch (opcode) {
+      case IORING_OP_READ:
+        n = pread(URING_FD(pFile), (void*)addr, len, offset);
+        break;
+      case IORING_OP_WRITE:
+        n = pwrite(URING_FD(pFile), addr, len, offset);
+        break;
+      default:
+#if URING_FSYNC_FLAGS
+        n = fdatasync(URING_FD(pFile));
+#else
+        n = fsync(URING_FD(pFile));
+#endif
+        break;
+    }
+  } while (n < 0 && errno == EINTR);
+
+  return n < 0 ? -errno : (int)n;
+}
+
+static int uringWaitForPrefetch(UringFile* p) {
+  int rc = SQLITE_OK;
+  while (rc == SQLITE_OK && p->prefetchInFlight) {
+    rc = uringEnter(&p->ring, 1);
+    uringDrain(p);
+  }
+  return rc;
+}
+
+// Runs a single read, write or sync operation and returns its result.
+static int uringRun(UringFile* p, sqlite3_file* pFile, __u8 opcode,
+                    const void* addr, unsigned len, sqlite3_int64 offset,
+                    int* pResult) {
+  struct io_uring_sqe* sqe;
+  int rc;
+
+  if (p->broken) {
+    *pResult = uringRunSync(pFile, opcode, addr, len, offset);
+    return SQLITE_OK;
+  }
+
+  sqe = uringPrepare(&p->ring, opcode, URING_FD(pFile), addr, len, offset,
+                     (__u64)URING_TAG_OP << 32);
+  if (opcode == IORING_OP_FSYNC) {
+    sqe->fsync_flags = URING_FSYNC_FLAGS;
+  }
+  p->nOutstanding++;
+  rc = uringWait(p);
+  if (rc != SQLITE_OK) {
+    uringAbandon(p);
+    // If the kernel hasn't picked up the operation, we can still run it.
+    if (p->nOutstanding > 0) return rc;
+    *pResult = uringRunSync(pFile, opcode, addr, len, offset);
+    return SQLITE_OK;
+  }
+  *pResult = p->opResult;
+  return rc;
+}
+
+// Submits pending writes and waits for them to complete.
+static int uringFlush(sqlite3_file* pFile) {
+  UringFile* p = uringFile(pFile);
+  int rc = SQLITE_OK;
+  int i;
+
+  if (p->nWrite == 0) return SQLITE_OK;
+
+  for (i = 0; i < p->nWrite; i++) {
+    UringWrite* w = &p->aWrite[i];
+    w->result = 0;
+    if (p->broken) continue;
+
+    uringPrepare(&p->ring, IORING_OP_WRITE, URING_FD(pFile), w->buffer,
+                 (unsigned)w->amount, w->offset,
+                 ((__u64)URING_TAG_WRITE << 32) | (__u64)i);
+    p->nOutstanding++;
+  }
+  if (!p->broken) {
+    rc = uringWait(p);
+    if (rc != SQLITE_OK) {
+      uringAbandon(p);
+      // Writes the kernel hasn't picked up have no result yet, the loop below
+      // writes them synchronously. That's not possible while some are still
+      // in flight, since writes in a batch may overlap with a later one.
+      if (p->nOutstanding == 0) rc = SQLITE_OK;
+    }
+  }
+
+  for (i = 0; i < p->nWrite && rc == SQLITE_OK; i++) {
+    UringWrite* w = &p->aWrite[i];
+    int written = w->result;
+
+    // Complete short writes synchronously, like unixWrite does.
+    while (written >= 0 && written < w->amount) {
+      ssize_t n = pwrite(URING_FD(pFile), w->buffer + written,
+                         w->amount - written, w->offset + written);
+      if (n <= 0) {
+        written = n < 0 ? -errno : -ENOSPC;
+        break;
+      }
+      written += (int)n;
+    }
+
+    if (written < 0) {
+      ((unixFile*)pFile)->lastErrno = -written;
+      rc = written == -ENOSPC ? SQLITE_FULL : SQLITE_IOERR_WRITE;
+    }
+  }
+
+  p->nWrite = 0;
+  return rc;
+}
+
+// Prefetched pages are only valid as long as the lock SQLite held when reading
+// them. Lock changes can indicate that other connections have written to the
+// database, so they discard prefetched data.
+static void uringForgetPrefetch(sqlite3_file* pFile) {
+  uringFile(pFile)->prefetchValid = 0;
+}
+
+static void uringInvalidatePrefetch(UringFile* p, sqlite3_int64 offset,
+                                    sqlite3_int64 end) {
+  if (p->prefetchValid && offset < p->prefetchOffset + URING_PREFETCH_SIZE &&
+      end > p->prefetchOffset) {
+    p->prefetchValid = 0;
+  }
+}
+
+static void uringStartPrefetch(UringFile* p, sqlite3_file* pFile,
+                               sqlite3_int64 offset) {
+  if (p->prefetchBuffer == 0) {
+    p->prefetchBuffer = sqlite3_malloc(URING_PREFETCH_SIZE);
+    if (p->prefetchBuffer == 0) return;
+  }
+  if (p->broken) return;
+  // The buffer can't be reused while the kernel may still write into it.
+  if (uringWaitForPrefetch(p) != SQLITE_OK) return;
+
+  uringPrepare(&p->ring, IORING_OP_READ, URING_FD(pFile), p->prefetchBuffer,
+               URING_PREFETCH_SIZE, offset,
+               (__u64)URING_TAG_PREFETCH << 32);
+  p->prefetchOffset = offset;
+  p->prefetchInFlight = 1;
+  p->prefetchValid = 1;
+
+  if (uringEnter(&p->ring, 0) != SQLITE_OK) {
+    // If the read is in flight, it must be waited for before the buffer is
+    // reused.
+    uringAbandon(p);
+  }
+}
+
+// Copies data from the prefetch buffer, returning whether it contained the
+// requested range.
+static int uringReadPrefetched(UringFile* p, void* pBuf, int amt,
+                               sqlite3_int64 offset) {
+  sqlite3_int64 start = offset - p->prefetchOffset;
+
+  if (!p->prefetchValid || start < 0 ||
+      start + amt > URING_PREFETCH_SIZE) {
+    return 0;
+  }
+  if (uringWaitForPrefetch(p) != SQLITE_OK || p->prefetchResult < 0) {
+    p->prefetchValid = 0;
+    return 0;
+  }
+  if (start + amt > p->prefetchResult) {
+    // Reads past the end of the file are handled by a regular read.
+    return 0;
+  }
+
+  memcpy(pBuf, p->prefetchBuffer + start, amt);
+  return 1;
+}
+
+static int uringClose(sqlite3_file* pFile) {
+  UringFile* p = uringFile(pFile);
+  const sqlite3_io_methods* pReal = p->pReal;
+  int rc = uringFlush(pFile);
+  int i;
+
+  uringWaitForPrefetch(p);
+  uringRingFree(&p->ring);
+  for (i = 0; i < URING_MAX_WRITES; i++) {
+    sqlite3_free(p->aWrite[i].buffer);
+  }
+  sqlite3_free(p->prefetchBuffer);
+
+  pFile->pMethods = pReal;
+  if (pReal->xClose(pFile) != SQLITE_OK) rc = SQLITE_IOERR_CLOSE;
+  return rc;
+}
+
+static int uringRead(sqlite3_file* pFile, void* pBuf, int amt,
+                     sqlite3_int64 offset) {
+  UringFile* p = uringFile(pFile);
+  int rc = uringFlush(pFile);
+  int got = 0;
+
+  if (rc != SQLITE_OK) return rc;
+
+  if (offset == p->lastReadEnd) {
+    p->nSequentialReads++;
+  } else {
+    p->nSequentialReads = 0;
+  }
+  p->lastReadEnd = offset + amt;
+
+  if (!uringReadPrefetched(p, pBuf, amt, offset)) {
+    while (got < amt) {
+      int result;
+      rc = uringRun(p, pFile, IORING_OP_READ, (char*)pBuf + got, amt - got,
+                    offset + got, &result);
+      if (rc != SQLITE_OK) return rc;
+      if (result < 0) {
+        ((unixFile*)pFile)->lastErrno = -result;
+        return SQLITE_IOERR_READ;
+      }
+      if (result == 0) break;
+      got += result;
+    }
+
+    if (got < amt) {
+      // Unread parts of the buffer must be zeroed.
+      memset((char*)pBuf + got, 0, amt - got);
+      return SQLITE_IOERR_SHORT_READ;
+    }
+  }
+
+  if (p->isMainDb && p->nSequentialReads >= URING_SEQUENTIAL_READS) {
+    sqlite3_int64 next = offset + amt;
+    if (!p->prefetchValid || next < p->prefetchOffset ||
+        next >= p->prefetchOffset + URING_PREFETCH_SIZE) {
+      uringStartPrefetch(p, pFile, next);
+    }
+  }
+
+  return SQLITE_OK;
+}
+
+static int uringOverlapsPendingWrite(UringFile* p, sqlite3_int64 offset,
+                                     sqlite3_int64 end) {
+  int i;
+  for (i = 0; i < p->nWrite; i++) {
+    UringWrite* w = &p->aWrite[i];
+    if (offset < w->offset + w->amount && end > w->offset) return 1;
+  }
+  return 0;
+}
+
+static int uringWrite(sqlite3_file* pFile, const void* pBuf, int amt,
+                      sqlite3_int64 offset) {
+  UringFile* p = uringFile(pFile);
+  sqlite3_int64 end = offset + amt;
+  UringWrite* w;
+  int rc;
+
+  uringInvalidatePrefetch(p, offset, end);
+
+  // SQLite may consider a checkpoint complete without another call that could
+  // report errors from pending writes (SQLITE_FCNTL_CKPT_DONE is only a hint),
+  // so writes made by checkpoints aren't batched.
+  if (!p->isMainDb || p->inCheckpoint) {
+    int result, written = 0;
+    while (written < amt) {
+      rc = uringRun(p, pFile, IORING_OP_WRITE, (const char*)pBuf + written,
+                    amt - written, offset + written, &result);
+      if (rc != SQLITE_OK) return rc;
+      if (result <= 0) {
+        ((unixFile*)pFile)->lastErrno = result < 0 ? -result : 0;
+        return result == -ENOSPC || result == 0 ? SQLITE_FULL
+                                                : SQLITE_IOERR_WRITE;
+      }
+      written += result;
+    }
+    return SQLITE_OK;
+  }
+
+  // Writes in the same batch may run in any order, so overlapping writes must
+  // be in different batches.
+  if (uringOverlapsPendingWrite(p, offset, end)) {
+    rc = uringFlush(pFile);
+    if (rc != SQLITE_OK) return rc;
+  }
+
+  // Extend the previous write if this one continues it.
+  if (p->nWrite > 0) {
+    w = &p->aWrite[p->nWrite - 1];
+    if (w->offset + w->amount == offset &&
+        w->amount + amt <= URING_MAX_WRITE_SIZE) {
+      if (w->amount + amt > w->capacity) {
+        int capacity = w->capacity * 2;
+        unsigned char* buffer;
+        if (capacity < w->amount + amt) capacity = w->amount + amt;
+        buffer = sqlite3_realloc(w->buffer, capacity);
+        if (buffer == 0) return SQLITE_IOERR_NOMEM;
+        w->buffer = buffer;
+        w->capacity = capacity;
+      }
+      memcpy(w->buffer + w->amount, pBuf, amt);
+      w->amount += amt;
+      return SQLITE_OK;
+    }
+  }
+
+  if (p->nWrite == URING_MAX_WRITES) {
+    rc = uringFlush(pFile);
+    if (rc != SQLITE_OK) return rc;
+  }
+
+  w = &p->aWrite[p->nWrite];
+  if (w->capacity < amt) {
+    unsigned char* buffer = sqlite3_realloc(w->buffer, amt);
+    if (buffer == 0) return SQLITE_IOERR_NOMEM;
+    w->buffer = buffer;
+    w->capacity = amt;
+  }
+  memcpy(w->buffer, pBuf, amt);
+  w->amount = amt;
+  w->offset = offset;
+  p->nWrite++;
+  return SQLITE_OK;
+}
+
+static int uringTruncate(sqlite3_file* pFile, sqlite3_int64 size) {
+  UringFile* p = uringFile(pFile);
+  int rc = uringFlush(pFile);
+  if (rc != SQLITE_OK) return rc;
+
+  p->prefetchValid = 0;
+  return p->pReal->xTruncate(pFile, size);
+}
+
+static int uringSync(sqlite3_file* pFile, int flags) {
+  UringFile* p = uringFile(pFile);
+  int rc = uringFlush(pFile);
+  int result;
+
+  if (rc != SQLITE_OK) return rc;
+  if (URING_NEEDS_DIRSYNC(pFile)) {
+    // The unix VFS also syncs the directory after creating files.
+    return p->pReal->xSync(pFile, flags);
+  }
+
+#ifdef SQLITE_NO_SYNC
+  (void)result;
+  return SQLITE_OK;
+#else
+  rc = uringRun(p, pFile, IORING_OP_FSYNC, 0, 0, 0, &result);
+  if (rc != SQLITE_OK) return rc;
+  if (result < 0) {
+    ((unixFile*)pFile)->lastErrno = -result;
+    return SQLITE_IOERR_FSYNC;
+  }
+  return SQLITE_OK;
+#endif
+}
+
+// Other methods are forwarded to the unix VFS after submitting pending writes,
+// so that the unix VFS and other connections see them.
+#define URING_FORWARD(pFile, call)           \
+  do {                                       \
+    int rc = uringFlush(pFile);              \
+    if (rc != SQLITE_OK) return rc;          \
+    return uringFile(pFile)->pReal->call;    \
+  } while (0)
+
+static int uringFileSize(sqlite3_file* pFile, sqlite3_int64* pSize) {
+  URING_FORWARD(pFile, xFileSize(pFile, pSize));
+}
+
+static int uringLock(sqlite3_file* pFile, int lock) {
+  uringForgetPrefetch(pFile);
+  URING_FORWARD(pFile, xLock(pFile, lock));
+}
+
+static int uringUnlock(sqlite3_file* pFile, int lock) {
+  uringForgetPrefetch(pFile);
+  URING_FORWARD(pFile, xUnlock(pFile, lock));
+}
+
+static int uringCheckReservedLock(sqlite3_file* pFile, int* pResOut) {
+  URING_FORWARD(pFile, xCheckReservedLock(pFile, pResOut));
+}
+
+static int uringFileControl(sqlite3_file* pFile, int op, void* pArg) {
+  if (op == SQLITE_FCNTL_PRAGMA) {
+    char** azArg = (char**)pArg;
+    if (sqlite3_stricmp(azArg[1], "uring_submissions") == 0) {
+      azArg[0] = sqlite3_mprintf("%llu", uringFile(pFile)->ring.nSubmitted);
+      return azArg[0] ? SQLITE_OK : SQLITE_NOMEM;
+    }
+  } else if (op == SQLITE_FCNTL_CKPT_START) {
+    uringFile(pFile)->inCheckpoint = 1;
+  } else if (op == SQLITE_FCNTL_CKPT_DONE) {
+    uringFile(pFile)->inCheckpoint = 0;
+  }
+
+  // When committing a transaction, SQLite issues SQLITE_FCNTL_SYNC after
+  // writing pages and before finalizing the rollback journal, even with
+  // PRAGMA synchronous = OFF. Flushing here surfaces errors from pending writes
+  // while the transaction can still be rolled back.
+  URING_FORWARD(pFile, xFileControl(pFile, op, pArg));
+}
+
+static int uringSectorSize(sqlite3_file* pFile) {
+  return uringFile(pFile)->pReal->xSectorSize(pFile);
+}
+
+static int uringDeviceCharacteristics(sqlite3_file* pFile) {
+  return uringFile(pFile)->pReal->xDeviceCharacteristics(pFile);
+}
+
+static int uringShmMap(sqlite3_file* pFile, int iPg, int pgsz, int bExtend,
+                       void volatile** pp) {
+  URING_FORWARD(pFile, xShmMap(pFile, iPg, pgsz, bExtend, pp));
+}
+
+static int uringShmLock(sqlite3_file* pFile, int offset, int n, int flags) {
+  uringForgetPrefetch(pFile);
+  URING_FORWARD(pFile, xShmLock(pFile, offset, n, flags));
+}
+
+static void uringShmBarrier(sqlite3_file* pFile) {
+  uringFlush(pFile);
+  uringForgetPrefetch(pFile);
+  uringFile(pFile)->pReal->xShmBarrier(pFile);
+}
+
+static int uringShmUnmap(sqlite3_file* pFile, int deleteFlag) {
+  URING_FORWARD(pFile, xShmUnmap(pFile, deleteFlag));
+}
+
+static int uringFetch(sqlite3_file* pFile, sqlite3_int64 offset, int amt,
+                      void** pp) {
+  URING_FORWARD(pFile, xFetch(pFile, offset, amt, pp));
+}
+
+static int uringUnfetch(sqlite3_file* pFile, sqlite3_int64 offset, void* p) {
+  return uringFile(pFile)->pReal->xUnfetch(pFile, offset, p);
+}
+
+static const sqlite3_io_methods uringIoMethods = {
+    3,
+    uringClose,
+    uringRead,
+    uringWrite,
+    uringTruncate,
+    uringSync,
+    uringFileSize,
+    uringLock,
+    uringUnlock,
+    uringCheckReservedLock,
+    uringFileControl,
+    uringSectorSize,
+    uringDeviceCharacteristics,
+    uringShmMap,
+    uringShmLock,
+    uringShmBarrier,
+    uringShmUnmap,
+    uringFetch,
+    uringUnfetch,
+};
+
+static int uringOpen(sqlite3_vfs* pVfs, const char* zName, sqlite3_file* pFile,
+                     int flags, int* pOutFlags) {
+  UringFile* p;
+  int rc = uringRealVfs->xOpen(uringRealVfs, zName, pFile, flags, pOutFlags);
+  (void)pVfs;
+
+  if (rc != SQLITE_OK || uringUnavailable ||
+      (flags & (SQLITE_OPEN_MAIN_DB | SQLITE_OPEN_WAL)) == 0 ||
+      pFile->pMethods->iVersion < 3) {
+    return rc;
+  }
+
+  p = uringFile(pFile);
+  memset(p, 0, sizeof(*p));
+  if (uringRingInit(&p->ring) != SQLITE_OK) {
+    // Fall back to the unix VFS for this file.
+    return SQLITE_OK;
+  }
+
+  // Writes to WAL files are not batched: Other connections may read frames as
+  // soon as the wal-index is updated, which doesn't involve this file. For the
+  // same reason, WAL reads can't be prefetched: We don't see when another
+  // connection restarts the WAL and overwrites frames.
+  p->isMainDb = (flags & SQLITE_OPEN_MAIN_DB) != 0;
+  p->lastReadEnd = -1;
+  p->pReal = pFile->pMethods;
+  pFile->pMethods = &uringIoMethods;
+  return SQLITE_OK;
+}
+
+SQLITE_API int dart_sqlite3_uring_vfs_register(int makeDefault) {
+  static sqlite3_vfs vfs;
+  sqlite3_mutex* mutex;
+  int rc = sqlite3_initialize();
+  if (rc != SQLITE_OK) return rc;
+
+  mutex = sqlite3_mutex_alloc(SQLITE_MUTEX_STATIC_VFS1);
+  sqlite3_mutex_enter(mutex);
+  if (vfs.zName == 0) {
+    uringRealVfs = sqlite3_vfs_find("unix");
+    if (uringRealVfs == 0) {
+      rc = SQLITE_ERROR;
+    } else {
+      vfs = *uringRealVfs;
+      vfs.pNext = 0;
+      vfs.zName = URING_VFS_NAME;
+      vfs.szOsFile = uringRealVfs->szOsFile + (int)sizeof(UringFile);
+      vfs.xOpen = uringOpen;
+    }
+  }
+  sqlite3_mutex_leave(mutex);
+
+  if (rc != SQLITE_OK) return rc;
+  return sqlite3_vfs_register(&vfs, makeDefault);
+}
+
+#else
+
+SQLITE_API int dart_sqlite3_uring_vfs_register(int makeDefault) {
+  (void)makeDefault;
+  return SQLITE_ERROR;
+}
+
+#endif
@@ -41,6 +41,7 @@ void main(List<String> args) async {
         :final additionalFlags,
         :final additionalLibraryDirectories,
         :final additionalLibraries,
+        :final uringVfs,
       ):
         // With Flutter on Linux (which already dynamically links SQLite through
         // its libgtk dependency), we run into issues where loading our SQLite
@@ -56,21 +57,44 @@ void main(List<String> args) async {
         if (input.config.code.targetOS == OS.linux) {
           linkerScript = input.outputDirectory.resolve('sqlite.map').path;
 
+          final symbols = {
+            ...usedSqliteSymbols,
+            'dart_sqlite3_vfs_proxy_create',
+            'dart_sqlite3_vfs_proxy_destroy',
+            'dart_sqlite3_vfs_proxy_run',
+            if (uringVfs) 'dart_sqlite3_uring_vfs_register',
+          };
+
           await File(linkerScript).writeAsString('''
 {
   global:
-${usedSqliteSymbols.map((symbol) => '    $symbol;').join('\n')}
+${symbols.map((symbol) => '    $symbol;').join('\n')}
   local:
     *;
 };
 ''');
         }
 
+        // Our own extensions are compiled in the same translation unit as
+        // SQLite: The io_uring VFS uses internals of the unix VFS, and the
+        // proxy for Dart file systems only needs the amalgamation for headers.
+        final extensions = [
+          input.packageRoot.resolve('assets/dart_vfs_proxy.c'),
+          if (uringVfs) input.packageRoot.resolve('assets/uring_vfs.c'),
+        ];
+        final combined = input.outputDirectory.resolve('sqlite3_dart.c');
+        await File.fromUri(combined).writeAsString('''
+#include "${p.absolute(sourceFile)}"
+${extensions.map((source) => '#include "${source.toFilePath()}"').join('\n')}
+''');
+        output.dependencies.addAll(extensions);
+        final sources = [combined.toFilePath()];
+
         final library = CBuilder.library(
           name: 'sqlite3',
           packageName: 'sqlite3',
           assetName: name,
-          sources: [sourceFile],
+          sources: sources,
           includes: [p.dirname(sourceFile), ...additionalIncludes],
           defines: defines,
           flags: [
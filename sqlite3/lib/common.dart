@@ -6,13 +6,15 @@
 /// {@canonicalFor statement.CommonPreparedStatement}
 library;
 
+export 'src/blob.dart';
 export 'src/constants.dart';
 export 'src/database.dart';
 export 'src/session.dart';
 export 'src/exception.dart';
 export 'src/functions.dart';
-export 'src/in_memory_vfs.dart' show InMemoryFileSystem;
+export 'src/in_memory_vfs.dart' show InMemoryFileSystem, MemoryFile;
 export 'src/jsonb.dart';
+export 'src/measured_vfs.dart';
 export 'src/result_set.dart';
 export 'src/sqlite3.dart';
 export 'src/statement.dart'
@@ -0,0 +1,108 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'database.dart';
+import 'exception.dart';
+
+/// A handle to incrementally read and write a single BLOB value without
+/// loading it into memory.
+///
+/// Handles are opened with [CommonDatabase.openBlob]. Reading large values
+/// through [read] or [openRead] only requires memory for the chunks being
+/// read, unlike selecting the column (which copies the entire value into a
+/// [Uint8List]).
+///
+/// Incremental I/O can't change the size of a BLOB. To write a large value
+/// incrementally, insert a placeholder of the right size with `zeroblob(n)`
+/// first and then [write] into it:
+///
+/// ```dart
+/// db.execute('INSERT INTO files (content) VALUES (zeroblob(?))', [size]);
+/// final blob = db.openBlob(
+///   table: 'files',
+///   column: 'content',
+///   rowId: db.lastInsertRowId,
+///   writable: true,
+/// );
+/// await file.openRead().pipe(blob.openWrite());
+/// blob.close();
+/// ```
+///
+/// When the row a handle points to is modified or deleted (by any statement
+/// on the same database connection), the handle expires and further reads or
+/// writes throw a [SqliteException]. To move a handle to another row in the
+/// same table and column, use [reopen], which is cheaper than opening a new
+/// handle.
+///
+/// Handles should be [close]d once they're no longer needed.
+///
+/// See also: https://sqlite.org/c3ref/blob_open.html
+///
+/// {@category common}
+abstract interface class BlobHandle {
+  /// The default size of chunks emitted by [openRead].
+  static const defaultChunkSize = 64 * 1024;
+
+  /// The `rowid` of the row this handle currently points to.
+  int get rowId;
+
+  /// The size of the BLOB value, in bytes.
+  ///
+  /// See also: https://sqlite.org/c3ref/blob_bytes.html
+  int get length;
+
+  /// Fills [target] with bytes from the BLOB, starting at [offset].
+  ///
+  /// Throws a [RangeError] if the BLOB doesn't have `target.length` bytes
+  /// after [offset].
+  ///
+  /// See also: https://sqlite.org/c3ref/blob_read.html
+  void read(Uint8List target, int offset);
+
+  /// Writes all of [source] into the BLOB, starting at [offset].
+  ///
+  /// This requires the handle to be opened with `writable: true`. Throws a
+  /// [RangeError] if the write would extend past the end of the BLOB.
+  ///
+  /// See also: https://sqlite.org/c3ref/blob_write.html
+  void write(Uint8List source, int offset);
+
+  /// Moves this handle to the row with the given [rowId], in the same table,
+  /// column and database.
+  ///
+  /// This is faster than closing this handle and opening a new one. When the
+  /// row doesn't exist or doesn't contain a BLOB, this throws a
+  /// [SqliteException] and the handle can't be used for reads or writes
+  /// anymore.
+  ///
+  /// See also: https://sqlite.org/c3ref/blob_reopen.html
+  void reopen(int rowId);
+
+  /// Returns a stream of chunks read from this BLOB, from [start] (inclusive)
+  /// to [end] (exclusive, defaults to [length]).
+  ///
+  /// Chunks are read lazily as the stream is listened to, so only a single
+  /// chunk of at most [chunkSize] bytes is in memory at a time unless the
+  /// listener keeps them around.
+  ///
+  /// The handle must not be reopened or closed while the stream is active.
+  Stream<Uint8List> openRead({
+    int start = 0,
+    int? end,
+    int chunkSize = defaultChunkSize,
+  });
+
+  /// Returns a sink writing all added bytes into this BLOB, starting at
+  /// [start].
+  ///
+  /// Writes happen synchronously when bytes are added. Errors writing to the
+  /// BLOB are thrown by [StreamSink.add], or reported through the future
+  /// returned by [StreamSink.addStream]. Closing the sink doesn't close this
+  /// handle.
+  StreamSink<List<int>> openWrite({int start = 0});
+
+  /// Closes this handle.
+  ///
+  /// See also: https://sqlite.org/c3ref/blob_close.html
+  void close();
+}
@@ -1,7 +1,9 @@
+import 'blob.dart';
 import 'functions.dart';
 import 'result_set.dart';
 import 'statement.dart';
 import 'constants.dart';
+import 'exception.dart';
 
 /// An opened sqlite3 database.
 ///
@@ -290,6 +292,26 @@ abstract class CommonDatabase {
   /// For details, see https://www.sqlite.org/c3ref/get_autocommit.html
   bool get autocommit;
 
+  /// Opens a [BlobHandle] to incrementally read (and, if [writable] is set,
+  /// write) the BLOB stored in [column] of the row with the given [rowId] in
+  /// [table].
+  ///
+  /// Unlike selecting the column, this doesn't load the entire value into
+  /// memory. The [database] parameter selects the schema containing [table],
+  /// which is useful for attached databases.
+  ///
+  /// This throws a [SqliteException] if the row doesn't exist or if the
+  /// column doesn't contain a BLOB or text value.
+  ///
+  /// See also: https://sqlite.org/c3ref/blob_open.html
+  BlobHandle openBlob({
+    required String table,
+    required String column,
+    required int rowId,
+    String database = 'main',
+    bool writable = false,
+  });
+
   /// Closes this database and releases associated resources.
   @Deprecated('Call close() instead')
   void dispose();
@@ -61,6 +61,27 @@ abstract interface class Sqlite3 implements CommonSqlite3 {
   /// See also: https://sqlite.org/c3ref/compileoption_get.html
   Iterable<String> get compileOptions;
 
+  /// Registers `unix-uring`, a virtual file system using io_uring to read,
+  /// write and sync database files.
+  ///
+  /// The file system is a wrapper around the default `unix` VFS. It batches
+  /// writes to database files and reads ahead when scanning database files
+  /// sequentially, which reduces the amount of system calls under heavy I/O.
+  /// When io_uring is unavailable (for instance because it has been disabled
+  /// in a container), it transparently falls back to the `unix` VFS.
+  /// `PRAGMA uring_submissions` reports how many operations on a database
+  /// file have been submitted through io_uring, it returns no rows for files
+  /// using the fallback.
+  ///
+  /// The VFS is only available in SQLite builds compiled from source on Linux
+  /// with the `uring_vfs` option. For details, see the documentation on hooks.
+  /// In other builds, this throws an [UnsupportedError].
+  ///
+  /// After registering the VFS, databases can use it by passing `unix-uring`
+  /// as a `vfs` to [open]. When [makeDefault] is enabled, it is used for all
+  /// databases not explicitly requesting another VFS.
+  void registerUringVfs({bool makeDefault = false});
+
   /// A function pointer to `sqlite3_close_v2`.
   ///
   /// This typically shouldn't be used directly since this library attaches
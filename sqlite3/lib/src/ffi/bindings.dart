@@ -3,6 +3,7 @@
 import 'dart:collection';
 import 'dart:convert';
 import 'dart:ffi';
+import 'dart:isolate';
 import 'dart:typed_data';
 
 import 'package:ffi/ffi.dart' as ffi;
@@ -16,6 +17,7 @@ import '../vfs.dart';
 import 'libsqlite3.g.dart';
 import 'libsqlite3.g.dart' as libsqlite3;
 import 'memory.dart';
+import 'vfs_proxy.dart';
 
 /// The only instance of [FfiBindings].
 ///
@@ -42,6 +44,7 @@ final sessionDeleteFinalizer = NativeFinalizer(
 final changesetFinalizeFinalizer = NativeFinalizer(
   addresses.sqlite3changeset_finalize.cast(),
 );
+final blobCloseFinalizer = NativeFinalizer(addresses.sqlite3_blob_close.cast());
 final hasColumnMetadata =
     ffiBindings.sqlite3_compileoption_used('ENABLE_COLUMN_METADATA') != 0;
 
@@ -257,7 +260,10 @@ final class FfiBindings implements RawSqliteBindings {
   @override
   void registerVirtualFileSystem(VirtualFileSystem vfs, int makeDefault) {
     final ptr = _RegisteredVfs.allocate(vfs);
-    final result = libsqlite3.sqlite3_vfs_register(ptr._vfsPtr, makeDefault);
+    final result = libsqlite3.sqlite3_vfs_register(
+      ptr._registeredPtr,
+      makeDefault,
+    );
     if (result != SqlError.SQLITE_OK) {
       ptr.deallocate();
       throw SqliteException(
@@ -275,8 +281,18 @@ final class FfiBindings implements RawSqliteBindings {
     if (ptr == null) {
       throw StateError('vfs has not been registered');
     }
+    if (ptr._openFiles > 0) {
+      // sqlite3 would keep calling the file system through callbacks closed
+      // by deallocate().
+      throw StateError(
+        'vfs still has ${ptr._openFiles} open files, close databases using '
+        'it before unregistering it.',
+      );
+    }
 
-    final result = libsqlite3.sqlite3_vfs_unregister(ptr._vfsPtr);
+    final result = libsqlite3.sqlite3_vfs_unregister(
+      ptr._registeredPtr,
+    );
     if (result != SqlError.SQLITE_OK) {
       throw SqliteException(
         extendedResultCode: result,
@@ -284,6 +300,7 @@ final class FfiBindings implements RawSqliteBindings {
       );
     }
 
+    _vfsPointers[vfs] = null;
     ptr.deallocate();
   }
 
@@ -301,67 +318,154 @@ final class FfiBindings implements RawSqliteBindings {
   }
 }
 
+/// A Dart [VirtualFileSystem] registered with sqlite3.
+///
+/// Methods of the `sqlite3_vfs` struct are [NativeCallable]s bound to the Dart
+/// file system. Files opened through Dart file systems all share the
+/// [_ioMethods] table, which finds the Dart file through the index stored in
+/// [_DartFile.dartFileId].
+///
+/// Callbacks are bound to the isolate registering the file system. When SQLite
+/// has been compiled by the build hook of this package, we register a proxy
+/// from `assets/dart_vfs_proxy.c` instead. It posts calls made on other threads
+/// to [_proxyPort] and blocks until this isolate has handled them, so that
+/// databases using the file system can be used on other isolates too.
 final class _RegisteredVfs {
-  static final Map<int, VirtualFileSystemFile> _files = {};
-  static final Map<int, VirtualFileSystem> _vfs = {};
+  /// Open files and the file system that has opened them, indexed by
+  /// [_DartFile.dartFileId].
+  static final List<(VirtualFileSystemFile, _RegisteredVfs)?> _files = [];
 
-  static int _vfsCounter = 0;
-  static int _fileCounter = 0;
+  /// Indices in [_files] that are no longer in use.
+  static final List<int> _freeFileIds = [];
 
+  /// The io methods shared by all files opened through a Dart file system.
+  ///
+  /// The table is allocated once per isolate and never freed, since sqlite3
+  /// references it for as long as files are open.
+  static final Pointer<sqlite3_io_methods> _ioMethods = _allocateIoMethods();
+
+  final VirtualFileSystem _dartVfs;
   final Pointer<sqlite3_vfs> _vfsPtr;
   final Pointer<Char> _name;
+  final List<NativeCallable> _callables = [];
 
-  _RegisteredVfs(this._vfsPtr, this._name);
+  Pointer<sqlite3_vfs>? _proxy;
+  RawReceivePort? _proxyPort;
 
-  factory _RegisteredVfs.allocate(VirtualFileSystem dartVfs) {
-    final name = Utf8Utils.allocateZeroTerminated(dartVfs.name).cast<Char>();
-    final id = _vfsCounter++;
+  /// The amount of files opened through this file system that haven't been
+  /// closed yet.
+  var _openFiles = 0;
 
-    final vfs = ffi.calloc<sqlite3_vfs>();
-    vfs.ref
+  _RegisteredVfs.allocate(this._dartVfs)
+    : _vfsPtr = ffi.calloc<sqlite3_vfs>(),
+      _name = Utf8Utils.allocateZeroTerminated(_dartVfs.name).cast<Char>() {
+    const error = SqlError.SQLITE_ERROR;
+
+    _vfsPtr.ref
       ..iVersion =
           2 // We don't support syscalls yet
       ..szOsFile = sizeOf<_DartFile>()
       ..mxPathname = 1024
-      ..zName = name
-      ..pAppData = Pointer.fromAddress(id)
-      ..xOpen = Pointer.fromFunction(_xOpen, SqlError.SQLITE_ERROR)
-      ..xDelete = Pointer.fromFunction(_xDelete, SqlError.SQLITE_ERROR)
-      ..xAccess = Pointer.fromFunction(_xAccess, SqlError.SQLITE_ERROR)
-      ..xFullPathname = Pointer.fromFunction(
-        _xFullPathname,
-        SqlError.SQLITE_ERROR,
+      ..zName = _name
+      ..xOpen = _bind(
+        NativeCallable<_VfsOpen>.isolateLocal(_xOpen, exceptionalReturn: error),
+      )
+      ..xDelete = _bind(
+        NativeCallable<_VfsDelete>.isolateLocal(
+          _xDelete,
+          exceptionalReturn: error,
+        ),
+      )
+      ..xAccess = _bind(
+        NativeCallable<_VfsAccess>.isolateLocal(
+          _xAccess,
+          exceptionalReturn: error,
+        ),
+      )
+      ..xFullPathname = _bind(
+        NativeCallable<_VfsFullPathname>.isolateLocal(
+          _xFullPathname,
+          exceptionalReturn: error,
+        ),
       )
       ..xDlOpen = nullPtr()
       ..xDlError = nullPtr()
       ..xDlSym = nullPtr()
       ..xDlClose = nullPtr()
-      ..xRandomness = Pointer.fromFunction(_xRandomness, SqlError.SQLITE_ERROR)
-      ..xSleep = Pointer.fromFunction(_xSleep, SqlError.SQLITE_ERROR)
+      ..xRandomness = _bind(
+        NativeCallable<_VfsRandomness>.isolateLocal(
+          _xRandomness,
+          exceptionalReturn: error,
+        ),
+      )
+      ..xSleep = _bind(
+        NativeCallable<_VfsSleep>.isolateLocal(
+          _xSleep,
+          exceptionalReturn: error,
+        ),
+      )
       ..xCurrentTime = nullPtr()
       ..xGetLastError = nullPtr()
-      ..xCurrentTimeInt64 = Pointer.fromFunction(
-        _xCurrentTime64,
-        SqlError.SQLITE_ERROR,
+      ..xCurrentTimeInt64 = _bind(
+        NativeCallable<_VfsCurrentTime64>.isolateLocal(
+          _xCurrentTime64,
+          exceptionalReturn: error,
+        ),
+      );
+    _createProxy();
+  }
+
+  /// The `sqlite3_vfs` to register with sqlite3.
+  Pointer<sqlite3_vfs> get _registeredPtr => _proxy ?? _vfsPtr;
+
+  void _createProxy() {
+    final port = RawReceivePort(null, 'sqlite3 vfs ${_dartVfs.name}')
+      ..keepIsolateAlive = false;
+
+    Pointer<sqlite3_vfs> proxy;
+    try {
+      proxy = vfsProxyCreate(
+        _vfsPtr,
+        NativeApi.initializeApiDLData,
+        port.sendPort.nativePort,
       );
+    } on ArgumentError {
+      // Precompiled libraries don't contain the proxy, so the file system can
+      // only be used on this isolate.
+      proxy = nullPtr();
+    }
 
-    _vfs[id] = dartVfs;
-    return _RegisteredVfs(vfs, name);
+    if (proxy.isNullPointer) {
+      port.close();
+    } else {
+      port.handler = (int call) => vfsProxyRun(Pointer.fromAddress(call));
+      _proxy = proxy;
+      _proxyPort = port;
+    }
+  }
+
+  Pointer<NativeFunction<T>> _bind<T extends Function>(
+    NativeCallable<T> callable,
+  ) {
+    _callables.add(callable..keepIsolateAlive = false);
+    return callable.nativeFunction;
   }
 
   void deallocate() {
-    _vfs.remove(_vfsPtr.ref.pAppData.address);
+    for (final callable in _callables) {
+      callable.close();
+    }
+    if (_proxy case final proxy?) {
+      vfsProxyDestroy(proxy);
+      _proxyPort!.close();
+    }
     ffi.calloc.free(_vfsPtr);
     _name.free();
   }
 
-  static int _runVfs(
-    Pointer<sqlite3_vfs> vfs,
-    void Function(VirtualFileSystem) body,
-  ) {
-    final dartVfs = _vfs[vfs.ref.pAppData.address]!;
+  int _runVfs(void Function(VirtualFileSystem) body) {
     try {
-      body(dartVfs);
+      body(_dartVfs);
       return SqlError.SQLITE_OK;
     } on VfsException catch (e) {
       return e.returnCode;
@@ -370,76 +474,53 @@ final class _RegisteredVfs {
     }
   }
 
-  static int _xOpen(
+  int _xOpen(
     Pointer<sqlite3_vfs> vfsPtr,
     Pointer<Char> zName,
     Pointer<sqlite3_file> file,
     int flags,
     Pointer<Int> pOutFlags,
   ) {
-    return _runVfs(vfsPtr, (vfs) {
+    return _runVfs((vfs) {
       final fileName = Sqlite3Filename(
         zName.isNullPointer ? null : zName.cast<sqlite3_char>().readString(),
       );
       final dartFilePtr = file.cast<_DartFile>();
 
       final (file: dartFile, :outFlags) = vfs.xOpen(fileName, flags);
-      final fileId = _fileCounter++;
-      _files[fileId] = dartFile;
-
-      final ioMethods = ffi.calloc<sqlite3_io_methods>();
-      ioMethods.ref
-        ..iVersion = 1
-        ..xClose = Pointer.fromFunction(_xClose, SqlError.SQLITE_ERROR)
-        ..xRead = Pointer.fromFunction(_xRead, SqlError.SQLITE_ERROR)
-        ..xWrite = Pointer.fromFunction(_xWrite, SqlError.SQLITE_ERROR)
-        ..xTruncate = Pointer.fromFunction(_xTruncate, SqlError.SQLITE_ERROR)
-        ..xSync = Pointer.fromFunction(_xSync, SqlError.SQLITE_ERROR)
-        ..xFileSize = Pointer.fromFunction(_xFileSize, SqlError.SQLITE_ERROR)
-        ..xLock = Pointer.fromFunction(_xLock, SqlError.SQLITE_ERROR)
-        ..xUnlock = Pointer.fromFunction(_xUnlock, SqlError.SQLITE_ERROR)
-        ..xCheckReservedLock = Pointer.fromFunction(
-          _xCheckReservedLock,
-          SqlError.SQLITE_ERROR,
-        )
-        ..xFileControl = Pointer.fromFunction(
-          _xFileControl,
-          SqlError.SQLITE_IOERR,
-        )
-        ..xSectorSize = Pointer.fromFunction(_xSectorSize, 4096)
-        ..xDeviceCharacteristics = Pointer.fromFunction(
-          _xDeviveCharacteristics,
-          0,
-        );
+      final int fileId;
+      if (_freeFileIds.isNotEmpty) {
+        fileId = _freeFileIds.removeLast();
+        _files[fileId] = (dartFile, this);
+      } else {
+        fileId = _files.length;
+        _files.add((dartFile, this));
+      }
+      _openFiles++;
 
       if (!pOutFlags.isNullPointer) {
         pOutFlags.value = outFlags;
       }
 
       dartFilePtr.ref
-        ..pMethods = ioMethods
+        ..pMethods = _ioMethods
         ..dartFileId = fileId;
     });
   }
 
-  static int _xDelete(
-    Pointer<sqlite3_vfs> vfsPtr,
-    Pointer<Char> zName,
-    int syncDir,
-  ) {
+  int _xDelete(Pointer<sqlite3_vfs> vfsPtr, Pointer<Char> zName, int syncDir) {
     return _runVfs(
-      vfsPtr,
       (vfs) => vfs.xDelete(zName.cast<sqlite3_char>().readString(), syncDir),
     );
   }
 
-  static int _xAccess(
+  int _xAccess(
     Pointer<sqlite3_vfs> vfsPtr,
     Pointer<Char> zName,
     int flags,
     Pointer<Int> pResOut,
   ) {
-    return _runVfs(vfsPtr, (vfs) {
+    return _runVfs((vfs) {
       if (!pResOut.isNullPointer) {
         pResOut.value = vfs.xAccess(
           zName.cast<sqlite3_char>().readString(),
@@ -449,13 +530,13 @@ final class _RegisteredVfs {
     });
   }
 
-  static int _xFullPathname(
+  int _xFullPathname(
     Pointer<sqlite3_vfs> vfsPtr,
     Pointer<Char> zName,
     int nOut,
     Pointer<Char> zOut,
   ) {
-    return _runVfs(vfsPtr, (vfs) {
+    return _runVfs((vfs) {
       final bytes = utf8.encode(
         vfs.xFullPathName(zName.cast<sqlite3_char>().readString()),
       );
@@ -469,25 +550,18 @@ final class _RegisteredVfs {
     });
   }
 
-  static int _xRandomness(
-    Pointer<sqlite3_vfs> vfsPtr,
-    int nByte,
-    Pointer<Char> zOut,
-  ) {
-    return _runVfs(vfsPtr, (vfs) {
+  int _xRandomness(Pointer<sqlite3_vfs> vfsPtr, int nByte, Pointer<Char> zOut) {
+    return _runVfs((vfs) {
       vfs.xRandomness(zOut.cast<Uint8>().asTypedList(nByte));
     });
   }
 
-  static int _xSleep(Pointer<sqlite3_vfs> vfsPtr, int microseconds) {
-    return _runVfs(
-      vfsPtr,
-      (vfs) => vfs.xSleep(Duration(microseconds: microseconds)),
-    );
+  int _xSleep(Pointer<sqlite3_vfs> vfsPtr, int microseconds) {
+    return _runVfs((vfs) => vfs.xSleep(Duration(microseconds: microseconds)));
   }
 
-  static int _xCurrentTime64(Pointer<sqlite3_vfs> vfsPtr, Pointer<Int64> out) {
-    return _runVfs(vfsPtr, (vfs) {
+  int _xCurrentTime64(Pointer<sqlite3_vfs> vfsPtr, Pointer<Int64> out) {
+    return _runVfs((vfs) {
       if (!out.isNullPointer) {
         // https://github.com/sqlite/sqlite/blob/8ee75f7c3ac1456b8d941781857be27bfddb57d6/src/os_unix.c#L6757
         const unixEpoch = 24405875 * 8640000;
@@ -497,12 +571,43 @@ final class _RegisteredVfs {
     });
   }
 
+  static Pointer<sqlite3_io_methods> _allocateIoMethods() {
+    final ioMethods = ffi.calloc<sqlite3_io_methods>();
+    ioMethods.ref
+      ..iVersion = 1
+      ..xClose = Pointer.fromFunction(_xClose, SqlError.SQLITE_ERROR)
+      ..xRead = Pointer.fromFunction(_xRead, SqlError.SQLITE_ERROR)
+      ..xWrite = Pointer.fromFunction(_xWrite, SqlError.SQLITE_ERROR)
+      ..xTruncate = Pointer.fromFunction(_xTruncate, SqlError.SQLITE_ERROR)
+      ..xSync = Pointer.fromFunction(_xSync, SqlError.SQLITE_ERROR)
+      ..xFileSize = Pointer.fromFunction(_xFileSize, SqlError.SQLITE_ERROR)
+      ..xLock = Pointer.fromFunction(_xLock, SqlError.SQLITE_ERROR)
+      ..xUnlock = Pointer.fromFunction(_xUnlock, SqlError.SQLITE_ERROR)
+      ..xCheckReservedLock = Pointer.fromFunction(
+        _xCheckReservedLock,
+        SqlError.SQLITE_ERROR,
+      )
+      ..xFileControl = Pointer.fromFunction(
+        _xFileControl,
+        SqlError.SQLITE_IOERR,
+      )
+      ..xSectorSize = Pointer.fromFunction(_xSectorSize, 4096)
+      ..xDeviceCharacteristics = Pointer.fromFunction(
+        _xDeviveCharacteristics,
+        0,
+      );
+    return ioMethods;
+  }
+
+  static VirtualFileSystemFile _fileFor(Pointer<sqlite3_file> ptr) {
+    return _files[ptr.cast<_DartFile>().ref.dartFileId]!.$1;
+  }
+
   static int _runFile(
     Pointer<sqlite3_file> file,
     void Function(VirtualFileSystemFile) body,
   ) {
-    final id = file.cast<_DartFile>().ref.dartFileId;
-    final dartFile = _files[id]!;
+    final dartFile = _fileFor(file);
     try {
       body(dartFile);
       return SqlError.SQLITE_OK;
@@ -515,11 +620,15 @@ final class _RegisteredVfs {
 
   static int _xClose(Pointer<sqlite3_file> ptr) {
     return _runFile(ptr, (file) {
-      file.xClose();
-
-      final dartFile = ptr.cast<_DartFile>().ref;
-      _files.remove(dartFile.dartFileId);
-      ffi.calloc.free(dartFile.pMethods);
+      // sqlite3 considers the file closed even if this fails.
+      try {
+        file.xClose();
+      } finally {
+        final fileId = ptr.cast<_DartFile>().ref.dartFileId;
+        _files[fileId]!.$2._openFiles--;
+        _files[fileId] = null;
+        _freeFileIds.add(fileId);
+      }
     });
   }
 
@@ -587,8 +696,7 @@ final class _RegisteredVfs {
     int op,
     Pointer<Void> pArg,
   ) {
-    final id = ptr.cast<_DartFile>().ref.dartFileId;
-    final dartFile = _files[id]!;
+    final dartFile = _fileFor(ptr);
     if (dartFile is VirtualFileSystemFileV1) {
       return dartFile.xFileControl(SqliteFileControl(op), pArg.address);
     }
@@ -597,8 +705,7 @@ final class _RegisteredVfs {
   }
 
   static int _xSectorSize(Pointer<sqlite3_file> ptr) {
-    final id = ptr.cast<_DartFile>().ref.dartFileId;
-    final dartFile = _files[id]!;
+    final dartFile = _fileFor(ptr);
     if (dartFile is VirtualFileSystemFileV1) {
       return dartFile.xSectorSize;
     }
@@ -608,8 +715,7 @@ final class _RegisteredVfs {
   }
 
   static int _xDeviveCharacteristics(Pointer<sqlite3_file> ptr) {
-    final id = ptr.cast<_DartFile>().ref.dartFileId;
-    final dartFile = _files[id]!;
+    final dartFile = _fileFor(ptr);
     return dartFile.xDeviceCharacteristics;
   }
 }
@@ -1119,6 +1225,98 @@ final class FfiDatabase implements RawSqliteDatabase, Finalizable {
   RawStatementCompiler newCompiler(List<int> utf8EncodedSql) {
     return FfiStatementCompiler(this, allocateBytes(utf8EncodedSql));
   }
+
+  @override
+  SqliteResult<RawSqliteBlob> sqlite3_blob_open(
+    String database,
+    String table,
+    String column,
+    int rowId,
+    int flags,
+  ) {
+    final databasePtr = Utf8Utils.allocateZeroTerminated(database);
+    final tablePtr = Utf8Utils.allocateZeroTerminated(table);
+    final columnPtr = Utf8Utils.allocateZeroTerminated(column);
+    final outBlob = allocate<Pointer<sqlite3_blob>>();
+
+    final resultCode = libsqlite3.sqlite3_blob_open(
+      db,
+      databasePtr,
+      tablePtr,
+      columnPtr,
+      rowId,
+      flags,
+      outBlob,
+    );
+    final blob = outBlob.value;
+
+    databasePtr.free();
+    tablePtr.free();
+    columnPtr.free();
+    outBlob.free();
+
+    if (resultCode != SqlError.SQLITE_OK) {
+      // sqlite3_blob_open may return a handle even if it failed.
+      if (!blob.isNullPointer) libsqlite3.sqlite3_blob_close(blob);
+      return (resultCode: resultCode, result: null);
+    }
+
+    return (resultCode: resultCode, result: FfiBlob(blob));
+  }
+}
+
+final class FfiBlob implements RawSqliteBlob, Finalizable {
+  final Pointer<sqlite3_blob> blob;
+  final Object detachToken = Object();
+
+  FfiBlob(this.blob) {
+    blobCloseFinalizer.attach(this, blob.cast(), detach: detachToken);
+  }
+
+  @override
+  int sqlite3_blob_bytes() => libsqlite3.sqlite3_blob_bytes(blob);
+
+  @override
+  int sqlite3_blob_read(Uint8List target, int offset) {
+    // Reads may call into Dart VFS implementations, so we can't pass the Dart
+    // buffer to a leaf call and have to copy from native memory instead.
+    final buffer = allocate<Uint8>(target.length);
+    final result = libsqlite3.sqlite3_blob_read(
+      blob,
+      buffer.cast(),
+      target.length,
+      offset,
+    );
+    if (result == SqlError.SQLITE_OK) {
+      target.setAll(0, buffer.asTypedList(target.length));
+    }
+    buffer.free();
+    return result;
+  }
+
+  @override
+  int sqlite3_blob_write(Uint8List source, int offset) {
+    final buffer = allocateBytes(source);
+    final result = libsqlite3.sqlite3_blob_write(
+      blob,
+      buffer.cast(),
+      source.length,
+      offset,
+    );
+    buffer.free();
+    return result;
+  }
+
+  @override
+  int sqlite3_blob_reopen(int rowId) {
+    return libsqlite3.sqlite3_blob_reopen(blob, rowId);
+  }
+
+  @override
+  int sqlite3_blob_close() {
+    blobCloseFinalizer.detach(detachToken);
+    return libsqlite3.sqlite3_blob_close(blob);
+  }
 }
 
 final class FfiStatementCompiler implements RawStatementCompiler {
@@ -1531,6 +1729,22 @@ typedef _UpdateHook =
     );
 typedef _CommitHook = Int Function(Pointer<Void>);
 typedef _RollbackHook = Void Function(Pointer<Void>);
+typedef _VfsOpen =
+    Int Function(
+      Pointer<sqlite3_vfs>,
+      Pointer<Char>,
+      Pointer<sqlite3_file>,
+      Int,
+      Pointer<Int>,
+    );
+typedef _VfsDelete = Int Function(Pointer<sqlite3_vfs>, Pointer<Char>, Int);
+typedef _VfsAccess =
+    Int Function(Pointer<sqlite3_vfs>, Pointer<Char>, Int, Pointer<Int>);
+typedef _VfsFullPathname =
+    Int Function(Pointer<sqlite3_vfs>, Pointer<Char>, Int, Pointer<Char>);
+typedef _VfsRandomness = Int Function(Pointer<sqlite3_vfs>, Int, Pointer<Char>);
+typedef _VfsSleep = Int Function(Pointer<sqlite3_vfs>, Int);
+typedef _VfsCurrentTime64 = Int Function(Pointer<sqlite3_vfs>, Pointer<Int64>);
 
 extension on NativeCallable {
   void closeIn(_FunctionFinalizers finalizers) {
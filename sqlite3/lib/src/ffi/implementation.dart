@@ -14,6 +14,7 @@ import 'api.dart';
 import 'bindings.dart';
 import 'libsqlite3.g.dart' as libsqlite3;
 import 'memory.dart';
+import 'uring.dart' as uring;
 
 final class FfiSqlite3 extends Sqlite3Implementation implements Sqlite3 {
   const FfiSqlite3() : super(ffiBindings);
@@ -89,6 +90,26 @@ final class FfiSqlite3 extends Sqlite3Implementation implements Sqlite3 {
       yield option;
     }
   }
+
+  @override
+  void registerUringVfs({bool makeDefault = false}) {
+    final int result;
+    try {
+      result = uring.registerUringVfs(makeDefault ? 1 : 0);
+    } on ArgumentError {
+      // The native function could not be resolved.
+      throw UnsupportedError(
+        'This SQLite build does not include the io_uring VFS.',
+      );
+    }
+
+    if (result != SqlError.SQLITE_OK) {
+      throw SqliteException(
+        extendedResultCode: result,
+        message: 'Could not register the io_uring VFS',
+      );
+    }
+  }
 }
 
 class SqliteExtensionImpl implements SqliteExtension {
@@ -111,6 +111,66 @@ external int sqlite3_bind_text(
   destructor,
 );
 
+@ffi.Native<ffi.Int Function(ffi.Pointer<sqlite3_blob>)>()
+external int sqlite3_blob_bytes(ffi.Pointer<sqlite3_blob> pBlob);
+
+@ffi.Native<ffi.Int Function(ffi.Pointer<sqlite3_blob>)>()
+external int sqlite3_blob_close(ffi.Pointer<sqlite3_blob> pBlob);
+
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<sqlite3>,
+    ffi.Pointer<sqlite3_char>,
+    ffi.Pointer<sqlite3_char>,
+    ffi.Pointer<sqlite3_char>,
+    ffi.Int64,
+    ffi.Int,
+    ffi.Pointer<ffi.Pointer<sqlite3_blob>>,
+  )
+>()
+external int sqlite3_blob_open(
+  ffi.Pointer<sqlite3> db,
+  ffi.Pointer<sqlite3_char> zDb,
+  ffi.Pointer<sqlite3_char> zTable,
+  ffi.Pointer<sqlite3_char> zColumn,
+  int iRow,
+  int flags,
+  ffi.Pointer<ffi.Pointer<sqlite3_blob>> ppBlob,
+);
+
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<sqlite3_blob>,
+    ffi.Pointer<ffi.Void>,
+    ffi.Int,
+    ffi.Int,
+  )
+>()
+external int sqlite3_blob_read(
+  ffi.Pointer<sqlite3_blob> pBlob,
+  ffi.Pointer<ffi.Void> Z,
+  int N,
+  int iOffset,
+);
+
+@ffi.Native<ffi.Int Function(ffi.Pointer<sqlite3_blob>, ffi.Int64)>()
+external int sqlite3_blob_reopen(ffi.Pointer<sqlite3_blob> pBlob, int iRow);
+
+@ffi.Native<
+  ffi.Int Function(
+    ffi.Pointer<sqlite3_blob>,
+    ffi.Pointer<ffi.Void>,
+    ffi.Int,
+    ffi.Int,
+  )
+>()
+external int sqlite3_blob_write(
+  ffi.Pointer<sqlite3_blob> pBlob,
+  ffi.Pointer<ffi.Void> z,
+  int n,
+  int iOffset,
+);
+
 @ffi.Native<
   ffi.Int Function(
     ffi.Pointer<sqlite3>,
@@ -972,6 +1032,50 @@ class _SymbolAddresses {
     >
   >
   get sqlite3_bind_text => ffi.Native.addressOf(self.sqlite3_bind_text);
+  ffi.Pointer<ffi.NativeFunction<ffi.Int Function(ffi.Pointer<sqlite3_blob>)>>
+  get sqlite3_blob_bytes => ffi.Native.addressOf(self.sqlite3_blob_bytes);
+  ffi.Pointer<ffi.NativeFunction<ffi.Int Function(ffi.Pointer<sqlite3_blob>)>>
+  get sqlite3_blob_close => ffi.Native.addressOf(self.sqlite3_blob_close);
+  ffi.Pointer<
+    ffi.NativeFunction<
+      ffi.Int Function(
+        ffi.Pointer<sqlite3>,
+        ffi.Pointer<sqlite3_char>,
+        ffi.Pointer<sqlite3_char>,
+        ffi.Pointer<sqlite3_char>,
+        ffi.Int64,
+        ffi.Int,
+        ffi.Pointer<ffi.Pointer<sqlite3_blob>>,
+      )
+    >
+  >
+  get sqlite3_blob_open => ffi.Native.addressOf(self.sqlite3_blob_open);
+  ffi.Pointer<
+    ffi.NativeFunction<
+      ffi.Int Function(
+        ffi.Pointer<sqlite3_blob>,
+        ffi.Pointer<ffi.Void>,
+        ffi.Int,
+        ffi.Int,
+      )
+    >
+  >
+  get sqlite3_blob_read => ffi.Native.addressOf(self.sqlite3_blob_read);
+  ffi.Pointer<
+    ffi.NativeFunction<ffi.Int Function(ffi.Pointer<sqlite3_blob>, ffi.Int64)>
+  >
+  get sqlite3_blob_reopen => ffi.Native.addressOf(self.sqlite3_blob_reopen);
+  ffi.Pointer<
+    ffi.NativeFunction<
+      ffi.Int Function(
+        ffi.Pointer<sqlite3_blob>,
+        ffi.Pointer<ffi.Void>,
+        ffi.Int,
+        ffi.Int,
+      )
+    >
+  >
+  get sqlite3_blob_write => ffi.Native.addressOf(self.sqlite3_blob_write);
   ffi.Pointer<
     ffi.NativeFunction<
       ffi.Int Function(
@@ -1559,6 +1663,8 @@ final class sqlite3_api_routines extends ffi.Opaque {}
 
 final class sqlite3_backup extends ffi.Opaque {}
 
+final class sqlite3_blob extends ffi.Opaque {}
+
 final class sqlite3_changeset_iter extends ffi.Opaque {}
 
 final class sqlite3_char extends ffi.Opaque {}
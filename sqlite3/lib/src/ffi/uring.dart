@@ -0,0 +1,11 @@
+@DefaultAsset('package:sqlite3/src/ffi/libsqlite3.g.dart')
+library;
+
+import 'dart:ffi';
+
+/// Registers the `unix-uring` VFS from `assets/uring_vfs.c`.
+///
+/// This symbol is only available when SQLite has been compiled with the
+/// `uring_vfs` user define.
+@Native<Int Function(Int)>(symbol: 'dart_sqlite3_uring_vfs_register')
+external int registerUringVfs(int makeDefault);
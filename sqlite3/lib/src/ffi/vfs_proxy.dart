@@ -0,0 +1,31 @@
+@DefaultAsset('package:sqlite3/src/ffi/libsqlite3.g.dart')
+library;
+
+import 'dart:ffi';
+
+import 'libsqlite3.g.dart';
+
+/// Creates a VFS from `assets/dart_vfs_proxy.c` forwarding calls to [real].
+///
+/// Calls made while the current isolate isn't active are posted to [port] and
+/// must be passed to [vfsProxyRun] by its handler. [dartApi] is the result of
+/// [NativeApi.initializeApiDLData].
+///
+/// These symbols are only available when SQLite has been compiled by the build
+/// hook of this package.
+@Native<
+  Pointer<sqlite3_vfs> Function(Pointer<sqlite3_vfs>, Pointer<Void>, Int64)
+>(symbol: 'dart_sqlite3_vfs_proxy_create')
+external Pointer<sqlite3_vfs> vfsProxyCreate(
+  Pointer<sqlite3_vfs> real,
+  Pointer<Void> dartApi,
+  int port,
+);
+
+@Native<Void Function(Pointer<sqlite3_vfs>)>(
+  symbol: 'dart_sqlite3_vfs_proxy_destroy',
+)
+external void vfsProxyDestroy(Pointer<sqlite3_vfs> proxy);
+
+@Native<Void Function(Pointer<Void>)>(symbol: 'dart_sqlite3_vfs_proxy_run')
+external void vfsProxyRun(Pointer<Void> call);
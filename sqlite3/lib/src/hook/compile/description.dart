@@ -68,6 +68,9 @@ sealed class SqliteBinary {
           additionalLibraries:
               (userDefines['additional_libraries'] as List?)?.cast() ??
               const [],
+          uringVfs:
+              userDefines['uring_vfs'] == true &&
+              input.config.code.targetOS == OS.linux,
         );
       default:
         throw ArgumentError.value(
@@ -330,6 +333,11 @@ final class CompileSqlite implements SqliteBinary {
   /// Additional libraries to link.
   final List<String> additionalLibraries;
 
+  /// Whether to compile `assets/uring_vfs.c` into the library.
+  ///
+  /// This is only supported on Linux.
+  final bool uringVfs;
+
   CompileSqlite({
     required this.sourceFile,
     required this.defines,
@@ -337,6 +345,7 @@ final class CompileSqlite implements SqliteBinary {
     required this.additionalFlags,
     required this.additionalLibraryDirectories,
     required this.additionalLibraries,
+    this.uringVfs = false,
   });
 }
 
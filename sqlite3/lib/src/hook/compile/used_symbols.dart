@@ -17,6 +17,12 @@ const usedSqliteSymbols = {
   'sqlite3_bind_parameter_count',
   'sqlite3_bind_parameter_index',
   'sqlite3_bind_text',
+  'sqlite3_blob_bytes',
+  'sqlite3_blob_close',
+  'sqlite3_blob_open',
+  'sqlite3_blob_read',
+  'sqlite3_blob_reopen',
+  'sqlite3_blob_write',
   'sqlite3_busy_handler',
   'sqlite3_changes',
   'sqlite3_close_v2',
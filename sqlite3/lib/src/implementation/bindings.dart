@@ -243,6 +243,41 @@ abstract interface class RawSqliteDatabase {
 
   int sqlite3_db_config(int op, int value);
   int sqlite3_get_autocommit();
+
+  // int sqlite3_blob_open(
+  //   sqlite3*,
+  //   const char *zDb,
+  //   const char *zTable,
+  //   const char *zColumn,
+  //   sqlite3_int64 iRow,
+  //   int flags,
+  //   sqlite3_blob **ppBlob
+  // );
+  SqliteResult<RawSqliteBlob> sqlite3_blob_open(
+    String database,
+    String table,
+    String column,
+    int rowId,
+    int flags,
+  );
+}
+
+/// A `sqlite3_blob` instance.
+///
+/// Implementations should use finalizers to automatically call
+/// `sqlite3_blob_close` even when [sqlite3_blob_close] is not called
+/// explicitly.
+abstract interface class RawSqliteBlob {
+  int sqlite3_blob_bytes();
+
+  /// Reads `target.length` bytes starting at [offset] into [target].
+  int sqlite3_blob_read(Uint8List target, int offset);
+
+  /// Writes all of [source] into the blob, starting at [offset].
+  int sqlite3_blob_write(Uint8List source, int offset);
+
+  int sqlite3_blob_reopen(int rowId);
+  int sqlite3_blob_close();
 }
 
 /// A stateful wrapper around multiple `sqlite3_prepare` invocations.
@@ -0,0 +1,195 @@
+import 'dart:async';
+import 'dart:math';
+import 'dart:typed_data';
+
+import '../blob.dart';
+import '../constants.dart';
+import 'bindings.dart';
+import 'database.dart';
+import 'exception.dart';
+
+final class BlobHandleImplementation implements BlobHandle {
+  final DatabaseImplementation database;
+  // Note: Implementations of this have platform-specific finalizers on them.
+  final RawSqliteBlob blob;
+
+  int _rowId;
+  int _length;
+  bool _closed = false;
+
+  BlobHandleImplementation(this.database, this.blob, this._rowId)
+    : _length = blob.sqlite3_blob_bytes();
+
+  static BlobHandleImplementation open(
+    DatabaseImplementation db, {
+    required String database,
+    required String table,
+    required String column,
+    required int rowId,
+    required bool writable,
+  }) {
+    final (:result, :resultCode) = db.database.sqlite3_blob_open(
+      database,
+      table,
+      column,
+      rowId,
+      writable ? 1 : 0,
+    );
+
+    if (resultCode != SqlError.SQLITE_OK) {
+      throwException(db, resultCode, operation: 'opening blob');
+    }
+
+    return BlobHandleImplementation(db, result!, rowId);
+  }
+
+  void _ensureUsable() {
+    if (_closed) {
+      throw StateError('This blob handle has already been closed');
+    }
+    if (database.isClosed) {
+      throw StateError('The database of this blob has already been closed');
+    }
+  }
+
+  @override
+  int get rowId => _rowId;
+
+  @override
+  int get length => _length;
+
+  @override
+  void read(Uint8List target, int offset) {
+    _ensureUsable();
+    RangeError.checkValidRange(offset, offset + target.length, _length);
+    if (target.isEmpty) return;
+
+    final result = blob.sqlite3_blob_read(target, offset);
+    if (result != SqlError.SQLITE_OK) {
+      throwException(database, result, operation: 'reading blob');
+    }
+  }
+
+  @override
+  void write(Uint8List source, int offset) {
+    _ensureUsable();
+    RangeError.checkValidRange(offset, offset + source.length, _length);
+    if (source.isEmpty) return;
+
+    final result = blob.sqlite3_blob_write(source, offset);
+    if (result != SqlError.SQLITE_OK) {
+      throwException(database, result, operation: 'writing blob');
+    }
+  }
+
+  @override
+  void reopen(int rowId) {
+    _ensureUsable();
+    final result = blob.sqlite3_blob_reopen(rowId);
+    if (result != SqlError.SQLITE_OK) {
+      _length = 0;
+      throwException(database, result, operation: 'reopening blob');
+    }
+
+    _rowId = rowId;
+    _length = blob.sqlite3_blob_bytes();
+  }
+
+  @override
+  Stream<Uint8List> openRead({
+    int start = 0,
+    int? end,
+    int chunkSize = BlobHandle.defaultChunkSize,
+  }) async* {
+    end = RangeError.checkValidRange(start, end, _length);
+    RangeError.checkValueInInterval(chunkSize, 1, 1 << 30, 'chunkSize');
+
+    for (var offset = start; offset < end; offset += chunkSize) {
+      final chunk = Uint8List(min(chunkSize, end - offset));
+      read(chunk, offset);
+      yield chunk;
+    }
+  }
+
+  @override
+  StreamSink<List<int>> openWrite({int start = 0}) {
+    RangeError.checkValueInInterval(start, 0, _length, 'start');
+    return _BlobSink(this, start);
+  }
+
+  @override
+  void close() {
+    if (!_closed) {
+      _closed = true;
+      blob.sqlite3_blob_close();
+    }
+  }
+}
+
+final class _BlobSink implements StreamSink<List<int>> {
+  final BlobHandleImplementation _blob;
+  final Completer<void> _done = Completer();
+  int _offset;
+
+  bool _isClosed = false;
+  bool _isBound = false;
+
+  _BlobSink(this._blob, this._offset);
+
+  void _checkCanAdd() {
+    if (_isClosed) {
+      throw StateError('Cannot add to a closed sink');
+    }
+    if (_isBound) {
+      throw StateError('Cannot add to a sink while adding a stream');
+    }
+  }
+
+  void _write(List<int> data) {
+    final bytes = data is Uint8List ? data : Uint8List.fromList(data);
+    _blob.write(bytes, _offset);
+    _offset += bytes.length;
+  }
+
+  @override
+  void add(List<int> data) {
+    _checkCanAdd();
+    _write(data);
+  }
+
+  @override
+  void addError(Object error, [StackTrace? stackTrace]) {
+    _checkCanAdd();
+    _isClosed = true;
+    _done.completeError(error, stackTrace);
+  }
+
+  @override
+  Future<void> addStream(Stream<List<int>> stream) async {
+    _checkCanAdd();
+    _isBound = true;
+    try {
+      await for (final chunk in stream) {
+        _write(chunk);
+      }
+    } finally {
+      _isBound = false;
+    }
+  }
+
+  @override
+  Future<void> close() {
+    if (_isBound) {
+      throw StateError('Cannot close a sink while adding a stream');
+    }
+    if (!_isClosed) {
+      _isClosed = true;
+      _done.complete();
+    }
+
+    return done;
+  }
+
+  @override
+  Future<void> get done => _done.future;
+}
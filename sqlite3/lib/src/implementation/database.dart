@@ -5,6 +5,7 @@ import 'dart:typed_data';
 
 import 'package:meta/meta.dart';
 
+import '../blob.dart';
 import '../constants.dart';
 import '../database.dart';
 import '../exception.dart';
@@ -12,6 +13,7 @@ import '../functions.dart';
 import '../result_set.dart';
 import '../statement.dart';
 import 'bindings.dart';
+import 'blob.dart';
 import 'exception.dart';
 import 'statement.dart';
 import 'utils.dart';
@@ -247,6 +249,25 @@ base class DatabaseImplementation implements CommonDatabase {
     }
   }
 
+  @override
+  BlobHandle openBlob({
+    required String table,
+    required String column,
+    required int rowId,
+    String database = 'main',
+    bool writable = false,
+  }) {
+    _ensureOpen();
+    return BlobHandleImplementation.open(
+      this,
+      database: database,
+      table: table,
+      column: column,
+      rowId: rowId,
+      writable: writable,
+    );
+  }
+
   @override
   void dispose() {
     return close();
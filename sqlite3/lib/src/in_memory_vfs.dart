@@ -1,3 +1,4 @@
+import 'dart:collection';
 import 'dart:math';
 import 'dart:typed_data';
 
@@ -14,20 +15,67 @@ import 'utils.dart';
 /// asynchronous storage APIs like IndexedDb. It can also serve as an example on
 /// how to write custom file systems to be used with sqlite3.
 ///
+/// Files are stored as [MemoryFile]s, which can be snapshotted cheaply. Use
+/// [clone] to copy the entire file system, e.g. to run tests against a copy of
+/// a prepared database or to back up a database while it's being written to.
+///
 /// {@category common}
 final class InMemoryFileSystem extends BaseVirtualFileSystem {
-  final Map<String, Uint8Buffer?> fileData = {};
+  /// All files in this file system, keyed by their path.
+  final Map<String, MemoryFile> files = {};
+
+  /// The [MemoryFile.chunkSize] of files created by sqlite3.
+  final int chunkSize;
+
+  InMemoryFileSystem({
+    super.name = 'dart-memory',
+    super.random,
+    this.chunkSize = MemoryFile.defaultChunkSize,
+  }) : assert(chunkSize > 0);
 
-  InMemoryFileSystem({super.name = 'dart-memory', super.random});
+  /// A view of [files] as contiguous buffers.
+  ///
+  /// Reading an entry moves the contents of the file into a contiguous buffer,
+  /// which is then returned without copying. Like in earlier versions of this
+  /// package, changes to the returned buffer are visible to the file system
+  /// and vice versa. Writing an entry stores the buffer itself.
+  ///
+  /// Files accessed through this map keep using their buffer until they're
+  /// replaced, so they can't share chunks with snapshots.
+  @Deprecated('Use files instead')
+  Map<String, Uint8Buffer?> get fileData => _FileDataView(this);
+
+  /// Returns a copy-on-write snapshot of the file at [path], or `null` if it
+  /// doesn't exist.
+  ///
+  /// See [MemoryFile.snapshot] for details.
+  MemoryFile? snapshot(String path) => files[path]?.snapshot();
+
+  /// Creates a new file system with the given [name] and snapshots of all
+  /// files in this file system.
+  ///
+  /// The clone shares the contents of files until either file system writes to
+  /// them, so cloning is cheap regardless of the size of files. As the clone
+  /// includes journals, cloning a database while a write transaction is active
+  /// yields a copy that sqlite3 recovers like after a crash.
+  InMemoryFileSystem clone({required String name, Random? random}) {
+    final clone = InMemoryFileSystem(
+      name: name,
+      random: random,
+      chunkSize: chunkSize,
+    );
+    files.forEach((path, file) => clone.files[path] = file.snapshot());
+    return clone;
+  }
 
   @override
   int xAccess(String path, int flags) {
-    return fileData.containsKey(path) ? 1 : 0;
+    return files.containsKey(path) ? 1 : 0;
   }
 
   @override
   void xDelete(String path, int syncDir) {
-    fileData.remove(path);
+    files.remove(path);
   }
 
   @override
@@ -38,11 +86,11 @@ final class InMemoryFileSystem extends BaseVirtualFileSystem {
   @override
   XOpenResult xOpen(Sqlite3Filename path, int flags) {
     final pathStr = path.path ?? random.randomFileName(prefix: '/');
-    if (!fileData.containsKey(pathStr)) {
+    if (!files.containsKey(pathStr)) {
       final create = flags & SqlFlag.SQLITE_OPEN_CREATE;
 
       if (create != 0) {
-        fileData[pathStr] = Uint8Buffer();
+        files[pathStr] = MemoryFile(chunkSize: chunkSize);
       } else {
         throw VfsException(SqlError.SQLITE_CANTOPEN);
       }
@@ -60,6 +108,247 @@ final class InMemoryFileSystem extends BaseVirtualFileSystem {
 
   @override
   void xSleep(Duration duration) {}
+
+  MemoryFile _fileForWrite(String path) {
+    return files[path] ??= MemoryFile(chunkSize: chunkSize);
+  }
+}
+
+/// The contents of a file in an [InMemoryFileSystem].
+///
+/// Contents are stored in chunks of [chunkSize] bytes, so growing a file never
+/// copies existing data. Chunks that have never been written to are not
+/// allocated and read as zeroes.
+///
+/// {@category common}
+final class MemoryFile {
+  /// The default [chunkSize], a multiple of common SQLite page sizes.
+  static const defaultChunkSize = 16 * 1024;
+
+  /// The size of chunks storing the contents of this file.
+  final int chunkSize;
+
+  /// Chunks of this file, with `null` entries for holes.
+  final List<Uint8List?> _chunks;
+
+  /// For each chunk in [_chunks], whether it's exclusively used by this file.
+  ///
+  /// Chunks shared with snapshots are copied before being written to.
+  final List<bool> _owned;
+
+  var _length = 0;
+
+  /// The contents of this file once it has been accessed through
+  /// [InMemoryFileSystem.fileData], in which case [_chunks] are unused.
+  Uint8Buffer? _buffer;
+
+  MemoryFile({this.chunkSize = defaultChunkSize})
+    : assert(chunkSize > 0),
+      _chunks = [],
+      _owned = [];
+
+  MemoryFile._fromBuffer(Uint8Buffer buffer, {required this.chunkSize})
+    : _chunks = [],
+      _owned = [],
+      _buffer = buffer;
+
+  /// Creates a file with a copy of [bytes] as its contents.
+  factory MemoryFile.fromBytes(
+    List<int> bytes, {
+    int chunkSize = defaultChunkSize,
+  }) {
+    return MemoryFile(chunkSize: chunkSize)
+      ..write(
+        bytes is Uint8List ? bytes : Uint8List.fromList(bytes),
+        0,
+      );
+  }
+
+  MemoryFile._snapshot(MemoryFile source)
+    : chunkSize = source.chunkSize,
+      _chunks = source._chunks.toList(),
+      _owned = List.filled(source._chunks.length, false, growable: true),
+      _length = source._length;
+
+  /// The length of this file, in bytes.
+  int get length => _buffer?.length ?? _length;
+
+  /// Truncates or extends this file to [length] bytes.
+  ///
+  /// Extending a file is a constant-time operation, the new region reads as
+  /// zeroes.
+  set length(int length) {
+    RangeError.checkNotNegative(length, 'length');
+    if (_buffer case final buffer?) {
+      buffer.length = length;
+      return;
+    }
+
+    if (length < _length) {
+      final usedChunks = (length + chunkSize - 1) ~/ chunkSize;
+      if (usedChunks < _chunks.length) {
+        _chunks.length = usedChunks;
+        _owned.length = usedChunks;
+      }
+
+      // Clear the tail of the last chunk so that extending the file again
+      // reads zeroes.
+      final tail = length % chunkSize;
+      if (tail != 0 &&
+          usedChunks <= _chunks.length &&
+          _chunks[usedChunks - 1] != null) {
+        _writableChunk(usedChunks - 1).fillRange(tail, chunkSize, 0);
+      }
+    }
+
+    _length = length;
+  }
+
+  /// Reads bytes starting at [offset] into [target] and returns the amount of
+  /// bytes read.
+  ///
+  /// Fewer than `target.length` bytes are read if the file ends before.
+  int read(Uint8List target, int offset) {
+    if (_buffer case final buffer?) {
+      if (offset >= buffer.length) return 0;
+
+      final available = min(target.length, buffer.length - offset);
+      target.setAll(0, buffer.buffer.asUint8List(offset, available));
+      return available;
+    }
+
+    if (offset >= _length) return 0;
+
+    final available = min(target.length, _length - offset);
+    var position = 0;
+    while (position < available) {
+      final fileOffset = offset + position;
+      final index = fileOffset ~/ chunkSize;
+      final inChunk = fileOffset % chunkSize;
+      final end = min(available, position + chunkSize - inChunk);
+
+      final chunk = index < _chunks.length ? _chunks[index] : null;
+      if (chunk == null) {
+        target.fillRange(position, end, 0);
+      } else {
+        target.setRange(position, end, chunk, inChunk);
+      }
+
+      position = end;
+    }
+
+    return available;
+  }
+
+  /// Writes [source] at [offset], extending the file if necessary.
+  void write(Uint8List source, int offset) {
+    RangeError.checkNotNegative(offset, 'offset');
+    if (_buffer case final buffer?) {
+      final end = offset + source.length;
+      if (end > buffer.length) {
+        buffer.length = end;
+      }
+      buffer.setRange(offset, end, source);
+      return;
+    }
+
+    var position = 0;
+    while (position < source.length) {
+      final fileOffset = offset + position;
+      final index = fileOffset ~/ chunkSize;
+      final inChunk = fileOffset % chunkSize;
+      final end = min(source.length, position + chunkSize - inChunk);
+
+      _writableChunk(
+        index,
+      ).setRange(inChunk, inChunk + end - position, source, position);
+      position = end;
+    }
+
+    _length = max(_length, offset + source.length);
+  }
+
+  /// Returns a copy of the contents of this file.
+  Uint8List toBytes() {
+    final bytes = Uint8List(length);
+    read(bytes, 0);
+    return bytes;
+  }
+
+  /// Returns a copy of this file.
+  ///
+  /// Snapshots share chunks with the file they've been created from. Chunks
+  /// are only copied once either file writes to them, so taking a snapshot is
+  /// cheap regardless of the size of the file.
+  MemoryFile snapshot() {
+    if (_buffer != null) {
+      return MemoryFile.fromBytes(toBytes(), chunkSize: chunkSize);
+    }
+
+    // Chunks are now shared, so this file must copy them before writing too.
+    _owned.fillRange(0, _owned.length, false);
+    return MemoryFile._snapshot(this);
+  }
+
+  /// Moves the contents of this file into a contiguous buffer for
+  /// [InMemoryFileSystem.fileData].
+  Uint8Buffer _asBuffer() {
+    if (_buffer case final buffer?) {
+      return buffer;
+    }
+
+    final buffer = Uint8Buffer(_length);
+    read(buffer.buffer.asUint8List(0, _length), 0);
+    _chunks.clear();
+    _owned.clear();
+    _length = 0;
+    return _buffer = buffer;
+  }
+
+  Uint8List _writableChunk(int index) {
+    if (index >= _chunks.length) {
+      _chunks.length = index + 1;
+      _owned.addAll(Iterable.generate(index + 1 - _owned.length, (_) => false));
+    }
+
+    if (_chunks[index] case final chunk? when _owned[index]) {
+      return chunk;
+    }
+
+    final chunk = switch (_chunks[index]) {
+      null => Uint8List(chunkSize),
+      final shared => Uint8List.fromList(shared),
+    };
+    _chunks[index] = chunk;
+    _owned[index] = true;
+    return chunk;
+  }
+}
+
+final class _FileDataView extends MapBase<String, Uint8Buffer?> {
+  final InMemoryFileSystem _fs;
+
+  _FileDataView(this._fs);
+
+  @override
+  Iterable<String> get keys => _fs.files.keys;
+
+  @override
+  Uint8Buffer? operator [](Object? key) => _fs.files[key]?._asBuffer();
+
+  @override
+  void operator []=(String key, Uint8Buffer? value) {
+    _fs.files[key] = MemoryFile._fromBuffer(
+      value ?? Uint8Buffer(),
+      chunkSize: _fs.chunkSize,
+    );
+  }
+
+  @override
+  void clear() => _fs.files.clear();
+
+  @override
+  Uint8Buffer? remove(Object? key) => _fs.files.remove(key)?._asBuffer();
 }
 
 class _InMemoryFile extends BaseVfsFile {
@@ -73,13 +362,7 @@ class _InMemoryFile extends BaseVfsFile {
 
   @override
   int readInto(Uint8List buffer, int offset) {
-    final file = vfs.fileData[path];
-    if (file == null || file.length <= offset) return 0;
-
-    final available = min(buffer.length, file.length - offset);
-    final list = file.buffer.asUint8List(0, file.length);
-    buffer.setRange(0, available, list, offset);
-    return available;
+    return vfs.files[path]?.read(buffer, offset) ?? 0;
   }
 
   @override
@@ -96,7 +379,7 @@ class _InMemoryFile extends BaseVfsFile {
 
   @override
   int xFileSize() {
-    return vfs.fileData[path]!.length;
+    return vfs.files[path]!.length;
   }
 
   @override
@@ -109,14 +392,7 @@ class _InMemoryFile extends BaseVfsFile {
 
   @override
   void xTruncate(int size) {
-    final file = vfs.fileData[path];
-
-    if (file == null) {
-      vfs.fileData[path] = Uint8Buffer();
-      vfs.fileData[path]!.length = size;
-    } else {
-      file.length = size;
-    }
+    vfs._fileForWrite(path).length = size;
   }
 
   @override
@@ -126,17 +402,6 @@ class _InMemoryFile extends BaseVfsFile {
 
   @override
   void xWrite(Uint8List buffer, int fileOffset) {
-    var file = vfs.fileData[path];
-
-    if (file == null) {
-      file = Uint8Buffer();
-      vfs.fileData[path] = file;
-    }
-
-    var endIndex = fileOffset + buffer.length;
-    if (endIndex > file.length) {
-      file.length = endIndex;
-    }
-    file.setRange(fileOffset, endIndex, buffer);
+    vfs._fileForWrite(path).write(buffer, fileOffset);
   }
 }
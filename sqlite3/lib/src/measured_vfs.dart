@@ -0,0 +1,551 @@
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'constants.dart';
+import 'vfs.dart';
+
+/// A [VirtualFileSystem] wrapping another file system to record how often
+/// its methods are called, how many bytes are transferred and how long calls
+/// take.
+///
+/// Statistics are grouped by [VfsFileKind] and [VfsOperation]. Use
+/// [statistics] to obtain a snapshot of the statistics collected so far:
+///
+/// ```dart
+/// final measured = MeasuredFileSystem(fileSystem);
+/// sqlite3.registerVirtualFileSystem(measured);
+///
+/// // Use databases opened with `vfs: measured.name`, then
+/// print(measured.statistics);
+/// ```
+///
+/// Counts and transferred bytes are always recorded exactly. Measuring the
+/// latency of operations requires reading a clock twice per call, which can be
+/// noticeable for fast file systems. With [latencySampleInterval], only every
+/// n-th call is timed.
+///
+/// {@category common}
+final class MeasuredFileSystem extends VirtualFileSystem {
+  /// The file system receiving calls from sqlite3 after they've been recorded.
+  final VirtualFileSystem inner;
+
+  /// Only every [latencySampleInterval]-th operation is timed. Defaults to `1`,
+  /// timing every operation.
+  final int latencySampleInterval;
+
+  final Stopwatch _clock = Stopwatch()..start();
+  final List<_OperationCounter> _counters = List.generate(
+    VfsFileKind.values.length * VfsOperation.values.length,
+    (_) => _OperationCounter(),
+  );
+
+  /// The kind of files that exist after having been opened through this file
+  /// system, used to attribute [xAccess] and [xDelete] calls. See [_kindOf].
+  final Map<String, VfsFileKind> _knownKinds = {};
+  var _untilSample = 0;
+
+  MeasuredFileSystem(
+    this.inner, {
+    String? name,
+    this.latencySampleInterval = 1,
+  }) : assert(latencySampleInterval > 0),
+       super(name ?? 'measured-${inner.name}');
+
+  /// A snapshot of the statistics recorded so far.
+  VfsStatistics get statistics {
+    return VfsStatistics._({
+      for (final kind in VfsFileKind.values)
+        kind: {
+          for (final operation in VfsOperation.values)
+            if (_counter(kind, operation) case final counter
+                when counter.count > 0)
+              operation: counter.snapshot(),
+        },
+    });
+  }
+
+  /// Clears all statistics recorded so far.
+  void reset() {
+    for (final counter in _counters) {
+      counter.reset();
+    }
+  }
+
+  _OperationCounter _counter(VfsFileKind kind, VfsOperation operation) {
+    return _counters[kind.index * VfsOperation.values.length + operation.index];
+  }
+
+  T _measure<T>(
+    VfsFileKind kind,
+    VfsOperation operation,
+    T Function() body, [
+    int bytes = 0,
+  ]) {
+    final counter = _counter(kind, operation)
+      ..count++
+      ..bytes += bytes;
+
+    final int? start;
+    if (_untilSample == 0) {
+      _untilSample = latencySampleInterval - 1;
+      start = _clock.elapsedMicroseconds;
+    } else {
+      _untilSample--;
+      start = null;
+    }
+
+    try {
+      return body();
+    } on VfsException {
+      counter.errors++;
+      rethrow;
+    } finally {
+      if (start != null) {
+        counter.addSample(_clock.elapsedMicroseconds - start);
+      }
+    }
+  }
+
+  /// Super-journals are named after the main database with `-mj` and a random
+  /// hexadecimal suffix.
+  static final _superJournal = RegExp(r'-mj[0-9A-F]+$');
+
+  VfsFileKind _kindOf(String path) {
+    if (_knownKinds[path] case final kind?) {
+      return kind;
+    }
+
+    // Files that haven't been opened yet (e.g. because sqlite3 checks whether
+    // a hot journal exists) are classified by the suffix sqlite3 appends to
+    // the database name.
+    if (path.endsWith('-journal') || _superJournal.hasMatch(path)) {
+      return VfsFileKind.journal;
+    } else if (path.endsWith('-wal')) {
+      return VfsFileKind.wal;
+    } else if (path.endsWith('-shm')) {
+      return VfsFileKind.other;
+    } else {
+      return VfsFileKind.mainDatabase;
+    }
+  }
+
+  @override
+  XOpenResult xOpen(Sqlite3Filename path, int flags) {
+    final kind = VfsFileKind.fromOpenFlags(flags);
+    final result = _measure(
+      kind,
+      VfsOperation.open,
+      () => inner.xOpen(path, flags),
+    );
+    if (path.path case final pathStr?) {
+      _knownKinds[pathStr] = kind;
+    }
+
+    return (
+      outFlags: result.outFlags,
+      file: _MeasuredFile(this, result.file, kind),
+    );
+  }
+
+  @override
+  void xDelete(String path, int syncDir) {
+    _measure(
+      _kindOf(path),
+      VfsOperation.delete,
+      () => inner.xDelete(path, syncDir),
+    );
+    // Journals are deleted after each transaction, don't keep paths that may
+    // never be used again around.
+    _knownKinds.remove(path);
+  }
+
+  @override
+  int xAccess(String path, int flags) {
+    return _measure(
+      _kindOf(path),
+      VfsOperation.access,
+      () => inner.xAccess(path, flags),
+    );
+  }
+
+  @override
+  String xFullPathName(String path) => inner.xFullPathName(path);
+
+  @override
+  void xRandomness(Uint8List target) => inner.xRandomness(target);
+
+  @override
+  void xSleep(Duration duration) => inner.xSleep(duration);
+
+  @override
+  DateTime xCurrentTime() => inner.xCurrentTime();
+}
+
+/// The kind of a file opened by sqlite3, derived from the flags passed to
+/// [VirtualFileSystem.xOpen].
+///
+/// {@category common}
+enum VfsFileKind {
+  /// A main database file.
+  mainDatabase,
+
+  /// A rollback journal or super-journal of a main database.
+  journal,
+
+  /// A write-ahead log.
+  wal,
+
+  /// Temporary databases, their journals, statement journals and transient
+  /// files.
+  temporary,
+
+  /// Files that don't fit any other kind.
+  other;
+
+  /// Determines the kind of file opened with [flags].
+  static VfsFileKind fromOpenFlags(int flags) {
+    if (flags & SqlFlag.SQLITE_OPEN_MAIN_DB != 0) {
+      return mainDatabase;
+    } else if (flags &
+            (SqlFlag.SQLITE_OPEN_MAIN_JOURNAL |
+                SqlFlag.SQLITE_OPEN_MASTER_JOURNAL) !=
+        0) {
+      return journal;
+    } else if (flags & SqlFlag.SQLITE_OPEN_WAL != 0) {
+      return wal;
+    } else if (flags &
+            (SqlFlag.SQLITE_OPEN_TEMP_DB |
+                SqlFlag.SQLITE_OPEN_TEMP_JOURNAL |
+                SqlFlag.SQLITE_OPEN_TRANSIENT_DB |
+                SqlFlag.SQLITE_OPEN_SUBJOURNAL) !=
+        0) {
+      return temporary;
+    } else {
+      return other;
+    }
+  }
+}
+
+/// Operations recorded by a [MeasuredFileSystem].
+///
+/// {@category common}
+enum VfsOperation {
+  /// [VirtualFileSystem.xOpen].
+  open,
+
+  /// [VirtualFileSystem.xDelete].
+  delete,
+
+  /// [VirtualFileSystem.xAccess].
+  access,
+
+  /// [VirtualFileSystemFile.xRead], with bytes counting the size of the
+  /// requested read.
+  read,
+
+  /// [VirtualFileSystemFile.xWrite].
+  write,
+
+  /// [VirtualFileSystemFile.xTruncate].
+  truncate,
+
+  /// [VirtualFileSystemFile.xSync].
+  sync,
+
+  /// [VirtualFileSystemFile.xFileSize].
+  fileSize,
+
+  /// [VirtualFileSystemFile.xLock].
+  lock,
+
+  /// [VirtualFileSystemFile.xUnlock].
+  unlock,
+
+  /// [VirtualFileSystemFile.xCheckReservedLock].
+  checkReservedLock,
+
+  /// [VirtualFileSystemFileV1.xFileControl].
+  fileControl,
+
+  /// [VirtualFileSystemFile.xClose].
+  close,
+}
+
+/// A snapshot of statistics collected by a [MeasuredFileSystem].
+///
+/// {@category common}
+final class VfsStatistics {
+  /// Statistics for each file kind and operation.
+  ///
+  /// Operations that haven't been called are not included.
+  final Map<VfsFileKind, Map<VfsOperation, VfsOperationStatistics>> byKind;
+
+  VfsStatistics._(this.byKind);
+
+  /// Returns statistics for [operation] on files of the given [kind], or on
+  /// all files if [kind] is `null`.
+  VfsOperationStatistics operation(
+    VfsOperation operation, {
+    VfsFileKind? kind,
+  }) {
+    final kinds = kind == null ? VfsFileKind.values : [kind];
+
+    return kinds
+        .map((kind) => byKind[kind]![operation])
+        .nonNulls
+        .fold(VfsOperationStatistics._empty, (a, b) => a._merge(b));
+  }
+
+  @override
+  String toString() {
+    final buffer = StringBuffer('VfsStatistics(');
+    byKind.forEach((kind, operations) {
+      operations.forEach((operation, stats) {
+        buffer.write('\n  ${kind.name}.${operation.name}: $stats');
+      });
+    });
+    return (buffer..write('\n)')).toString();
+  }
+}
+
+/// Statistics on calls to a single [VfsOperation].
+///
+/// {@category common}
+final class VfsOperationStatistics {
+  static final _empty = VfsOperationStatistics._(
+    0,
+    0,
+    0,
+    LatencyHistogram._(List.filled(LatencyHistogram.bucketCount, 0), 0, 0),
+  );
+
+  /// How often the operation has been called.
+  final int count;
+
+  /// How many of these calls failed with a [VfsException].
+  final int errors;
+
+  /// The amount of bytes read or written by these calls.
+  final int bytes;
+
+  /// The latency of timed calls.
+  final LatencyHistogram latency;
+
+  VfsOperationStatistics._(this.count, this.errors, this.bytes, this.latency);
+
+  VfsOperationStatistics _merge(VfsOperationStatistics other) {
+    return VfsOperationStatistics._(
+      count + other.count,
+      errors + other.errors,
+      bytes + other.bytes,
+      latency._merge(other.latency),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'count: $count, errors: $errors, bytes: $bytes, latency: $latency';
+  }
+}
+
+/// A histogram of operation latencies with power-of-two buckets.
+///
+/// Bucket `0` counts operations taking less than a microsecond. Bucket `i`
+/// counts operations taking at least `2^(i-1)` and less than `2^i`
+/// microseconds, with the last bucket also counting all slower operations.
+///
+/// {@category common}
+final class LatencyHistogram {
+  /// The amount of [buckets].
+  static const bucketCount = 32;
+
+  /// The amount of timed operations in each bucket.
+  final List<int> buckets;
+
+  /// The total time spent in timed operations, in microseconds.
+  final int _totalMicros;
+
+  /// The longest time spent in a timed operation, in microseconds.
+  final int _maxMicros;
+
+  LatencyHistogram._(List<int> buckets, this._totalMicros, this._maxMicros)
+    : buckets = List.unmodifiable(buckets);
+
+  /// The amount of timed operations.
+  int get samples => buckets.fold(0, (a, b) => a + b);
+
+  /// The total time spent in timed operations.
+  Duration get total => Duration(microseconds: _totalMicros);
+
+  /// The longest time spent in a timed operation.
+  Duration get maximum => Duration(microseconds: _maxMicros);
+
+  /// The average time spent in a timed operation.
+  Duration get mean {
+    final samples = this.samples;
+    return samples == 0
+        ? Duration.zero
+        : Duration(microseconds: _totalMicros ~/ samples);
+  }
+
+  /// Returns an upper bound for the latency of the given [percentile] (between
+  /// `0` and `1`) of timed operations.
+  Duration percentile(double percentile) {
+    RangeError.checkValueInInterval(percentile, 0, 1, 'percentile');
+    final target = (samples * percentile).ceil();
+
+    var seen = 0;
+    for (var i = 0; i < bucketCount; i++) {
+      seen += buckets[i];
+      if (seen >= target && seen > 0) {
+        return i == bucketCount - 1 ? maximum : upperBound(i);
+      }
+    }
+
+    return Duration.zero;
+  }
+
+  /// The exclusive upper bound of latencies counted in the bucket at [index].
+  static Duration upperBound(int index) {
+    return Duration(microseconds: 1 << index);
+  }
+
+  static int _bucketFor(int micros) {
+    return min(micros.bitLength, bucketCount - 1);
+  }
+
+  LatencyHistogram _merge(LatencyHistogram other) {
+    return LatencyHistogram._(
+      [for (var i = 0; i < bucketCount; i++) buckets[i] + other.buckets[i]],
+      _totalMicros + other._totalMicros,
+      max(_maxMicros, other._maxMicros),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'samples: $samples, mean: $mean, p50: ${percentile(0.5)}, '
+        'p99: ${percentile(0.99)}, max: $maximum';
+  }
+}
+
+final class _OperationCounter {
+  var count = 0;
+  var errors = 0;
+  var bytes = 0;
+  var _totalMicros = 0;
+  var _maxMicros = 0;
+  final List<int> _buckets = List.filled(LatencyHistogram.bucketCount, 0);
+
+  void addSample(int micros) {
+    _buckets[LatencyHistogram._bucketFor(micros)]++;
+    _totalMicros += micros;
+    _maxMicros = max(_maxMicros, micros);
+  }
+
+  VfsOperationStatistics snapshot() {
+    return VfsOperationStatistics._(
+      count,
+      errors,
+      bytes,
+      LatencyHistogram._(_buckets, _totalMicros, _maxMicros),
+    );
+  }
+
+  void reset() {
+    count = 0;
+    errors = 0;
+    bytes = 0;
+    _totalMicros = 0;
+    _maxMicros = 0;
+    _buckets.fillRange(0, _buckets.length, 0);
+  }
+}
+
+final class _MeasuredFile implements VirtualFileSystemFileV1 {
+  final MeasuredFileSystem _fs;
+  final VirtualFileSystemFile _inner;
+  final VfsFileKind _kind;
+
+  _MeasuredFile(this._fs, this._inner, this._kind);
+
+  @override
+  int get xDeviceCharacteristics => _inner.xDeviceCharacteristics;
+
+  @override
+  int get xSectorSize => switch (_inner) {
+    final VirtualFileSystemFileV1 v1 => v1.xSectorSize,
+    _ => 4096,
+  };
+
+  @override
+  void xClose() {
+    _fs._measure(_kind, VfsOperation.close, _inner.xClose);
+  }
+
+  @override
+  void xRead(Uint8List target, int fileOffset) {
+    _fs._measure(
+      _kind,
+      VfsOperation.read,
+      () => _inner.xRead(target, fileOffset),
+      target.length,
+    );
+  }
+
+  @override
+  void xWrite(Uint8List buffer, int fileOffset) {
+    _fs._measure(
+      _kind,
+      VfsOperation.write,
+      () => _inner.xWrite(buffer, fileOffset),
+      buffer.length,
+    );
+  }
+
+  @override
+  void xTruncate(int size) {
+    _fs._measure(_kind, VfsOperation.truncate, () => _inner.xTruncate(size));
+  }
+
+  @override
+  void xSync(int flags) {
+    _fs._measure(_kind, VfsOperation.sync, () => _inner.xSync(flags));
+  }
+
+  @override
+  int xFileSize() {
+    return _fs._measure(_kind, VfsOperation.fileSize, _inner.xFileSize);
+  }
+
+  @override
+  void xLock(int mode) {
+    _fs._measure(_kind, VfsOperation.lock, () => _inner.xLock(mode));
+  }
+
+  @override
+  void xUnlock(int mode) {
+    _fs._measure(_kind, VfsOperation.unlock, () => _inner.xUnlock(mode));
+  }
+
+  @override
+  int xCheckReservedLock() {
+    return _fs._measure(
+      _kind,
+      VfsOperation.checkReservedLock,
+      _inner.xCheckReservedLock,
+    );
+  }
+
+  @override
+  int xFileControl(SqliteFileControl op, int ptr) {
+    return switch (_inner) {
+      final VirtualFileSystemFileV1 v1 => _fs._measure(
+        _kind,
+        VfsOperation.fileControl,
+        () => v1.xFileControl(op, ptr),
+      ),
+      _ => SqlError.SQLITE_NOTFOUND,
+    };
+  }
+}
@@ -49,6 +49,17 @@ abstract interface class CommonSqlite3 {
   /// method for them (like `drift` or `sqflite_common_ffi_web`).
   /// For more information on how to implement this, see the readme of the
   /// `sqlite3` package for details.
+  ///
+  /// On native platforms, the file system is always called on the isolate that
+  /// has registered it. When SQLite has been compiled from source by the build
+  /// hook of this package (the default), databases using the file system can
+  /// also be used on other isolates (e.g. through
+  /// `package:sqlite3_connection_pool`): Their calls are posted to the
+  /// registering isolate, and block until it has handled them. So that
+  /// isolate must stay alive and keep processing events while other isolates
+  /// use the file system, and it must not wait for them synchronously.
+  /// With precompiled libraries, databases using the file system must only
+  /// be used on the registering isolate.
   void registerVirtualFileSystem(
     VirtualFileSystem vfs, {
     bool makeDefault = false,
@@ -59,6 +70,8 @@ abstract interface class CommonSqlite3 {
   ///
   /// sqlite3 is not clear about what happens when this method is called with
   /// the file system being in used. Thus, this method should be used with care.
+  /// On native platforms, this throws a [StateError] if files opened through
+  /// [vfs] are still open.
   void unregisterVirtualFileSystem(VirtualFileSystem vfs);
 }
 
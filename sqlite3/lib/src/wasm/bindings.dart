@@ -392,6 +392,94 @@ final class WasmDatabase implements RawSqliteDatabase {
       callback?.toExternalReference,
     );
   }
+
+  @override
+  SqliteResult<RawSqliteBlob> sqlite3_blob_open(
+    String database,
+    String table,
+    String column,
+    int rowId,
+    int flags,
+  ) {
+    final zDb = bindings.allocateZeroTerminated(database);
+    final zTable = bindings.allocateZeroTerminated(table);
+    final zColumn = bindings.allocateZeroTerminated(column);
+    final blobOut = bindings.malloc(WasmBindings.pointerSize);
+
+    final resultCode = bindings.sqlite3_blob_open(
+      db,
+      zDb,
+      zTable,
+      zColumn,
+      rowId,
+      flags,
+      blobOut,
+    );
+    final blob = bindings.memory.int32ValueOfPointer(blobOut);
+    bindings
+      ..free(zDb)
+      ..free(zTable)
+      ..free(zColumn)
+      ..free(blobOut);
+
+    if (resultCode != SqlError.SQLITE_OK) {
+      // sqlite3_blob_open may return a handle even if it failed.
+      if (blob != 0) bindings.sqlite3_blob_close(blob);
+      return (resultCode: resultCode, result: null);
+    }
+
+    return (resultCode: resultCode, result: WasmBlob(bindings, blob));
+  }
+}
+
+final class WasmBlob implements RawSqliteBlob {
+  final wasm.WasmBindings bindings;
+  final Pointer blob;
+  final Object detach = Object();
+
+  WasmBlob(this.bindings, this.blob) {
+    bindings.blobFinalizer?.attach(this, blob, detach: detach);
+  }
+
+  @override
+  int sqlite3_blob_bytes() => bindings.sqlite3_blob_bytes(blob);
+
+  @override
+  int sqlite3_blob_read(Uint8List target, int offset) {
+    final length = target.length;
+    final buffer = bindings.malloc(length);
+    final result = bindings.sqlite3_blob_read(blob, buffer, length, offset);
+    if (result == SqlError.SQLITE_OK) {
+      // Don't cache the buffer before the call, the memory may have grown.
+      target.setAll(0, bindings.memory.dartBuffer.asUint8List(buffer, length));
+    }
+    bindings.free(buffer);
+    return result;
+  }
+
+  @override
+  int sqlite3_blob_write(Uint8List source, int offset) {
+    final buffer = bindings.allocateBytes(source);
+    final result = bindings.sqlite3_blob_write(
+      blob,
+      buffer,
+      source.length,
+      offset,
+    );
+    bindings.free(buffer);
+    return result;
+  }
+
+  @override
+  int sqlite3_blob_reopen(int rowId) {
+    return bindings.sqlite3_blob_reopen(blob, rowId);
+  }
+
+  @override
+  int sqlite3_blob_close() {
+    bindings.blobFinalizer?.detach(detach);
+    return bindings.sqlite3_blob_close(blob);
+  }
 }
 
 final class WasmStatementCompiler implements RawStatementCompiler {
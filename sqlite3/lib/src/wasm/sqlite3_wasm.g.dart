@@ -105,6 +105,12 @@ extension type SqliteExports(JSObject raw) implements JSObject {
     Pointer /*<struct sqlite3_stmt *>*/ arg0,
     Pointer /*<struct sqlite3_char *>*/ zName,
   );
+  external JSFunction? get sqlite3_blob_bytes;
+  external JSFunction? get sqlite3_blob_close;
+  external JSFunction? get sqlite3_blob_open;
+  external JSFunction? get sqlite3_blob_read;
+  external JSFunction? get sqlite3_blob_reopen;
+  external JSFunction? get sqlite3_blob_write;
   external int sqlite3_changes(Pointer /*<struct sqlite3 *>*/ db);
   external int sqlite3_close_v2(Pointer /*<struct sqlite3 *>*/ db);
   external Pointer /*<void *>*/ sqlite3_column_blob(
@@ -8,6 +8,7 @@ import '../../../platform/web.dart';
 import '../../../vfs.dart';
 import '../../js_interop.dart';
 import '../../../utils.dart';
+import '../durability.dart';
 import 'sync_channel.dart';
 import 'worker.dart';
 
@@ -50,9 +51,33 @@ final class WasmVfs extends BaseVirtualFileSystem {
        serializer = MessageSerializer(workerOptions.communicationBuffer),
        super(name: vfsName);
 
+  /// The amount of writes copied into the data region of [serializer] that
+  /// haven't been sent to the worker yet, see [_batchWrite].
+  var _batchedWrites = 0;
+  var _batchedWriteBytes = 0;
+
+  /// The files written to by the pending batch.
+  final Set<int> _batchedFiles = {};
+
+  /// Errors of batches that have failed, by the files they've written to.
+  ///
+  /// Batches are sent before unrelated operations, which can't report the
+  /// error. So we keep it until the next `xSync` or `xClose` of the file.
+  final Map<int, int> _failedWrites = {};
+
   Res _runInWorker<Req extends Message, Res extends Message>(
     WorkerOperation<Req, Res> operation,
     Req requestData,
+  ) {
+    // Other operations reuse the data region and may depend on pending
+    // writes, so those need to reach the worker first.
+    _sendBatchedWrites();
+    return _send(operation, requestData);
+  }
+
+  Res _send<Req extends Message, Res extends Message>(
+    WorkerOperation<Req, Res> operation,
+    Req requestData,
   ) {
     serializer.write(requestData);
 
@@ -64,6 +89,59 @@ final class WasmVfs extends BaseVirtualFileSystem {
     return operation.readResponse(serializer);
   }
 
+  /// Copies a write into the data region without waiting for the worker.
+  ///
+  /// Writes are sent in bulk once the data region is full or before any other
+  /// operation, so errors writing data are reported by the next `xSync` or
+  /// `xClose` of the file.
+  void _batchWrite(int fd, Uint8List data, int offset) {
+    assert(data.length <= BatchedWrites.maxLength);
+    final size = BatchedWrites.entrySize(data.length);
+    if (_batchedWriteBytes + size > MessageSerializer.dataSize) {
+      _sendBatchedWrites();
+    }
+
+    final position = _batchedWriteBytes;
+    serializer.dataRegionView
+      ..setInt32(position, fd)
+      ..setInt32(position + 4, data.length)
+      ..setFloat64(position + 8, offset.toDouble());
+    serializer.byteView.setAll(position + BatchedWrites.headerSize, data);
+
+    _batchedWrites++;
+    _batchedWriteBytes += size;
+    _batchedFiles.add(fd);
+  }
+
+  void _sendBatchedWrites() {
+    if (_batchedWrites == 0) {
+      return;
+    }
+
+    final request = Flags(_batchedWrites, _batchedWriteBytes, 0);
+    final files = _batchedFiles.toList();
+    _batchedWrites = 0;
+    _batchedWriteBytes = 0;
+    _batchedFiles.clear();
+
+    try {
+      _send(WorkerOperation.xWriteBatch, request);
+    } on VfsException catch (e) {
+      // We don't know which write has failed, so all files in the batch
+      // report the error.
+      for (final fd in files) {
+        _failedWrites[fd] ??= e.returnCode;
+      }
+    }
+  }
+
+  /// Throws the error of a failed batch writing to [fd], if there is one.
+  void _checkBatchedWrites(int fd) {
+    if (_failedWrites.remove(fd) case final rc?) {
+      throw VfsException(rc);
+    }
+  }
+
   @override
   int xAccess(String path, int flags) {
     final res = _runInWorker(
@@ -104,6 +182,12 @@ final class WasmVfs extends BaseVirtualFileSystem {
     _runInWorker(WorkerOperation.xSleep, Flags(duration.inMilliseconds, 0, 0));
   }
 
+  /// Flushes files that have been synced by sqlite3 but not flushed yet due to
+  /// the [DurabilityPolicy] passed to [createOptions].
+  void flush() {
+    _runInWorker(WorkerOperation.flush, const EmptyMessage());
+  }
+
   void close() {
     _runInWorker(WorkerOperation.stopServer, const EmptyMessage());
   }
@@ -114,30 +198,112 @@ final class WasmVfs extends BaseVirtualFileSystem {
 
   /// Creates [WorkerOptions] that can be sent to an [VfsWorker] instance which
   /// is responsible for hosting the file system on the other end.
-  static WorkerOptions createOptions({String root = 'pkg_sqlite3_db/'}) {
+  ///
+  /// The [durability] policy controls when the worker flushes files synced by
+  /// sqlite3. Since the worker also flushes files when their lock is released,
+  /// deferred policies mostly save flushes within a transaction. Statistics
+  /// are available through [VfsWorker.flushStatistics].
+  static WorkerOptions createOptions({
+    String root = 'pkg_sqlite3_db/',
+    DurabilityPolicy durability = DurabilityPolicy.full,
+  }) {
     return WorkerOptions(
       synchronizationBuffer: RequestResponseSynchronizer.createBuffer(),
       communicationBuffer: SharedArrayBuffer(MessageSerializer.totalSize),
       root: root,
+      durability: durability,
     );
   }
 }
 
 class WasmFile extends BaseVfsFile {
+  /// How many bytes to fetch when sqlite3 reads a file sequentially.
+  static const _readAheadSize = 256 * 1024;
+
   final WasmVfs vfs;
   final int fd;
 
   int lockStatus = SqlFileLockingLevels.SQLITE_LOCK_NONE;
 
+  // Since other tabs can't access a file while we hold a lock on it, the
+  // following caches are only used while the file is locked.
+
+  /// Bytes read speculatively after a sequential read, starting at
+  /// [_readAheadOffset].
+  Uint8List? _readAhead;
+  int _readAheadOffset = 0;
+
+  /// Whether [_readAhead] extends to the end of the file.
+  bool _readAheadReachesEnd = false;
+
+  /// The end of the last read, used to detect sequential reads.
+  int _lastReadEnd = -1;
+
+  int? _knownSize;
+
   WasmFile(this.vfs, this.fd);
 
+  bool get _isLocked => lockStatus != SqlFileLockingLevels.SQLITE_LOCK_NONE;
+
   @override
   int get xDeviceCharacteristics {
     return SqlDeviceCharacteristics.SQLITE_IOCAP_UNDELETABLE_WHEN_OPEN;
   }
 
+  /// Drops cached data if writes to this file have failed, since the cache
+  /// includes them.
+  void _checkCaches() {
+    if (vfs._failedWrites.containsKey(fd)) {
+      _clearCaches();
+    }
+  }
+
   @override
   int readInto(Uint8List buffer, int offset) {
+    _checkCaches();
+    final sequential = offset == _lastReadEnd;
+    final int bytesRead;
+
+    if (_readCached(buffer, offset) case final cached?) {
+      bytesRead = cached;
+    } else if (sequential && _isLocked && buffer.length < _readAheadSize) {
+      final window = Uint8List(_readAheadSize);
+      final available = _readFromWorker(window, offset);
+
+      _readAhead = Uint8List.sublistView(window, 0, available);
+      _readAheadOffset = offset;
+      _readAheadReachesEnd = available < window.length;
+
+      bytesRead = min(available, buffer.length);
+      buffer.setRange(0, bytesRead, window);
+    } else {
+      bytesRead = _readFromWorker(buffer, offset);
+    }
+
+    _lastReadEnd = offset + bytesRead;
+    return bytesRead;
+  }
+
+  /// Serves a read from [_readAhead], returning the amount of bytes read or
+  /// `null` if the range isn't cached.
+  int? _readCached(Uint8List buffer, int offset) {
+    final cached = _readAhead;
+    if (cached == null || offset < _readAheadOffset) {
+      return null;
+    }
+
+    final start = offset - _readAheadOffset;
+    if (start + buffer.length <= cached.length ||
+        (_readAheadReachesEnd && start <= cached.length)) {
+      final bytesRead = min(buffer.length, cached.length - start);
+      buffer.setRange(0, bytesRead, cached, start);
+      return bytesRead;
+    }
+
+    return null;
+  }
+
+  int _readFromWorker(Uint8List buffer, int offset) {
     var remainingBytes = buffer.length;
     var totalBytesRead = 0;
 
@@ -168,33 +334,53 @@ class WasmFile extends BaseVfsFile {
     return totalBytesRead;
   }
 
+  void _clearCaches() {
+    _readAhead = null;
+    _knownSize = null;
+  }
+
   @override
   int xCheckReservedLock() {
     // Copying the approach from sqlite3's implementation here: We can't check
     // whether another tab has a lock on this file without racing. So, we just
     // reprot whether _we_ have a lock...
-    return lockStatus != SqlFileLockingLevels.SQLITE_LOCK_NONE ? 1 : 0;
+    return _isLocked ? 1 : 0;
   }
 
   @override
   void xClose() {
-    vfs._runInWorker(WorkerOperation.xClose, Flags(fd, 0, 0));
+    _clearCaches();
+    try {
+      vfs._runInWorker(WorkerOperation.xClose, Flags(fd, 0, 0));
+    } finally {
+      // File descriptors can be reused, so forget the error either way.
+      vfs._checkBatchedWrites(fd);
+    }
   }
 
   @override
   int xFileSize() {
+    _checkCaches();
+    if (_knownSize case final size?) {
+      return size;
+    }
+
     final response = vfs._runInWorker(
       WorkerOperation.xFileSize,
       Flags(fd, 0, 0),
     );
-    return response.flag0;
+    final size = response.flag0;
+    if (_isLocked) {
+      _knownSize = size;
+    }
+    return size;
   }
 
   @override
   void xLock(int mode) {
     // In our implementation, all locks are exclusive. So we only need to lock
     // if this file is not currently locked.
-    if (lockStatus == SqlFileLockingLevels.SQLITE_LOCK_NONE) {
+    if (!_isLocked) {
       vfs._runInWorker(WorkerOperation.xLock, Flags(fd, mode, 0));
     }
 
@@ -203,22 +389,31 @@ class WasmFile extends BaseVfsFile {
 
   @override
   void xSync(int flags) {
+    vfs._sendBatchedWrites();
+    vfs._checkBatchedWrites(fd);
     vfs._runInWorker(WorkerOperation.xSync, Flags(fd, 0, 0));
   }
 
   @override
   void xTruncate(int size) {
+    _clearCaches();
     vfs._runInWorker(WorkerOperation.xTruncate, Flags(fd, size, 0));
+
+    if (_isLocked) {
+      _knownSize = size;
+    }
   }
 
   @override
   void xUnlock(int mode) {
     // As we only have exlusive locks in OPFS, this only needs to do something
     // when sqlite3 requests to clear the lock entirely.
-    if (lockStatus != SqlFileLockingLevels.SQLITE_LOCK_NONE &&
-        mode == SqlFileLockingLevels.SQLITE_LOCK_NONE) {
+    if (_isLocked && mode == SqlFileLockingLevels.SQLITE_LOCK_NONE) {
+      _clearCaches();
       vfs._runInWorker(WorkerOperation.xUnlock, Flags(fd, mode, 0));
     }
+
+    lockStatus = mode;
   }
 
   @override
@@ -227,26 +422,47 @@ class WasmFile extends BaseVfsFile {
     var totalBytesWritten = 0;
 
     while (remainingBytes > 0) {
-      // Again, we may have to split this into multiple write calls if the
-      // buffer would otherwise overflow.
-      final bytesToWrite = min(MessageSerializer.dataSize, remainingBytes);
-
-      final subBuffer =
-          (bytesToWrite == remainingBytes && totalBytesWritten == 0)
-          ? buffer
-          : buffer.buffer.asUint8List(
-              buffer.offsetInBytes + totalBytesWritten,
-              bytesToWrite,
-            );
-      vfs.serializer.byteView.set(subBuffer, 0);
-
-      vfs._runInWorker(
-        WorkerOperation.xWrite,
-        Flags(fd, fileOffset + totalBytesWritten, bytesToWrite),
+      // Again, we may have to split this into multiple writes if the buffer
+      // would otherwise overflow.
+      final bytesToWrite = min(BatchedWrites.maxLength, remainingBytes);
+      final subBuffer = buffer.buffer.asUint8List(
+        buffer.offsetInBytes + totalBytesWritten,
+        bytesToWrite,
       );
+      vfs._batchWrite(fd, subBuffer, fileOffset + totalBytesWritten);
 
       totalBytesWritten += bytesToWrite;
       remainingBytes -= bytesToWrite;
     }
+
+    _updateCaches(buffer, fileOffset);
+  }
+
+  /// Applies a write to [_readAhead] and [_knownSize] so that they reflect
+  /// writes that haven't been sent to the worker yet.
+  void _updateCaches(Uint8List data, int offset) {
+    final end = offset + data.length;
+    if (_knownSize case final size?) {
+      _knownSize = max(size, end);
+    }
+
+    final cached = _readAhead;
+    if (cached != null) {
+      final cachedEnd = _readAheadOffset + cached.length;
+      final start = max(offset, _readAheadOffset);
+      if (start < min(end, cachedEnd)) {
+        cached.setRange(
+          start - _readAheadOffset,
+          min(end, cachedEnd) - _readAheadOffset,
+          data,
+          start - offset,
+        );
+      }
+
+      if (end > cachedEnd) {
+        // The file may have grown past the cached range.
+        _readAheadReachesEnd = false;
+      }
+    }
   }
 }
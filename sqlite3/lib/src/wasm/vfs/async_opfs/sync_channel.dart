@@ -3,7 +3,7 @@ import 'dart:typed_data';
 
 import '../../js_interop.dart';
 
-const protocolVersion = 1;
+const protocolVersion = 2;
 const asyncIdleWaitTimeMs = 150;
 const asyncIdleWaitTime = Duration(milliseconds: asyncIdleWaitTimeMs);
 
@@ -63,13 +63,8 @@ class RequestResponseSynchronizer {
     return Atomics.load(int32View, _responseIndex);
   }
 
-  String waitForRequest() {
-    return Atomics.waitWithTimeout(
-      int32View,
-      _requestIndex,
-      -1,
-      asyncIdleWaitTimeMs,
-    );
+  String waitForRequest([int timeoutMs = asyncIdleWaitTimeMs]) {
+    return Atomics.waitWithTimeout(int32View, _requestIndex, -1, timeoutMs);
   }
 
   int takeOpcode() {
@@ -86,7 +81,7 @@ class RequestResponseSynchronizer {
 }
 
 class MessageSerializer {
-  static const dataSize = 64 * 1024;
+  static const dataSize = 1024 * 1024;
   static const metaOffset = dataSize;
   static const metaSize = 2048;
   static const totalSize = metaOffset + metaSize;
@@ -95,9 +90,13 @@ class MessageSerializer {
   final ByteData dataView;
   final Uint8List byteView;
 
+  /// A view over the data region, used to encode [BatchedWrites].
+  final ByteData dataRegionView;
+
   MessageSerializer(this.buffer)
     : dataView = buffer.asByteData(metaOffset, metaSize),
-      byteView = buffer.asUint8List();
+      byteView = buffer.asUint8List(),
+      dataRegionView = buffer.asByteData(0, dataSize);
 
   void write(Message message) {
     if (message is EmptyMessage) {
@@ -157,6 +156,22 @@ class MessageSerializer {
   }
 }
 
+/// Describes how writes are packed into the data region of a
+/// [MessageSerializer] for [WorkerOperation.xWriteBatch].
+///
+/// Each write starts with a header of [headerSize] bytes: The file descriptor
+/// and the length of the write as int32 values, followed by the offset as a
+/// float64. The written bytes follow the header and are padded to a multiple
+/// of eight bytes.
+abstract final class BatchedWrites {
+  static const headerSize = 16;
+
+  /// The largest amount of bytes that can be written with a single entry.
+  static const maxLength = MessageSerializer.dataSize - headerSize;
+
+  static int entrySize(int length) => headerSize + ((length + 7) & ~7);
+}
+
 enum WorkerOperation<Req extends Message, Res extends Message> {
   xAccess<NameAndInt32Flags, Flags>(
     MessageSerializer.readNameAndFlags,
@@ -171,7 +186,10 @@ enum WorkerOperation<Req extends Message, Res extends Message> {
     MessageSerializer.readFlags,
   ),
   xRead<Flags, Flags>(MessageSerializer.readFlags, MessageSerializer.readFlags),
-  xWrite<Flags, EmptyMessage>(
+  /// Applies the writes in the data region (see [BatchedWrites]). The
+  /// request contains the amount of writes in flag0 and their total size in
+  /// flag1.
+  xWriteBatch<Flags, EmptyMessage>(
     MessageSerializer.readFlags,
     MessageSerializer.readEmpty,
   ),
@@ -203,6 +221,10 @@ enum WorkerOperation<Req extends Message, Res extends Message> {
     MessageSerializer.readFlags,
     MessageSerializer.readEmpty,
   ),
+  flush<EmptyMessage, EmptyMessage>(
+    MessageSerializer.readEmpty,
+    MessageSerializer.readEmpty,
+  ),
   stopServer<EmptyMessage, EmptyMessage>(
     MessageSerializer.readEmpty,
     MessageSerializer.readEmpty,
@@ -15,6 +15,7 @@ import '../../../constants.dart';
 import '../../../platform/web.dart';
 import '../../../vfs.dart';
 import '../../js_interop.dart';
+import '../durability.dart';
 import 'sync_channel.dart';
 
 const _workerDebugLog = bool.fromEnvironment(
@@ -38,11 +39,16 @@ extension type WorkerOptions._raw(JSObject _) implements JSObject {
   external SharedArrayBuffer get synchronizationBuffer;
   external SharedArrayBuffer get communicationBuffer;
 
+  /// The [DurabilityPolicy.flushDelay] in milliseconds, or `null` to flush on
+  /// every sync.
+  external int? get flushDelayMs;
+
   external factory WorkerOptions._({
     required int clientVersion,
     required String root,
     required SharedArrayBuffer synchronizationBuffer,
     required SharedArrayBuffer communicationBuffer,
+    required int? flushDelayMs,
   });
 
   factory WorkerOptions({
@@ -50,14 +56,23 @@ extension type WorkerOptions._raw(JSObject _) implements JSObject {
     required String root,
     required SharedArrayBuffer synchronizationBuffer,
     required SharedArrayBuffer communicationBuffer,
+    DurabilityPolicy durability = DurabilityPolicy.full,
   }) {
     return WorkerOptions._(
       clientVersion: clientVersion,
       root: root,
       synchronizationBuffer: synchronizationBuffer,
       communicationBuffer: communicationBuffer,
+      flushDelayMs: durability.flushDelay?.inMilliseconds,
     );
   }
+
+  DurabilityPolicy get durability {
+    return DurabilityPolicy.fromFlushDelay(switch (flushDelayMs) {
+      null => null,
+      final ms => Duration(milliseconds: ms),
+    });
+  }
 }
 
 class _ResolvedPath {
@@ -95,9 +110,20 @@ class VfsWorker {
   final Map<int, _OpenedFileHandle> _openFiles = {};
   final Set<_OpenedFileHandle> _implicitlyHeldLocks = {};
 
+  final DurabilityPolicy durability;
+  final FlushCounter _flushCounter = FlushCounter();
+
+  /// Files that have been synced, but not yet flushed due to [durability].
+  final Set<_OpenedFileHandle> _unflushed = {};
+  final Stopwatch _sinceFirstUnflushedSync = Stopwatch();
+
   VfsWorker._(WorkerOptions options, this.root)
     : synchronizer = RequestResponseSynchronizer(options.synchronizationBuffer),
-      messages = MessageSerializer(options.communicationBuffer);
+      messages = MessageSerializer(options.communicationBuffer),
+      durability = options.durability;
+
+  /// Statistics on how often files have been synced and flushed.
+  FlushStatistics get flushStatistics => _flushCounter.statistics;
 
   static Future<VfsWorker> create(WorkerOptions options) async {
     var root = await storageManager!.directory;
@@ -200,22 +226,29 @@ class VfsWorker {
     return Flags(bytesRead, 0, 0);
   }
 
-  Future<EmptyMessage> _xWrite(Flags req) async {
-    final file = _openFiles[req.flag0]!;
-    final offset = req.flag1;
-    final bufferLength = req.flag2;
-    assert(bufferLength <= MessageSerializer.dataSize);
+  Future<EmptyMessage> _xWriteBatch(Flags req) async {
+    final view = messages.dataRegionView;
+    var position = 0;
 
-    final syncHandle = await _openForSynchronousAccess(file);
-    final bytesWritten = syncHandle.writeDart(
-      messages.viewByteRange(0, bufferLength),
-      FileSystemReadWriteOptions(at: offset),
-    );
+    for (var i = 0; i < req.flag0; i++) {
+      final file = _openFiles[view.getInt32(position)]!;
+      final length = view.getInt32(position + 4);
+      final offset = view.getFloat64(position + 8).toInt();
+
+      final syncHandle = await _openForSynchronousAccess(file);
+      final bytesWritten = syncHandle.writeDart(
+        messages.viewByteRange(position + BatchedWrites.headerSize, length),
+        FileSystemReadWriteOptions(at: offset),
+      );
+
+      if (bytesWritten != length) {
+        throw const VfsException(SqlExtendedError.SQLITE_IOERR_WRITE);
+      }
 
-    if (bytesWritten != bufferLength) {
-      throw const VfsException(SqlExtendedError.SQLITE_IOERR_WRITE);
+      position += BatchedWrites.entrySize(length);
     }
 
+    assert(position == req.flag1);
     return const EmptyMessage();
   }
 
@@ -261,17 +294,52 @@ class VfsWorker {
 
   Future<EmptyMessage> _xSync(Flags req) async {
     final file = _openFiles[req.flag0]!;
+    _flushCounter.syncs++;
 
     // Closing a sync handle will also flush it, so we only need to call flush
     // explicitly if the file is currently opened.
     final syncHandle = file.syncHandle;
     if (!file.readonly && syncHandle != null) {
-      syncHandle.flush();
+      if (durability.flushDelay == null) {
+        _flushCounter.measure(syncHandle.flush);
+      } else {
+        if (_unflushed.isEmpty) {
+          _sinceFirstUnflushedSync
+            ..reset()
+            ..start();
+        }
+        _unflushed.add(file);
+      }
     }
 
     return const EmptyMessage();
   }
 
+  void _flushPending() {
+    for (final file in _unflushed) {
+      if (file.syncHandle case final syncHandle?) {
+        _flushCounter.measure(syncHandle.flush);
+      }
+    }
+
+    _unflushed.clear();
+    _sinceFirstUnflushedSync.stop();
+  }
+
+  /// How long to wait for a request before flushing pending files or
+  /// releasing implicit locks.
+  int _requestTimeoutMs() {
+    if (durability.flushDelay case final delay? when _unflushed.isNotEmpty) {
+      final remaining = delay - _sinceFirstUnflushedSync.elapsed;
+      // A delay of zero means that we flush once idle.
+      if (delay > Duration.zero) {
+        return remaining.inMilliseconds.clamp(0, asyncIdleWaitTimeMs);
+      }
+    }
+
+    return asyncIdleWaitTimeMs;
+  }
+
   Future<EmptyMessage> _xLock(Flags req) async {
     final file = _openFiles[req.flag0]!;
 
@@ -306,10 +374,15 @@ class VfsWorker {
 
   Future<void> start() async {
     while (!_stopped) {
-      final waitResult = synchronizer.waitForRequest();
+      final timeout = _requestTimeoutMs();
+      final waitResult = synchronizer.waitForRequest(timeout);
       if (waitResult == Atomics.timedOut) {
-        // No requests for some time, transition to idle
-        _releaseImplicitLocks();
+        // Either no requests for some time or a deferred flush is due.
+        _flushPending();
+        if (timeout == asyncIdleWaitTimeMs) {
+          // Transition to idle
+          _releaseImplicitLocks();
+        }
         continue;
       }
 
@@ -344,8 +417,8 @@ class VfsWorker {
           case WorkerOperation.xRead:
             response = await _xRead(request as Flags);
             break;
-          case WorkerOperation.xWrite:
-            response = await _xWrite(request as Flags);
+          case WorkerOperation.xWriteBatch:
+            response = await _xWriteBatch(request as Flags);
             break;
           case WorkerOperation.xClose:
             await _xClose(request as Flags);
@@ -366,9 +439,14 @@ class VfsWorker {
           case WorkerOperation.xUnlock:
             response = await _xUnlock(request as Flags);
             break;
+          case WorkerOperation.flush:
+            _flushPending();
+            response = const EmptyMessage();
+            break;
           case WorkerOperation.stopServer:
             response = const EmptyMessage();
             _stopped = true;
+            _flushPending();
             _releaseImplicitLocks();
             break;
         }
@@ -384,6 +462,12 @@ class VfsWorker {
       }
 
       synchronizer.respond(rc);
+
+      if (durability.flushDelay case final delay?
+          when delay > Duration.zero &&
+              _sinceFirstUnflushedSync.elapsed >= delay) {
+        _flushPending();
+      }
     }
   }
 
@@ -448,6 +532,8 @@ class VfsWorker {
     if (syncHandle != null) {
       _log('Closing sync handle for ${handle.debugPath}');
       handle.syncHandle = null;
+      // Closing the handle flushes it.
+      _unflushed.remove(handle);
       _implicitlyHeldLocks.remove(handle);
       handle.explicitlyLocked = false;
       syncHandle.close();
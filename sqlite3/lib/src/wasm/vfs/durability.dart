@@ -0,0 +1,113 @@
+import 'package:meta/meta.dart';
+
+/// Controls when OPFS-based file systems flush writes to persistent storage.
+///
+/// By default ([full]), files are flushed whenever sqlite3 syncs them, which
+/// happens at least once per transaction. The other policies defer flushes
+/// and tell sqlite3 that its data is durable right away, so that multiple
+/// transactions can share a single flush.
+///
+/// Deferring flushes is similar to `PRAGMA synchronous = OFF` for the time
+/// between two flushes: Writes are applied to OPFS access handles right away,
+/// but browsers only guarantee that they are persisted after a flush. In some
+/// browsers, a crashing tab or worker may lose recently committed
+/// transactions. If the browser or the operating system crashes, those may be
+/// lost as well and the database may be corrupted.
+///
+/// {@category wasm}
+final class DurabilityPolicy {
+  /// How long to wait after a sync before flushing, or `null` to flush on each
+  /// sync.
+  final Duration? flushDelay;
+
+  const DurabilityPolicy._(this.flushDelay);
+
+  /// Flushes files each time sqlite3 syncs them.
+  static const full = DurabilityPolicy._(null);
+
+  /// Flushes files once the file system is idle after a sync.
+  static const onIdle = DurabilityPolicy._(Duration.zero);
+
+  /// Flushes files at most [interval] after sqlite3 has synced them.
+  ///
+  /// An interval of [Duration.zero] is equivalent to [onIdle].
+  const DurabilityPolicy.interval(Duration interval) : flushDelay = interval;
+
+  /// Restores a policy from its [flushDelay].
+  factory DurabilityPolicy.fromFlushDelay(Duration? flushDelay) {
+    return switch (flushDelay) {
+      null => full,
+      final interval => DurabilityPolicy.interval(interval),
+    };
+  }
+
+  @override
+  int get hashCode => flushDelay.hashCode;
+
+  @override
+  bool operator ==(Object other) {
+    return other is DurabilityPolicy && other.flushDelay == flushDelay;
+  }
+
+  @override
+  String toString() {
+    return switch (flushDelay) {
+      null => 'DurabilityPolicy.full',
+      Duration.zero => 'DurabilityPolicy.onIdle',
+      final interval => 'DurabilityPolicy.interval($interval)',
+    };
+  }
+}
+
+/// Statistics on flushes issued by an OPFS-based file system, see
+/// [DurabilityPolicy].
+///
+/// {@category wasm}
+final class FlushStatistics {
+  /// How often sqlite3 has requested a file to be synced.
+  final int syncs;
+
+  /// How often a file has been flushed.
+  final int flushes;
+
+  /// The total time spent flushing files.
+  final Duration flushTime;
+
+  const FlushStatistics({
+    required this.syncs,
+    required this.flushes,
+    required this.flushTime,
+  });
+
+  @override
+  String toString() {
+    return 'FlushStatistics(syncs: $syncs, flushes: $flushes, '
+        'flushTime: $flushTime)';
+  }
+}
+
+/// Collects [FlushStatistics].
+@internal
+final class FlushCounter {
+  var syncs = 0;
+  var _flushes = 0;
+  final Stopwatch _flushTime = Stopwatch();
+
+  FlushStatistics get statistics {
+    return FlushStatistics(
+      syncs: syncs,
+      flushes: _flushes,
+      flushTime: _flushTime.elapsed,
+    );
+  }
+
+  void measure(void Function() flush) {
+    _flushes++;
+    _flushTime.start();
+    try {
+      flush();
+    } finally {
+      _flushTime.stop();
+    }
+  }
+}
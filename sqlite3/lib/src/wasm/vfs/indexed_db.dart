@@ -9,7 +9,6 @@ import 'dart:typed_data';
 
 import 'package:meta/meta.dart';
 import 'package:sqlite3/src/wasm/async.dart';
-import 'package:typed_data/typed_buffers.dart';
 import 'package:web/web.dart' as web;
 
 import '../../constants.dart';
@@ -17,24 +16,45 @@ import '../../vfs.dart';
 import '../js_interop.dart';
 import '../../in_memory_vfs.dart';
 import '../../utils.dart';
+import 'async_opfs/sync_channel.dart';
 
-// Format of the files store: `{name: <path>, length: <size>}`. See also
-// [_FileEntry], which is the actual object that we're storing in the
+// Format of the files store: `{name: <path>, length: <size>, blockSize: <n>}`.
+// See also [_FileEntry], which is the actual object that we're storing in the
 // database.
 const _filesStore = 'files';
 const _fileName = 'name';
 const _fileNameIndex = 'fileName';
 
 // Format of blocks store: Key is a (file id, offset) pair, value is a blob.
-// Each blob is 4096 bytes large. If we have a file that isn't a multiple of
-// this length, we set the "length" attribute on the file instead of storing
-// shorter blobs. This simplifies the implementation.
+// Each blob is as large as the block size of the file, which is 4096 bytes for
+// files written by older versions of this package. If we have a file that
+// isn't a multiple of this length, we set the "length" attribute on the file
+// instead of storing shorter blobs. This simplifies the implementation.
 const _blocksStore = 'blocks';
 final _storesJs = [_filesStore.toJS, _blocksStore.toJS].toJS;
 
-const _blockSize = 4096;
+const _legacyBlockSize = 4096;
 const _maxFileSize = 9007199254740992;
 
+/// The default block size for new files.
+///
+/// Older versions of this package assume that all files use blocks of
+/// [_legacyBlockSize] bytes, so we keep that by default to not break databases
+/// opened with a downgraded version. Larger block sizes are opt-in.
+const _defaultBlockSize = _legacyBlockSize;
+
+void _checkBlockSize(int blockSize) {
+  if (blockSize < 512 ||
+      blockSize > MessageSerializer.dataSize ||
+      blockSize & (blockSize - 1) != 0) {
+    throw ArgumentError.value(
+      blockSize,
+      'blockSize',
+      'Must be a power of two between 512 and ${MessageSerializer.dataSize}',
+    );
+  }
+}
+
 @JS('Blob')
 external JSFunction get _blobConstructor;
 
@@ -212,51 +232,72 @@ final class _IndexedDbTransaction {
   /// while we have an IndexedDB transaction though, as yielding can invalidate
   /// the transaction. These reads are put into [additionalReads] and must be
   /// awaited after the transaction.
-  Future<Uint8Buffer> startRead(
+  Future<(MemoryFile, int)> startRead(
     int fileId,
     List<Future<void>> additionalReads,
   ) async {
     final file = await _readFile(fileId);
-    final result = Uint8Buffer(file.length);
+    final blockSize = file.effectiveBlockSize;
+    final result = MemoryFile()..length = file.length;
+
+    // In older versions of this implementation, we sometimes generated
+    // trailing blocks. We'll just ignore them here to avoid crashing, these
+    // don't cause any damage otherwise.
+    await readBlocks(fileId, 0, file.length, additionalReads, (offset, data) {
+      final length = min(blockSize, file.length - offset);
+      result.write(data.asUint8List(0, length), offset);
+    });
+
+    return (result, blockSize);
+  }
+
+  /// Starts reading blocks of a file starting in the range from [start]
+  /// (inclusive) to [end] (exclusive), calling [onBlock] for each block.
+  ///
+  /// Missing blocks are not reported. Like in [startRead], reads of blocks
+  /// stored as [web.Blob]s are added to [additionalReads].
+  Future<void> readBlocks(
+    int fileId,
+    int start,
+    int end,
+    List<Future<void>> additionalReads,
+    void Function(int offset, ByteBuffer data) onBlock,
+  ) async {
+    if (end <= start) return;
 
     final reader = _blocks
-        .openCursor(_rangeOverFile(fileId))
+        .openCursor(
+          _rangeOverFile(
+            fileId,
+            startOffset: start,
+            endOffsetInclusive: end - 1,
+          ),
+        )
         .cursorIterator<web.IDBCursorWithValue>();
     while (await reader.moveNext()) {
       final row = reader.current;
       final key = (row.key as JSArray).toDart;
       final rowOffset = (key[1] as JSNumber).toDartInt;
-      if (rowOffset >= file.length) {
-        // In older versions of this implementation, we sometimes generated
-        // trailing blocks. We'll just ignore them here to avoid crashing, these
-        // don't cause any damage otherwise.
-        break;
-      }
-      final length = min(_blockSize, file.length - rowOffset);
-
-      void completeRead(ByteBuffer data) {
-        result.setAll(rowOffset, data.asUint8List(0, length));
-      }
 
       if (row.value.instanceof(_blobConstructor)) {
         // We can't have an async suspension in here because that would close
         // the transaction. Launch the reader now and wait for all reads later.
         additionalReads.add(
-          (row.value as web.Blob).byteBuffer().then(completeRead),
+          (row.value as web.Blob).byteBuffer().then(
+            (data) => onBlock(rowOffset, data),
+          ),
         );
       } else {
-        completeRead((row.value as JSArrayBuffer).toDart);
+        onBlock(rowOffset, (row.value as JSArrayBuffer).toDart);
       }
     }
-
-    return result;
   }
 
-  Future<int> createFile(String path) async {
+  Future<int> createFile(String path, int blockSize) async {
     _checkNotClosed();
 
     final res = await _files
-        .put(_FileEntry(name: path, length: 0))
+        .put(_FileEntry(name: path, length: 0, blockSize: blockSize))
         .complete<JSNumber>();
     return res.toDartInt;
   }
@@ -265,71 +306,69 @@ final class _IndexedDbTransaction {
     _checkNotClosed();
 
     final file = await _readFile(fileId);
+    final blockSize = file.effectiveBlockSize;
 
-    Future<void> writeBlock(int blockStart, Uint8List block) async {
-      assert(block.length == _blockSize, 'Invalid block size');
-
-      // Check if we're overriding (parts of) an existing block
-      final cursor = await _blocks
-          .openCursor(web.IDBKeyRange.only([fileId.toJS, blockStart.toJS].toJS))
-          .complete<web.IDBCursorWithValue?>();
-
-      final value = block.buffer.toJS;
-
-      if (cursor == null) {
-        // There isn't, let's write a new block
-        await _blocks
-            .put(value, [fileId.toJS, blockStart.toJS].toJS)
-            .complete<JSAny?>();
-      } else {
-        await cursor.update(value).complete<JSAny?>();
-      }
-    }
-
-    final changedOffsets = writes.replacedBlocks.keys.toList()..sort();
+    // put() replaces existing blocks, so we don't have to check whether we're
+    // overriding an existing block first.
     await Future.wait(
-      changedOffsets.map(
-        (offset) => writeBlock(offset, writes.replacedBlocks[offset]!),
-      ),
+      writes.replacedBlocks.entries.map((entry) {
+        assert(entry.value.length == blockSize, 'Invalid block size');
+        return _blocks
+            .put(entry.value.buffer.toJS, [fileId.toJS, entry.key.toJS].toJS)
+            .complete<JSAny?>();
+      }),
     );
 
     if (writes.newFileLength != file.length) {
-      final fileCursor = _files.openCursor(fileId.toJS).cursorIterator();
-      await fileCursor.moveNext();
-      // Update the file length as recorded in the database
-      await fileCursor.current
-          .update(_FileEntry(name: file.name, length: writes.newFileLength))
-          .complete();
+      await _updateLength(fileId, file, writes.newFileLength);
     }
   }
 
-  Future<void> truncate(int fileId, int length) async {
-    _checkNotClosed();
-
-    // First, let's find the size of the file
-    final file = await _readFile(fileId);
-    final fileLength = file.length;
-
-    if (fileLength > length) {
-      final endOffset = (length ~/ _blockSize) * _blockSize;
-
-      // Delete all higher blocks (those starting at or past the end offset).
-      await _blocks
-          .delete(_rangeOverFile(fileId, startOffset: endOffset))
-          .complete();
-    } else if (fileLength < length) {
-      // We don't need to do anything here, missing blocks count as zero bytes.
-    }
-
-    // Update the file length as recorded in the database
+  Future<void> _updateLength(int fileId, _FileEntry file, int length) async {
     final fileCursor = _files.openCursor(fileId.toJS).cursorIterator();
     await fileCursor.moveNext();
 
+    // Update the file length as recorded in the database
     await fileCursor.current
-        .update(_FileEntry(name: file.name, length: length))
+        .update(
+          _FileEntry(
+            name: file.name,
+            length: length,
+            blockSize: file.blockSize,
+          ),
+        )
         .complete();
   }
 
+  /// Sets the length of a file to [length], deleting blocks past its end.
+  ///
+  /// If the new end of the file is within a block, the [tail] of that block is
+  /// written as well, so that bytes past the end of the file are zeroed.
+  Future<void> truncate(int fileId, int length, {Uint8List? tail}) async {
+    _checkNotClosed();
+
+    final file = await _readFile(fileId);
+    final blockSize = file.effectiveBlockSize;
+
+    // Delete all blocks starting at or past the new end of the file.
+    final endOffset = (length + blockSize - 1) ~/ blockSize * blockSize;
+    final pending = [
+      _blocks.delete(_rangeOverFile(fileId, startOffset: endOffset)).complete(),
+      if (tail != null)
+        _blocks
+            .put(
+              tail.buffer.toJS,
+              [fileId.toJS, (endOffset - blockSize).toJS].toJS,
+            )
+            .complete(),
+    ];
+    await pending.wait;
+
+    if (file.length != length) {
+      await _updateLength(fileId, file, length);
+    }
+  }
+
   Future<void> deleteFile(int id) async {
     _checkNotClosed();
 
@@ -354,76 +393,25 @@ extension type _FileEntry._(JSObject _) implements JSObject {
   external String get name;
   external int get length;
 
-  external factory _FileEntry({required String name, required int length});
+  /// The size of blocks for this file, which is not set for files written by
+  /// older versions of this package.
+  external int? get blockSize;
+
+  external factory _FileEntry({
+    required String name,
+    required int length,
+    int? blockSize,
+  });
+
+  int get effectiveBlockSize => blockSize ?? _legacyBlockSize;
 }
 
 class _FileWriteRequest {
-  final Uint8List originalContent;
+  /// Blocks to write, keyed by their offset.
   final Map<int, Uint8List> replacedBlocks = {};
   int newFileLength;
 
-  _FileWriteRequest(this.originalContent)
-    : newFileLength = originalContent.length;
-
-  void _updateBlock(int blockOffset, int offsetInBlock, Uint8List data) {
-    final block = replacedBlocks.putIfAbsent(blockOffset, () {
-      final block = Uint8List(_blockSize);
-
-      if (originalContent.length > blockOffset) {
-        block.setAll(
-          0,
-          originalContent.buffer.asUint8List(
-            originalContent.offsetInBytes + blockOffset,
-            min(_blockSize, originalContent.length - blockOffset),
-          ),
-        );
-      }
-
-      return block;
-    });
-
-    block.setAll(offsetInBlock, data);
-  }
-
-  void addWrite(int offset, Uint8List data) {
-    var offsetInData = 0;
-    while (offsetInData < data.length) {
-      final offsetInFile = offset + offsetInData;
-      final blockStart = offsetInFile ~/ _blockSize * _blockSize;
-
-      int offsetInBlock, bytesToWrite;
-
-      if (offsetInFile % _blockSize != 0) {
-        // Write to block boundary
-        offsetInBlock = offsetInFile % _blockSize;
-        bytesToWrite = min(
-          _blockSize - offsetInBlock,
-          data.length - offsetInData,
-        );
-      } else {
-        // Write full block if possible
-        bytesToWrite = min(_blockSize, data.length - offsetInData);
-        offsetInBlock = 0;
-      }
-
-      final chunk = data.buffer.asUint8List(
-        data.offsetInBytes + offsetInData,
-        bytesToWrite,
-      );
-      offsetInData += bytesToWrite;
-
-      _updateBlock(blockStart, offsetInBlock, chunk);
-    }
-
-    newFileLength = max(newFileLength, offset + data.length);
-  }
-}
-
-class _OffsetAndBuffer {
-  final int offset;
-  final Uint8List buffer;
-
-  _OffsetAndBuffer(this.offset, this.buffer);
+  _FileWriteRequest(this.newFileLength);
 }
 
 /// A file system storing files divided into blocks in an IndexedDB database.
@@ -433,6 +421,9 @@ class _OffsetAndBuffer {
 /// after the database is changed. However you can wait for changes manually
 /// with [flush].
 ///
+/// All files are loaded into memory when the file system is opened. For large
+/// databases, consider using a [LazyIndexedDbFileSystem] instead.
+///
 /// {@category wasm}
 final class IndexedDbFileSystem extends BaseVirtualFileSystem {
   final AsynchronousIndexedDbFileSystem _asynchronous;
@@ -442,16 +433,25 @@ final class IndexedDbFileSystem extends BaseVirtualFileSystem {
 
   bool _writeAutomatically = true;
 
+  /// The size of blocks for files created by this file system.
+  final int blockSize;
+
   // A cache so that synchronous changes are visible right away
   final InMemoryFileSystem _memory;
   final LinkedList<_IndexedDbWorkItem> _pendingWork = LinkedList();
 
   final Set<String> _inMemoryOnlyFiles = {};
   final Map<String, int> _knownFileIds = {};
+  final Map<String, int> _blockSizes = {};
+
+  var _transactions = 0;
+  var _blocksWritten = 0;
+  var _bytesWritten = 0;
 
   IndexedDbFileSystem._(
     String dbName, {
     String vfsName = 'indexeddb',
+    this.blockSize = _defaultBlockSize,
     super.random,
   }) : _asynchronous = AsynchronousIndexedDbFileSystem(dbName),
        _memory = InMemoryFileSystem(random: random),
@@ -469,13 +469,29 @@ final class IndexedDbFileSystem extends BaseVirtualFileSystem {
   /// When disabled, no IndexedDB writes are scheduled by default. Instead, all
   /// writes are batched up until [flush] is called explicitly. This allows
   /// being more explicit about when to write to IndexedDB.
+  ///
+  /// Files are stored in blocks of [blockSize] bytes, which must be a power of
+  /// two. It defaults to 4096, which older versions of this package can read
+  /// as well. Using 8192, the default page size of databases, makes each page
+  /// write replace exactly one block. Since changed blocks are written as a
+  /// whole, the block size should not be larger than the page size. Existing
+  /// files keep the block size they have been created with, but files created
+  /// with a block size other than 4096 can't be read by versions of this
+  /// package before 3.6.0.
   static Future<IndexedDbFileSystem> open({
     required String dbName,
     String vfsName = 'indexeddb',
     Random? random,
     bool writeAutomatically = true,
+    int blockSize = _defaultBlockSize,
   }) async {
-    final fs = IndexedDbFileSystem._(dbName, vfsName: vfsName, random: random);
+    _checkBlockSize(blockSize);
+    final fs = IndexedDbFileSystem._(
+      dbName,
+      vfsName: vfsName,
+      blockSize: blockSize,
+      random: random,
+    );
     fs._writeAutomatically = writeAutomatically;
     await fs._asynchronous.open();
     await fs._readFiles();
@@ -512,6 +528,16 @@ final class IndexedDbFileSystem extends BaseVirtualFileSystem {
   /// To await a full close operation, call and await [close].
   bool get isClosed => _isClosing || _asynchronous._isClosed;
 
+  /// Statistics on writes made to IndexedDB since this file system has been
+  /// opened.
+  IndexedDbWriteStatistics get writeStatistics {
+    return IndexedDbWriteStatistics._(
+      transactions: _transactions,
+      blocksWritten: _blocksWritten,
+      bytesWritten: _bytesWritten,
+    );
+  }
+
   Future<void> _submitWork(_IndexedDbWorkItem work) {
     _checkClosed();
 
@@ -538,9 +564,18 @@ final class IndexedDbFileSystem extends BaseVirtualFileSystem {
 
     if (!_isWorking && _pendingWork.isNotEmpty) {
       _isWorking = true;
+      _transactions++;
       final items = _pendingWork.toList();
       _pendingWork.clear();
 
+      // Items run asynchronously, so file contents need to be captured now.
+      // Otherwise, writes made while this transaction is running could be
+      // persisted before earlier writes they depend on (e.g. database pages
+      // before the journal protecting them).
+      for (final item in items) {
+        item.prepare();
+      }
+
       await _asynchronous._performWrites(items).whenComplete(() {
         _isWorking = false;
 
@@ -594,8 +629,9 @@ final class IndexedDbFileSystem extends BaseVirtualFileSystem {
         final name = entry.key;
         final fileId = entry.value;
 
-        final data = await tx.startRead(fileId, additionalReads);
-        _memory.fileData[name] = data;
+        final (data, blockSize) = await tx.startRead(fileId, additionalReads);
+        _memory.files[name] = data;
+        _blockSizes[name] = blockSize;
       }
     });
     await additionalReads.wait;
@@ -639,7 +675,8 @@ final class IndexedDbFileSystem extends BaseVirtualFileSystem {
         // after we're done.
         _inMemoryOnlyFiles.add(pathStr);
       } else {
-        _submitWork(_CreateFileWorkItem(this, pathStr));
+        _blockSizes[pathStr] = blockSize;
+        _submitWork(_CreateFileWorkItem(this, pathStr, blockSize));
       }
     }
 
@@ -653,6 +690,46 @@ final class IndexedDbFileSystem extends BaseVirtualFileSystem {
   void xSleep(Duration duration) {
     // noop
   }
+
+  /// Returns a copy of the block at [offset] of the in-memory file at [path],
+  /// or `null` if the file has been deleted or no longer contains that block.
+  Uint8List? _currentBlock(String path, int offset) {
+    final data = _memory.files[path];
+    final blockSize = _blockSizes[path];
+    if (data == null || blockSize == null || offset >= data.length) {
+      return null;
+    }
+
+    final block = Uint8List(blockSize);
+    data.read(block, offset);
+    return block;
+  }
+}
+
+/// Counters describing writes made by an [IndexedDbFileSystem].
+///
+/// {@category wasm}
+final class IndexedDbWriteStatistics {
+  /// The amount of IndexedDB transactions used to persist changes.
+  final int transactions;
+
+  /// The amount of blocks written to IndexedDB.
+  final int blocksWritten;
+
+  /// The amount of bytes in [blocksWritten].
+  final int bytesWritten;
+
+  IndexedDbWriteStatistics._({
+    required this.transactions,
+    required this.blocksWritten,
+    required this.bytesWritten,
+  });
+
+  @override
+  String toString() {
+    return 'IndexedDbWriteStatistics(transactions: $transactions, '
+        'blocks: $blocksWritten, bytes: $bytesWritten)';
+  }
 }
 
 class _IndexedDbFile implements VirtualFileSystemFileV1 {
@@ -701,10 +778,14 @@ class _IndexedDbFile implements VirtualFileSystemFileV1 {
     memoryFile.xTruncate(size);
 
     if (!vfs._inMemoryOnlyFiles.contains(path)) {
-      vfs._submitWorkFunction(
-        (tx) async => tx.truncate(await vfs._fileId(tx, path), size),
-        'truncate $path',
-      );
+      final blockSize = vfs._blockSizes[path]!;
+      final tail = size % blockSize == 0
+          ? null
+          : vfs._currentBlock(path, size - size % blockSize);
+
+      vfs._submitWorkFunction((tx) async {
+        await tx.truncate(await vfs._fileId(tx, path), size, tail: tail);
+      }, 'truncate $path');
     }
   }
 
@@ -714,28 +795,24 @@ class _IndexedDbFile implements VirtualFileSystemFileV1 {
   @override
   void xWrite(Uint8List buffer, int fileOffset) {
     vfs._checkClosed();
+    memoryFile.xWrite(buffer, fileOffset);
 
-    if (vfs._inMemoryOnlyFiles.contains(path)) {
-      // There's nothing to persist, so we just forward the write to the in-
-      // memory buffer.
-      memoryFile.xWrite(buffer, fileOffset);
+    if (vfs._inMemoryOnlyFiles.contains(path) || buffer.isEmpty) {
+      // There's nothing to persist.
       return;
     }
 
-    final previousContent = vfs._memory.fileData[path] ?? Uint8Buffer();
-    final previousList = previousContent.buffer.asUint8List(
-      0,
-      previousContent.length,
-    );
-    memoryFile.xWrite(buffer, fileOffset);
-
-    // We need to copy the buffer for the write because it will become invalid
-    // after this synchronous method returns.
-    final copy = Uint8List(buffer.length)..setAll(0, buffer);
+    // Only remember which blocks have changed. Their contents are taken from
+    // the in-memory file when a flush starts, so that blocks written multiple
+    // times before a flush are only written once.
+    final blockSize = vfs._blockSizes[path]!;
+    final firstBlock = fileOffset ~/ blockSize;
+    final lastBlock = (fileOffset + buffer.length - 1) ~/ blockSize;
 
     vfs._submitWork(
-      _WriteFileWorkItem(vfs, path, previousList)
-        ..writes.add(_OffsetAndBuffer(fileOffset, copy)),
+      _WriteFileWorkItem(vfs, path)..dirtyBlocks.addAll([
+        for (var i = firstBlock; i <= lastBlock; i++) i * blockSize,
+      ]),
     );
   }
 }
@@ -758,6 +835,10 @@ sealed class _IndexedDbWorkItem extends LinkedListEntry<_IndexedDbWorkItem> {
     return true;
   }
 
+  /// Called synchronously when this item is taken out of the queue, right
+  /// before the transaction running it starts.
+  void prepare() {}
+
   Future<void> run(_IndexedDbTransaction tx);
 }
 
@@ -838,11 +919,13 @@ final class _CreateFileWorkItem extends _IndexedDbWorkItem {
   final IndexedDbFileSystem fileSystem;
   final String path;
 
-  _CreateFileWorkItem(this.fileSystem, this.path);
+  final int blockSize;
+
+  _CreateFileWorkItem(this.fileSystem, this.path, this.blockSize);
 
   @override
   Future<void> run(_IndexedDbTransaction tx) async {
-    final id = await tx.createFile(path);
+    final id = await tx.createFile(path, blockSize);
     fileSystem._knownFileIds[path] = id;
   }
 }
@@ -851,10 +934,14 @@ final class _WriteFileWorkItem extends _IndexedDbWorkItem {
   final IndexedDbFileSystem fileSystem;
   final String path;
 
-  final Uint8List originalContent;
-  final List<_OffsetAndBuffer> writes = [];
+  /// Offsets of blocks that have been changed.
+  final Set<int> dirtyBlocks = {};
+
+  /// The contents of [dirtyBlocks] at the time this item was prepared, or
+  /// `null` if the file has been deleted before that.
+  _FileWriteRequest? _request;
 
-  _WriteFileWorkItem(this.fileSystem, this.path, this.originalContent);
+  _WriteFileWorkItem(this.fileSystem, this.path);
 
   @override
   bool insertInto(LinkedList<_IndexedDbWorkItem> pending) {
@@ -864,7 +951,7 @@ final class _WriteFileWorkItem extends _IndexedDbWorkItem {
       if (current is _WriteFileWorkItem) {
         if (current.path == path) {
           // Merge the two pending writes into one transaction.
-          current.writes.addAll(writes);
+          current.dirtyBlocks.addAll(dirtyBlocks);
           return false;
         } else {
           current = current.previous;
@@ -886,14 +973,693 @@ final class _WriteFileWorkItem extends _IndexedDbWorkItem {
     return true;
   }
 
+  @override
+  void prepare() {
+    final data = fileSystem._memory.files[path];
+    if (data == null) {
+      // The file has been deleted in the meantime.
+      return;
+    }
+
+    final request = _request = _FileWriteRequest(data.length);
+    for (final offset in dirtyBlocks) {
+      // Blocks past the end of the file have been truncated in the meantime.
+      if (fileSystem._currentBlock(path, offset) case final block?) {
+        request.replacedBlocks[offset] = block;
+        fileSystem._blocksWritten++;
+        fileSystem._bytesWritten += block.length;
+      }
+    }
+  }
+
   @override
   Future<void> run(_IndexedDbTransaction tx) async {
-    final request = _FileWriteRequest(originalContent);
+    if (_request case final request?) {
+      await tx.write(await fileSystem._fileId(tx, path), request);
+    }
+  }
+}
+
+/// Options shared between a [LazyIndexedDbFileSystem] and the
+/// [IndexedDbVfsWorker] accessing IndexedDB on its behalf.
+///
+/// {@category wasm}
+@JS()
+@anonymous
+extension type IndexedDbWorkerOptions._raw(JSObject _) implements JSObject {
+  external String get databaseName;
+  external SharedArrayBuffer get synchronizationBuffer;
+  external SharedArrayBuffer get communicationBuffer;
+
+  external factory IndexedDbWorkerOptions({
+    required String databaseName,
+    required SharedArrayBuffer synchronizationBuffer,
+    required SharedArrayBuffer communicationBuffer,
+  });
+}
+
+enum _LazyOperation {
+  /// Reads `flag2` blocks of file `flag0`, starting at block `flag1`.
+  readBlocks,
+
+  /// Stages `flag2` blocks of file `flag0`, starting at block `flag1`.
+  stageBlocks,
+
+  /// Writes staged blocks of file `flag0` and sets its length.
+  commit,
+  createFile,
+  deleteFile,
+  truncate,
+  stopServer,
+}
+
+/// The maximum amount of blocks to read at once.
+const _maxReadAhead = 16;
+
+/// The amount of blocks that fit into the communication buffer.
+int _transferBlocks(int blockSize) => MessageSerializer.dataSize ~/ blockSize;
+
+Flags _fileLengthFlags(int fileId, int length) {
+  // Flags are 32-bit integers, so we split the length.
+  return Flags(fileId, length ~/ _legacyBlockSize, length % _legacyBlockSize);
+}
+
+int _readFileLength(Flags flags) {
+  return flags.flag1 * _legacyBlockSize + flags.flag2;
+}
+
+/// A file system storing files in the same format as [IndexedDbFileSystem],
+/// but loading blocks on demand.
+///
+/// [IndexedDbFileSystem] reads all files into memory when it's opened, which
+/// makes opening large databases slow. This file system only loads the names
+/// and lengths of files when opened, and then loads blocks when they're first
+/// read. Up to `maxCachedBlocks` blocks are kept in memory, evicting the least
+/// recently used blocks when more are loaded.
+///
+/// Since IndexedDB is asynchronous, reads can't be served from the worker
+/// hosting the database. Similar to `WasmVfs`, this file system uses shared
+/// memory and `Atomics` to wait for another worker running an
+/// [IndexedDbVfsWorker], which performs all IndexedDB operations. To set this
+/// up, call [createWorkerOptions] and send the options to a worker calling
+/// [IndexedDbVfsWorker.create]. The options can then be passed to [open].
+///
+/// Writes are kept in memory until sqlite3 syncs a file or releases its
+/// write lock, at which point they're committed in a single IndexedDB
+/// transaction.
+///
+/// {@category wasm}
+final class LazyIndexedDbFileSystem extends BaseVirtualFileSystem {
+  final RequestResponseSynchronizer _synchronizer;
+  final MessageSerializer _messages;
+
+  /// The maximum amount of blocks to keep in memory.
+  final int maxCachedBlocks;
+
+  /// The size of blocks for files created by this file system.
+  final int blockSize;
+
+  final Map<String, _LazyFile> _files;
+
+  /// Files opened with [SqlFlag.SQLITE_OPEN_DELETEONCLOSE] aren't persisted.
+  final InMemoryFileSystem _memory;
+
+  /// Cached blocks, keyed by file id and offset, in least-recently used order.
+  final LinkedHashMap<(int, int), Uint8List> _blocks = LinkedHashMap();
+
+  /// Offsets of blocks (per file id) that have been changed in [_blocks] but
+  /// not sent to the worker yet. These blocks can't be evicted.
+  final Map<int, SplayTreeSet<int>> _dirty = {};
+
+  LazyIndexedDbFileSystem._(
+    IndexedDbWorkerOptions options,
+    this._files, {
+    required this.maxCachedBlocks,
+    required this.blockSize,
+    required String vfsName,
+    super.random,
+  }) : _synchronizer = RequestResponseSynchronizer(
+         options.synchronizationBuffer,
+       ),
+       _messages = MessageSerializer(options.communicationBuffer),
+       _memory = InMemoryFileSystem(random: random),
+       super(name: vfsName);
+
+  /// Creates [IndexedDbWorkerOptions] to send to a worker hosting an
+  /// [IndexedDbVfsWorker] for the IndexedDB database named [databaseName].
+  static IndexedDbWorkerOptions createWorkerOptions(String databaseName) {
+    return IndexedDbWorkerOptions(
+      databaseName: databaseName,
+      synchronizationBuffer: RequestResponseSynchronizer.createBuffer(),
+      communicationBuffer: SharedArrayBuffer(MessageSerializer.totalSize),
+    );
+  }
+
+  /// Opens the file system for the database described by [options].
+  ///
+  /// [maxCachedBlocks] bounds the amount of blocks kept in memory. It defaults
+  /// to 2048 blocks (8 MiB with the default [blockSize]). New files are
+  /// created with blocks of [blockSize] bytes, see [IndexedDbFileSystem.open].
+  static Future<LazyIndexedDbFileSystem> open({
+    required IndexedDbWorkerOptions options,
+    String vfsName = 'indexeddb',
+    Random? random,
+    int maxCachedBlocks = 2048,
+    int blockSize = _defaultBlockSize,
+  }) async {
+    _checkBlockSize(blockSize);
+    if (maxCachedBlocks < _maxReadAhead) {
+      throw ArgumentError.value(
+        maxCachedBlocks,
+        'maxCachedBlocks',
+        'Must be at least $_maxReadAhead',
+      );
+    }
+
+    final files = <String, _LazyFile>{};
+    final database = AsynchronousIndexedDbFileSystem(options.databaseName);
+    await database.open();
+    try {
+      await database._runTransaction(mode: 'readonly', (tx) async {
+        for (final MapEntry(key: name, value: id)
+            in (await tx.listFiles()).entries) {
+          final entry = await tx._readFile(id);
+          files[name] = _LazyFile(
+            id,
+            name,
+            entry.length,
+            entry.effectiveBlockSize,
+          );
+        }
+      });
+    } finally {
+      database.close();
+    }
+
+    return LazyIndexedDbFileSystem._(
+      options,
+      files,
+      maxCachedBlocks: maxCachedBlocks,
+      blockSize: blockSize,
+      vfsName: vfsName,
+      random: random,
+    );
+  }
+
+  Flags _runInWorker(_LazyOperation operation, Message request) {
+    _messages.write(request);
+
+    final rc = _synchronizer.requestAndWaitForResponse(operation.index);
+    if (rc != 0) {
+      throw VfsException(rc);
+    }
+
+    return MessageSerializer.readFlags(_messages);
+  }
+
+  /// Commits pending writes and stops the [IndexedDbVfsWorker].
+  void close() {
+    for (final file in _files.values) {
+      _commit(file);
+    }
+    _runInWorker(_LazyOperation.stopServer, const EmptyMessage());
+  }
+
+  /// Returns the cached block of [file] at [offset], loading it (along with
+  /// following blocks) if necessary.
+  Uint8List _block(_LazyFile file, int offset) {
+    final key = (file.id, offset);
+    if (_blocks.remove(key) case final cached?) {
+      // Re-insert to mark the block as most recently used.
+      return _blocks[key] = cached;
+    }
+
+    final blockSize = file.blockSize;
+    if (offset >= file.length) {
+      // Blocks past the end of the file are never stored.
+      return _insert(key, Uint8List(blockSize));
+    }
+
+    // Read ahead up to the next block we already have.
+    final maxCount = min(_maxReadAhead, _transferBlocks(blockSize));
+    var count = 1;
+    while (count < maxCount &&
+        offset + count * blockSize < file.length &&
+        !_blocks.containsKey((file.id, offset + count * blockSize))) {
+      count++;
+    }
+
+    _runInWorker(
+      _LazyOperation.readBlocks,
+      Flags(file.id, offset ~/ blockSize, count),
+    );
+    final loaded = [
+      for (var i = 0; i < count; i++)
+        Uint8List(blockSize)
+          ..setAll(0, _messages.viewByteRange(i * blockSize, blockSize)),
+    ];
+
+    // Insert the requested block last so that it's the most recently used.
+    for (var i = count - 1; i > 0; i--) {
+      _insert((file.id, offset + i * blockSize), loaded[i]);
+    }
+    return _insert(key, loaded[0]);
+  }
+
+  Uint8List _insert((int, int) key, Uint8List block) {
+    _blocks
+      ..remove(key)
+      ..[key] = block;
+    if (_blocks.length > maxCachedBlocks) {
+      _evict();
+    }
+    return block;
+  }
+
+  void _evict() {
+    bool isDirty((int, int) key) => _dirty[key.$1]?.contains(key.$2) ?? false;
+
+    final excess = _blocks.length - maxCachedBlocks;
+    var evictable = _blocks.keys
+        .where((key) => !isDirty(key))
+        .take(excess)
+        .toList();
+
+    if (evictable.length < excess) {
+      // Too many blocks are dirty, send them to the worker so that we can
+      // drop them.
+      for (final file in _files.values) {
+        _stage(file);
+      }
+      evictable = _blocks.keys.take(excess).toList();
+    }
+
+    evictable.forEach(_blocks.remove);
+  }
+
+  void _markDirty(_LazyFile file, int offset) {
+    _dirty.putIfAbsent(file.id, SplayTreeSet.new).add(offset);
+    file.needsCommit = true;
+  }
+
+  void _dropBlocks(_LazyFile file, {int from = 0}) {
+    _blocks.removeWhere((key, _) => key.$1 == file.id && key.$2 >= from);
+    _dirty[file.id]?.removeWhere((offset) => offset >= from);
+  }
+
+  /// Sends dirty blocks of [file] to the worker, which keeps them until
+  /// they're committed.
+  void _stage(_LazyFile file) {
+    final dirty = _dirty.remove(file.id);
+    if (dirty == null) return;
+
+    final blockSize = file.blockSize;
+    final maxCount = _transferBlocks(blockSize);
+    final offsets = dirty.toList();
+    var i = 0;
+    while (i < offsets.length) {
+      // Send runs of adjacent blocks in a single request.
+      final first = offsets[i];
+      var count = 0;
+      while (i < offsets.length &&
+          count < maxCount &&
+          offsets[i] == first + count * blockSize) {
+        _messages.byteView.setAll(
+          count * blockSize,
+          _blocks[(file.id, offsets[i])]!,
+        );
+        count++;
+        i++;
+      }
+
+      _runInWorker(
+        _LazyOperation.stageBlocks,
+        Flags(file.id, first ~/ blockSize, count),
+      );
+    }
+  }
+
+  void _commit(_LazyFile file) {
+    if (!file.needsCommit || !identical(_files[file.path], file)) return;
+
+    _stage(file);
+    _runInWorker(
+      _LazyOperation.commit,
+      _fileLengthFlags(file.id, file.length),
+    );
+    file.needsCommit = false;
+  }
+
+  @override
+  int xAccess(String path, int flags) {
+    return _files.containsKey(path) || _memory.xAccess(path, flags) != 0
+        ? 1
+        : 0;
+  }
+
+  @override
+  void xDelete(String path, int syncDir) {
+    if (_files.remove(path) case final file?) {
+      _dropBlocks(file);
+      _runInWorker(_LazyOperation.deleteFile, Flags(file.id, 0, 0));
+    } else {
+      _memory.xDelete(path, syncDir);
+    }
+  }
+
+  @override
+  String xFullPathName(String path) => _memory.xFullPathName(path);
+
+  @override
+  XOpenResult xOpen(Sqlite3Filename path, int flags) {
+    final pathStr = path.path ?? random.randomFileName(prefix: '/');
+    var file = _files[pathStr];
+
+    if (file == null) {
+      if ((flags & SqlFlag.SQLITE_OPEN_DELETEONCLOSE) != 0 ||
+          _memory.xAccess(pathStr, 0) != 0) {
+        // No point in persisting this file, it won't exist after we're done.
+        return _memory.xOpen(Sqlite3Filename(pathStr), flags);
+      }
+
+      if ((flags & SqlFlag.SQLITE_OPEN_CREATE) == 0) {
+        throw VfsException(SqlError.SQLITE_CANTOPEN);
+      }
+
+      final created = _runInWorker(
+        _LazyOperation.createFile,
+        NameAndInt32Flags(pathStr, blockSize, 0, 0),
+      );
+      file = _files[pathStr] = _LazyFile(created.flag0, pathStr, 0, blockSize);
+    }
+
+    return (outFlags: 0, file: _LazyIndexedDbFile(this, file));
+  }
+
+  @override
+  void xSleep(Duration duration) {
+    // noop
+  }
+}
+
+final class _LazyFile {
+  final int id;
+  final String path;
+  final int blockSize;
+  int length;
+
+  /// Whether the file has changes that haven't been committed to IndexedDB.
+  bool needsCommit = false;
+
+  _LazyFile(this.id, this.path, this.length, this.blockSize);
+}
+
+final class _LazyIndexedDbFile extends BaseVfsFile {
+  final LazyIndexedDbFileSystem vfs;
+  final _LazyFile file;
+
+  var _lockMode = SqlFileLockingLevels.SQLITE_LOCK_NONE;
+
+  _LazyIndexedDbFile(this.vfs, this.file);
+
+  @override
+  int readInto(Uint8List buffer, int offset) {
+    final available = max(0, min(buffer.length, file.length - offset));
+    var read = 0;
+
+    while (read < available) {
+      final position = offset + read;
+      final offsetInBlock = position % file.blockSize;
+      final length = min(file.blockSize - offsetInBlock, available - read);
+
+      final block = vfs._block(file, position - offsetInBlock);
+      buffer.setRange(read, read + length, block, offsetInBlock);
+      read += length;
+    }
+
+    return available;
+  }
+
+  @override
+  int xCheckReservedLock() {
+    return _lockMode >= SqlFileLockingLevels.SQLITE_LOCK_RESERVED ? 1 : 0;
+  }
+
+  @override
+  void xClose() => vfs._commit(file);
+
+  @override
+  int xFileSize() => file.length;
+
+  @override
+  void xLock(int mode) {
+    _lockMode = mode;
+  }
+
+  @override
+  void xSync(int flags) => vfs._commit(file);
+
+  @override
+  void xTruncate(int size) {
+    if (size < file.length) {
+      final offsetInBlock = size % file.blockSize;
+      final lastBlock = size - offsetInBlock;
+
+      // Bytes past the end of the file in the last block must be zeroed, so
+      // that growing the file again doesn't bring them back.
+      if (offsetInBlock != 0) {
+        vfs._block(file, lastBlock).fillRange(offsetInBlock, file.blockSize, 0);
+        vfs._markDirty(file, lastBlock);
+      }
+      vfs._dropBlocks(file, from: lastBlock + file.blockSize);
+
+      vfs._runInWorker(
+        _LazyOperation.truncate,
+        _fileLengthFlags(file.id, size),
+      );
+    } else if (size > file.length) {
+      file.needsCommit = true;
+    }
+
+    file.length = size;
+  }
+
+  @override
+  void xUnlock(int mode) {
+    if (_lockMode > SqlFileLockingLevels.SQLITE_LOCK_SHARED) {
+      // A write transaction has completed, persist it.
+      vfs._commit(file);
+    }
+    _lockMode = mode;
+  }
+
+  @override
+  void xWrite(Uint8List buffer, int fileOffset) {
+    var written = 0;
+
+    while (written < buffer.length) {
+      final position = fileOffset + written;
+      final offsetInBlock = position % file.blockSize;
+      final blockStart = position - offsetInBlock;
+      final length = min(
+        file.blockSize - offsetInBlock,
+        buffer.length - written,
+      );
+
+      final block = length == file.blockSize
+          // We're replacing the whole block, so there's no need to load it.
+          ? vfs._insert((file.id, blockStart), Uint8List(file.blockSize))
+          : vfs._block(file, blockStart);
+      block.setRange(offsetInBlock, offsetInBlock + length, buffer, written);
+      vfs._markDirty(file, blockStart);
+      written += length;
+    }
+
+    file.length = max(file.length, fileOffset + buffer.length);
+  }
+}
+
+/// Performs IndexedDB operations for a [LazyIndexedDbFileSystem] hosted in
+/// another worker.
+///
+/// The worker hosting the database uses
+/// [LazyIndexedDbFileSystem.createWorkerOptions] to obtain options that must
+/// be sent to this worker, which then calls [create] and [start].
+///
+/// {@category wasm}
+final class IndexedDbVfsWorker {
+  final AsynchronousIndexedDbFileSystem _database;
+  final RequestResponseSynchronizer _synchronizer;
+  final MessageSerializer _messages;
+
+  /// Blocks sent by the client that haven't been committed yet, by file id and
+  /// offset.
+  final Map<int, Map<int, Uint8List>> _staged = {};
+  final Map<int, int> _blockSizes = {};
+  var _stopped = false;
+
+  IndexedDbVfsWorker._(this._database, IndexedDbWorkerOptions options)
+    : _synchronizer = RequestResponseSynchronizer(
+        options.synchronizationBuffer,
+      ),
+      _messages = MessageSerializer(options.communicationBuffer);
+
+  static Future<IndexedDbVfsWorker> create(
+    IndexedDbWorkerOptions options,
+  ) async {
+    final database = AsynchronousIndexedDbFileSystem(options.databaseName);
+    await database.open();
+    return IndexedDbVfsWorker._(database, options);
+  }
+
+  Future<int> _blockSize(int fileId) async {
+    if (_blockSizes[fileId] case final blockSize?) {
+      return blockSize;
+    }
+
+    late int blockSize;
+    await _database._runTransaction(mode: 'readonly', (tx) async {
+      blockSize = (await tx._readFile(fileId)).effectiveBlockSize;
+    });
+    return _blockSizes[fileId] = blockSize;
+  }
+
+  Future<Message> _readBlocks(Flags request) async {
+    final fileId = request.flag0;
+    final blockSize = await _blockSize(fileId);
+    final start = request.flag1 * blockSize;
+    final length = request.flag2 * blockSize;
+    final target = _messages.viewByteRange(0, length)..fillRange(0, length, 0);
+
+    final additionalReads = <Future<void>>[];
+    await _database._runTransaction(mode: 'readonly', (tx) {
+      return tx.readBlocks(fileId, start, start + length, additionalReads, (
+        offset,
+        data,
+      ) {
+        target.setAll(
+          offset - start,
+          data.asUint8List(0, min(blockSize, data.lengthInBytes)),
+        );
+      });
+    });
+    await additionalReads.wait;
+
+    // Staged blocks are newer than what's in the database.
+    _staged[fileId]?.forEach((offset, block) {
+      if (offset >= start && offset < start + length) {
+        target.setAll(offset - start, block);
+      }
+    });
+
+    return const EmptyMessage();
+  }
+
+  Future<Message> _stageBlocks(Flags request) async {
+    final blockSize = await _blockSize(request.flag0);
+    final staged = _staged.putIfAbsent(request.flag0, () => {});
+    for (var i = 0; i < request.flag2; i++) {
+      staged[(request.flag1 + i) * blockSize] = Uint8List(blockSize)
+        ..setAll(0, _messages.viewByteRange(i * blockSize, blockSize));
+    }
+
+    return const EmptyMessage();
+  }
+
+  Future<Message> _commit(Flags request) async {
+    final fileId = request.flag0;
+    final write = _FileWriteRequest(_readFileLength(request))
+      ..replacedBlocks.addAll(_staged.remove(fileId) ?? const {});
+
+    await _database._runTransaction(
+      mode: 'readwrite',
+      (tx) => tx.write(fileId, write),
+    );
+    return const EmptyMessage();
+  }
+
+  Future<Message> _createFile(NameAndInt32Flags request) async {
+    late int id;
+    await _database._runTransaction(mode: 'readwrite', (tx) async {
+      id = await tx.createFile(request.name, request.flag0);
+    });
+    _blockSizes[id] = request.flag0;
+    return Flags(id, 0, 0);
+  }
+
+  Future<Message> _deleteFile(Flags request) async {
+    _staged.remove(request.flag0);
+    _blockSizes.remove(request.flag0);
+    await _database._runTransaction(
+      mode: 'readwrite',
+      (tx) => tx.deleteFile(request.flag0),
+    );
+    return const EmptyMessage();
+  }
+
+  Future<Message> _truncate(Flags request) async {
+    final length = _readFileLength(request);
+    final blockSize = await _blockSize(request.flag0);
+    final endOffset = (length + blockSize - 1) ~/ blockSize * blockSize;
+    _staged[request.flag0]?.removeWhere((offset, _) => offset >= endOffset);
+
+    await _database._runTransaction(
+      mode: 'readwrite',
+      (tx) => tx.truncate(request.flag0, length),
+    );
+    return const EmptyMessage();
+  }
+
+  /// Serves requests from the [LazyIndexedDbFileSystem] until it's closed.
+  Future<void> start() async {
+    while (!_stopped) {
+      final waitResult = _synchronizer.waitForRequest();
+      if (waitResult == Atomics.timedOut) {
+        continue;
+      }
+
+      int rc;
+      try {
+        final operation = _LazyOperation.values[_synchronizer.takeOpcode()];
+        final Message response;
+
+        switch (operation) {
+          case _LazyOperation.readBlocks:
+            response = await _readBlocks(
+              MessageSerializer.readFlags(_messages),
+            );
+          case _LazyOperation.stageBlocks:
+            response = await _stageBlocks(
+              MessageSerializer.readFlags(_messages),
+            );
+          case _LazyOperation.commit:
+            response = await _commit(MessageSerializer.readFlags(_messages));
+          case _LazyOperation.createFile:
+            response = await _createFile(
+              MessageSerializer.readNameAndFlags(_messages),
+            );
+          case _LazyOperation.deleteFile:
+            response = await _deleteFile(
+              MessageSerializer.readFlags(_messages),
+            );
+          case _LazyOperation.truncate:
+            response = await _truncate(MessageSerializer.readFlags(_messages));
+          case _LazyOperation.stopServer:
+            response = const EmptyMessage();
+            _stopped = true;
+        }
+
+        _messages.write(response);
+        rc = 0;
+      } on VfsException catch (e) {
+        rc = e.returnCode;
+      } catch (e) {
+        rc = SqlError.SQLITE_IOERR;
+      }
 
-    for (final write in writes) {
-      request.addWrite(write.offset, write.buffer);
+      _synchronizer.respond(rc);
     }
 
-    await tx.write(await fileSystem._fileId(tx, path), request);
+    _database.close();
   }
 }
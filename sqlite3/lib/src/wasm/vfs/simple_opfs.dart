@@ -1,3 +1,5 @@
+import 'dart:async';
+import 'dart:collection';
 import 'dart:js_interop';
 import 'dart:typed_data';
 
@@ -15,6 +17,7 @@ import '../../vfs.dart';
 import '../js_interop.dart';
 import '../../in_memory_vfs.dart';
 import '../../platform/web.dart';
+import 'durability.dart';
 
 @internal
 enum FileType {
@@ -45,6 +48,30 @@ enum FileType {
 /// Please note that [SimpleOpfsFileSystem]s are only available in dedicated web workers,
 /// not in the JavaScript context for a tab or a shared web worker.
 ///
+/// ## Batch atomic writes
+///
+/// When `batchAtomicWrites` is enabled, the database file reports
+/// `SQLITE_IOCAP_BATCH_ATOMIC`. For transactions whose changes fit into the
+/// page cache, sqlite3 then skips the rollback journal: Writes to the database
+/// are buffered in memory and applied to the file when the transaction
+/// commits. This avoids writing and syncing a journal file for each
+/// transaction.
+///
+/// Transactions that haven't committed leave no trace in the file, and if
+/// applying the writes fails, the changes already written are reverted before
+/// sqlite3 falls back to using a journal. However, OPFS doesn't make a series
+/// of writes atomic: If the worker is terminated or the browser crashes while
+/// the buffered writes are being applied, the database may be left
+/// partially updated without a journal to recover it. Only enable this option
+/// if that risk is acceptable, e.g. because the database can be restored
+/// from another source.
+///
+/// ## Durability
+///
+/// By default, files are flushed each time sqlite3 syncs them. A different
+/// `durability` policy can defer and coalesce those flushes, see
+/// [DurabilityPolicy] for details. Pending flushes can be issued with [flush].
+///
 /// [file system access API]: https://developer.mozilla.org/en-US/docs/Web/API/File_System_Access_API
 ///
 /// {@category wasm}
@@ -62,6 +89,19 @@ final class SimpleOpfsFileSystem extends BaseVirtualFileSystem {
 
   _OpfsFiles? _files;
 
+  /// Whether the database file supports batch atomic writes, see the
+  /// documentation on this class.
+  final bool batchAtomicWrites;
+
+  /// When files are flushed after sqlite3 syncs them.
+  final DurabilityPolicy durability;
+
+  final FlushCounter _flushCounter = FlushCounter();
+
+  /// Files that have been synced, but not yet flushed due to [durability].
+  final Set<FileType> _unflushed = {};
+  Timer? _flushTimer;
+
   /// An in-memory overlay used for files that aren't persisted (e.g. temporary
   /// materialized views).
   final InMemoryFileSystem _memory = InMemoryFileSystem();
@@ -70,7 +110,11 @@ final class SimpleOpfsFileSystem extends BaseVirtualFileSystem {
   ///
   /// Before using this file system, call [open] to load the required access
   /// handles.
-  SimpleOpfsFileSystem({String vfsName = 'simple-opfs'}) : super(name: vfsName);
+  SimpleOpfsFileSystem({
+    String vfsName = 'simple-opfs',
+    this.batchAtomicWrites = false,
+    this.durability = DurabilityPolicy.full,
+  }) : super(name: vfsName);
 
   static Future<(FileSystemDirectoryHandle?, FileSystemDirectoryHandle)>
   _resolveDir(String path, {bool create = true}) async {
@@ -113,10 +157,15 @@ final class SimpleOpfsFileSystem extends BaseVirtualFileSystem {
   /// using the [proposed lock mode](https://github.com/whatwg/fs/blob/main/proposals/MultipleReadersWriters.md).
   /// This mode is currently not supported across browsers, but can be used on
   /// Chrome for faster database access across tabs.
+  ///
+  /// For [batchAtomicWrites] and [durability], see the documentation on this
+  /// class.
   static Future<SimpleOpfsFileSystem> loadFromStorage(
     String path, {
     String vfsName = 'simple-opfs',
     bool readWriteUnsafe = false,
+    bool batchAtomicWrites = false,
+    DurabilityPolicy durability = DurabilityPolicy.full,
   }) async {
     final storage = storageManager;
     if (storage == null) {
@@ -128,6 +177,8 @@ final class SimpleOpfsFileSystem extends BaseVirtualFileSystem {
       directory,
       vfsName: vfsName,
       readWriteUnsafe: readWriteUnsafe,
+      batchAtomicWrites: batchAtomicWrites,
+      durability: durability,
     );
   }
 
@@ -169,13 +220,22 @@ final class SimpleOpfsFileSystem extends BaseVirtualFileSystem {
   /// This mode is currently not supported across browsers, but can be used on
   /// Chrome for faster database access across tabs.
   ///
+  /// For [batchAtomicWrites] and [durability], see the documentation on this
+  /// class.
+  ///
   /// [FileSystemDirectoryHandle]: https://developer.mozilla.org/en-US/docs/Web/API/FileSystemDirectoryHandle
   static Future<SimpleOpfsFileSystem> inDirectory(
     FileSystemDirectoryHandle root, {
     String vfsName = 'simple-opfs',
     bool readWriteUnsafe = false,
+    bool batchAtomicWrites = false,
+    DurabilityPolicy durability = DurabilityPolicy.full,
   }) async {
-    final fs = SimpleOpfsFileSystem(vfsName: vfsName);
+    final fs = SimpleOpfsFileSystem(
+      vfsName: vfsName,
+      batchAtomicWrites: batchAtomicWrites,
+      durability: durability,
+    );
     await fs.open(root, readWriteUnsafe: readWriteUnsafe);
     return fs;
   }
@@ -249,11 +309,41 @@ final class SimpleOpfsFileSystem extends BaseVirtualFileSystem {
   @override
   void xSleep(Duration duration) {}
 
+  /// Statistics on how often files have been synced and flushed.
+  FlushStatistics get flushStatistics => _flushCounter.statistics;
+
+  void _sync(FileType type) {
+    _flushCounter.syncs++;
+
+    if (durability.flushDelay case final delay?) {
+      _unflushed.add(type);
+      _flushTimer ??= Timer(delay, flush);
+    } else {
+      final handle = _requireFiles().handleFor(type);
+      _flushCounter.measure(handle.flush);
+    }
+  }
+
+  /// Flushes files that have been synced by sqlite3 but not flushed yet due to
+  /// the [durability] policy.
+  void flush() {
+    _flushTimer?.cancel();
+    _flushTimer = null;
+
+    if (_files case final files?) {
+      for (final type in _unflushed) {
+        _flushCounter.measure(files.handleFor(type).flush);
+      }
+    }
+    _unflushed.clear();
+  }
+
   /// Closes the synchronous access handles kept open while this file system is
   /// active.
   ///
   /// This file system can be re-opened afterwards with [open].
   void close() {
+    flush();
     _files?.close();
     _files = null;
   }
@@ -302,11 +392,24 @@ class _SimpleOpfsFile extends BaseVfsFile {
 
   var _lockMode = SqlFileLockingLevels.SQLITE_LOCK_NONE;
 
+  /// Writes buffered between `SQLITE_FCNTL_BEGIN_ATOMIC_WRITE` and
+  /// `SQLITE_FCNTL_COMMIT_ATOMIC_WRITE`, by their offset.
+  ///
+  /// sqlite3 doesn't read from or truncate the file while a batch is active.
+  SplayTreeMap<int, Uint8List>? _batch;
+
   FileSystemSyncAccessHandle get syncHandle =>
       vfs._requireFiles().handleFor(type);
 
   _SimpleOpfsFile(this.vfs, this.type, this.deleteOnClose);
 
+  @override
+  int get xDeviceCharacteristics {
+    return vfs.batchAtomicWrites && type == FileType.database
+        ? SqlDeviceCharacteristics.SQLITE_IOCAP_BATCH_ATOMIC
+        : 0;
+  }
+
   @override
   int readInto(Uint8List buffer, int offset) {
     return syncHandle.readDart(buffer, FileSystemReadWriteOptions(at: offset));
@@ -326,6 +429,65 @@ class _SimpleOpfsFile extends BaseVfsFile {
     }
   }
 
+  @override
+  int xFileControl(int op, int ptr) {
+    switch (op) {
+      case SqliteFileControl.beginAtomicWrite:
+        _batch = SplayTreeMap();
+        return SqlError.SQLITE_OK;
+      case SqliteFileControl.commitAtomicWrite:
+        final batch = _batch!;
+        _batch = null;
+        return _applyBatch(batch);
+      case SqliteFileControl.rollbackAtomicWrite:
+        _batch = null;
+        return SqlError.SQLITE_OK;
+    }
+
+    return super.xFileControl(op, ptr);
+  }
+
+  /// Applies writes buffered in an atomic batch.
+  ///
+  /// If a write fails, previous writes are reverted so that sqlite3 can retry
+  /// the transaction with a rollback journal.
+  int _applyBatch(SplayTreeMap<int, Uint8List> batch) {
+    final handle = syncHandle;
+    final originalSize = handle.getSize();
+    final replaced = <(int, Uint8List)>[];
+
+    try {
+      for (final MapEntry(key: offset, value: data) in batch.entries) {
+        if (offset < originalSize) {
+          final previous = Uint8List(data.length);
+          final bytesRead = handle.readDart(
+            previous,
+            FileSystemReadWriteOptions(at: offset),
+          );
+          replaced.add((
+            offset,
+            Uint8List.sublistView(previous, 0, bytesRead),
+          ));
+        }
+
+        _writeFully(handle, data, offset);
+      }
+
+      return SqlError.SQLITE_OK;
+    } on Object {
+      try {
+        for (final (offset, data) in replaced.reversed) {
+          _writeFully(handle, data, offset);
+        }
+        handle.truncate(originalSize);
+      } on Object {
+        // We can't recover from this, report the original error.
+      }
+
+      return SqlExtendedError.SQLITE_IOERR_COMMIT_ATOMIC;
+    }
+  }
+
   @override
   int xFileSize() {
     return syncHandle.getSize();
@@ -338,7 +500,7 @@ class _SimpleOpfsFile extends BaseVfsFile {
 
   @override
   void xSync(int flags) {
-    syncHandle.flush();
+    vfs._sync(type);
   }
 
   @override
@@ -353,7 +515,21 @@ class _SimpleOpfsFile extends BaseVfsFile {
 
   @override
   void xWrite(Uint8List buffer, int fileOffset) {
-    final bytesWritten = syncHandle.writeDart(
+    if (_batch case final batch?) {
+      // The buffer may be a view over memory that sqlite3 reuses, so it needs
+      // to be copied.
+      batch[fileOffset] = Uint8List.fromList(buffer);
+    } else {
+      _writeFully(syncHandle, buffer, fileOffset);
+    }
+  }
+
+  static void _writeFully(
+    FileSystemSyncAccessHandle handle,
+    Uint8List buffer,
+    int fileOffset,
+  ) {
+    final bytesWritten = handle.writeDart(
       buffer,
       FileSystemReadWriteOptions(at: fileOffset),
     );
@@ -28,6 +28,7 @@ class WasmBindings {
   // finalizers anymore.
   Finalizer<Pointer>? changesetFinalizer,
       sessionFinalizer,
+      blobFinalizer,
       databaseFinalizer,
       statementFinalizer;
 
@@ -38,6 +39,9 @@ class WasmBindings {
 
     changesetFinalizer = Finalizer((p) => sqlite3.sqlite3changeset_finalize(p));
     sessionFinalizer = Finalizer((p) => sqlite3.sqlite3session_delete(p));
+    blobFinalizer = Finalizer(
+      (p) => sqlite3.sqlite3_blob_close?.callAsFunction(null, p.toJS),
+    );
     databaseFinalizer = Finalizer((p) => sqlite3.sqlite3_close_v2(p));
     statementFinalizer = Finalizer((p) => sqlite3.sqlite3_finalize(p));
   }
@@ -333,6 +337,84 @@ class WasmBindings {
     return sqlite3.dart_sqlite3_db_config_int(db, op, value);
   }
 
+  /// Calls a function that may not be exported from older `sqlite3.wasm`
+  /// bundles.
+  static int _callOptional(
+    JSFunction? function,
+    String name,
+    List<JSAny?> arguments,
+  ) {
+    if (function == null) {
+      throw UnsupportedError(
+        '$name is not available in this version of sqlite3.wasm. '
+        'Try upgrading to a newer sqlite3.wasm bundle.',
+      );
+    }
+
+    final result = function.callMethodVarArgs<JSNumber>('call'.toJS, [
+      null,
+      ...arguments,
+    ]);
+    return result.toDartInt;
+  }
+
+  int sqlite3_blob_open(
+    Pointer db,
+    Pointer zDb,
+    Pointer zTable,
+    Pointer zColumn,
+    int rowId,
+    int flags,
+    Pointer blobOut,
+  ) {
+    return _callOptional(sqlite3.sqlite3_blob_open, 'sqlite3_blob_open', [
+      db.toJS,
+      zDb.toJS,
+      zTable.toJS,
+      zColumn.toJS,
+      JsBigInt.fromInt(rowId).jsObject,
+      flags.toJS,
+      blobOut.toJS,
+    ]);
+  }
+
+  int sqlite3_blob_reopen(Pointer blob, int rowId) {
+    return _callOptional(sqlite3.sqlite3_blob_reopen, 'sqlite3_blob_reopen', [
+      blob.toJS,
+      JsBigInt.fromInt(rowId).jsObject,
+    ]);
+  }
+
+  int sqlite3_blob_close(Pointer blob) {
+    return _callOptional(sqlite3.sqlite3_blob_close, 'sqlite3_blob_close', [
+      blob.toJS,
+    ]);
+  }
+
+  int sqlite3_blob_bytes(Pointer blob) {
+    return _callOptional(sqlite3.sqlite3_blob_bytes, 'sqlite3_blob_bytes', [
+      blob.toJS,
+    ]);
+  }
+
+  int sqlite3_blob_read(Pointer blob, Pointer buffer, int n, int offset) {
+    return _callOptional(sqlite3.sqlite3_blob_read, 'sqlite3_blob_read', [
+      blob.toJS,
+      buffer.toJS,
+      n.toJS,
+      offset.toJS,
+    ]);
+  }
+
+  int sqlite3_blob_write(Pointer blob, Pointer buffer, int n, int offset) {
+    return _callOptional(sqlite3.sqlite3_blob_write, 'sqlite3_blob_write', [
+      blob.toJS,
+      buffer.toJS,
+      n.toJS,
+      offset.toJS,
+    ]);
+  }
+
   int sqlite3session_create(Pointer db, Pointer zDb, Pointer sessionOut) {
     return sqlite3.sqlite3session_create(db, zDb, sessionOut);
   }
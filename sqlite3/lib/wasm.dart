@@ -15,7 +15,14 @@ library;
 export 'common.dart';
 
 export 'src/wasm/vfs/simple_opfs.dart' show SimpleOpfsFileSystem;
-export 'src/wasm/vfs/indexed_db.dart' show IndexedDbFileSystem;
+export 'src/wasm/vfs/durability.dart' show DurabilityPolicy, FlushStatistics;
+export 'src/wasm/vfs/indexed_db.dart'
+    show
+        IndexedDbFileSystem,
+        IndexedDbVfsWorker,
+        IndexedDbWorkerOptions,
+        IndexedDbWriteStatistics,
+        LazyIndexedDbFileSystem;
 export 'src/wasm/vfs/async_opfs/client.dart' show WasmVfs;
 export 'src/wasm/vfs/async_opfs/worker.dart' show WorkerOptions, VfsWorker;
 export 'src/wasm/loader.dart' show WasmModuleLoader;
@@ -1,5 +1,6 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:math';
 import 'dart:typed_data';
 
 import 'package:sqlite3/common.dart';
@@ -1065,6 +1066,110 @@ void testDatabase(
     });
   });
 
+  group('blob', () {
+    setUp(() {
+      database
+        ..execute('CREATE TABLE files (id INTEGER PRIMARY KEY, content BLOB);')
+        ..execute(
+          'INSERT INTO files (id, content) VALUES (1, ?), (2, zeroblob(300000))',
+          [
+            Uint8List.fromList([1, 2, 3, 4, 5]),
+          ],
+        );
+    });
+
+    BlobHandle openBlob(int rowId, {bool writable = false}) {
+      final blob = database.openBlob(
+        table: 'files',
+        column: 'content',
+        rowId: rowId,
+        writable: writable,
+      );
+      addTearDown(blob.close);
+      return blob;
+    }
+
+    test('read', () {
+      final blob = openBlob(1);
+      expect(blob.length, 5);
+
+      final target = Uint8List(3);
+      blob.read(target, 2);
+      expect(target, [3, 4, 5]);
+
+      expect(() => blob.read(target, 3), throwsRangeError);
+    });
+
+    test('write', () {
+      final blob = openBlob(1, writable: true);
+      blob.write(Uint8List.fromList([9, 9]), 1);
+      expect(database.select('SELECT content FROM files WHERE id = 1'), [
+        {
+          'content': [1, 9, 9, 4, 5],
+        },
+      ]);
+
+      expect(() => blob.write(Uint8List(2), 4), throwsRangeError);
+    });
+
+    test('write requires writable handle', () {
+      final blob = openBlob(1);
+      expect(
+        () => blob.write(Uint8List(1), 0),
+        throwsSqlError(SqlError.SQLITE_READONLY, SqlError.SQLITE_READONLY),
+      );
+    });
+
+    test('reopen', () {
+      final blob = openBlob(1);
+      blob.reopen(2);
+      expect(blob.rowId, 2);
+      expect(blob.length, 300000);
+
+      expect(() => blob.reopen(3), throwsA(isA<SqliteException>()));
+    });
+
+    test('expires when the row changes', () {
+      final blob = openBlob(1);
+      database.execute('UPDATE files SET content = x\'00\' WHERE id = 1');
+
+      expect(
+        () => blob.read(Uint8List(1), 0),
+        throwsSqlError(SqlError.SQLITE_ABORT, SqlError.SQLITE_ABORT),
+      );
+    });
+
+    test('streams', () async {
+      final blob = openBlob(2, writable: true);
+      final data = Uint8List(300000);
+      for (var i = 0; i < data.length; i++) {
+        data[i] = i % 251;
+      }
+
+      await Stream.fromIterable([
+        for (var i = 0; i < data.length; i += 70000)
+          data.sublist(i, min(i + 70000, data.length)),
+      ]).pipe(blob.openWrite());
+
+      final chunks = await blob.openRead(chunkSize: 100000).toList();
+      expect(chunks.map((e) => e.length), [100000, 100000, 100000]);
+      expect(chunks.expand((e) => e), data);
+
+      expect(await blob.openRead(start: 299998).toList(), [
+        [data[299998], data[299999]],
+      ]);
+    });
+
+    test('sink reports writes past the end', () async {
+      final blob = openBlob(1, writable: true);
+      final sink = blob.openWrite(start: 4);
+      await expectLater(
+        sink.addStream(Stream.value([1, 2])),
+        throwsRangeError,
+      );
+    });
+  });
+
   test('autocommit', () {
     expect(database.autocommit, equals(true));
     database.execute('BEGIN');
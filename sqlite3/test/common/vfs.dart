@@ -71,6 +71,162 @@ void testVfs(FutureOr<CommonSqlite3> Function() loadSqlite) {
     insert.close();
   });
 
+  test('can clone in-memory file systems', () {
+    final memory = InMemoryFileSystem(name: 'dart-original');
+    sqlite3.registerVirtualFileSystem(memory);
+    addTearDown(() => sqlite3.unregisterVirtualFileSystem(memory));
+
+    final db = sqlite3.open('/db', vfs: memory.name);
+    addTearDown(db.close);
+    db
+      ..execute('CREATE TABLE foo (bar TEXT);')
+      ..execute('INSERT INTO foo (bar) VALUES (?)', ['a' * 100000]);
+
+    final clone = memory.clone(name: 'dart-clone');
+    sqlite3.registerVirtualFileSystem(clone);
+    addTearDown(() => sqlite3.unregisterVirtualFileSystem(clone));
+
+    // Writes to either database must not be visible in the other one.
+    db.execute('INSERT INTO foo (bar) VALUES (?)', ['b']);
+    final cloned = sqlite3.open('/db', vfs: clone.name);
+    addTearDown(cloned.close);
+    expect(cloned.select('SELECT * FROM foo'), hasLength(1));
+
+    cloned.execute('DELETE FROM foo');
+    expect(db.select('SELECT * FROM foo'), hasLength(2));
+    expect(cloned.select('PRAGMA integrity_check'), [
+      {'integrity_check': 'ok'},
+    ]);
+  });
+
+  test('memory files are sparse and copy on write', () {
+    final file = MemoryFile(chunkSize: 16);
+    file.write(Uint8List.fromList([1, 2, 3]), 14);
+    file.length = 100;
+    expect(file.length, 100);
+
+    final snapshot = file.snapshot();
+    file.write(Uint8List.fromList([4, 4]), 15);
+    file.length = 15;
+    file.length = 17;
+
+    expect(file.toBytes(), [...Uint8List(14), 1, 0, 0]);
+    expect(snapshot.toBytes(), [...Uint8List(14), 1, 2, 3, ...Uint8List(83)]);
+
+    final target = Uint8List.fromList([9, 9, 9, 9]);
+    expect(snapshot.read(target, 98), 2);
+    expect(target, [0, 0, 9, 9]);
+  });
+
+  test('fileData exposes mutable buffers', () {
+    final memory = InMemoryFileSystem(name: 'dart-file-data');
+    sqlite3.registerVirtualFileSystem(memory);
+    addTearDown(() => sqlite3.unregisterVirtualFileSystem(memory));
+
+    sqlite3.open('/app.db', vfs: memory.name)
+      ..execute('CREATE TABLE foo (bar TEXT);')
+      ..close();
+
+    // ignore: deprecated_member_use
+    final buffer = memory.fileData['/app.db']!;
+    // ignore: deprecated_member_use
+    expect(memory.fileData['/app.db'], same(buffer));
+
+    // Corrupting the header through the buffer affects the file system.
+    buffer[0] = 0;
+    final db = sqlite3.open('/app.db', vfs: memory.name);
+    expect(
+      () => db.select('SELECT * FROM sqlite_schema'),
+      throwsA(isA<SqliteException>()),
+    );
+    db.close();
+
+    // Writes through the file system are visible in the buffer too.
+    memory.files['/app.db']!.write(Uint8List.fromList([83]), 0);
+    expect(buffer[0], 83);
+    expect(buffer, hasLength(memory.files['/app.db']!.length));
+  });
+
+  test('can measure file systems', () {
+    final measured = MeasuredFileSystem(
+      InMemoryFileSystem(),
+      name: 'dart-measured',
+    );
+    sqlite3.registerVirtualFileSystem(measured);
+    addTearDown(() => sqlite3.unregisterVirtualFileSystem(measured));
+
+    final db = sqlite3.open('/db', vfs: measured.name);
+    addTearDown(db.close);
+    db
+      ..execute('CREATE TABLE foo (bar TEXT);')
+      ..execute('INSERT INTO foo (bar) VALUES (?)', ['a' * 10000]);
+
+    final stats = measured.statistics;
+    final writes = stats.operation(
+      VfsOperation.write,
+      kind: VfsFileKind.mainDatabase,
+    );
+    expect(writes.count, isPositive);
+    expect(writes.bytes, greaterThan(10000));
+    expect(writes.latency.samples, writes.count);
+    expect(
+      stats.operation(VfsOperation.write, kind: VfsFileKind.journal).count,
+      isPositive,
+    );
+    expect(
+      stats.operation(VfsOperation.write).count,
+      greaterThan(writes.count),
+    );
+
+    measured.reset();
+    expect(measured.statistics.operation(VfsOperation.read).count, isZero);
+  });
+
+  test('attributes files that have not been opened by their name', () {
+    final measured = MeasuredFileSystem(InMemoryFileSystem());
+
+    measured
+      ..xAccess('/db', 0)
+      ..xAccess('/db-journal', 0)
+      ..xAccess('/db-wal', 0)
+      ..xAccess('/db-mj1A2B3C4D', 0);
+
+    final stats = measured.statistics;
+    for (final kind in [VfsFileKind.mainDatabase, VfsFileKind.wal]) {
+      expect(stats.operation(VfsOperation.access, kind: kind).count, 1);
+    }
+    expect(
+      stats.operation(VfsOperation.access, kind: VfsFileKind.journal).count,
+      2,
+    );
+  });
+
+  test('can sample latencies', () {
+    final measured = MeasuredFileSystem(
+      InMemoryFileSystem(),
+      name: 'dart-sampled',
+      latencySampleInterval: 4,
+    );
+    sqlite3.registerVirtualFileSystem(measured);
+    addTearDown(() => sqlite3.unregisterVirtualFileSystem(measured));
+
+    final db = sqlite3.open('/db', vfs: measured.name);
+    addTearDown(db.close);
+    for (var i = 0; i < 10; i++) {
+      db.execute('CREATE TABLE foo$i (bar TEXT);');
+    }
+
+    final total = measured.statistics.byKind.values
+        .expand((operations) => operations.values)
+        .fold((count: 0, samples: 0), (sum, stats) {
+          return (
+            count: sum.count + stats.count,
+            samples: sum.samples + stats.latency.samples,
+          );
+        });
+    expect(total.samples, (total.count / 4).ceil());
+  });
+
   test(
     'can use atomic writes',
     () {
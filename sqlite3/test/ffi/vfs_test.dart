@@ -1,11 +1,130 @@
 @Tags(['ffi'])
 library;
 
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:isolate';
+
 import 'package:sqlite3/sqlite3.dart';
+import 'package:sqlite3/src/ffi/vfs_proxy.dart';
 import 'package:test/test.dart';
 
+import '../common/utils.dart';
 import '../common/vfs.dart';
 
 void main() {
   testVfs(() => sqlite3);
+
+  test('cannot unregister dart file systems with open files', () {
+    final vfs = InMemoryFileSystem(name: 'dart-open-files');
+    sqlite3.registerVirtualFileSystem(vfs);
+
+    final database = sqlite3.open('/database', vfs: vfs.name);
+    expect(() => sqlite3.unregisterVirtualFileSystem(vfs), throwsStateError);
+    database.select('SELECT 1');
+
+    database.close();
+    sqlite3.unregisterVirtualFileSystem(vfs);
+  });
+
+  test('dart file systems can be used on other isolates', () async {
+    try {
+      vfsProxyDestroy(nullptr);
+    } on ArgumentError {
+      markTestSkipped('Not compiled by the build hook');
+      return;
+    }
+
+    final vfs = InMemoryFileSystem(name: 'dart-other-isolates');
+    sqlite3.registerVirtualFileSystem(vfs);
+    addTearDown(() => sqlite3.unregisterVirtualFileSystem(vfs));
+
+    await Isolate.run(() {
+      sqlite3.open('/database', vfs: 'dart-other-isolates')
+        ..execute('CREATE TABLE foo (bar TEXT);')
+        ..execute("INSERT INTO foo VALUES ('from another isolate');")
+        ..close();
+    });
+
+    final database = sqlite3.open('/database', vfs: vfs.name);
+    expect(database.select('SELECT * FROM foo'), [
+      {'bar': 'from another isolate'},
+    ]);
+    database.close();
+  });
+
+  test('io_uring vfs', () {
+    try {
+      sqlite3.registerUringVfs();
+    } on UnsupportedError {
+      // Set by the CI job compiling SQLite with the io_uring VFS.
+      if (Platform.environment.containsKey('SQLITE3_TEST_URING')) rethrow;
+      markTestSkipped('Not compiled with the uring_vfs option');
+      return;
+    }
+
+    final directory = Directory.systemTemp.createTempSync('sqlite3-uring');
+    addTearDown(() => directory.deleteSync(recursive: true));
+
+    final path = '${directory.path}/test.db';
+    var db = sqlite3.open(path, vfs: 'unix-uring');
+    db
+      ..execute('PRAGMA cache_size = 10;')
+      ..execute('CREATE TABLE foo (id INTEGER PRIMARY KEY, bar BLOB);')
+      ..execute('''
+WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 5000)
+INSERT INTO foo (bar) SELECT randomblob(200) FROM n;
+''');
+    // Scanning the table issues sequential reads, which are prefetched.
+    expect(db.select('SELECT count(*) AS c FROM foo'), [
+      {'c': 5000},
+    ]);
+    // The file system falls back to the unix VFS when io_uring is unavailable,
+    // make sure that didn't happen.
+    expect(
+      db.select('PRAGMA uring_submissions').single.values.single,
+      isA<String>().having(int.parse, 'int.parse', greaterThan(0)),
+    );
+    db
+      ..execute('PRAGMA journal_mode = WAL;')
+      ..execute('UPDATE foo SET bar = randomblob(100);')
+      ..close();
+
+    // The file should be readable by the default VFS.
+    db = sqlite3.open(path);
+    addTearDown(db.close);
+    expect(db.select('PRAGMA integrity_check'), [
+      {'integrity_check': 'ok'},
+    ]);
+    expect(db.select('SELECT sum(length(bar)) AS s FROM foo'), [
+      {'s': 500000},
+    ]);
+  });
+
+  test('io_uring vfs reports failed writes before committing', () {
+    if (!Platform.isLinux) {
+      markTestSkipped('Requires /dev/full');
+      return;
+    }
+
+    try {
+      sqlite3.registerUringVfs();
+    } on UnsupportedError {
+      markTestSkipped('Not compiled with the uring_vfs option');
+      return;
+    }
+
+    // All writes to /dev/full fail with ENOSPC. Without syncs, batched writes
+    // must still be completed before the transaction is committed.
+    final db = sqlite3.open('/dev/full', vfs: 'unix-uring');
+    addTearDown(db.close);
+    db
+      ..execute('PRAGMA journal_mode = MEMORY;')
+      ..execute('PRAGMA synchronous = OFF;');
+
+    expect(
+      () => db.execute('CREATE TABLE foo (bar TEXT);'),
+      throwsSqlError(SqlError.SQLITE_FULL, SqlError.SQLITE_FULL),
+    );
+  });
 }
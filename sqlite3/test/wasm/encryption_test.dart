@@ -50,10 +50,12 @@ void main() {
     }
 
     // Replace with encrypted copy.
+    // ignore: deprecated_member_use
     memory.fileData['/app.db'] = Uint8Buffer()
       ..addAll(
         _encryptDatabase(
           ciphers,
+          // ignore: deprecated_member_use
           memory.fileData['/app.db']!.buffer.asUint8List(),
           'encryption key',
         ),
@@ -71,10 +73,12 @@ void main() {
     }
 
     // Replace with decrypted database
+    // ignore: deprecated_member_use
     memory.fileData['/app.db'] = Uint8Buffer()
       ..addAll(
         _decryptDatabase(
           ciphers,
+          // ignore: deprecated_member_use
           memory.fileData['/app.db']!.buffer.asUint8List(),
           'encryption key',
         ),
@@ -96,6 +100,7 @@ Uint8List _encryptDatabase(
   String key,
 ) {
   final vfs = InMemoryFileSystem(name: 'encrypt');
+  // ignore: deprecated_member_use
   vfs.fileData['/app.db'] = Uint8Buffer()..addAll(decrypted);
   bindings.registerVirtualFileSystem(vfs);
 
@@ -104,6 +109,7 @@ Uint8List _encryptDatabase(
   db.close();
   bindings.unregisterVirtualFileSystem(vfs);
 
+  // ignore: deprecated_member_use
   final data = vfs.fileData['/app.db']!;
   return data.buffer.asUint8List(data.offsetInBytes, data.lengthInBytes);
 }
@@ -114,6 +120,7 @@ Uint8List _decryptDatabase(
   String key,
 ) {
   final vfs = InMemoryFileSystem(name: 'decrypt');
+  // ignore: deprecated_member_use
   vfs.fileData['/app.db'] = Uint8Buffer()..addAll(decrypted);
   bindings.registerVirtualFileSystem(vfs);
 
@@ -123,6 +130,7 @@ Uint8List _decryptDatabase(
   db.close();
   bindings.unregisterVirtualFileSystem(vfs);
 
+  // ignore: deprecated_member_use
   final data = vfs.fileData['/app.db']!;
   return data.buffer.asUint8List(data.offsetInBytes, data.lengthInBytes);
 }
@@ -123,6 +123,108 @@ Future<void> main() async {
       await IndexedDbFileSystem.deleteDatabase(name);
     });
 
+    test('coalesces writes to blocks until flushed', () async {
+      final name = _randomName();
+      final fs = await IndexedDbFileSystem.open(
+        dbName: name,
+        random: random,
+        writeAutomatically: false,
+        blockSize: 1024,
+      );
+      addTearDown(() => IndexedDbFileSystem.deleteDatabase(name));
+
+      final file = fs
+          .xOpen(Sqlite3Filename('/database'), SqlFlag.SQLITE_OPEN_CREATE)
+          .file;
+      for (var i = 0; i < 10; i++) {
+        file.xWrite(Uint8List.fromList([i, i, i]), 100 * i);
+      }
+      file.xWrite(Uint8List(10), 1020);
+      file.xTruncate(1500);
+      await fs.flush();
+
+      // All writes touch the first two blocks, which are only written once.
+      expect(fs.writeStatistics.transactions, 1);
+      expect(fs.writeStatistics.blocksWritten, 2);
+      expect(fs.writeStatistics.bytesWritten, 2048);
+      await fs.close();
+
+      final reopened = await IndexedDbFileSystem.open(
+        dbName: name,
+        random: random,
+      );
+      final reopenedFile = reopened
+          .xOpen(Sqlite3Filename('/database'), 0)
+          .file;
+      expect(reopenedFile.xFileSize(), 1500);
+
+      final target = Uint8List(3);
+      reopenedFile.xRead(target, 900);
+      expect(target, [9, 9, 9]);
+      await reopened.close();
+    });
+
+    test('uses blocks readable by older versions by default', () async {
+      final name = _randomName();
+      final fs = await IndexedDbFileSystem.open(
+        dbName: name,
+        random: random,
+        writeAutomatically: false,
+      );
+      addTearDown(() => IndexedDbFileSystem.deleteDatabase(name));
+
+      fs
+          .xOpen(Sqlite3Filename('/database'), SqlFlag.SQLITE_OPEN_CREATE)
+          .file
+          .xWrite(Uint8List(5000), 0);
+      await fs.flush();
+
+      expect(fs.writeStatistics.blocksWritten, 2);
+      expect(fs.writeStatistics.bytesWritten, 8192);
+      await fs.close();
+    });
+
+    test('does not persist writes made during a flush early', () async {
+      final name = _randomName();
+      final fs = await IndexedDbFileSystem.open(
+        dbName: name,
+        random: random,
+        writeAutomatically: false,
+        blockSize: 1024,
+      );
+      addTearDown(() => IndexedDbFileSystem.deleteDatabase(name));
+
+      final file = fs
+          .xOpen(Sqlite3Filename('/database'), SqlFlag.SQLITE_OPEN_CREATE)
+          .file;
+      file.xWrite(Uint8List.fromList([1, 1, 1]), 0);
+      final flush = fs.flush();
+      // These writes happen after the flush has started, they must not be
+      // included in it.
+      file.xWrite(Uint8List.fromList([2, 2, 2]), 0);
+      file.xWrite(Uint8List.fromList([2, 2, 2]), 2000);
+      await flush;
+
+      Future<(int, List<int>)> readPersisted() async {
+        final other = await IndexedDbFileSystem.open(
+          dbName: name,
+          random: random,
+        );
+        final otherFile = other.xOpen(Sqlite3Filename('/database'), 0).file;
+        final target = Uint8List(3);
+        otherFile.xRead(target, 0);
+        final result = (otherFile.xFileSize(), target.toList());
+        await other.close();
+        return result;
+      }
+
+      expect(await readPersisted(), (3, [1, 1, 1]));
+
+      await fs.flush();
+      expect(await readPersisted(), (2003, [2, 2, 2]));
+      await fs.close();
+    });
+
     test(
       'example with frequent writes',
       () async {
@@ -196,8 +196,21 @@ void main() {
     });
 
     // See worker.dart for the supported backends
-    for (final backend in ['memory', 'opfs-simple', 'opfs', 'indexeddb']) {
-      final requiresSab = backend == 'opfs';
+    for (final backend in [
+      'memory',
+      'opfs-simple',
+      'opfs-simple-atomic',
+      'opfs-simple-deferred',
+      'opfs',
+      'opfs-deferred',
+      'indexeddb',
+      'indexeddb-lazy',
+    ]) {
+      final requiresSab = const {
+        'opfs',
+        'opfs-deferred',
+        'indexeddb-lazy',
+      }.contains(backend);
       final missingSab = requiresSab && globalContext.has('SharedArrayBuffer');
 
       test(
@@ -234,9 +247,9 @@ void main() {
                   'on this platform with a simple `dart test` setup.'
             : null,
         onPlatform: {
-          if (backend == 'opfs')
+          if (backend == 'opfs' || backend == 'opfs-deferred')
             'chrome || edge': Skip('todo: Always times out in GitHub actions'),
-          if (backend == 'opfs')
+          if (backend == 'opfs' || backend == 'opfs-deferred')
             'firefox': Skip('todo: Currently broken in firefox'),
         },
       );
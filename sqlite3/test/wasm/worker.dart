@@ -1,7 +1,10 @@
 import 'dart:async';
 
 import 'dart:js_interop';
+import 'dart:js_interop_unsafe';
+import 'dart:typed_data';
 
+import 'package:sqlite3/src/wasm/vfs/async_opfs/client.dart' show WasmFile;
 import 'package:sqlite3/wasm.dart';
 import 'package:web/web.dart' as web;
 
@@ -24,6 +27,8 @@ void main() {
           final wasmUri = Uri.parse((rawData.toDart[1] as JSString).toDart);
 
           _startTest(backend, wasmUri);
+        } else if ((rawData as JSObject).has('databaseName')) {
+          _startIndexedDbServer(rawData as IndexedDbWorkerOptions);
         } else {
           _startOpfsServer(rawData as WorkerOptions);
         }
@@ -55,6 +60,29 @@ Future<void> _startTest(String fsImplementation, Uri wasmUri) async {
         wasmUri: wasmUri,
       );
       break;
+    case 'indexeddb-lazy':
+      test = _runTest(
+        open: () async {
+          // Like for OPFS, IndexedDB operations run in another worker.
+          final options = LazyIndexedDbFileSystem.createWorkerOptions(
+            'worker-test-lazy',
+          );
+
+          final worker = web.Worker(scope.location.href.toJS);
+          worker.postMessage(options);
+          await web.EventStreamProviders.messageEvent.forTarget(worker).first;
+
+          return LazyIndexedDbFileSystem.open(
+            options: options,
+            maxCachedBlocks: 16,
+          );
+        },
+        close: (fs) async {
+          fs.close();
+        },
+        wasmUri: wasmUri,
+      );
+      break;
     case 'opfs-simple':
       test = _runTest(
         open: () => SimpleOpfsFileSystem.loadFromStorage('worker-test'),
@@ -64,23 +92,91 @@ Future<void> _startTest(String fsImplementation, Uri wasmUri) async {
         wasmUri: wasmUri,
       );
       break;
+    case 'opfs-simple-atomic':
+      test = _runTest(
+        open: () => SimpleOpfsFileSystem.loadFromStorage(
+          'worker-test-atomic',
+          batchAtomicWrites: true,
+        ),
+        close: (fs) async {
+          fs.close();
+        },
+        wasmUri: wasmUri,
+      ).then((_) => _testUncommittedAtomicWrite(wasmUri));
+      break;
+    case 'opfs-simple-deferred':
+      test = _runTest(
+        open: () => SimpleOpfsFileSystem.loadFromStorage(
+          'worker-test-deferred',
+          durability: const DurabilityPolicy.interval(Duration(minutes: 1)),
+        ),
+        close: (fs) async {
+          final statistics = fs.flushStatistics;
+          _expect(
+            statistics.flushes < statistics.syncs,
+            'Syncs should not flush immediately, got $statistics',
+          );
+          fs.close();
+        },
+        wasmUri: wasmUri,
+      );
+      break;
     case 'opfs':
+      Future<WasmVfs> open() async {
+        // Start another worker with this entrypoint to launch the OPFS
+        // server needed for synchronous access.
+        final options = WasmVfs.createOptions();
+
+        final worker = web.Worker(scope.location.href.toJS);
+        worker.postMessage(options);
+
+        // Wait for the worker to acknowledge it being ready
+        await web.EventStreamProviders.messageEvent.forTarget(worker).first;
+
+        return WasmVfs(workerOptions: options);
+      }
+
+      test = _runTest(
+        open: open,
+        close: (vfs) async {
+          vfs.close();
+        },
+        wasmUri: wasmUri,
+      ).then((_) async => _testWasmVfsFiles(await open()));
+      break;
+    case 'opfs-deferred':
+      // Flush statistics are tracked by the worker hosting the file system,
+      // which reports them once it's stopped.
+      late Future<web.MessageEvent> stopped;
+
       test = _runTest(
         open: () async {
-          // Start another worker with this entrypoint to launch the OPFS
-          // server needed for synchronous access.
-          final options = WasmVfs.createOptions();
+          final options = WasmVfs.createOptions(
+            root: 'pkg_sqlite3_db_deferred/',
+            durability: const DurabilityPolicy.interval(Duration(minutes: 1)),
+          );
 
           final worker = web.Worker(scope.location.href.toJS);
+          final messages = web.EventStreamProviders.messageEvent.forTarget(
+            worker,
+          );
+          final ready = messages.first;
+          stopped = messages.skip(1).first;
           worker.postMessage(options);
-
-          // Wait for the worker to acknowledge it being ready
-          await web.EventStreamProviders.messageEvent.forTarget(worker).first;
+          await ready;
 
           return WasmVfs(workerOptions: options);
         },
         close: (vfs) async {
           vfs.close();
+          final [syncs, flushes] = [
+            for (final value in ((await stopped).data as JSArray).toDart)
+              (value as JSNumber).toDartInt,
+          ];
+          _expect(
+            flushes < syncs,
+            'Syncs should not flush immediately, got $flushes of $syncs',
+          );
         },
         wasmUri: wasmUri,
       );
@@ -102,6 +198,20 @@ Future<void> _startOpfsServer(WorkerOptions options) async {
     [true.toJS].toJS,
   );
   await worker.start();
+
+  // Report flush statistics to the 'opfs-deferred' test.
+  final statistics = worker.flushStatistics;
+  (globalContext as web.DedicatedWorkerGlobalScope).postMessage(
+    [statistics.syncs.toJS, statistics.flushes.toJS].toJS,
+  );
+}
+
+Future<void> _startIndexedDbServer(IndexedDbWorkerOptions options) async {
+  final worker = await IndexedDbVfsWorker.create(options);
+  (globalContext as web.DedicatedWorkerGlobalScope).postMessage(
+    [true.toJS].toJS,
+  );
+  await worker.start();
 }
 
 void _expect(bool condition, String reason) {
@@ -170,3 +280,124 @@ Future<void> _runTest<T extends VirtualFileSystem>({
   );
   database2.close();
 }
+
+/// Checks that transactions using batch atomic writes don't create a journal
+/// and leave no trace in the database file if they don't commit.
+Future<void> _testUncommittedAtomicWrite(Uri wasmUri) async {
+  Future<CommonDatabase> openDatabase(VirtualFileSystem fs) async {
+    final sqlite3 = await WasmSqlite3.loadFromUrl(wasmUri);
+    sqlite3.registerVirtualFileSystem(fs, makeDefault: true);
+    return sqlite3.open('database');
+  }
+
+  Future<SimpleOpfsFileSystem> open() {
+    return SimpleOpfsFileSystem.loadFromStorage(
+      'worker-test-uncommitted',
+      batchAtomicWrites: true,
+    );
+  }
+
+  final fileSystem = await open();
+  final measured = MeasuredFileSystem(fileSystem);
+  final database = await openDatabase(measured);
+  // The first transaction creating the database always uses a journal.
+  database.execute('CREATE TABLE foo (bar INTEGER);');
+  database.execute('INSERT INTO foo VALUES (1);');
+
+  measured.reset();
+  database.execute('BEGIN');
+  for (var i = 2; i <= 100; i++) {
+    database.execute('INSERT INTO foo VALUES (?);', [i]);
+  }
+
+  // Without batch atomic writes, sqlite3 would open the journal and write the
+  // original pages into it as soon as they're changed.
+  final statistics = measured.statistics;
+  _expect(
+    statistics.operation(VfsOperation.open, kind: VfsFileKind.journal).count ==
+        0,
+    'Transaction should not open a journal, got $statistics',
+  );
+  _expect(
+    statistics.operation(VfsOperation.write).count == 0,
+    'Nothing should be written before the commit, got $statistics',
+  );
+  _expect(
+    fileSystem.xAccess('/database-journal', 0) == 0,
+    'Transaction should not use a journal',
+  );
+
+  // Simulate the worker being terminated before the transaction commits.
+  fileSystem.close();
+
+  final fileSystem2 = await open();
+  final database2 = await openDatabase(fileSystem2);
+
+  _expect(
+    database2.select('SELECT * FROM foo').length == 1,
+    'Uncommitted rows should not be visible',
+  );
+  _expect(
+    database2.select('PRAGMA integrity_check').single.values.single == 'ok',
+    'Database should be intact',
+  );
+  database2.close();
+  fileSystem2.close();
+}
+
+/// Checks that files of a [WasmVfs] see their own batched writes, both in
+/// reads served by the read-ahead cache and in their cached size, and that
+/// failed batches are reported when syncing files.
+void _testWasmVfsFiles(WasmVfs vfs) {
+  final file = vfs
+      .xOpen(Sqlite3Filename('/batched'), SqlFlag.SQLITE_OPEN_CREATE)
+      .file;
+  file.xLock(SqlFileLockingLevels.SQLITE_LOCK_SHARED);
+  file.xTruncate(0);
+
+  for (var i = 0; i < 64; i++) {
+    file.xWrite(Uint8List(4096)..fillRange(0, 4096, i), i * 4096);
+  }
+  _expect(file.xFileSize() == 64 * 4096, 'Size should include batched writes');
+
+  // Sequential reads populate the read-ahead cache.
+  final page = Uint8List(4096);
+  for (var i = 0; i < 4; i++) {
+    file.xRead(page, i * 4096);
+    _expect(page.every((b) => b == i), 'Should read page $i');
+  }
+
+  // Writes to cached pages and past the end of the file must be visible.
+  file.xWrite(Uint8List(4096)..fillRange(0, 4096, 100), 4 * 4096);
+  file.xWrite(Uint8List(4096)..fillRange(0, 4096, 101), 64 * 4096);
+  file.xRead(page, 4 * 4096);
+  _expect(page.every((b) => b == 100), 'Should see write to cached page');
+  _expect(file.xFileSize() == 65 * 4096, 'Size should include appended page');
+  file.xRead(page, 64 * 4096);
+  _expect(page.every((b) => b == 101), 'Should read appended page');
+
+  file.xTruncate(4096);
+  _expect(file.xFileSize() == 4096, 'Size should reflect truncate');
+  file.xSync(0);
+
+  // A write to a file the worker doesn't know fails the batch, which must be
+  // reported by the file it was batched with, not by unrelated operations.
+  file.xWrite(Uint8List(10), 0);
+  WasmFile(vfs, 999999).xWrite(Uint8List(10), 0);
+  vfs.xAccess('/batched', 0);
+
+  var syncFailed = false;
+  try {
+    file.xSync(0);
+  } on VfsException {
+    syncFailed = true;
+  }
+  _expect(syncFailed, 'Sync should report the failed batch');
+  // The error is only reported once.
+  file.xSync(0);
+
+  file.xUnlock(SqlFileLockingLevels.SQLITE_LOCK_NONE);
+  file.xClose();
+  vfs.xDelete('/batched', 0);
+  vfs.close();
+}
@@ -0,0 +1,88 @@
+import 'dart:io';
+
+import 'package:sqlite3/sqlite3.dart';
+
+/// Compares the cost of reading and writing pages through a file system
+/// implemented in Dart with the default file system of sqlite3.
+///
+/// When SQLite has been compiled with the `uring_vfs` option, this also
+/// measures the `unix-uring` file system.
+///
+/// With a tiny page cache, each page read by a full table scan results in a
+/// call into the file system. For the Dart file system, this includes the
+/// callback from native code into Dart.
+///
+/// Usage: `dart run tool/vfs_benchmark.dart [iterations]`
+void main(List<String> args) {
+  final iterations = args.isEmpty ? 20 : int.parse(args.single);
+  final directory = Directory.systemTemp.createTempSync('sqlite3-vfs-bench');
+
+  final memory = InMemoryFileSystem(name: 'dart-benchmark');
+  sqlite3.registerVirtualFileSystem(memory);
+
+  var hasUring = true;
+  try {
+    sqlite3.registerUringVfs();
+  } on UnsupportedError {
+    hasUring = false;
+  }
+
+  try {
+    _benchmark(
+      'default VFS',
+      sqlite3.open('${directory.path}/bench.db'),
+      iterations,
+    );
+    if (hasUring) {
+      _benchmark(
+        'io_uring VFS',
+        sqlite3.open('${directory.path}/bench-uring.db', vfs: 'unix-uring'),
+        iterations,
+      );
+    }
+    _benchmark(
+      'Dart VFS (InMemoryFileSystem)',
+      sqlite3.open('/bench.db', vfs: memory.name),
+      iterations,
+    );
+  } finally {
+    sqlite3.unregisterVirtualFileSystem(memory);
+    directory.deleteSync(recursive: true);
+  }
+}
+
+void _benchmark(String name, Database db, int iterations) {
+  db
+    ..execute('PRAGMA cache_size = 10;')
+    // Only measure callbacks, not the cost of syncing files to disk.
+    ..execute('PRAGMA synchronous = OFF;')
+    ..execute('CREATE TABLE t (id INTEGER PRIMARY KEY, payload BLOB);')
+    ..execute('''
+WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 20000)
+INSERT INTO t (payload) SELECT randomblob(200) FROM n;
+''');
+  final pages = db.select('PRAGMA page_count').single.columnAt(0) as int;
+
+  final reads = Stopwatch()..start();
+  for (var i = 0; i < iterations; i++) {
+    db.select('SELECT sum(length(payload)) FROM t');
+  }
+  reads.stop();
+
+  final writes = Stopwatch()..start();
+  for (var i = 0; i < iterations; i++) {
+    db.execute('UPDATE t SET payload = randomblob(200);');
+  }
+  writes.stop();
+  db.close();
+
+  String perPage(Stopwatch watch) {
+    final micros = watch.elapsedMicroseconds / (iterations * pages);
+    return '${micros.toStringAsFixed(2)}µs/page';
+  }
+
+  print(
+    '$name ($pages pages): reads ${perPage(reads)}, '
+    'writes ${perPage(writes)}',
+  );
+}
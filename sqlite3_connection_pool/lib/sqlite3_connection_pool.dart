@@ -2,3 +2,4 @@ export 'src/abort_exception.dart';
 export 'src/connection.dart' show PoolConnection;
 export 'src/raw.dart' show PoolConnections;
 export 'src/pool.dart';
+export 'src/updates.dart' hide TableUpdateDecoder;
@@ -109,6 +109,10 @@ final class PoolConnection {
     );
   }
 
+  /// Returns how often each statement in the prepared statement cache of this
+  /// connection has been used.
+  Map<String, int> get cachedStatementHits => _ref.cachedStatementHits();
+
   /// A call to this method invalidates all prior [lookupCachedStatement] return
   /// values, as the underlying statement could have been evicted from this
   /// call.
@@ -34,6 +34,11 @@ external void pkg_sqlite3_connection_pool_close_uninitialized(
   ffi.Pointer<UninitializedPool> uninitialized,
 );
 
+@ffi.Native<ffi.Void Function(ffi.Pointer<PoolConnection>)>()
+external void pkg_sqlite3_connection_pool_idle_reader_close(
+  ffi.Pointer<PoolConnection> connection,
+);
+
 @ffi.Native<
   ffi.Pointer<ConnectionPool> Function(
     ffi.Pointer<UninitializedPool>,
@@ -76,6 +81,14 @@ external ffi.Pointer<PoolRequest> pkg_sqlite3_connection_pool_obtain_exclusive(
   int port,
 );
 
+@ffi.Native<
+  ffi.Pointer<PoolConnection> Function(ffi.Pointer<ConnectionPool>)
+>(isLeaf: true)
+external ffi.Pointer<PoolConnection>
+pkg_sqlite3_connection_pool_obtain_idle_reader(
+  ffi.Pointer<ConnectionPool> pool,
+);
+
 @ffi.Native<
   ffi.Pointer<PoolRequest> Function(
     ffi.Pointer<ConnectionPool>,
@@ -91,6 +104,22 @@ external ffi.Pointer<PoolRequest> pkg_sqlite3_connection_pool_obtain_single(
   int read,
 );
 
+@ffi.Native<
+  ffi.Pointer<PoolRequest> Function(
+    ffi.Pointer<ConnectionPool>,
+    ffi.Int64,
+    ffi.Int64,
+    ffi.UintPtr,
+  )
+>(isLeaf: true)
+external ffi.Pointer<PoolRequest>
+pkg_sqlite3_connection_pool_obtain_snapshot_group(
+  ffi.Pointer<ConnectionPool> pool,
+  int tag,
+  int port,
+  int readers,
+);
+
 @ffi.Native<
   ffi.Void Function(
     ffi.Pointer<ffi.Uint8>,
@@ -121,11 +150,21 @@ external void pkg_sqlite3_connection_pool_query_connections(
   int reader_count,
 );
 
+@ffi.Native<ffi.UintPtr Function(ffi.Pointer<ConnectionPool>)>()
+external int pkg_sqlite3_connection_pool_query_idle_reader_count(
+  ffi.Pointer<ConnectionPool> pool,
+);
+
 @ffi.Native<ffi.UintPtr Function(ffi.Pointer<ConnectionPool>)>()
 external int pkg_sqlite3_connection_pool_query_read_connection_count(
   ffi.Pointer<ConnectionPool> pool,
 );
 
+@ffi.Native<ffi.Void Function(ffi.Pointer<PoolRequest>)>()
+external void pkg_sqlite3_connection_pool_release_writer(
+  ffi.Pointer<PoolRequest> request,
+);
+
 @ffi.Native<ffi.Void Function(ffi.Pointer<PoolRequest>)>()
 external void pkg_sqlite3_connection_pool_request_close(
   ffi.Pointer<PoolRequest> request,
@@ -144,6 +183,23 @@ external ffi.Pointer<ffi.Void> pkg_sqlite3_connection_pool_stmt_cache_get(
   int sql_len,
 );
 
+@ffi.Native<
+  ffi.UintPtr Function(
+    ffi.Pointer<PoolConnection>,
+    ffi.Pointer<ffi.Pointer<ffi.Uint8>>,
+    ffi.Pointer<ffi.UintPtr>,
+    ffi.Pointer<ffi.Uint64>,
+    ffi.UintPtr,
+  )
+>(isLeaf: true)
+external int pkg_sqlite3_connection_pool_stmt_cache_hits(
+  ffi.Pointer<PoolConnection> connection,
+  ffi.Pointer<ffi.Pointer<ffi.Uint8>> sql,
+  ffi.Pointer<ffi.UintPtr> sql_len,
+  ffi.Pointer<ffi.Uint64> hits,
+  int capacity,
+);
+
 @ffi.Native<
   ffi.Int Function(
     ffi.Pointer<PoolConnection>,
@@ -186,6 +242,12 @@ class _SymbolAddresses {
   get pkg_sqlite3_connection_pool_close_uninitialized => ffi.Native.addressOf(
     self.pkg_sqlite3_connection_pool_close_uninitialized,
   );
+  ffi.Pointer<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<PoolConnection>)>
+  >
+  get pkg_sqlite3_connection_pool_idle_reader_close => ffi.Native.addressOf(
+    self.pkg_sqlite3_connection_pool_idle_reader_close,
+  );
   ffi.Pointer<ffi.NativeFunction<ffi.Void Function(ffi.Pointer<PoolRequest>)>>
   get pkg_sqlite3_connection_pool_request_close =>
       ffi.Native.addressOf(self.pkg_sqlite3_connection_pool_request_close);
@@ -242,6 +304,39 @@ final class ExternalFunctions extends ffi.Struct {
   >
   sqlite3_close_v2;
 
+  external ffi.Pointer<
+    ffi.NativeFunction<
+      ffi.Pointer<ffi.Char> Function(
+        ffi.Pointer<ffi.Void>,
+        ffi.Pointer<ffi.Char>,
+      )
+    >
+  >
+  sqlite3_db_filename;
+
+  external ffi.Pointer<
+    ffi.NativeFunction<
+      ffi.Int Function(
+        ffi.Pointer<ffi.Void>,
+        ffi.Pointer<ffi.Char>,
+        ffi.Int,
+        ffi.Pointer<ffi.Pointer<ffi.Void>>,
+        ffi.Pointer<ffi.Pointer<ffi.Char>>,
+      )
+    >
+  >
+  sqlite3_prepare_v2;
+
+  external ffi.Pointer<
+    ffi.NativeFunction<ffi.Int Function(ffi.Pointer<ffi.Void>)>
+  >
+  sqlite3_step;
+
+  external ffi.Pointer<
+    ffi.NativeFunction<ffi.Int64 Function(ffi.Pointer<ffi.Void>, ffi.Int)>
+  >
+  sqlite3_column_int64;
+
   external ffi.Pointer<
     ffi.NativeFunction<ffi.Int Function(ffi.Int64, ffi.Pointer<ffi.Void>)>
   >
@@ -291,6 +386,35 @@ final class ExternalFunctions extends ffi.Struct {
       ffi.NativeFunction<ffi.Int Function(ffi.Pointer<ffi.Void>)>
     >
     sqlite3_close_v2,
+    required ffi.Pointer<
+      ffi.NativeFunction<
+        ffi.Pointer<ffi.Char> Function(
+          ffi.Pointer<ffi.Void>,
+          ffi.Pointer<ffi.Char>,
+        )
+      >
+    >
+    sqlite3_db_filename,
+    required ffi.Pointer<
+      ffi.NativeFunction<
+        ffi.Int Function(
+          ffi.Pointer<ffi.Void>,
+          ffi.Pointer<ffi.Char>,
+          ffi.Int,
+          ffi.Pointer<ffi.Pointer<ffi.Void>>,
+          ffi.Pointer<ffi.Pointer<ffi.Char>>,
+        )
+      >
+    >
+    sqlite3_prepare_v2,
+    required ffi.Pointer<
+      ffi.NativeFunction<ffi.Int Function(ffi.Pointer<ffi.Void>)>
+    >
+    sqlite3_step,
+    required ffi.Pointer<
+      ffi.NativeFunction<ffi.Int64 Function(ffi.Pointer<ffi.Void>, ffi.Int)>
+    >
+    sqlite3_column_int64,
     required ffi.Pointer<
       ffi.NativeFunction<ffi.Int Function(ffi.Int64, ffi.Pointer<ffi.Void>)>
     >
@@ -302,6 +426,10 @@ final class ExternalFunctions extends ffi.Struct {
     ..ref.sqlite3_get_autocommit = sqlite3_get_autocommit
     ..ref.sqlite3_finalize = sqlite3_finalize
     ..ref.sqlite3_close_v2 = sqlite3_close_v2
+    ..ref.sqlite3_db_filename = sqlite3_db_filename
+    ..ref.sqlite3_prepare_v2 = sqlite3_prepare_v2
+    ..ref.sqlite3_step = sqlite3_step
+    ..ref.sqlite3_column_int64 = sqlite3_column_int64
     ..ref.dart_post_c_object = dart_post_c_object;
 }
 
@@ -320,6 +448,17 @@ final class InitializedPool extends ffi.Struct {
 
   @ffi.UnsignedChar()
   external int enable_update_hooks;
+
+  @ffi.UnsignedChar()
+  external int track_updated_rows;
+
+  @ffi.Uint32()
+  external int cross_process_poll_interval_ms;
+
+  external ffi.Pointer<ffi.Pointer<ffi.Char>> warmup_statements;
+
+  @ffi.UintPtr()
+  external int warmup_statement_count;
 }
 
 final class PoolConnection extends ffi.Struct {
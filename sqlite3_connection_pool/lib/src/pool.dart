@@ -10,6 +10,7 @@ import 'package:sqlite3/sqlite3.dart';
 import 'connection.dart';
 import 'mutex.dart';
 import 'raw.dart';
+import 'updates.dart';
 
 /// The result of calling [ConnectionLease.execute]. This provides access to the
 /// `autocommit` state (indicating whether the database is in a transaction) as
@@ -45,23 +46,30 @@ final class SqliteConnectionPool {
   /// will always share the same underlying pool.
   final String name;
   final RawSqliteConnectionPool _raw;
-  final StreamController<List<String>> _updatedTables =
+  final StreamController<List<TableUpdate>> _updates =
       StreamController.broadcast();
   RawReceivePort? _receiveTableUpdates;
 
+  /// Mergeable writes waiting to be run as part of the next group commit.
+  final List<_MergeableWrite> _pendingMergeableWrites = [];
+  bool _groupCommitScheduled = false;
+
   bool _isClosed = false;
 
   SqliteConnectionPool._(this.name, this._raw) {
-    _updatedTables.onListen = () {
+    _updates.onListen = () {
       assert(_receiveTableUpdates == null);
+      // The native pool tracks which table names it has sent to each port, so
+      // every new port needs a fresh decoder.
+      final decoder = TableUpdateDecoder();
       final port = _receiveTableUpdates = RawReceivePort(
-        (List<dynamic> msg) => _updatedTables.add(msg.cast()),
+        (Object? msg) => _updates.add(decoder.decode(msg)),
         'Receive table updates',
       );
       port.keepIsolateAlive = false;
       _raw.addUpdateListener(port.sendPort);
     };
-    _updatedTables.onCancel = () {
+    _updates.onCancel = () {
       if (_receiveTableUpdates case final port?) {
         port.close();
         _raw.removeUpdateListener(port.sendPort);
@@ -103,7 +111,19 @@ final class SqliteConnectionPool {
   /// For long-running writes that using multiple transactions,
   /// [ConnectionLease.notifyUpdates] can be used to emit updates before a
   /// writer is returned.
-  Stream<List<String>> get updatedTables => _updatedTables.stream;
+  Stream<List<String>> get updatedTables {
+    return updates.map((updates) => [for (final u in updates) u.table]);
+  }
+
+  /// A broadcast stream of updates made by write transactions on this
+  /// database.
+  ///
+  /// This emits the same events as [updatedTables], but also includes the
+  /// [TableUpdate.rows] affected by each write if
+  /// [PoolConnections.trackUpdatedRows] has been enabled when opening the pool.
+  /// This allows listeners to only invalidate data depending on rows that have
+  /// actually changed.
+  Stream<List<TableUpdate>> get updates => _updates.stream;
 
   /// Sends an update notification that will be emitted in [updatedTables].
   ///
@@ -136,9 +156,44 @@ final class SqliteConnectionPool {
   /// connection became available, the future may complete with an
   /// [PoolAbortException] instead.
   Future<ConnectionLease> reader({Future<void>? abortSignal}) async {
+    if (tryReader() case final lease?) {
+      return lease;
+    }
+
     return _requestReaderOrWriter(false, abortSignal);
   }
 
+  /// Synchronously obtains an idle read connection from the pool, or returns
+  /// `null` if no read connection is available right now.
+  ///
+  /// Unlike [reader], this doesn't lock the pool or wait for a message from
+  /// native code, making it cheap to use for short queries. It returns `null`
+  /// when all read connections are in use, or when other read requests are
+  /// waiting for a connection (to avoid starving them).
+  ///
+  /// Like with [reader], the returned [ConnectionLease] must be returned to the
+  /// pool with [ConnectionLease.returnLease].
+  ConnectionLease? tryReader() {
+    _checkNotClosed();
+    final request = _raw.tryObtainIdleReader();
+    if (request == null) {
+      return null;
+    }
+
+    final lease = ConnectionLease._(
+      PoolConnection.unsafeFromPointer(request.connection.connection),
+      request,
+      false,
+    );
+    // Like _rollbackPendingTransaction, but synchronously since we can't wait
+    // here. Read transactions are cheap to roll back.
+    final database = lease._connection.database;
+    if (!database.autocommit) {
+      database.execute('ROLLBACK');
+    }
+    return lease;
+  }
+
   /// Obtains a connection suitable for writes from the connection pool.
   ///
   /// There is only one write connection for the entire pool, so different
@@ -202,11 +257,245 @@ final class SqliteConnectionPool {
     return exclusive;
   }
 
+  /// Returns up to [limit] of the most frequently used statements in the
+  /// prepared statement caches of all connections, starting with the most used
+  /// statement.
+  ///
+  /// The result can be stored and passed to [PoolConnections.warmupStatements]
+  /// when opening the pool the next time. To read the caches consistently,
+  /// this temporarily obtains [exclusiveAccess] to the pool.
+  Future<List<String>> hotStatements({int limit = 32}) async {
+    final exclusive = await exclusiveAccess();
+    final hits = <String, int>{};
+    try {
+      for (final connection in [exclusive.writer, ...exclusive.readers]) {
+        final cached = connection.unsafeRawConnection.cachedStatementHits;
+        for (final MapEntry(:key, :value) in cached.entries) {
+          hits[key] = (hits[key] ?? 0) + value;
+        }
+      }
+    } finally {
+      exclusive.close();
+    }
+
+    final statements = hits.keys.where((sql) => hits[sql]! > 0).toList()
+      ..sort((a, b) => hits[b]!.compareTo(hits[a]!));
+    return statements.take(limit).toList();
+  }
+
+  /// Obtains [readers] read connections that all observe the same state of
+  /// the database.
+  ///
+  /// This can be used to split a report across multiple connections while
+  /// still getting consistent results. To ensure all connections see the same
+  /// snapshot, this briefly takes the write connection of the pool and locks
+  /// the database for writes (with `BEGIN IMMEDIATE`) while starting read
+  /// transactions on each reader. The write connection is returned to the pool
+  /// before this future completes. Connections are only taken once the writer
+  /// and enough readers are available at the same time, so waiting for a
+  /// group doesn't block writes.
+  ///
+  /// Read transactions are kept open until [SnapshotGroup.close] is called.
+  /// In WAL mode, SQLite does not checkpoint pages still needed by an active
+  /// read transaction, so the snapshot stays valid even when writes happen in
+  /// the meantime. Since open read transactions prevent checkpoints from
+  /// completing, groups should not be kept open longer than necessary.
+  ///
+  /// [readers] must be positive and not exceed the amount of read connections
+  /// in this pool.
+  ///
+  /// If an [abortSignal] is given and the future completes before the
+  /// connections became available, the future may complete with an
+  /// [PoolAbortException] instead.
+  Future<SnapshotGroup> snapshotGroup(
+    int readers, {
+    Future<void>? abortSignal,
+  }) async {
+    _checkNotClosed();
+    RangeError.checkValueInInterval(
+      readers,
+      1,
+      _raw.readConnectionCount,
+      'readers',
+    );
+
+    final (request, future) = _raw.requestSnapshotGroup(readers);
+    _installAbortSignal(request, abortSignal);
+    final connections = await future;
+
+    final group = SnapshotGroup._(request, connections.readers);
+    try {
+      await group._begin(
+        AsyncConnection._(
+          PoolConnection.unsafeFromPointer(connections.writer.connection),
+        ),
+      );
+    } on Object {
+      group.close();
+      rethrow;
+    }
+
+    return group;
+  }
+
+  /// Runs an aggregating query in parallel by splitting it into ranges of an
+  /// integer key, with each range running on a different read connection.
+  ///
+  /// The key range of [table] is determined by querying the minimum and
+  /// maximum of [keyColumn], which should be the `rowid` or an indexed integer
+  /// column. It is then split into equally-sized partitions. For each
+  /// partition, [sql] runs with [parameters] followed by the inclusive lower
+  /// and upper bound of the partition. Each result is converted with [map],
+  /// and results of all partitions are merged with [combine]:
+  ///
+  /// ```dart
+  /// final total = await pool.partitionedQuery(
+  ///   table: 'orders',
+  ///   sql: 'SELECT sum(amount) FROM orders WHERE rowid BETWEEN ? AND ?',
+  ///   map: (rows) => rows.single.columnAt(0) as int? ?? 0,
+  ///   combine: (a, b) => a + b,
+  /// );
+  /// ```
+  ///
+  /// Aggregates like `count` and `sum` can be merged by adding partial
+  /// results, `min` and `max` by taking the minimum or maximum of partial
+  /// results. Averages need to be computed from partial sums and counts.
+  ///
+  /// All partitions observe the same state of the database, as they run on a
+  /// [snapshotGroup]. By default, the query is split across the read
+  /// connections of the pool that are idle when calling this method (or
+  /// waits for one if none are). A different amount can be set with
+  /// [partitions]. If the table is empty, [sql] runs once with bounds not
+  /// matching any row. When the pool has no read connections, [sql] runs once
+  /// on the write connection.
+  ///
+  /// Throws an [ArgumentError] if [keyColumn] contains values that aren't
+  /// integers.
+  Future<T> partitionedQuery<T>({
+    required String table,
+    String keyColumn = 'rowid',
+    required String sql,
+    List<Object?> parameters = const [],
+    required T Function(ResultSet rows) map,
+    required T Function(T a, T b) combine,
+    int? partitions,
+  }) async {
+    _checkNotClosed();
+    final readers = _raw.readConnectionCount;
+    if (readers == 0) {
+      // There are no readers to split the query across. In that case, reader()
+      // resolves to the writer, on which we run the query once.
+      final connection = await reader();
+      try {
+        final (lower, upper) =
+            await _queryKeyRange(connection, table, keyColumn) ?? (1, 0);
+        final (rows, _) = await connection.select(sql, [
+          ...parameters,
+          lower,
+          upper,
+        ]);
+        return map(rows);
+      } finally {
+        connection.returnLease();
+      }
+    }
+
+    // Waiting for busy readers would usually take longer than running larger
+    // partitions on the readers available right now.
+    final group = await snapshotGroup(
+      (partitions ?? _raw.idleReadConnectionCount).clamp(1, readers),
+    );
+    try {
+      final first = group.readers.first;
+      final bounds = await _queryKeyRange(first, table, keyColumn);
+      if (bounds == null) {
+        final (rows, _) = await first.select(sql, [...parameters, 1, 0]);
+        return map(rows);
+      }
+
+      final ranges = _splitRange(bounds.$1, bounds.$2, group.readers.length);
+      final results = await Future.wait([
+        for (final (i, (lower, upper)) in ranges.indexed)
+          group.readers[i]
+              .select(sql, [...parameters, lower, upper])
+              .then((result) => map(result.$1)),
+      ]);
+
+      return results.reduce(combine);
+    } finally {
+      group.close();
+    }
+  }
+
+  /// Returns the smallest and largest value of [key] in [table], or `null` if
+  /// the table is empty.
+  static Future<(int, int)?> _queryKeyRange(
+    AsyncConnection connection,
+    String table,
+    String key,
+  ) async {
+    final (rows, _) = await connection.select(_keyRangeQuery(table, key));
+    return switch ((rows.single.columnAt(0), rows.single.columnAt(1))) {
+      (final int min, final int max) => (min, max),
+      (null, null) => null,
+      _ => throw ArgumentError.value(
+        key,
+        'keyColumn',
+        'Must only contain integers',
+      ),
+    };
+  }
+
+  static String _keyRangeQuery(String table, String key) {
+    String escape(String identifier) {
+      return '"${identifier.replaceAll('"', '""')}"';
+    }
+
+    return 'SELECT min(${escape(key)}), max(${escape(key)}) '
+        'FROM ${escape(table)}';
+  }
+
+  /// Splits the inclusive range from [min] to [max] into at most [count]
+  /// non-empty inclusive ranges.
+  static List<(int, int)> _splitRange(int min, int max, int count) {
+    // Use BigInt to avoid overflows for keys close to the bounds of int64.
+    final length = BigInt.from(max) - BigInt.from(min) + BigInt.one;
+    final partitions = BigInt.from(count) > length ? length.toInt() : count;
+    final step = length ~/ BigInt.from(partitions);
+
+    return [
+      for (var i = 0; i < partitions; i++)
+        (
+          (BigInt.from(min) + step * BigInt.from(i)).toInt(),
+          i == partitions - 1
+              ? max
+              : (BigInt.from(min) + step * BigInt.from(i + 1)).toInt() - 1,
+        ),
+    ];
+  }
+
   /// Executes the [sql] statement on the write connection.
+  ///
+  /// When [mergeable] is enabled, the statement may be grouped with other
+  /// mergeable writes issued on this pool instance while the write connection
+  /// is busy. All writes in such a group run back-to-back in a single
+  /// transaction, paying for one commit instead of one per statement. Each
+  /// write runs in its own savepoint, so a failing statement only rolls back
+  /// its own changes and completes its future with the error. The returned
+  /// future completes after the shared transaction has been committed.
+  ///
+  /// Mergeable writes must not contain transaction control statements like
+  /// `BEGIN` or `COMMIT`. If a statement ends the shared transaction anyway
+  /// (e.g. through `INSERT OR ROLLBACK`), all writes of that group fail.
   Future<ExecuteResult> execute(
     String sql, {
     List<Object?> parameters = const [],
+    bool mergeable = false,
   }) async {
+    if (mergeable) {
+      return _enqueueMergeableWrite(sql, parameters);
+    }
+
     final connection = await writer();
     try {
       return await connection.execute(sql, parameters);
@@ -215,6 +504,128 @@ final class SqliteConnectionPool {
     }
   }
 
+  Future<ExecuteResult> _enqueueMergeableWrite(
+    String sql,
+    List<Object?> parameters,
+  ) {
+    _checkNotClosed();
+    final write = _MergeableWrite(sql, parameters);
+    _pendingMergeableWrites.add(write);
+
+    if (!_groupCommitScheduled) {
+      _groupCommitScheduled = true;
+      _runGroupCommits();
+    }
+
+    return write.completer.future;
+  }
+
+  /// Drains [_pendingMergeableWrites], running all writes that have been
+  /// enqueued while waiting for the write connection in one transaction.
+  Future<void> _runGroupCommits() async {
+    try {
+      while (_pendingMergeableWrites.isNotEmpty) {
+        ConnectionLease connection;
+        try {
+          connection = await writer();
+        } catch (e, s) {
+          for (final write in _pendingMergeableWrites) {
+            write.completer.completeError(e, s);
+          }
+          _pendingMergeableWrites.clear();
+          continue;
+        }
+
+        // Writes enqueued while we were waiting for the writer are part of
+        // this group, later ones will be part of the next one.
+        final batch = _pendingMergeableWrites.toList();
+        _pendingMergeableWrites.clear();
+
+        try {
+          final statements = [
+            for (final write in batch) (write.sql, write.parameters),
+          ];
+          final results = await connection.unsafeAccessOnIsolate(
+            (conn) => _runGroupCommit(conn, statements),
+          );
+
+          for (final (i, (result, error)) in results.indexed) {
+            if (error case (final error, final trace)) {
+              batch[i].completer.completeError(error, trace);
+            } else {
+              batch[i].completer.complete(result!);
+            }
+          }
+        } catch (e, s) {
+          // The shared transaction could not be committed, so none of the
+          // writes took effect.
+          for (final write in batch) {
+            write.completer.completeError(e, s);
+          }
+        } finally {
+          connection.returnLease();
+        }
+      }
+    } finally {
+      _groupCommitScheduled = false;
+    }
+  }
+
+  static List<(ExecuteResult?, (Object, StackTrace)?)> _runGroupCommit(
+    PoolConnection conn,
+    List<(String, List<Object?>)> statements,
+  ) {
+    final db = conn.database;
+    final results = <(ExecuteResult?, (Object, StackTrace)?)>[];
+
+    db.execute('BEGIN IMMEDIATE');
+    try {
+      for (final (sql, parameters) in statements) {
+        db.execute('SAVEPOINT group_commit');
+        try {
+          conn.execute(sql, parameters);
+          results.add((AsyncConnection._execResult(db), null));
+          db.execute('RELEASE group_commit');
+        } catch (e, s) {
+          if (db.autocommit) {
+            // The statement rolled back the entire transaction, taking
+            // earlier writes of this group with it.
+            rethrow;
+          }
+
+          db
+            ..execute('ROLLBACK TO group_commit')
+            ..execute('RELEASE group_commit');
+          results.add((null, (e, s)));
+        }
+      }
+
+      db.execute('COMMIT');
+    } catch (_) {
+      if (!db.autocommit) {
+        db.execute('ROLLBACK');
+      }
+      rethrow;
+    }
+
+    // Results are collected inside the group's transaction, but each write
+    // should report the state of the connection after it has been committed.
+    final autoCommit = db.autocommit;
+    return [
+      for (final (result, error) in results)
+        (
+          result == null
+              ? null
+              : (
+                  autoCommit: autoCommit,
+                  changes: result.changes,
+                  lastInsertRowId: result.lastInsertRowId,
+                ),
+          error,
+        ),
+    ];
+  }
+
   /// Runs a query on a reading connection from the pool.
   Future<ResultSet> readQuery(
     String sql, {
@@ -254,7 +665,7 @@ final class SqliteConnectionPool {
       _raw.close();
       _receiveTableUpdates?.close();
       _receiveTableUpdates = null;
-      _updatedTables.close();
+      _updates.close();
       _isClosed = true;
     }
   }
@@ -490,7 +901,7 @@ base class AsyncConnection {
 final class ConnectionLease extends AsyncConnection {
   // The native request from which the database has been obtained. Closing this
   // will return the connection to the pool.
-  final RawPoolRequest _request;
+  final RawLease _request;
   final bool _isWriter;
 
   ConnectionLease._(super._connection, this._request, this._isWriter)
@@ -520,8 +931,9 @@ final class ConnectionLease extends AsyncConnection {
   ///      haven't made it to [SqliteConnectionPool.updatedTables] yet.
   Future<void> notifyUpdates() {
     return unsafeAccess((_) {
-      if (_isWriter && !_closed) {
-        _request.notifyUpdates();
+      if (_request case final RawPoolRequest request
+          when _isWriter && !_closed) {
+        request.notifyUpdates();
       }
     });
   }
@@ -578,3 +990,78 @@ final class ExclusivePoolAccess {
     _request.close();
   }
 }
+
+final class _MergeableWrite {
+  final String sql;
+  final List<Object?> parameters;
+  final Completer<ExecuteResult> completer = Completer();
+
+  _MergeableWrite(this.sql, this.parameters);
+}
+
+/// Read connections from a pool that all observe the same state of the
+/// database, obtained through [SqliteConnectionPool.snapshotGroup].
+///
+/// Each reader is in a read transaction, which must not be ended manually.
+/// After using the connections, the group must be [close]d to allow other
+/// requests to use the readers.
+final class SnapshotGroup {
+  /// The read connections in this group.
+  final List<AsyncConnection> readers;
+  final RawPoolRequest _request;
+
+  SnapshotGroup._(this._request, List<PoolConnectionRef> readers)
+    : readers = [
+        for (final reader in readers)
+          AsyncConnection._(
+            PoolConnection.unsafeFromPointer(reader.connection),
+          ),
+      ];
+
+  Future<void> _begin(AsyncConnection writer) async {
+    try {
+      await writer._rollbackPendingTransaction();
+      // Taking the write lock prevents other connections (including ones
+      // outside of this pool) from committing while we start read
+      // transactions.
+      await writer.execute('BEGIN IMMEDIATE');
+      try {
+        await Future.wait([
+          for (final reader in readers)
+            reader.unsafeAccessOnIsolate((conn) {
+              final db = conn.database;
+              if (!db.autocommit) {
+                db.execute('ROLLBACK');
+              }
+
+              // BEGIN is deferred, reading the schema version is what starts
+              // the read transaction.
+              db.execute('BEGIN; PRAGMA schema_version;');
+            }),
+        ]);
+      } finally {
+        await writer.execute('ROLLBACK');
+      }
+    } finally {
+      writer._close();
+      _request.releaseWriter();
+    }
+  }
+
+  /// Ends the read transactions on [readers] and returns them to the pool.
+  void close() {
+    if (readers.first._closed) {
+      return;
+    }
+
+    for (final reader in readers) {
+      final database = reader._connection.database;
+      if (!database.autocommit) {
+        database.execute('ROLLBACK');
+      }
+      reader._close();
+    }
+
+    _request.close();
+  }
+}
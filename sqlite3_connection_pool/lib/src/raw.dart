@@ -1,3 +1,7 @@
+/// @docImport 'pool.dart';
+/// @docImport 'updates.dart';
+library;
+
 import 'dart:async';
 import 'dart:convert';
 import 'dart:ffi';
@@ -20,6 +24,10 @@ final _requestFinalizer = NativeFinalizer(
   addresses.pkg_sqlite3_connection_pool_request_close.cast(),
 );
 
+final _idleReaderFinalizer = NativeFinalizer(
+  addresses.pkg_sqlite3_connection_pool_idle_reader_close.cast(),
+);
+
 @internal
 final class RawSqliteConnectionPool implements Finalizable {
   var _requestCounter = 0;
@@ -45,6 +53,18 @@ final class RawSqliteConnectionPool implements Finalizable {
       _PoolLease parsed;
       if (isExclusive) {
         parsed = const _ExclusiveLease();
+      } else if (message.length > 3) {
+        parsed = _SnapshotGroupLease(
+          PoolConnectionRef(
+            Pointer<PoolConnection>.fromAddress(message[2] as int),
+          ),
+          [
+            for (final reader in message.skip(3))
+              PoolConnectionRef(
+                Pointer<PoolConnection>.fromAddress(reader as int),
+              ),
+          ],
+        );
       } else {
         final poolConnection = Pointer<PoolConnection>.fromAddress(
           message[2] as int,
@@ -114,6 +134,57 @@ final class RawSqliteConnectionPool implements Finalizable {
     );
   }
 
+  /// Obtains an idle read connection synchronously, or returns `null` if no
+  /// connection is idle or other requests for read connections are pending.
+  RawIdleReaderLease? tryObtainIdleReader() {
+    final connection = pkg_sqlite3_connection_pool_obtain_idle_reader(_pool);
+    if (connection.address == 0) {
+      return null;
+    }
+
+    return RawIdleReaderLease._(PoolConnectionRef(connection));
+  }
+
+  /// Requests the write connection and [readers] read connections at the same
+  /// time.
+  ///
+  /// After starting transactions on the readers, the write connection should
+  /// be released with [RawPoolRequest.releaseWriter].
+  (
+    RawPoolRequest,
+    Future<({PoolConnectionRef writer, List<PoolConnectionRef> readers})>,
+  )
+  requestSnapshotGroup(int readers) {
+    final (tag, completer) = _createRequest();
+    final request = RawPoolRequest._(
+      tag,
+      this,
+      pkg_sqlite3_connection_pool_obtain_snapshot_group(
+        _pool,
+        tag,
+        _nativePort,
+        readers,
+      ),
+    );
+
+    return (
+      request,
+      completer.future.then((f) {
+        final lease = f as _SnapshotGroupLease;
+        return (writer: lease._writer, readers: lease._readers);
+      }),
+    );
+  }
+
+  int get readConnectionCount {
+    return pkg_sqlite3_connection_pool_query_read_connection_count(_pool);
+  }
+
+  /// The amount of read connections that aren't currently leased out.
+  int get idleReadConnectionCount {
+    return pkg_sqlite3_connection_pool_query_idle_reader_count(_pool);
+  }
+
   (RawPoolRequest, Future<void>) requestExclusive() {
     final (tag, completer) = _createRequest();
     final request = RawPoolRequest._(
@@ -215,6 +286,11 @@ final class RawSqliteConnectionPool implements Finalizable {
             .cast()
         ..sqlite3_finalize = libsqlite3.addresses.sqlite3_finalize.cast()
         ..sqlite3_close_v2 = libsqlite3.addresses.sqlite3_close_v2.cast()
+        ..sqlite3_db_filename = libsqlite3.addresses.sqlite3_db_filename.cast()
+        ..sqlite3_prepare_v2 = libsqlite3.addresses.sqlite3_prepare_v2.cast()
+        ..sqlite3_step = libsqlite3.addresses.sqlite3_step.cast()
+        ..sqlite3_column_int64 = libsqlite3.addresses.sqlite3_column_int64
+            .cast()
         ..dart_post_c_object = NativeApi.postCObject.cast();
 
       try {
@@ -223,6 +299,9 @@ final class RawSqliteConnectionPool implements Finalizable {
           :writer,
           :preparedStatementCacheSize,
           :enableNativeUpdateHooks,
+          :trackUpdatedRows,
+          :crossProcessUpdates,
+          :warmupStatements,
         ) = open();
 
         initOptions.read_count = readers.length;
@@ -230,6 +309,16 @@ final class RawSqliteConnectionPool implements Finalizable {
         initOptions.write = writer.leak().cast();
         initOptions.prepared_statement_cache_size = preparedStatementCacheSize;
         initOptions.enable_update_hooks = enableNativeUpdateHooks ? 1 : 0;
+        initOptions.track_updated_rows = trackUpdatedRows ? 1 : 0;
+        initOptions.cross_process_poll_interval_ms =
+            crossProcessUpdates?.inMilliseconds ?? 0;
+        initOptions.warmup_statement_count = warmupStatements.length;
+        initOptions.warmup_statements = alloc(warmupStatements.length);
+        for (final (i, sql) in warmupStatements.indexed) {
+          (initOptions.warmup_statements + i).value = sql
+              .toNativeUtf8(allocator: alloc)
+              .cast();
+        }
 
         for (final (i, reader) in readers.indexed) {
           (initOptions.reads + i).value = reader.leak().cast();
@@ -272,12 +361,48 @@ final class PoolConnections {
   /// be enabled.
   final bool enableNativeUpdateHooks;
 
+  /// Whether native update hooks should also record the rowids affected by
+  /// writes, exposed through [TableUpdate.rows].
+  ///
+  /// This has no effect if [enableNativeUpdateHooks] is disabled.
+  final bool trackUpdatedRows;
+
+  /// If set, shares updates with pools opened on the same database file in
+  /// other processes.
+  ///
+  /// Committed writes are published to a `-updates` file next to the
+  /// database, which pools in other processes check at this interval. Tables
+  /// written to by another process are then reported on
+  /// [SqliteConnectionPool.updates] like local writes. When that file can't be
+  /// created, `PRAGMA data_version` is polled on idle readers instead, and all
+  /// tables known to the pool are reported after remote writes.
+  ///
+  /// Pools in all processes need to enable this option to publish their
+  /// writes.
+  final Duration? crossProcessUpdates;
+
+  /// SQL statements to prepare on each connection when it's added to the pool,
+  /// so that the first requests using them don't have to prepare them.
+  ///
+  /// Warm-up statements are pinned in the prepared statement cache, so they're
+  /// never evicted. This has no effect if [preparedStatementCacheSize] is zero.
+  /// A list of statements to warm up can be obtained from
+  /// [SqliteConnectionPool.hotStatements].
+  final List<String> warmupStatements;
+
   PoolConnections(
     this.writer,
     this.readers, {
     this.preparedStatementCacheSize = 0,
     this.enableNativeUpdateHooks = true,
-  }) : assert(preparedStatementCacheSize >= 0);
+    this.trackUpdatedRows = false,
+    this.crossProcessUpdates,
+    this.warmupStatements = const [],
+  }) : assert(preparedStatementCacheSize >= 0),
+       assert(
+         crossProcessUpdates == null ||
+             crossProcessUpdates > Duration.zero,
+       );
 }
 
 extension type PoolConnectionRef(
@@ -295,6 +420,35 @@ extension type PoolConnectionRef(
     );
   }
 
+  /// Returns the SQL text and hit count of all cached statements.
+  Map<String, int> cachedStatementHits() {
+    final count = pkg_sqlite3_connection_pool_stmt_cache_hits(
+      connection,
+      nullptr,
+      nullptr,
+      nullptr,
+      0,
+    );
+
+    return using((alloc) {
+      final sql = alloc<Pointer<Uint8>>(count);
+      final sqlLength = alloc<UintPtr>(count);
+      final hits = alloc<Uint64>(count);
+      pkg_sqlite3_connection_pool_stmt_cache_hits(
+        connection,
+        sql,
+        sqlLength,
+        hits,
+        count,
+      );
+
+      return {
+        for (var i = 0; i < count; i++)
+          utf8.decode(sql[i].asTypedList(sqlLength[i])): hits[i],
+      };
+    });
+  }
+
   bool putCachedStatement(Uint8List sql, Pointer<Void> statement) {
     return pkg_sqlite3_connection_pool_stmt_cache_put(
           connection,
@@ -307,8 +461,14 @@ extension type PoolConnectionRef(
   }
 }
 
+/// A handle returning a leased connection to the pool when closed.
+@internal
+sealed class RawLease implements Finalizable {
+  void close();
+}
+
 @internal
-final class RawPoolRequest implements Finalizable {
+final class RawPoolRequest extends RawLease {
   final int _dartTag;
   final RawSqliteConnectionPool _pool;
 
@@ -321,6 +481,7 @@ final class RawPoolRequest implements Finalizable {
 
   bool get isCompleted => !_pool._outstandingRequests.containsKey(_dartTag);
 
+  @override
   void close() {
     _requestFinalizer.detach(_detachToken);
     pkg_sqlite3_connection_pool_request_close(_handle);
@@ -333,6 +494,33 @@ final class RawPoolRequest implements Finalizable {
   void notifyUpdates() {
     pkg_sqlite3_connection_pool_notify_updates(_handle);
   }
+
+  /// Returns the write connection of a snapshot group request to the pool.
+  void releaseWriter() {
+    pkg_sqlite3_connection_pool_release_writer(_handle);
+  }
+}
+
+/// A read connection obtained without waiting through
+/// [RawSqliteConnectionPool.tryObtainIdleReader].
+@internal
+final class RawIdleReaderLease extends RawLease {
+  final PoolConnectionRef connection;
+  final Object _detachToken = Object();
+
+  RawIdleReaderLease._(this.connection) {
+    _idleReaderFinalizer.attach(
+      this,
+      connection.connection.cast(),
+      detach: _detachToken,
+    );
+  }
+
+  @override
+  void close() {
+    _idleReaderFinalizer.detach(_detachToken);
+    pkg_sqlite3_connection_pool_idle_reader_close(connection.connection);
+  }
 }
 
 sealed class _PoolLease {
@@ -349,3 +537,10 @@ final class _SingleConnectionLease extends _PoolLease {
 final class _ExclusiveLease extends _PoolLease {
   const _ExclusiveLease();
 }
+
+final class _SnapshotGroupLease extends _PoolLease {
+  final PoolConnectionRef _writer;
+  final List<PoolConnectionRef> _readers;
+
+  _SnapshotGroupLease(this._writer, this._readers);
+}
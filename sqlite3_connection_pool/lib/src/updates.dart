@@ -0,0 +1,155 @@
+/// @docImport 'pool.dart';
+/// @docImport 'raw.dart';
+library;
+
+import 'dart:typed_data';
+
+/// A table affected by a write transaction, as reported by
+/// [SqliteConnectionPool.updates].
+final class TableUpdate {
+  /// The name of the table that has been updated.
+  final String table;
+
+  /// The rows affected by writes on [table].
+  ///
+  /// This is only available when [PoolConnections.trackUpdatedRows] is
+  /// enabled, and `null` for custom notifications sent with
+  /// [SqliteConnectionPool.dispatchUpdateNotification].
+  final RowChanges? rows;
+
+  const TableUpdate(this.table, [this.rows]);
+
+  @override
+  String toString() {
+    return 'TableUpdate($table, $rows)';
+  }
+}
+
+/// Decodes update notifications sent by the native pool to a single port.
+///
+/// To avoid copying table names for each notification, the pool only sends
+/// table ids. Names are sent once, the first time a notification containing
+/// them is sent to a port.
+final class TableUpdateDecoder {
+  /// Table names indexed by their id.
+  final List<String> _tableNames = [];
+
+  /// Parses a `[ids, newNames, rows, reset]` notification.
+  ///
+  /// `ids` is an [Int32List] of updated table ids, and `newNames` is either
+  /// `null` or a list of names to append to [_tableNames]. When row tracking
+  /// is enabled, `rows` contains an `[inserted, updated, deleted]` list of
+  /// rowid ranges for each entry in `ids`. Since the pool reassigns ids after
+  /// many names have been used, `reset` indicates that [_tableNames] need to
+  /// be cleared before adding `newNames`.
+  List<TableUpdate> decode(Object? message) {
+    final [ids, newNames, rows, reset] = message as List<Object?>;
+    if (reset == true) {
+      _tableNames.clear();
+    }
+    if (newNames != null) {
+      _tableNames.addAll((newNames as List<Object?>).cast());
+    }
+
+    ids as Int32List;
+    rows as List<Object?>?;
+
+    return [
+      for (var i = 0; i < ids.length; i++)
+        TableUpdate(
+          _tableNames[ids[i]],
+          rows == null ? null : RowChanges._fromMessage(rows[i]),
+        ),
+    ];
+  }
+}
+
+/// Rows of a table affected by a write transaction, split by the kind of
+/// write.
+final class RowChanges {
+  /// Rows that have been inserted, or `null` if too many rows were affected to
+  /// track them individually.
+  final RowIdSet? inserted;
+
+  /// Rows that have been updated, or `null` if too many rows were affected to
+  /// track them individually.
+  final RowIdSet? updated;
+
+  /// Rows that have been deleted, or `null` if too many rows were affected to
+  /// track them individually.
+  final RowIdSet? deleted;
+
+  const RowChanges._(this.inserted, this.updated, this.deleted);
+
+  factory RowChanges._fromMessage(Object? message) {
+    final [inserted, updated, deleted] = message as List<Object?>;
+    return RowChanges._(
+      RowIdSet._fromRanges(inserted as Int64List?),
+      RowIdSet._fromRanges(updated as Int64List?),
+      RowIdSet._fromRanges(deleted as Int64List?),
+    );
+  }
+
+  /// Whether the row with the given [rowid] may have been changed.
+  ///
+  /// This returns `true` for all rows if too many rows were affected to track
+  /// them individually.
+  bool affects(int rowid) {
+    bool check(RowIdSet? set) => set == null || set.contains(rowid);
+
+    return check(inserted) || check(updated) || check(deleted);
+  }
+
+  @override
+  String toString() {
+    return 'RowChanges(inserted: $inserted, updated: $updated, '
+        'deleted: $deleted)';
+  }
+}
+
+/// A set of rowids, represented as a sorted list of inclusive ranges.
+final class RowIdSet {
+  /// Flattened `(start, end)` pairs of inclusive ranges, sorted by start.
+  final Int64List _ranges;
+
+  RowIdSet._(this._ranges);
+
+  static RowIdSet? _fromRanges(Int64List? ranges) {
+    return ranges == null ? null : RowIdSet._(ranges);
+  }
+
+  /// Whether this set contains no rows.
+  bool get isEmpty => _ranges.isEmpty;
+
+  /// The inclusive ranges making up this set, in ascending order.
+  Iterable<(int, int)> get ranges sync* {
+    for (var i = 0; i < _ranges.length; i += 2) {
+      yield (_ranges[i], _ranges[i + 1]);
+    }
+  }
+
+  /// Whether [rowid] is in this set.
+  bool contains(int rowid) {
+    // Binary search for the last range starting at or before rowid.
+    var low = 0;
+    var high = _ranges.length ~/ 2;
+    while (low < high) {
+      final mid = (low + high) >> 1;
+      if (_ranges[mid * 2] <= rowid) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+
+    if (low == 0) return false;
+    return rowid <= _ranges[(low - 1) * 2 + 1];
+  }
+
+  @override
+  String toString() {
+    return ranges
+        .map((r) => r.$1 == r.$2 ? '${r.$1}' : '${r.$1}-${r.$2}')
+        .join(', ');
+  }
+}
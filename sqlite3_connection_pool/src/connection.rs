@@ -1,8 +1,10 @@
 use crate::pool::ExternalFunctions;
 use lru::LruCache;
-use std::ffi::{c_int, c_void};
+use std::collections::HashMap;
+use std::ffi::{CStr, c_char, c_int, c_void};
+use std::mem;
 use std::num::NonZeroUsize;
-use std::ptr::NonNull;
+use std::ptr::{self, NonNull};
 
 #[derive(Copy, Clone)]
 #[repr(transparent)]
@@ -18,19 +20,75 @@ pub struct PreparedStatement(pub NonNull<c_void>);
 unsafe impl Send for PreparedStatement {}
 unsafe impl Sync for PreparedStatement {}
 
+/// A cache of prepared statements for a single connection.
+///
+/// Statements are kept in an LRU cache. Statements that have recently been used at least
+/// [StatementCache::PIN_THRESHOLD] times are moved to a separate set of pinned statements that
+/// aren't evicted by the LRU cache. At most half of the cache size is used for pinned statements,
+/// which don't count towards the capacity of the LRU cache.
+///
+/// Recent hit counts are halved every [StatementCache::DECAY_INTERVAL] lookups. Pinned statements
+/// whose recent hit count drops below half of the threshold are moved back into the LRU cache, so
+/// that statements that are no longer used don't occupy pinned slots forever.
 pub struct StatementCache {
-    cache: LruCache<String, PreparedStatement>,
+    cache: LruCache<String, CachedStatement>,
+    pinned: HashMap<String, CachedStatement>,
+    max_pinned: usize,
+    /// Lookups since recent hit counts have last been decayed.
+    lookups_since_decay: u64,
+}
+
+struct CachedStatement {
+    stmt: PreparedStatement,
+    /// How often this statement has been returned from [StatementCache::lookup].
+    hits: u64,
+    /// Like `hits`, but decayed over time. This decides whether the statement is pinned.
+    recent_hits: u64,
+}
+
+impl CachedStatement {
+    fn new(stmt: PreparedStatement, recent_hits: u64) -> Self {
+        Self {
+            stmt,
+            hits: 0,
+            recent_hits,
+        }
+    }
 }
 
 impl StatementCache {
+    const PIN_THRESHOLD: u64 = 64;
+    const DECAY_INTERVAL: u64 = 1024;
+
     pub fn new(size: usize) -> Option<Self> {
         Some(Self {
             cache: LruCache::new(NonZeroUsize::new(size)?),
+            pinned: HashMap::new(),
+            max_pinned: size / 2,
+            lookups_since_decay: 0,
         })
     }
 
     pub fn lookup(&mut self, sql: &str) -> Option<NonNull<c_void>> {
-        self.cache.get(sql).map(|p| p.0)
+        self.lookups_since_decay += 1;
+
+        if let Some(entry) = self.pinned.get_mut(sql) {
+            entry.hits += 1;
+            entry.recent_hits += 1;
+            return Some(entry.stmt.0);
+        }
+
+        let entry = self.cache.get_mut(sql)?;
+        entry.hits += 1;
+        entry.recent_hits += 1;
+        let stmt = entry.stmt.0;
+
+        if entry.recent_hits >= Self::PIN_THRESHOLD && self.pinned.len() < self.max_pinned {
+            let (sql, entry) = self.cache.pop_entry(sql).unwrap();
+            self.pinned.insert(sql, entry);
+        }
+
+        Some(stmt)
     }
 
     pub fn put(
@@ -39,20 +97,119 @@ impl StatementCache {
         stmt: PreparedStatement,
         finalize: extern "C" fn(PreparedStatement) -> c_int,
     ) {
-        if let Some((_, old)) = self.cache.push(sql, stmt) {
-            if old != stmt {
+        // Statements are only put into the cache after a lookup missed, which is when a pinned
+        // slot is worth freeing up. Decaying here also gives us a way to finalize statements
+        // evicted by unpinning others.
+        if self.lookups_since_decay >= Self::DECAY_INTERVAL {
+            self.decay(finalize);
+        }
+
+        let entry = CachedStatement::new(stmt, 0);
+
+        if let Some(pinned) = self.pinned.get_mut(&sql) {
+            // This only happens if Dart prepared the statement again after failing to look it up,
+            // which it doesn't do. Still, let's not leak the old statement.
+            let old = mem::replace(pinned, entry);
+            if old.stmt != stmt {
+                finalize(old.stmt);
+            }
+            return;
+        }
+
+        if let Some((_, old)) = self.cache.push(sql, entry) {
+            if old.stmt != stmt {
                 // We had to remove an older statement from the cache to make room for the new one.
                 // Properly finalize that statement now.
-                finalize(old);
+                finalize(old.stmt);
             }
         }
     }
 
+    /// Prepares `sql` and adds it to the cache as a pinned statement, if there's room for more
+    /// pinned statements.
+    ///
+    /// Statements that fail to prepare or consist of more than one statement are ignored, since
+    /// they would never be looked up.
+    pub fn warm_up(&mut self, connection: Connection, sql: &CStr, functions: &ExternalFunctions) {
+        const SQLITE_OK: c_int = 0;
+
+        let Ok(key) = sql.to_str() else {
+            return;
+        };
+        if self.pinned.contains_key(key) || self.cache.contains(key) {
+            return;
+        }
+
+        let mut stmt: Option<PreparedStatement> = None;
+        let mut tail: *const c_char = ptr::null();
+        let rc = (functions.sqlite3_prepare_v2)(connection, sql.as_ptr(), -1, &mut stmt, &mut tail);
+        let Some(stmt) = stmt else {
+            return;
+        };
+
+        let has_tail = !tail.is_null() && {
+            let tail = unsafe {
+                // Safety: The tail points into the NUL-terminated sql string.
+                CStr::from_ptr(tail)
+            };
+            tail.to_bytes().iter().any(|b| !b.is_ascii_whitespace())
+        };
+        if rc != SQLITE_OK || has_tail {
+            (functions.sqlite3_finalize)(stmt);
+            return;
+        }
+
+        if self.pinned.len() < self.max_pinned {
+            // Give statements pinned ahead of time until the next decay to be used before
+            // they're moved into the LRU cache.
+            let entry = CachedStatement::new(stmt, Self::PIN_THRESHOLD);
+            self.pinned.insert(key.to_owned(), entry);
+        } else if let Some((_, old)) = self
+            .cache
+            .push(key.to_owned(), CachedStatement::new(stmt, 0))
+        {
+            (functions.sqlite3_finalize)(old.stmt);
+        }
+    }
+
+    /// Halves recent hit counts and moves pinned statements that are no longer used frequently
+    /// back into the LRU cache.
+    fn decay(&mut self, finalize: extern "C" fn(PreparedStatement) -> c_int) {
+        self.lookups_since_decay = 0;
+
+        for (_, entry) in self.cache.iter_mut() {
+            entry.recent_hits /= 2;
+        }
+
+        let mut unpinned = Vec::new();
+        for (sql, entry) in self.pinned.iter_mut() {
+            entry.recent_hits /= 2;
+            if entry.recent_hits < Self::PIN_THRESHOLD / 2 {
+                unpinned.push(sql.clone());
+            }
+        }
+
+        for sql in unpinned {
+            let entry = self.pinned.remove(&sql).unwrap();
+            if let Some((_, old)) = self.cache.push(sql, entry) {
+                finalize(old.stmt);
+            }
+        }
+    }
+
+    /// Calls `report` with the SQL text and the hit count of each cached statement.
+    pub fn report_hits(&self, mut report: impl FnMut(&str, u64)) {
+        for (sql, entry) in self.pinned.iter().chain(self.cache.iter()) {
+            report(sql, entry.hits);
+        }
+    }
+
     pub fn close_statements(&mut self, functions: &ExternalFunctions) {
-        for (_, stmt) in self.cache.iter() {
-            (functions.sqlite3_finalize)(*stmt);
+        for (_, entry) in self.pinned.iter().chain(self.cache.iter()) {
+            (functions.sqlite3_finalize)(entry.stmt);
         }
 
+        self.pinned.clear();
         self.cache.clear()
     }
 }
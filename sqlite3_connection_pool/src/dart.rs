@@ -14,10 +14,19 @@ pub struct RawDartCObject {
 }
 
 impl RawDartCObject {
+    pub const TYPE_NULL: c_int = 0;
     pub const TYPE_BOOL: c_int = 1;
     pub const TYPE_INT64: c_int = 3;
     pub const TYPE_STRING: c_int = 5;
     pub const TYPE_ARRAY: c_int = 6;
+    pub const TYPE_TYPED_DATA: c_int = 7;
+
+    pub fn null() -> Self {
+        Self {
+            type_: Self::TYPE_NULL,
+            value: RawDartCObjectValue { as_int64: 0 },
+        }
+    }
 }
 
 impl From<bool> for RawDartCObject {
@@ -77,10 +86,17 @@ pub struct RawDartCObjectArray {
 #[derive(Clone, Copy)] // to allow use in union
 pub struct RawDartCObjectTypedData {
     pub type_: c_int,
+    /// The length in elements (not bytes).
     pub length: isize,
     pub values: *const u8,
 }
 
+impl RawDartCObjectTypedData {
+    // Values of `Dart_TypedData_Type` in `dart_api.h`.
+    pub const TYPE_INT32: c_int = 6;
+    pub const TYPE_INT64: c_int = 8;
+}
+
 #[repr(C)]
 #[derive(Clone, Copy)] // to allow use in union
 pub struct RawDartCObjectExternalTypedData {
@@ -18,6 +18,11 @@ typedef struct ExternalFunctions {
   int (*sqlite3_get_autocommit)(Connection);
   int (*sqlite3_finalize)(void*);
   int (*sqlite3_close_v2)(Connection);
+  const char* (*sqlite3_db_filename)(Connection, const char*);
+  int (*sqlite3_prepare_v2)(Connection, const char*, int, void**,
+                            const char**);
+  int (*sqlite3_step)(void*);
+  int64_t (*sqlite3_column_int64)(void*, int);
   int (*dart_post_c_object)(int64_t, const void* message);
 } SqliteFunctions;
 
@@ -28,6 +33,10 @@ typedef struct InitializedPool {
   uintptr_t read_count;
   uintptr_t prepared_statement_cache_size;
   unsigned char enable_update_hooks;
+  unsigned char track_updated_rows;
+  uint32_t cross_process_poll_interval_ms;
+  const char** warmup_statements;
+  uintptr_t warmup_statement_count;
 } InitializedPool;
 
 typedef int64_t DartPort;
@@ -49,12 +58,23 @@ PoolRequest* pkg_sqlite3_connection_pool_obtain_single(
 PoolRequest* pkg_sqlite3_connection_pool_obtain_exclusive(
     const ConnectionPool* pool, int64_t tag, DartPort port);
 
+struct PoolConnection* pkg_sqlite3_connection_pool_obtain_idle_reader(
+    const ConnectionPool* pool);
+void pkg_sqlite3_connection_pool_idle_reader_close(
+    struct PoolConnection* connection);
+
+PoolRequest* pkg_sqlite3_connection_pool_obtain_snapshot_group(
+    const ConnectionPool* pool, int64_t tag, DartPort port, uintptr_t readers);
+void pkg_sqlite3_connection_pool_release_writer(const PoolRequest* request);
+
 void pkg_sqlite3_connection_pool_add_readers(const ConnectionPool* pool,
                                              uintptr_t count,
                                              const Connection* reads);
 
 uintptr_t pkg_sqlite3_connection_pool_query_read_connection_count(
     const ConnectionPool* pool);
+uintptr_t pkg_sqlite3_connection_pool_query_idle_reader_count(
+    const ConnectionPool* pool);
 void pkg_sqlite3_connection_pool_query_connections(
     const ConnectionPool* pool, struct PoolConnection** writer,
     struct PoolConnection** readers, uintptr_t reader_count);
@@ -73,3 +93,6 @@ void* pkg_sqlite3_connection_pool_stmt_cache_get(
 int pkg_sqlite3_connection_pool_stmt_cache_put(
     const struct PoolConnection* connection, const uint8_t* sql,
     uintptr_t sql_len, void* stmt, int (*sqlite3_finalize)(void*));
+uintptr_t pkg_sqlite3_connection_pool_stmt_cache_hits(
+    const struct PoolConnection* connection, const uint8_t** sql,
+    uintptr_t* sql_len, uint64_t* hits, uintptr_t capacity);
@@ -0,0 +1,100 @@
+use crate::pool::PoolConnection;
+use std::ptr;
+use std::sync::atomic::{AtomicBool, AtomicPtr, AtomicU64, Ordering};
+
+/// Idle read connections that can be claimed without locking the pool.
+///
+/// The first [IdleReaders::CAPACITY] read connections of a pool are tracked in a bitmask when
+/// they're idle. Uncontended read requests can then claim a connection with a single
+/// compare-and-swap instead of locking the pool, allocating a wait node and waiting for a port
+/// message.
+///
+/// While read requests are queued on the pool, [IdleReaders::has_waiters] is set. That disables
+/// lock-free acquisitions (so that queued requests are served first) and makes lock-free returns
+/// hand the connection to the queue instead.
+pub struct IdleReaders {
+    /// Bit `i` is set if the connection in `slots[i]` is idle.
+    idle: AtomicU64,
+    has_waiters: AtomicBool,
+    slots: [AtomicPtr<PoolConnection>; Self::CAPACITY],
+}
+
+impl IdleReaders {
+    pub const CAPACITY: usize = u64::BITS as usize;
+
+    pub fn new() -> Self {
+        Self {
+            idle: AtomicU64::new(0),
+            has_waiters: AtomicBool::new(false),
+            slots: [const { AtomicPtr::new(ptr::null_mut()) }; Self::CAPACITY],
+        }
+    }
+
+    /// Makes the connection at `index` available for lock-free acquisitions.
+    ///
+    /// This must be called before the connection is marked as idle for the first time.
+    pub fn register(&self, index: usize, connection: *const PoolConnection) {
+        self.slots[index].store(connection.cast_mut(), Ordering::Release);
+    }
+
+    /// Marks the connection at `index` as idle.
+    ///
+    /// Returns whether read requests were waiting while doing that. In that case, the caller must
+    /// lock the pool and dispatch idle connections to waiters, as those may have been enqueued
+    /// without seeing this connection.
+    pub fn release(&self, index: usize) -> bool {
+        self.idle.fetch_or(1 << index, Ordering::SeqCst);
+        self.has_waiters.load(Ordering::SeqCst)
+    }
+
+    /// The amount of connections currently marked as idle.
+    pub fn count(&self) -> usize {
+        self.idle.load(Ordering::SeqCst).count_ones() as usize
+    }
+
+    /// Claims an idle connection and returns its index, regardless of whether read requests are
+    /// waiting.
+    pub fn claim(&self) -> Option<usize> {
+        let mut current = self.idle.load(Ordering::SeqCst);
+        loop {
+            if current == 0 {
+                return None;
+            }
+
+            let index = current.trailing_zeros() as usize;
+            match self.idle.compare_exchange_weak(
+                current,
+                current & !(1 << index),
+                Ordering::SeqCst,
+                Ordering::SeqCst,
+            ) {
+                Ok(_) => return Some(index),
+                Err(actual) => current = actual,
+            }
+        }
+    }
+
+    /// Claims an idle connection if no read requests are waiting for one.
+    pub fn try_acquire(&self) -> Option<&PoolConnection> {
+        if self.has_waiters.load(Ordering::SeqCst) {
+            return None;
+        }
+
+        let index = self.claim()?;
+        let connection = self.slots[index].load(Ordering::Acquire);
+        // Safety: Connections are registered before being marked as idle, and pools never remove
+        // read connections.
+        Some(unsafe { &*connection })
+    }
+
+    pub fn idle_count(&self) -> usize {
+        self.idle.load(Ordering::SeqCst).count_ones() as usize
+    }
+
+    /// Updates whether read requests are waiting on the pool.
+    ///
+    /// This must only be called while holding the pool's lock.
+    pub fn set_has_waiters(&self, has_waiters: bool) {
+        self.has_waiters.store(has_waiters, Ordering::SeqCst);
+    }
+}
@@ -1,20 +1,23 @@
 use crate::client::PoolClient;
 use crate::connection::{Connection, PreparedStatement};
 use crate::dart::DartPort;
-use crate::pool::{ConnectionPool, PendingMessage, PoolConnection, PoolRequestHandle, PoolState};
+use crate::pool::{ConnectionPool, PendingMessage, Pool, PoolConnection, PoolRequestHandle};
 use crate::registry::{InitializedPool, MaybeInitializedPool, PoolRegistry, UninitializedPool};
-use crate::update_hook::send_update_notification;
 use std::ffi::{c_char, c_int, c_void, CStr};
 use std::mem::MaybeUninit;
 use std::ptr::NonNull;
-use std::sync::{Arc, Mutex};
+use std::sync::Arc;
 use std::{ptr, slice};
 
 mod client;
 mod connection;
 mod dart;
+mod idle_readers;
+mod notifier;
 mod pool;
 mod registry;
+mod row_set;
+mod table_names;
 mod update_hook;
 
 fn to_client(pool: ConnectionPool) -> NonNull<PoolClient> {
@@ -83,7 +86,7 @@ extern "C" fn pkg_sqlite3_connection_pool_close(pool: *mut PoolClient) {
     drop(pool)
 }
 
-fn clone_arc(pool: &Mutex<PoolState>) -> ConnectionPool {
+fn clone_arc(pool: &Pool) -> ConnectionPool {
     let ptr = ptr::from_ref(pool);
 
     unsafe { Arc::increment_strong_count(ptr) };
@@ -123,6 +126,60 @@ extern "C" fn pkg_sqlite3_connection_pool_obtain_exclusive(
     ))
 }
 
+/// Obtains an idle read connection without locking the pool or waiting for a port message.
+///
+/// Returns a null pointer if no read connection is idle or if other read requests are queued. In
+/// that case, [pkg_sqlite3_connection_pool_obtain_single] should be used instead.
+///
+/// Connections obtained through this function must be returned with
+/// [pkg_sqlite3_connection_pool_idle_reader_close].
+#[unsafe(no_mangle)]
+extern "C" fn pkg_sqlite3_connection_pool_obtain_idle_reader(
+    client: &PoolClient,
+) -> *const PoolConnection {
+    match client.pool.try_obtain_idle_reader() {
+        Some(connection) => connection,
+        None => ptr::null(),
+    }
+}
+
+#[unsafe(no_mangle)]
+extern "C" fn pkg_sqlite3_connection_pool_idle_reader_close(connection: &PoolConnection) {
+    unsafe {
+        // Safety: Dart only calls this once for connections obtained through
+        // pkg_sqlite3_connection_pool_obtain_idle_reader.
+        Pool::return_idle_reader(connection)
+    };
+}
+
+/// Requests the write connection and `readers` read connections at the same time.
+///
+/// Once the connections are available, a `[tag, false, writer, ...readers]` message is posted to
+/// the port. Dart uses the writer to block writes while starting read transactions on all readers,
+/// and then returns it with [pkg_sqlite3_connection_pool_release_writer].
+#[unsafe(no_mangle)]
+extern "C" fn pkg_sqlite3_connection_pool_obtain_snapshot_group(
+    client: &PoolClient,
+    tag: i64,
+    port: DartPort,
+    readers: usize,
+) -> *mut PoolRequestHandle {
+    let pool = &client.pool;
+    let mut state = pool.lock().unwrap();
+    let pool = clone_arc(pool);
+
+    Box::into_raw(Box::new(state.request_snapshot_group(
+        pool,
+        PendingMessage { tag, port },
+        readers,
+    )))
+}
+
+#[unsafe(no_mangle)]
+extern "C" fn pkg_sqlite3_connection_pool_release_writer(request: &PoolRequestHandle) {
+    request.release_writer();
+}
+
 #[unsafe(no_mangle)]
 extern "C" fn pkg_sqlite3_connection_pool_add_readers(
     client: &PoolClient,
@@ -150,6 +207,12 @@ extern "C" fn pkg_sqlite3_connection_pool_query_read_connection_count(
     readers.len()
 }
 
+#[unsafe(no_mangle)]
+extern "C" fn pkg_sqlite3_connection_pool_query_idle_reader_count(client: &PoolClient) -> usize {
+    let state = client.pool.lock().unwrap();
+    state.idle_reader_count()
+}
+
 #[unsafe(no_mangle)]
 extern "C" fn pkg_sqlite3_connection_pool_query_connections(
     client: &PoolClient,
@@ -166,7 +229,7 @@ extern "C" fn pkg_sqlite3_connection_pool_query_connections(
             break;
         }
 
-        unsafe { readers.add(i).write(conn) };
+        unsafe { readers.add(i).write(&**conn) };
     }
 }
 
@@ -190,6 +253,7 @@ extern "C" fn pkg_sqlite3_connection_pool_notify_updates(request: &PoolRequestHa
         // Safety: Dart must only call this when owning a write connection.
         pool.send_update_notifications()
     };
+    Pool::unlock(pool);
 }
 
 #[unsafe(no_mangle)]
@@ -211,7 +275,8 @@ extern "C" fn pkg_sqlite3_connection_pool_notify_updates_custom(
         }
     });
 
-    send_update_notification(updates, &pool.update_listeners, &pool.functions);
+    pool.send_custom_update_notification(updates);
+    Pool::unlock(pool);
 }
 
 #[unsafe(no_mangle)]
@@ -227,6 +292,36 @@ extern "C" fn pkg_sqlite3_connection_pool_stmt_cache_get(
         .and_then(|cache| cache.lookup(sql))
 }
 
+/// Reports the SQL text and hit count of statements cached on a connection.
+///
+/// Up to `capacity` entries are written to the output arrays, the return value is the total amount
+/// of cached statements. The SQL pointers are valid until the connection is used again.
+#[unsafe(no_mangle)]
+extern "C" fn pkg_sqlite3_connection_pool_stmt_cache_hits(
+    connection: &PoolConnection,
+    sql: *mut *const u8,
+    sql_len: *mut usize,
+    hits: *mut u64,
+    capacity: usize,
+) -> usize {
+    let mut count = 0;
+    if let Some(cache) = &connection.cached_statements {
+        cache.report_hits(|text, hit_count| {
+            if count < capacity {
+                unsafe {
+                    // Safety: Dart provides arrays with room for capacity entries.
+                    sql.add(count).write(text.as_ptr());
+                    sql_len.add(count).write(text.len());
+                    hits.add(count).write(hit_count);
+                }
+            }
+            count += 1;
+        });
+    }
+
+    count
+}
+
 #[unsafe(no_mangle)]
 extern "C" fn pkg_sqlite3_connection_pool_stmt_cache_put(
     connection: &mut PoolConnection,
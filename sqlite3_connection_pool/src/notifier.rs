@@ -0,0 +1,436 @@
+use crate::connection::{Connection, PreparedStatement};
+use crate::pool::{ExternalFunctions, Pool};
+use std::ffi::{CStr, CString, OsString, c_char, c_int};
+use std::fs::{File, OpenOptions};
+use std::io;
+use std::ptr;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, Weak};
+use std::thread;
+use std::time::Duration;
+
+/// Shares committed table sets with pools in other processes using the same database file.
+///
+/// Updates are published to a ring buffer stored in a `-updates` file next to the database. The
+/// file is only accessed with positioned reads and writes while holding a file lock, so it's
+/// effectively served from the page cache shared between processes. A background thread polls
+/// the ring's head and forwards remote commits to update listeners of the pool.
+///
+/// If the ring file can't be opened (e.g. because the directory of the database is read-only), the
+/// thread instead polls `PRAGMA data_version` on an idle reader. That only tells us that another
+/// connection has changed the database, so we then notify listeners about all tables known to the
+/// pool.
+pub struct ChangeNotifier {
+    /// Identifies entries written by this notifier so that they're not reported back to the pool.
+    origin: u64,
+    poll_interval: Duration,
+    functions: ExternalFunctions,
+    channel: Channel,
+    /// The number of commits on the write connection of this pool, incremented by its commit hook.
+    local_commits: Arc<AtomicU64>,
+    /// Tables of commits passed to [ChangeNotifier::queue] that haven't been written to the ring
+    /// yet.
+    queued: Mutex<Vec<Vec<CString>>>,
+}
+
+enum Channel {
+    Ring(Mutex<Ring>),
+    DataVersion(Mutex<DataVersions>),
+}
+
+/// Changes made by other processes, as observed by [ChangeNotifier::poll].
+pub enum RemoteChanges {
+    Tables(Vec<CString>),
+    /// Another process has written to the database, but we don't know which tables have changed.
+    Unknown,
+}
+
+impl ChangeNotifier {
+    /// Creates a notifier for the database opened by `writer` and starts a thread polling for
+    /// remote changes.
+    ///
+    /// Returns [None] for in-memory and temporary databases, which can't be shared between
+    /// processes.
+    pub fn start(
+        pool: Weak<Pool>,
+        writer: Connection,
+        functions: ExternalFunctions,
+        poll_interval: Duration,
+        local_commits: Arc<AtomicU64>,
+    ) -> Option<Arc<Self>> {
+        let path = database_path(writer, &functions)?;
+        let mut ring_path = path;
+        ring_path.push("-updates");
+
+        static NEXT_ORIGIN: AtomicU64 = AtomicU64::new(0);
+        let origin =
+            (std::process::id() as u64) << 32 | NEXT_ORIGIN.fetch_add(1, Ordering::Relaxed);
+
+        let channel = match Ring::open(ring_path.into()) {
+            Ok(ring) => Channel::Ring(Mutex::new(ring)),
+            Err(_) => Channel::DataVersion(Default::default()),
+        };
+
+        let notifier = Arc::new(Self {
+            origin,
+            poll_interval,
+            functions,
+            channel,
+            local_commits,
+            queued: Default::default(),
+        });
+
+        let polled = notifier.clone();
+        thread::Builder::new()
+            .name("sqlite3_connection_pool notifier".into())
+            .spawn(move || polled.run(pool))
+            .ok()?;
+
+        Some(notifier)
+    }
+
+    /// Records a committed write to the given tables.
+    ///
+    /// This is called while holding the lock on the pool, so the commit is only written to the
+    /// ring by a later call to [ChangeNotifier::publish_queued].
+    pub fn queue<'a>(&self, tables: impl IntoIterator<Item = &'a CStr>) {
+        if let Channel::Ring(_) = &self.channel {
+            let tables = tables.into_iter().map(CStr::to_owned).collect();
+            self.queued.lock().unwrap().push(tables);
+        }
+    }
+
+    /// Writes queued commits to the ring, which involves file I/O and locks.
+    pub fn publish_queued(&self) {
+        let Channel::Ring(ring) = &self.channel else {
+            return;
+        };
+
+        let queued = std::mem::take(&mut *self.queued.lock().unwrap());
+        if queued.is_empty() {
+            return;
+        }
+
+        let mut ring = ring.lock().unwrap();
+        for tables in queued {
+            // Failing to publish an update is not something we can report to the writer, and it
+            // doesn't affect this process.
+            let _ = ring.publish(self.origin, tables.iter().map(|t| t.as_c_str()));
+        }
+    }
+
+    fn run(&self, pool: Weak<Pool>) {
+        loop {
+            thread::sleep(self.poll_interval);
+
+            // Stop polling once the pool has been closed.
+            let Some(pool) = pool.upgrade() else {
+                return;
+            };
+
+            if let Some(changes) = self.poll(&pool) {
+                pool.lock().unwrap().send_remote_update_notification(changes);
+            }
+        }
+    }
+
+    fn poll(&self, pool: &Arc<Pool>) -> Option<RemoteChanges> {
+        match &self.channel {
+            Channel::Ring(ring) => ring.lock().unwrap().poll(self.origin).ok().flatten(),
+            Channel::DataVersion(versions) => {
+                // The commit hook runs before the data version changes, so reading local_commits
+                // first ensures that a local commit between the two is seen on the next poll
+                // instead of being reported as remote.
+                let local_commits = self.local_commits.load(Ordering::SeqCst);
+                let connection = pool.try_obtain_idle_reader()?;
+                let version = data_version(connection.raw, &self.functions);
+                let index = connection.reader_index;
+                unsafe {
+                    // Safety: We've just obtained this connection.
+                    Pool::return_idle_reader(connection)
+                };
+
+                versions
+                    .lock()
+                    .unwrap()
+                    .update(index, version?, local_commits)
+                    .then_some(RemoteChanges::Unknown)
+            }
+        }
+    }
+}
+
+fn database_path(writer: Connection, functions: &ExternalFunctions) -> Option<OsString> {
+    let path = (functions.sqlite3_db_filename)(writer, c"main".as_ptr());
+    if path.is_null() {
+        return None;
+    }
+
+    let path = unsafe {
+        // Safety: sqlite3_db_filename returns a valid C string if the result is not null.
+        CStr::from_ptr(path)
+    };
+    if path.is_empty() {
+        return None;
+    }
+
+    Some(path.to_str().ok()?.into())
+}
+
+/// Runs `PRAGMA data_version` on a connection that isn't used concurrently.
+fn data_version(connection: Connection, functions: &ExternalFunctions) -> Option<i64> {
+    const SQLITE_OK: c_int = 0;
+    const SQLITE_ROW: c_int = 100;
+
+    let mut stmt: Option<PreparedStatement> = None;
+    let rc = (functions.sqlite3_prepare_v2)(
+        connection,
+        c"PRAGMA data_version".as_ptr(),
+        -1,
+        &mut stmt,
+        ptr::null_mut::<*const c_char>(),
+    );
+    let stmt = stmt?;
+
+    let version = if rc == SQLITE_OK && (functions.sqlite3_step)(stmt) == SQLITE_ROW {
+        Some((functions.sqlite3_column_int64)(stmt, 0))
+    } else {
+        None
+    };
+
+    (functions.sqlite3_finalize)(stmt);
+    version
+}
+
+/// The last `PRAGMA data_version` observed on each read connection.
+///
+/// The data version is specific to each connection, so we need to compare it against an earlier
+/// version from the same connection.
+#[derive(Default)]
+struct DataVersions {
+    /// Indexed by the index of the reader, the last version and the amount of local commits at
+    /// the time it was read.
+    versions: Vec<Option<(i64, u64)>>,
+}
+
+impl DataVersions {
+    /// Records a new data version and returns whether it indicates a remote write.
+    ///
+    /// The data version of a reader also changes for commits on the writer of this pool, so changes
+    /// are only reported if no local commit has happened since the version was last read. This
+    /// can miss remote writes racing with local ones, which is why the ring is preferred.
+    fn update(&mut self, reader: usize, version: i64, local_commits: u64) -> bool {
+        if reader >= self.versions.len() {
+            self.versions.resize(reader + 1, None);
+        }
+
+        let previous = self.versions[reader].replace((version, local_commits));
+        matches!(previous, Some((v, c)) if v != version && c == local_commits)
+    }
+}
+
+/// A fixed-size ring of update entries stored in a file.
+///
+/// The file starts with a [Ring::HEADER_SIZE] header consisting of a magic value and the sequence
+/// number of the next entry. It is followed by [Ring::SLOTS] slots, each consisting of the
+/// sequence number of the entry stored in it, the origin of the entry, the length of the payload
+/// and the names of updated tables separated by NUL bytes.
+struct Ring {
+    file: File,
+    /// The sequence number of the next entry we haven't read yet.
+    next_sequence: u64,
+    buffer: Vec<u8>,
+}
+
+impl Ring {
+    const MAGIC: u64 = u64::from_le_bytes(*b"sq3pool1");
+    const HEADER_SIZE: u64 = 16;
+    const SLOTS: u64 = 256;
+    const SLOT_SIZE: u64 = 512;
+    const SLOT_HEADER_SIZE: usize = 20;
+    /// Length of an entry whose table names didn't fit into its slot.
+    const OVERFLOWED: u32 = u32::MAX;
+
+    fn open(path: OsString) -> io::Result<Self> {
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create(true)
+            .truncate(false)
+            .open(path)?;
+        file.lock()?;
+
+        let mut header = [0u8; Self::HEADER_SIZE as usize];
+        let next_sequence = match read_at(&file, &mut header, 0) {
+            Ok(()) if u64::from_le_bytes(header[..8].try_into().unwrap()) == Self::MAGIC => {
+                u64::from_le_bytes(header[8..].try_into().unwrap())
+            }
+            _ => {
+                // New or corrupted file, initialize it.
+                file.set_len(Self::HEADER_SIZE + Self::SLOTS * Self::SLOT_SIZE)?;
+                header[..8].copy_from_slice(&Self::MAGIC.to_le_bytes());
+                header[8..].copy_from_slice(&0u64.to_le_bytes());
+                write_at(&file, &header, 0)?;
+                0
+            }
+        };
+        file.unlock()?;
+
+        Ok(Self {
+            file,
+            next_sequence,
+            buffer: Vec::with_capacity(Self::SLOT_SIZE as usize),
+        })
+    }
+
+    fn slot_offset(sequence: u64) -> u64 {
+        Self::HEADER_SIZE + (sequence % Self::SLOTS) * Self::SLOT_SIZE
+    }
+
+    fn head(&self) -> io::Result<u64> {
+        let mut head = [0u8; 8];
+        read_at(&self.file, &mut head, 8)?;
+        Ok(u64::from_le_bytes(head))
+    }
+
+    fn publish<'a>(
+        &mut self,
+        origin: u64,
+        tables: impl IntoIterator<Item = &'a CStr>,
+    ) -> io::Result<()> {
+        let buffer = &mut self.buffer;
+        buffer.clear();
+        buffer.resize(Self::SLOT_HEADER_SIZE, 0);
+
+        let mut length = 0u32;
+        for table in tables {
+            let name = table.to_bytes_with_nul();
+            if buffer.len() + name.len() > Self::SLOT_SIZE as usize {
+                buffer.truncate(Self::SLOT_HEADER_SIZE);
+                length = Self::OVERFLOWED;
+                break;
+            }
+
+            buffer.extend_from_slice(name);
+            length += name.len() as u32;
+        }
+
+        buffer[8..16].copy_from_slice(&origin.to_le_bytes());
+        buffer[16..20].copy_from_slice(&length.to_le_bytes());
+
+        self.file.lock()?;
+        let result = self.append(length);
+        self.file.unlock()?;
+        result
+    }
+
+    /// Writes the entry in [Ring::buffer] to the next slot, which requires an exclusive lock.
+    fn append(&mut self, length: u32) -> io::Result<()> {
+        let sequence = self.head()?;
+        self.buffer[..8].copy_from_slice(&sequence.to_le_bytes());
+
+        let written = Self::SLOT_HEADER_SIZE + if length == Self::OVERFLOWED { 0 } else { length as usize };
+        write_at(&self.file, &self.buffer[..written], Self::slot_offset(sequence))?;
+        write_at(&self.file, &(sequence + 1).to_le_bytes(), 8)
+    }
+
+    fn poll(&mut self, origin: u64) -> io::Result<Option<RemoteChanges>> {
+        // Checking the head without a lock is fine since it only tells us whether there's anything
+        // to read. Entries are read under a shared lock.
+        if self.head()? == self.next_sequence {
+            return Ok(None);
+        }
+
+        self.file.lock_shared()?;
+        let result = self.read_entries(origin);
+        self.file.unlock()?;
+        result
+    }
+
+    fn read_entries(&mut self, origin: u64) -> io::Result<Option<RemoteChanges>> {
+        let head = self.head()?;
+        if head < self.next_sequence || head - self.next_sequence > Self::SLOTS {
+            // The ring has been overwritten (or recreated) since we've last read it.
+            self.next_sequence = head;
+            return Ok(Some(RemoteChanges::Unknown));
+        }
+
+        let mut tables = Vec::<CString>::new();
+        let mut has_remote_entries = false;
+        self.buffer.resize(Self::SLOT_SIZE as usize, 0);
+
+        for sequence in self.next_sequence..head {
+            read_at(&self.file, &mut self.buffer, Self::slot_offset(sequence))?;
+            let header = &self.buffer[..Self::SLOT_HEADER_SIZE];
+            let entry_sequence = u64::from_le_bytes(header[..8].try_into().unwrap());
+            let entry_origin = u64::from_le_bytes(header[8..16].try_into().unwrap());
+            let length = u32::from_le_bytes(header[16..20].try_into().unwrap());
+
+            if entry_origin == origin {
+                continue;
+            }
+            // The file is shared with other processes, so we can't trust the length to be valid.
+            let max_length = Self::SLOT_SIZE as usize - Self::SLOT_HEADER_SIZE;
+            if entry_sequence != sequence
+                || length == Self::OVERFLOWED
+                || length as usize > max_length
+            {
+                self.next_sequence = head;
+                return Ok(Some(RemoteChanges::Unknown));
+            }
+
+            has_remote_entries = true;
+            let payload = &self.buffer[Self::SLOT_HEADER_SIZE..][..length as usize];
+            for name in payload.split_inclusive(|b| *b == 0) {
+                let Ok(name) = CStr::from_bytes_with_nul(name) else {
+                    self.next_sequence = head;
+                    return Ok(Some(RemoteChanges::Unknown));
+                };
+                if !tables.iter().any(|t| t.as_c_str() == name) {
+                    tables.push(name.to_owned());
+                }
+            }
+        }
+
+        self.next_sequence = head;
+        Ok(has_remote_entries.then_some(RemoteChanges::Tables(tables)))
+    }
+}
+
+#[cfg(unix)]
+fn read_at(file: &File, buf: &mut [u8], offset: u64) -> io::Result<()> {
+    std::os::unix::fs::FileExt::read_exact_at(file, buf, offset)
+}
+
+#[cfg(unix)]
+fn write_at(file: &File, buf: &[u8], offset: u64) -> io::Result<()> {
+    std::os::unix::fs::FileExt::write_all_at(file, buf, offset)
+}
+
+#[cfg(windows)]
+fn read_at(file: &File, mut buf: &mut [u8], mut offset: u64) -> io::Result<()> {
+    use std::os::windows::fs::FileExt;
+
+    while !buf.is_empty() {
+        match file.seek_read(buf, offset)? {
+            0 => return Err(io::ErrorKind::UnexpectedEof.into()),
+            n => {
+                buf = &mut buf[n..];
+                offset += n as u64;
+            }
+        }
+    }
+    Ok(())
+}
+
+#[cfg(windows)]
+fn write_at(file: &File, mut buf: &[u8], mut offset: u64) -> io::Result<()> {
+    use std::os::windows::fs::FileExt;
+
+    while !buf.is_empty() {
+        let n = file.seek_write(buf, offset)?;
+        buf = &buf[n..];
+        offset += n as u64;
+    }
+    Ok(())
+}
@@ -1,18 +1,34 @@
 use crate::connection::{Connection, PreparedStatement, StatementCache};
 use crate::dart::{DartPort, RawDartCObject, RawDartCObjectArray, RawDartCObjectValue};
-use crate::update_hook::CollectedTableUpdates;
+use crate::idle_readers::IdleReaders;
+use crate::notifier::{ChangeNotifier, RemoteChanges};
+use crate::table_names::{TableNames, UpdateListener};
+use crate::update_hook::{CollectedTableUpdates, send_update_notification};
 use std::cell::UnsafeCell;
 use std::collections::VecDeque;
-use std::ffi::{c_char, c_int, c_void};
+use std::ffi::{CStr, CString, c_char, c_int, c_void};
 use std::marker::PhantomData;
 use std::ptr::NonNull;
-use std::sync::{Arc, Mutex};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, LockResult, Mutex, MutexGuard};
+use std::time::Duration;
 
 /// A connection pool can be locked, in which case some Dart actor has exclusive access to all
 /// connections. When a new pool is initialized, it is also in this state.
-pub type ConnectionPool = Arc<Mutex<PoolState>>;
+pub type ConnectionPool = Arc<Pool>;
+
+pub struct Pool {
+    // Note: This field is declared first so that it's dropped before idle_readers, which the
+    // state references.
+    state: Mutex<PoolState>,
+    /// Idle read connections that can be obtained without locking [Pool::state].
+    pub idle_readers: IdleReaders,
+}
 
 pub struct PoolState {
+    /// The pool containing this state, referenced by connections so that they can be returned
+    /// without a request handle.
+    owner: *const Pool,
     reads: ReadState,
     writes: WriteState,
 
@@ -27,20 +43,39 @@ pub struct PoolState {
     /// This allows not locking in update hooks (since the SQLite connection is never used
     /// concurrently).
     table_updates: Option<UnsafeCell<CollectedTableUpdates>>,
-    pub update_listeners: Vec<DartPort>,
+    /// Ids for table names used in update notifications.
+    pub table_names: Arc<Mutex<TableNames>>,
+    pub update_listeners: Vec<UpdateListener>,
+    /// If enabled, shares committed updates with pools in other processes.
+    notifier: Option<Arc<ChangeNotifier>>,
+    /// The number of commits on the write connection, counted in its commit hook.
+    local_commits: Arc<AtomicU64>,
     cache_size: usize,
+    /// Statements to prepare on each connection when it's added to the pool.
+    warmup_statements: Vec<CString>,
 }
 
+// PoolState is only accessed while holding the pool's lock.
+unsafe impl Send for PoolState {}
+
 #[repr(C)]
 pub struct PoolConnection {
     /// The raw `sqlite3*` connection pointer.
     pub raw: Connection,
     /// If statement caches are enabled, an LRU cache storing prepared statements by their SQL text.
     pub cached_statements: Option<StatementCache>,
+    /// The pool owning this connection.
+    pub pool: *const Pool,
+    /// For read connections, the index in [ReadState::connections].
+    pub reader_index: usize,
 }
 
 struct ReadState {
-    connections: Vec<PoolConnection>,
+    /// All read connections. They are boxed because pointers to them are given to Dart and need
+    /// to stay valid when connections are added.
+    connections: Vec<Box<PoolConnection>>,
+    /// Idle read connections that can't be tracked in [Pool::idle_readers] because their index
+    /// exceeds [IdleReaders::CAPACITY].
     idle_connections: VecDeque<usize>,
     waiters: LinkedList<Self>,
 }
@@ -92,6 +127,7 @@ enum Waiter {
     Reader(ReadPoolRequest),
     Writer(WritePoolRequest),
     Exclusive(ExclusivePoolRequest),
+    SnapshotGroup(SnapshotGroupRequest),
 }
 
 #[derive(Default)]
@@ -112,46 +148,210 @@ struct WritePoolRequest {
 #[derive(Default)]
 struct ExclusivePoolRequest {
     has_writer: bool,
-    obtained_read_connections: usize,
+    /// Indices of read connections obtained by this request so far.
+    obtained_read_connections: Vec<usize>,
 }
 
-impl PoolState {
+/// A request for the write connection and a fixed amount of read connections at the same time.
+///
+/// Holding the write connection while starting read transactions on all readers ensures they all
+/// observe the same database state. Afterwards, the writer can be released early with
+/// [PoolRequestHandle::release_writer].
+///
+/// Connections are only assigned once the writer and all readers are available at the same time.
+/// Holding the writer while waiting for readers would block writes for longer than necessary,
+/// and holding some readers while waiting for others could deadlock with exclusive requests.
+struct SnapshotGroupRequest {
+    has_writer: bool,
+    requested_readers: usize,
+    obtained_read_connections: Vec<usize>,
+}
+
+impl Pool {
     pub fn new(
         functions: ExternalFunctions,
         writer: Connection,
         reads: &[Connection],
         cache_size: usize,
         enable_update_hooks: bool,
+        track_updated_rows: bool,
+        cross_process_poll_interval: Option<Duration>,
+        warmup_statements: Vec<CString>,
+    ) -> ConnectionPool {
+        let pool = Arc::new_cyclic(|owner| Pool {
+            state: Mutex::new(PoolState::new(
+                owner.as_ptr(),
+                functions,
+                writer,
+                cache_size,
+                enable_update_hooks,
+                track_updated_rows,
+                warmup_statements,
+            )),
+            idle_readers: IdleReaders::new(),
+        });
+
+        {
+            let mut state = pool.lock().unwrap();
+            state.add_readers(reads);
+            state.register_hooks_on_writer(cross_process_poll_interval.is_some());
+            state.notifier = cross_process_poll_interval.and_then(|interval| {
+                ChangeNotifier::start(
+                    Arc::downgrade(&pool),
+                    writer,
+                    functions,
+                    interval,
+                    state.local_commits.clone(),
+                )
+            });
+        }
+        pool
+    }
+
+    pub fn lock(&self) -> LockResult<MutexGuard<'_, PoolState>> {
+        self.state.lock()
+    }
+
+    /// Releases the lock on the pool, and then publishes commits that have been queued while it
+    /// was held to other processes.
+    ///
+    /// This should be used instead of dropping the guard when the write connection may have been
+    /// returned or notified about updates, so that other users of the pool don't have to wait
+    /// for the file I/O involved in publishing.
+    pub fn unlock(state: MutexGuard<'_, PoolState>) {
+        let notifier = state.notifier.clone();
+        drop(state);
+
+        if let Some(notifier) = notifier {
+            notifier.publish_queued();
+        }
+    }
+
+    /// Attempts to obtain an idle read connection without locking the pool.
+    ///
+    /// When this returns a connection, the strong count of the pool has been incremented. It is
+    /// decremented again by [Pool::return_idle_reader].
+    pub fn try_obtain_idle_reader(self: &Arc<Self>) -> Option<&PoolConnection> {
+        let connection = self.idle_readers.try_acquire()?;
+        unsafe { Arc::increment_strong_count(Arc::as_ptr(self)) };
+        Some(connection)
+    }
+
+    /// Returns a connection obtained through [Pool::try_obtain_idle_reader].
+    ///
+    /// ## Safety
+    ///
+    /// The connection must have been obtained from [Pool::try_obtain_idle_reader] and not be
+    /// returned already.
+    pub unsafe fn return_idle_reader(connection: &PoolConnection) {
+        let pool = unsafe {
+            // Safety: This takes over the reference count incremented when obtaining the
+            // connection.
+            Arc::from_raw(connection.pool)
+        };
+
+        let index = connection.reader_index;
+        if index < IdleReaders::CAPACITY && pool.idle_readers.release(index) {
+            // A waiter was enqueued concurrently, hand idle connections to it.
+            pool.lock().unwrap().dispatch_idle_readers();
+        } else if index >= IdleReaders::CAPACITY {
+            pool.lock().unwrap().return_read_connection(index);
+        }
+    }
+}
+
+impl PoolState {
+    fn new(
+        owner: *const Pool,
+        functions: ExternalFunctions,
+        writer: Connection,
+        cache_size: usize,
+        enable_update_hooks: bool,
+        track_updated_rows: bool,
+        warmup_statements: Vec<CString>,
     ) -> Self {
-        let wrap_connection = |conn: Connection| -> PoolConnection {
-            PoolConnection {
-                raw: conn,
-                cached_statements: StatementCache::new(cache_size),
-            }
+        let table_names: Arc<Mutex<TableNames>> = Default::default();
+        let local_commits: Arc<AtomicU64> = Default::default();
+        let mut writer = PoolConnection {
+            raw: writer,
+            cached_statements: StatementCache::new(cache_size),
+            pool: owner,
+            reader_index: usize::MAX,
         };
+        Self::warm_up(&mut writer, &warmup_statements, &functions);
 
         Self {
+            owner,
             reads: ReadState {
-                idle_connections: (0usize..reads.len()).collect(),
-                connections: reads.iter().copied().map(wrap_connection).collect(),
+                idle_connections: Default::default(),
+                connections: Default::default(),
                 waiters: Default::default(),
             },
             writes: WriteState {
-                connection: wrap_connection(writer),
+                connection: writer,
                 acquired: false,
                 waiters: Default::default(),
             },
             functions,
             table_updates: if enable_update_hooks {
-                Some(Default::default())
+                Some(UnsafeCell::new(CollectedTableUpdates::new(
+                    track_updated_rows,
+                    table_names.clone(),
+                    local_commits.clone(),
+                )))
             } else {
                 None
             },
+            table_names,
             update_listeners: Default::default(),
+            notifier: None,
+            local_commits,
             cache_size,
+            warmup_statements,
         }
     }
 
+    /// Prepares the configured warm-up statements on a connection that isn't in use yet.
+    fn warm_up(
+        connection: &mut PoolConnection,
+        statements: &[CString],
+        functions: &ExternalFunctions,
+    ) {
+        if let Some(cache) = &mut connection.cached_statements {
+            for sql in statements {
+                cache.warm_up(connection.raw, sql, functions);
+            }
+        }
+    }
+
+    fn idle_readers<'a>(&self) -> &'a IdleReaders {
+        unsafe {
+            // Safety: The owning pool outlives its state.
+            &(*self.owner).idle_readers
+        }
+    }
+
+    /// Claims an idle read connection, if there is one.
+    fn take_idle_reader(&mut self) -> Option<usize> {
+        self.idle_readers()
+            .claim()
+            .or_else(|| self.reads.idle_connections.pop_front())
+    }
+
+    /// Returns a reader claimed with [Self::take_idle_reader] without dispatching it to waiters.
+    fn untake_idle_reader(&mut self, conn: usize) {
+        if conn < IdleReaders::CAPACITY {
+            self.idle_readers().release(conn);
+        } else {
+            self.reads.idle_connections.push_front(conn);
+        }
+    }
+
+    fn update_has_read_waiters(&self) {
+        self.idle_readers()
+            .set_has_waiters(self.reads.waiters.first.is_some());
+    }
+
     unsafe fn drop_waiter(&mut self, waiter: NonNull<WaitNode>) {
         let mut waiter = unsafe { Box::from_raw(waiter.as_ptr()) };
         let as_mut = waiter.as_mut();
@@ -159,6 +359,7 @@ impl PoolState {
         // Remove waiter from queue
         if as_mut.read_entry.is_some() {
             self.reads.waiters.unlink(as_mut);
+            self.update_has_read_waiters();
         }
         if as_mut.write_entry.is_some() {
             self.writes.waiters.unlink(as_mut);
@@ -184,22 +385,55 @@ impl PoolState {
                 if exclusive.has_writer {
                     self.return_write_connection()
                 }
-                for i in 0..self.reads.connections.len() {
-                    self.return_read_connection(i)
+                for i in &exclusive.obtained_read_connections {
+                    self.return_read_connection(*i)
+                }
+            }
+            Waiter::SnapshotGroup(ref group) => {
+                if group.has_writer {
+                    self.return_write_connection()
+                }
+                for i in &group.obtained_read_connections {
+                    self.return_read_connection(*i)
                 }
             }
         }
     }
 
-    fn return_read_connection(&mut self, conn: usize) {
-        self.reads.idle_connections.push_back(conn);
+    pub fn return_read_connection(&mut self, conn: usize) {
+        if conn < IdleReaders::CAPACITY {
+            self.idle_readers().release(conn);
+        } else {
+            self.reads.idle_connections.push_back(conn);
+        }
+
+        self.dispatch_idle_readers();
+    }
 
-        if let Some(mut waiting) = self.reads.waiters.first {
+    /// Assigns idle read connections to waiting requests.
+    pub fn dispatch_idle_readers(&mut self) {
+        while let Some(mut waiting) = self.reads.waiters.first {
             let waiter = unsafe { waiting.as_mut() };
             let did_complete = self.try_complete(waiter, &mut false, &mut false);
-            if did_complete {
-                self.reads.waiters.unlink(waiter);
+            if !did_complete {
+                break;
             }
+
+            self.unlink_completed(waiter);
+        }
+    }
+
+    /// Removes a completed waiter from all queues it's part of.
+    ///
+    /// Requests needing both read and write connections are part of both queues, and may complete
+    /// through either of them.
+    fn unlink_completed(&mut self, waiter: &mut WaitNode) {
+        if waiter.read_entry.is_some() {
+            self.reads.waiters.unlink(waiter);
+            self.update_has_read_waiters();
+        }
+        if waiter.write_entry.is_some() {
+            self.writes.waiters.unlink(waiter);
         }
     }
 
@@ -218,10 +452,73 @@ impl PoolState {
                 // have an exclusive reference to table updates.
                 updates.get().as_mut().unwrap_unchecked()
             };
-            updates.send_notification(self.update_listeners.as_slice(), &self.functions);
+            updates.send_notification(
+                self.update_listeners.as_slice(),
+                self.notifier.as_deref(),
+                &self.functions,
+            );
+            updates.reset_table_names_if_full();
         }
     }
 
+    /// Resets table names after sending a notification for names that may not have been seen
+    /// before.
+    ///
+    /// This is only possible while the write connection isn't leased, since its update hooks
+    /// might hold on to table ids otherwise.
+    fn reset_table_names_if_idle(&self) {
+        if self.writes.acquired {
+            return;
+        }
+
+        match self.table_updates.as_ref() {
+            Some(updates) => {
+                let updates = unsafe {
+                    // Safety: Nobody has leased the write connection, and we hold the pool lock.
+                    updates.get().as_mut().unwrap_unchecked()
+                };
+                updates.reset_table_names_if_full();
+            }
+            None => {
+                self.table_names.lock().unwrap().reset_if_full();
+            }
+        }
+    }
+
+    /// Sends a notification for the given tables, as requested by Dart.
+    pub fn send_custom_update_notification<'a>(&self, updates: impl Iterator<Item = &'a CStr>) {
+        let updates: Vec<&CStr> = updates.collect();
+        if let Some(notifier) = &self.notifier {
+            notifier.queue(updates.iter().copied());
+        }
+
+        send_update_notification(
+            updates,
+            &self.table_names,
+            &self.update_listeners,
+            &self.functions,
+        );
+        self.reset_table_names_if_idle();
+    }
+
+    /// Forwards writes made by pools in other processes to update listeners.
+    pub fn send_remote_update_notification(&self, changes: RemoteChanges) {
+        let tables = match changes {
+            RemoteChanges::Tables(tables) => tables,
+            // We don't know which tables have been changed, so notify listeners about all tables
+            // they might be interested in.
+            RemoteChanges::Unknown => self.table_names.lock().unwrap().names().to_vec(),
+        };
+
+        send_update_notification(
+            tables.iter().map(|t| t.as_c_str()),
+            &self.table_names,
+            &self.update_listeners,
+            &self.functions,
+        );
+        self.reset_table_names_if_idle();
+    }
+
     fn return_write_connection(&mut self) {
         unsafe {
             // Safety: We have an exclusive reference to the write connection.
@@ -235,7 +532,7 @@ impl PoolState {
             let waiter = unsafe { waiting.as_mut() };
             let did_complete = self.try_complete(waiter, &mut false, &mut false);
             if did_complete {
-                self.writes.waiters.unlink(waiter);
+                self.unlink_completed(waiter);
             }
         }
     }
@@ -265,16 +562,44 @@ impl PoolState {
         self.register_waiter(pool, msg, Waiter::Exclusive(Default::default()))
     }
 
+    /// Requests the write connection and `readers` read connections at the same time.
+    ///
+    /// `readers` must not exceed the amount of read connections in the pool.
+    pub fn request_snapshot_group(
+        &mut self,
+        pool: ConnectionPool,
+        msg: PendingMessage,
+        readers: usize,
+    ) -> PoolRequestHandle {
+        self.register_waiter(
+            pool,
+            msg,
+            Waiter::SnapshotGroup(SnapshotGroupRequest {
+                has_writer: false,
+                requested_readers: readers,
+                obtained_read_connections: Vec::with_capacity(readers),
+            }),
+        )
+    }
+
     pub fn add_readers(&mut self, connections: &[Connection]) {
         self.reads.connections.reserve(connections.len());
-        self.reads.idle_connections.reserve(connections.len());
 
         let start_index = self.reads.connections.len();
         for connection in connections {
-            self.reads.connections.push(PoolConnection {
+            let reader_index = self.reads.connections.len();
+            let mut connection = Box::new(PoolConnection {
                 raw: *connection,
                 cached_statements: StatementCache::new(self.cache_size),
+                pool: self.owner,
+                reader_index,
             });
+            Self::warm_up(&mut connection, &self.warmup_statements, &self.functions);
+
+            if reader_index < IdleReaders::CAPACITY {
+                self.idle_readers().register(reader_index, &*connection);
+            }
+            self.reads.connections.push(connection);
         }
 
         let end_index = start_index + connections.len();
@@ -283,8 +608,13 @@ impl PoolState {
         }
     }
 
+    /// Returns the amount of read connections not currently leased out.
+    pub fn idle_reader_count(&self) -> usize {
+        self.idle_readers().count() + self.reads.idle_connections.len()
+    }
+
     /// Returns the write and all read connections of this pool.
-    pub fn view_connections(&self) -> (&PoolConnection, &[PoolConnection]) {
+    pub fn view_connections(&self) -> (&PoolConnection, &[Box<PoolConnection>]) {
         let writer = &self.writes.connection;
         let readers = self.reads.connections.as_slice();
 
@@ -304,6 +634,13 @@ impl PoolState {
             waiter,
         });
         let request = Box::leak(request);
+        if !matches!(request.waiter, Waiter::Writer(_)) {
+            // Mark read requests as waiting before looking for idle connections. Connections
+            // returned without the lock concurrently will then see the flag and dispatch to us
+            // if we miss them.
+            self.idle_readers().set_has_waiters(true);
+        }
+
         let mut reads = false;
         let mut writes = false;
         let request_completed = self.try_complete(request, &mut reads, &mut writes);
@@ -319,6 +656,7 @@ impl PoolState {
                 self.writes.waiters.push(request);
             }
         }
+        self.update_has_read_waiters();
 
         PoolRequestHandle {
             pool,
@@ -341,9 +679,9 @@ impl PoolState {
                 *waiting_for_reads = true;
                 assert!(reads.assigned_connection.is_none() && !reads.has_writer);
 
-                let connection = if let Some(conn_idx) = self.reads.idle_connections.pop_front() {
+                let connection = if let Some(conn_idx) = self.take_idle_reader() {
                     reads.assigned_connection = Some(conn_idx);
-                    Some(&self.reads.connections[conn_idx])
+                    Some(&*self.reads.connections[conn_idx])
                 } else if self.reads.connections.is_empty()
                     && self.try_assign_write(&mut reads.has_writer)
                 {
@@ -385,16 +723,51 @@ impl PoolState {
                     return false;
                 }
 
-                while exclusive.obtained_read_connections < self.reads.connections.len() {
-                    let Some(_) = self.reads.idle_connections.pop_front() else {
+                while exclusive.obtained_read_connections.len() < self.reads.connections.len() {
+                    let Some(idx) = self.take_idle_reader() else {
                         return false;
                     };
-                    exclusive.obtained_read_connections += 1;
+                    exclusive.obtained_read_connections.push(idx);
                 }
 
                 waiter.port.send_did_obtain_exclusive(&self.functions);
                 true
             }
+            Waiter::SnapshotGroup(group) => {
+                *waiting_for_reads = true;
+                *waiting_for_writes = true;
+
+                debug_assert!(!group.has_writer && group.obtained_read_connections.is_empty());
+                if self.writes.acquired {
+                    return false;
+                }
+
+                while group.obtained_read_connections.len() < group.requested_readers {
+                    let Some(idx) = self.take_idle_reader() else {
+                        while let Some(idx) = group.obtained_read_connections.pop() {
+                            self.untake_idle_reader(idx);
+                        }
+                        return false;
+                    };
+                    group.obtained_read_connections.push(idx);
+                }
+
+                // The writer is only held until the client has started read transactions on the
+                // readers and calls release_writer.
+                let assigned_writer = self.try_assign_write(&mut group.has_writer);
+                debug_assert!(assigned_writer);
+
+                let readers = group
+                    .obtained_read_connections
+                    .iter()
+                    .map(|idx| &*self.reads.connections[*idx]);
+                waiter.port.send_did_obtain_group(
+                    &self.writes.connection,
+                    readers,
+                    &self.functions,
+                );
+                true
+            }
         }
     }
 
@@ -419,23 +792,37 @@ impl PoolState {
     }
 
     pub fn register_update_listener(&mut self, update_listener: DartPort) {
-        self.update_listeners.push(update_listener);
+        self.update_listeners
+            .push(UpdateListener::new(update_listener));
     }
 
     pub fn remove_update_listeners(&mut self, removed_listeners: &[DartPort]) {
         self.update_listeners
-            .retain(|l| !removed_listeners.contains(l));
+            .retain(|l| !removed_listeners.contains(&l.port));
     }
 
-    pub fn register_hooks_on_writer(arc: &ConnectionPool) {
-        let pool = arc.lock().unwrap();
-        let Some(updates) = pool.table_updates.as_ref() else {
-            return;
-        };
+    /// Registers hooks collecting updates on the writer.
+    ///
+    /// If update hooks are disabled, this still registers a commit hook if `count_commits` is set,
+    /// since the change notifier needs to tell local commits apart from remote ones.
+    fn register_hooks_on_writer(&self, count_commits: bool) {
+        let writer = &self.writes.connection;
 
-        let updates_ptr = updates.get();
-        let writer = &pool.writes.connection;
-        CollectedTableUpdates::attach_to(updates_ptr, &pool.functions, writer.raw);
+        if let Some(updates) = self.table_updates.as_ref() {
+            let updates_ptr = updates.get();
+            CollectedTableUpdates::attach_to(updates_ptr, &self.functions, writer.raw);
+        } else if count_commits {
+            extern "C" fn commit_hook(context: NonNull<c_void>) -> c_int {
+                let commits = unsafe { context.cast::<AtomicU64>().as_ref() };
+                commits.fetch_add(1, Ordering::SeqCst);
+                // Returning zero makes the COMMIT operation continue normally.
+                0
+            }
+
+            // The counter is kept alive by this state, which outlives the writer.
+            let commits = Arc::as_ptr(&self.local_commits).cast_mut();
+            (self.functions.sqlite3_commit_hook)(writer.raw, Some(commit_hook), commits.cast());
+        }
     }
 }
 
@@ -448,7 +835,7 @@ impl Drop for PoolState {
             "Tried to drop with leased write connection"
         );
         assert_eq!(
-            self.reads.idle_connections.len(),
+            self.reads.idle_connections.len() + self.idle_readers().idle_count(),
             self.reads.connections.len(),
             "Tried to drop with leased read connection"
         );
@@ -480,6 +867,35 @@ impl PendingMessage {
         (api.dart_post_c_object)(self.port, &mut array);
     }
 
+    /// Sends a `[tag, false, writer_ptr, ...reader_ptrs]` message to this port.
+    fn send_did_obtain_group<'a>(
+        &self,
+        writer: &PoolConnection,
+        readers: impl Iterator<Item = &'a PoolConnection>,
+        api: &ExternalFunctions,
+    ) {
+        let mut values: Vec<RawDartCObject> = vec![
+            RawDartCObject::from(self.tag),
+            RawDartCObject::from(false),
+            RawDartCObject::from(writer as *const PoolConnection as i64),
+        ];
+        values.extend(readers.map(|r| RawDartCObject::from(r as *const PoolConnection as i64)));
+
+        let mut list_values: Vec<*mut RawDartCObject> =
+            values.iter_mut().map(|v| v as *mut RawDartCObject).collect();
+        let mut array = RawDartCObject {
+            type_: RawDartCObject::TYPE_ARRAY,
+            value: RawDartCObjectValue {
+                as_array: RawDartCObjectArray {
+                    length: list_values.len() as isize,
+                    values: list_values.as_mut_ptr(),
+                },
+            },
+        };
+
+        (api.dart_post_c_object)(self.port, &mut array);
+    }
+
     /// Sends a `[tag, false, connection_ptr]` message to this port.
     fn send_did_obtain_connection(&self, connection: &PoolConnection, api: &ExternalFunctions) {
         let list_values: &mut [*mut RawDartCObject] = &mut [
@@ -587,10 +1003,31 @@ pub struct PoolRequestHandle {
     node: NonNull<WaitNode>,
 }
 
+impl PoolRequestHandle {
+    /// For completed snapshot group requests, returns the write connection to the pool while
+    /// keeping the read connections.
+    pub fn release_writer(&self) {
+        let mut pool = self.pool.lock().unwrap();
+        let node = unsafe {
+            // Safety: We have locked the pool, so nothing else is accessing the node.
+            &mut *self.node.as_ptr()
+        };
+
+        if let Waiter::SnapshotGroup(group) = &mut node.waiter {
+            if group.has_writer {
+                group.has_writer = false;
+                pool.return_write_connection();
+            }
+        }
+        Pool::unlock(pool);
+    }
+}
+
 impl Drop for PoolRequestHandle {
     fn drop(&mut self) {
         let mut pool = self.pool.lock().unwrap();
         unsafe { pool.drop_waiter(self.node) };
+        Pool::unlock(pool);
     }
 }
 
@@ -619,5 +1056,15 @@ pub struct ExternalFunctions {
     pub sqlite3_get_autocommit: extern "C" fn(Connection) -> c_int,
     pub sqlite3_finalize: extern "C" fn(PreparedStatement) -> c_int,
     pub sqlite3_close_v2: extern "C" fn(Connection) -> c_int,
+    pub sqlite3_db_filename: extern "C" fn(Connection, *const c_char) -> *const c_char,
+    pub sqlite3_prepare_v2: extern "C" fn(
+        Connection,
+        *const c_char,
+        c_int,
+        *mut Option<PreparedStatement>,
+        *mut *const c_char,
+    ) -> c_int,
+    pub sqlite3_step: extern "C" fn(PreparedStatement) -> c_int,
+    pub sqlite3_column_int64: extern "C" fn(PreparedStatement, c_int) -> i64,
     pub dart_post_c_object: extern "C" fn(port: DartPort, message: &mut RawDartCObject) -> bool,
 }
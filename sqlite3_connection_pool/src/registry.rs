@@ -1,20 +1,21 @@
 use crate::connection::Connection;
-use crate::pool::{ConnectionPool, ExternalFunctions, PoolState};
+use crate::pool::{ConnectionPool, ExternalFunctions, Pool};
 use std::collections::HashMap;
-use std::ffi::c_uchar;
+use std::ffi::{CStr, CString, c_char, c_uchar};
 use std::slice;
 use std::sync::{Arc, LazyLock, Mutex, MutexGuard, Weak};
+use std::time::Duration;
 
 static REGISTRY: LazyLock<PoolRegistry> = LazyLock::new(|| PoolRegistry::default());
 
 #[derive(Default)]
 pub struct PoolRegistry {
-    pools: Mutex<HashMap<String, Weak<Mutex<PoolState>>>>,
+    pools: Mutex<HashMap<String, Weak<Pool>>>,
 }
 
 pub struct UninitializedPool<'a> {
     name: &'a str,
-    guard: MutexGuard<'a, HashMap<String, Weak<Mutex<PoolState>>>>,
+    guard: MutexGuard<'a, HashMap<String, Weak<Pool>>>,
 }
 
 pub enum MaybeInitializedPool<'a> {
@@ -30,6 +31,13 @@ pub struct InitializedPool {
     read_count: usize,
     prepared_statement_cache_size: usize,
     enable_update_hooks: c_uchar,
+    track_updated_rows: c_uchar,
+    /// If non-zero, the interval (in milliseconds) at which to poll for writes made by pools in
+    /// other processes.
+    cross_process_poll_interval_ms: u32,
+    /// SQL statements to prepare on each connection of the pool.
+    warmup_statements: *const *const c_char,
+    warmup_statement_count: usize,
 }
 
 impl PoolRegistry {
@@ -49,19 +57,39 @@ impl PoolRegistry {
     }
 }
 
+impl InitializedPool {
+    fn warmup_statements(&self) -> Vec<CString> {
+        if self.warmup_statement_count == 0 {
+            return Vec::new();
+        }
+
+        let statements = unsafe {
+            // Safety: Dart passes an array of warmup_statement_count C strings.
+            slice::from_raw_parts(self.warmup_statements, self.warmup_statement_count)
+        };
+        statements
+            .iter()
+            .map(|sql| unsafe { CStr::from_ptr(*sql) }.to_owned())
+            .collect()
+    }
+}
+
 impl<'a> UninitializedPool<'a> {
     pub fn initialize(mut self, initialized: &InitializedPool) -> ConnectionPool {
-        let state = PoolState::new(
+        let pool = Pool::new(
             initialized.functions,
             initialized.write,
             unsafe { slice::from_raw_parts(initialized.reads, initialized.read_count) },
             initialized.prepared_statement_cache_size,
             initialized.enable_update_hooks != 0,
+            initialized.track_updated_rows != 0,
+            match initialized.cross_process_poll_interval_ms {
+                0 => None,
+                ms => Some(Duration::from_millis(ms.into())),
+            },
+            initialized.warmup_statements(),
         );
 
-        let pool = ConnectionPool::new(Mutex::new(state));
-        PoolState::register_hooks_on_writer(&pool);
-
         self.guard
             .insert(self.name.to_string(), Arc::downgrade(&pool));
         pool
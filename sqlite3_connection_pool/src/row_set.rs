@@ -0,0 +1,167 @@
+/// A set of rowids, stored as sorted, non-overlapping and non-adjacent inclusive ranges.
+///
+/// Rows changed by typical writes tend to be clustered (e.g. a batch of inserts assigns
+/// consecutive rowids), so ranges are a compact representation. To bound memory for large writes,
+/// a set that would need more than [RowIdSet::MAX_RANGES] ranges turns into an _overflowed_ set
+/// that no longer knows which rows it contains. Listeners have to assume that every row may have
+/// changed in that case.
+#[derive(Default)]
+pub struct RowIdSet {
+    // Stored as `[start, end]` arrays so that the ranges can be viewed as a flat `&[i64]`.
+    ranges: Vec<[i64; 2]>,
+    overflowed: bool,
+}
+
+impl RowIdSet {
+    pub const MAX_RANGES: usize = 1024;
+
+    /// The ranges in this set, or [None] if the set has overflowed.
+    pub fn ranges(&self) -> Option<&[[i64; 2]]> {
+        if self.overflowed {
+            None
+        } else {
+            Some(&self.ranges)
+        }
+    }
+
+    /// The ranges in this set as `start, end` pairs in a flat slice, or [None] if the set has
+    /// overflowed.
+    pub fn flat_ranges(&self) -> Option<&[i64]> {
+        self.ranges().map(|ranges| ranges.as_flattened())
+    }
+
+    pub fn insert(&mut self, rowid: i64) {
+        if self.overflowed {
+            return;
+        }
+
+        // Find the first range that contains rowid or ends right before it.
+        let idx = self
+            .ranges
+            .partition_point(|&[_, end]| end.checked_add(1).is_some_and(|e| e < rowid));
+
+        if let Some(range) = self.ranges.get_mut(idx) {
+            let [start, end] = *range;
+            if start <= rowid && rowid <= end {
+                return;
+            }
+
+            if end.checked_add(1) == Some(rowid) {
+                range[1] = rowid;
+                // This might close the gap to the next range.
+                if let Some(&[next_start, next_end]) = self.ranges.get(idx + 1) {
+                    if rowid.checked_add(1) == Some(next_start) {
+                        self.ranges[idx][1] = next_end;
+                        self.ranges.remove(idx + 1);
+                    }
+                }
+                return;
+            }
+
+            if rowid.checked_add(1) == Some(start) {
+                range[0] = rowid;
+                return;
+            }
+        }
+
+        self.ranges.insert(idx, [rowid, rowid]);
+        self.check_overflow();
+    }
+
+    /// Removes all rows from this set, keeping its allocation.
+    pub fn clear(&mut self) {
+        self.ranges.clear();
+        self.overflowed = false;
+    }
+
+    /// Adds all rows from `other` into this set.
+    pub fn union(&mut self, other: &RowIdSet) {
+        if self.overflowed {
+            return;
+        }
+        if other.overflowed {
+            self.mark_overflowed();
+            return;
+        }
+        if other.ranges.is_empty() {
+            return;
+        }
+        if self.ranges.is_empty() {
+            self.ranges.extend_from_slice(&other.ranges);
+            return;
+        }
+
+        let mut merged: Vec<[i64; 2]> =
+            Vec::with_capacity(self.ranges.len() + other.ranges.len());
+        let mut left = self.ranges.iter().copied().peekable();
+        let mut right = other.ranges.iter().copied().peekable();
+
+        loop {
+            let next = match (left.peek(), right.peek()) {
+                (Some(a), Some(b)) if a[0] <= b[0] => left.next(),
+                (Some(_), Some(_)) => right.next(),
+                (Some(_), None) => left.next(),
+                (None, Some(_)) => right.next(),
+                (None, None) => break,
+            };
+            let [start, end] = next.unwrap();
+
+            match merged.last_mut() {
+                Some(last) if last[1].checked_add(1).is_none_or(|e| e >= start) => {
+                    last[1] = last[1].max(end);
+                }
+                _ => merged.push([start, end]),
+            }
+        }
+
+        self.ranges = merged;
+        self.check_overflow();
+    }
+
+    fn check_overflow(&mut self) {
+        if self.ranges.len() > Self::MAX_RANGES {
+            self.mark_overflowed();
+        }
+    }
+
+    fn mark_overflowed(&mut self) {
+        self.overflowed = true;
+        self.ranges = Vec::new();
+    }
+}
+
+/// Rows of a single table affected by a transaction, split by the kind of write.
+#[derive(Default)]
+pub struct RowChanges {
+    pub inserted: RowIdSet,
+    pub updated: RowIdSet,
+    pub deleted: RowIdSet,
+}
+
+impl RowChanges {
+    // Values for the operation passed to update hooks, https://sqlite.org/c3ref/update_hook.html
+    const SQLITE_DELETE: i32 = 9;
+    const SQLITE_INSERT: i32 = 18;
+    const SQLITE_UPDATE: i32 = 23;
+
+    pub fn record(&mut self, write_kind: i32, rowid: i64) {
+        match write_kind {
+            Self::SQLITE_INSERT => self.inserted.insert(rowid),
+            Self::SQLITE_UPDATE => self.updated.insert(rowid),
+            Self::SQLITE_DELETE => self.deleted.insert(rowid),
+            _ => {}
+        }
+    }
+
+    pub fn union(&mut self, other: &RowChanges) {
+        self.inserted.union(&other.inserted);
+        self.updated.union(&other.updated);
+        self.deleted.union(&other.deleted);
+    }
+
+    pub fn clear(&mut self) {
+        self.inserted.clear();
+        self.updated.clear();
+        self.deleted.clear();
+    }
+}
@@ -0,0 +1,126 @@
+use std::cell::Cell;
+use std::collections::HashMap;
+use std::ffi::{CStr, CString};
+
+use crate::dart::DartPort;
+
+/// Assigns small integer ids to table names.
+///
+/// Update notifications only contain table ids. Each listener is told about names the first time
+/// it receives a notification containing them, so that notifications don't need to allocate and
+/// copy strings.
+///
+/// Since Dart can send notifications for arbitrary names, ids are only stable within a
+/// _generation_. Once more than [TableNames::MAX_NAMES] names have been interned, the pool calls
+/// [TableNames::reset_if_full] when no ids are in use, and listeners are told to forget the names
+/// they know about with their next notification.
+#[derive(Default)]
+pub struct TableNames {
+    ids: HashMap<CString, u32>,
+    names: Vec<CString>,
+    generation: u64,
+}
+
+impl TableNames {
+    pub const MAX_NAMES: usize = 1024;
+
+    pub fn intern(&mut self, name: &CStr) -> u32 {
+        if let Some(id) = self.ids.get(name) {
+            return *id;
+        }
+
+        let id = self.names.len() as u32;
+        self.names.push(name.to_owned());
+        self.ids.insert(name.to_owned(), id);
+        id
+    }
+
+    pub fn names(&self) -> &[CString] {
+        &self.names
+    }
+
+    pub fn generation(&self) -> u64 {
+        self.generation
+    }
+
+    /// Forgets all names if more than [Self::MAX_NAMES] have been interned, returning whether
+    /// that was the case.
+    ///
+    /// Callers must ensure that no ids from the current generation are still in use.
+    pub fn reset_if_full(&mut self) -> bool {
+        if self.names.len() <= Self::MAX_NAMES {
+            return false;
+        }
+
+        self.ids.clear();
+        self.names.clear();
+        self.generation += 1;
+        true
+    }
+}
+
+/// A port listening for update notifications.
+pub struct UpdateListener {
+    pub port: DartPort,
+    /// The amount of table names (from [TableNames::names]) that have been sent to this listener.
+    pub known_tables: Cell<usize>,
+    /// The [TableNames] generation that `known_tables` refers to.
+    pub generation: Cell<u64>,
+}
+
+impl UpdateListener {
+    pub fn new(port: DartPort) -> Self {
+        Self {
+            port,
+            known_tables: Cell::new(0),
+            generation: Cell::new(0),
+        }
+    }
+}
+
+/// A set of table ids, backed by a bitset that keeps its capacity when cleared.
+#[derive(Default)]
+pub struct TableSet {
+    words: Vec<u64>,
+}
+
+impl TableSet {
+    /// Adds `id` to this set, returning whether it was newly inserted.
+    pub fn insert(&mut self, id: u32) -> bool {
+        let (word, bit) = Self::position(id);
+        if word >= self.words.len() {
+            self.words.resize(word + 1, 0);
+        }
+
+        let was_set = self.words[word] & bit != 0;
+        self.words[word] |= bit;
+        !was_set
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.words.iter().all(|w| *w == 0)
+    }
+
+    pub fn clear(&mut self) {
+        self.words.fill(0);
+    }
+
+    pub fn iter(&self) -> impl Iterator<Item = u32> + '_ {
+        self.words.iter().enumerate().flat_map(|(i, word)| {
+            let mut remaining = *word;
+            std::iter::from_fn(move || {
+                if remaining == 0 {
+                    return None;
+                }
+
+                let bit = remaining.trailing_zeros();
+                remaining &= remaining - 1;
+                Some(i as u32 * u64::BITS + bit)
+            })
+        })
+    }
+
+    fn position(id: u32) -> (usize, u64) {
+        ((id / u64::BITS) as usize, 1 << (id % u64::BITS))
+    }
+}
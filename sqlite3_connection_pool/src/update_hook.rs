@@ -1,25 +1,62 @@
 use crate::connection::Connection;
-use crate::dart::{DartPort, RawDartCObject, RawDartCObjectArray, RawDartCObjectValue};
+use crate::dart::{
+    RawDartCObject, RawDartCObjectArray, RawDartCObjectTypedData, RawDartCObjectValue,
+};
+use crate::notifier::ChangeNotifier;
 use crate::pool::ExternalFunctions;
-use std::collections::HashSet;
+use crate::row_set::{RowChanges, RowIdSet};
+use crate::table_names::{TableNames, TableSet, UpdateListener};
+use std::collections::HashMap;
 use std::ffi::{CStr, CString, c_char, c_int, c_void};
-use std::mem;
 use std::ptr::NonNull;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
 
-#[derive(Default)]
 pub struct CollectedTableUpdates {
+    /// Whether to record the rowids affected by writes in addition to table names.
+    track_rows: bool,
+    table_names: Arc<Mutex<TableNames>>,
+    /// Ids of table names seen by the update hook, so that we only need to lock `table_names`
+    /// for tables not seen on this connection before.
+    known_tables: HashMap<CString, u32>,
     /// Tables that have been updated in the current transaction (that hasn't been committed yet).
-    uncommitted_updates: HashSet<CString>,
+    uncommitted_updates: TableSet,
     /// Tables that have been updated and committed but for which Dart clients have not been
     /// notified yet.
     ///
     /// We can't notify Dart clients directly in a commit hook because the notification then runs
     /// concurrently to the rest of the commit. So we might issue reads before the transaction is
     /// fully committed, causing stale data to get returned.
-    outstanding_notification: HashSet<CString>,
+    outstanding_notification: TableSet,
+    /// If rows are tracked, changed rows for uncommitted and outstanding updates, indexed by
+    /// table id.
+    uncommitted_rows: Vec<RowChanges>,
+    outstanding_rows: Vec<RowChanges>,
+    /// Buffer for table ids in the next notification, reused across notifications.
+    notification_ids: Vec<i32>,
+    /// Counts commits on the connection, see [ChangeNotifier].
+    local_commits: Arc<AtomicU64>,
 }
 
 impl CollectedTableUpdates {
+    pub fn new(
+        track_rows: bool,
+        table_names: Arc<Mutex<TableNames>>,
+        local_commits: Arc<AtomicU64>,
+    ) -> Self {
+        Self {
+            track_rows,
+            table_names,
+            known_tables: Default::default(),
+            uncommitted_updates: Default::default(),
+            outstanding_notification: Default::default(),
+            uncommitted_rows: Default::default(),
+            outstanding_rows: Default::default(),
+            notification_ids: Default::default(),
+            local_commits,
+        }
+    }
+
     pub fn attach_to(
         ptr: *mut CollectedTableUpdates,
         functions: &ExternalFunctions,
@@ -27,14 +64,14 @@ impl CollectedTableUpdates {
     ) {
         extern "C" fn update_hook(
             context: NonNull<c_void>,
-            _write_kind: c_int,
+            write_kind: c_int,
             _database: *const c_char,
             table: *const c_char,
-            _rowid: i64,
+            rowid: i64,
         ) {
             let table = unsafe { CStr::from_ptr(table) };
             let context = unsafe { context.cast::<CollectedTableUpdates>().as_mut() };
-            context.handle_update(table)
+            context.handle_update(table, write_kind, rowid)
         }
 
         extern "C" fn rollback_hook(context: NonNull<c_void>) {
@@ -54,78 +91,262 @@ impl CollectedTableUpdates {
         (functions.sqlite3_rollback_hook)(connection, Some(rollback_hook), ptr.cast());
     }
 
-    fn handle_update(&mut self, table: &CStr) {
-        if !self.outstanding_notification.contains(table)
-            && !self.uncommitted_updates.contains(table)
-        {
-            self.uncommitted_updates.insert(table.to_owned());
+    fn table_id(&mut self, table: &CStr) -> u32 {
+        if let Some(id) = self.known_tables.get(table) {
+            return *id;
+        }
+
+        let id = self.table_names.lock().unwrap().intern(table);
+        self.known_tables.insert(table.to_owned(), id);
+        id
+    }
+
+    fn handle_update(&mut self, table: &CStr, write_kind: c_int, rowid: i64) {
+        let id = self.table_id(table);
+        self.uncommitted_updates.insert(id);
+
+        if self.track_rows {
+            let index = id as usize;
+            if index >= self.uncommitted_rows.len() {
+                self.uncommitted_rows.resize_with(index + 1, Default::default);
+            }
+            self.uncommitted_rows[index].record(write_kind, rowid);
         }
     }
 
     fn handle_commit(&mut self) {
-        for update in mem::take(&mut self.uncommitted_updates) {
-            self.outstanding_notification.insert(update);
+        self.local_commits.fetch_add(1, Ordering::SeqCst);
+
+        for id in self.uncommitted_updates.iter() {
+            self.outstanding_notification.insert(id);
+
+            if self.track_rows {
+                let index = id as usize;
+                if index >= self.outstanding_rows.len() {
+                    self.outstanding_rows.resize_with(index + 1, Default::default);
+                }
+
+                let changes = &mut self.uncommitted_rows[index];
+                self.outstanding_rows[index].union(changes);
+                changes.clear();
+            }
         }
+
+        self.uncommitted_updates.clear();
     }
 
     fn handle_rollback(&mut self) {
+        if self.track_rows {
+            for id in self.uncommitted_updates.iter() {
+                self.uncommitted_rows[id as usize].clear();
+            }
+        }
+
         self.uncommitted_updates.clear()
     }
 
-    pub fn send_notification(&mut self, listeners: &[DartPort], functions: &ExternalFunctions) {
-        let updates = mem::take(&mut self.outstanding_notification);
-        if updates.is_empty() {
+    pub fn send_notification(
+        &mut self,
+        listeners: &[UpdateListener],
+        notifier: Option<&ChangeNotifier>,
+        functions: &ExternalFunctions,
+    ) {
+        if self.outstanding_notification.is_empty() {
             return;
         }
 
-        send_update_notification(updates.iter().map(|c| c.as_c_str()), listeners, functions);
+        self.notification_ids.clear();
+        self.notification_ids
+            .extend(self.outstanding_notification.iter().map(|id| id as i32));
+        self.outstanding_notification.clear();
+
+        if let Some(notifier) = notifier {
+            let names = self.table_names.lock().unwrap();
+            let names = names.names();
+            notifier.queue(
+                self.notification_ids
+                    .iter()
+                    .map(|id| names[*id as usize].as_c_str()),
+            );
+        }
+
+        send_table_ids(
+            &self.notification_ids,
+            self.track_rows.then_some(&*self.outstanding_rows),
+            &self.table_names,
+            listeners,
+            functions,
+        );
+
+        if self.track_rows {
+            for id in &self.notification_ids {
+                self.outstanding_rows[*id as usize].clear();
+            }
+        }
+    }
+
+    /// Resets [TableNames] if it's full.
+    ///
+    /// This must only be called outside of transactions and after [Self::send_notification], so
+    /// that no table ids are in use.
+    pub fn reset_table_names_if_full(&mut self) {
+        if self.table_names.lock().unwrap().reset_if_full() {
+            self.known_tables.clear();
+            self.uncommitted_rows.clear();
+            self.outstanding_rows.clear();
+        }
     }
 }
 
+/// Sends a notification for tables with the given names, as requested by Dart.
 pub fn send_update_notification<'a>(
     updates: impl IntoIterator<Item = &'a CStr>,
-    listeners: &[DartPort],
+    table_names: &Mutex<TableNames>,
+    listeners: &[UpdateListener],
     functions: &ExternalFunctions,
 ) {
     if listeners.is_empty() {
         return;
     }
 
-    let iter = updates.into_iter();
-    let mut dart_strings: Vec<RawDartCObject> = Vec::with_capacity(iter.size_hint().0);
-    for update in iter {
-        dart_strings.push(RawDartCObject {
-            type_: RawDartCObject::TYPE_STRING,
-            value: RawDartCObjectValue {
-                as_string: update.as_ptr(),
-            },
-        });
-    }
+    let ids: Vec<i32> = {
+        let mut names = table_names.lock().unwrap();
+        updates
+            .into_iter()
+            .map(|name| names.intern(name) as i32)
+            .collect()
+    };
 
-    raw_send_update_notification(dart_strings, listeners, functions);
+    send_table_ids(&ids, None, table_names, listeners, functions);
 }
 
-fn raw_send_update_notification(
-    updates: Vec<RawDartCObject>,
-    listeners: &[DartPort],
-    functions: &ExternalFunctions,
-) {
-    let mut dart_string_references: Vec<*mut RawDartCObject> =
-        updates.iter().map(|d| d as *const _ as *mut _).collect();
+fn typed_data_object<T>(type_: c_int, values: &[T]) -> RawDartCObject {
+    RawDartCObject {
+        type_: RawDartCObject::TYPE_TYPED_DATA,
+        value: RawDartCObjectValue {
+            as_typed_data: RawDartCObjectTypedData {
+                type_,
+                length: values.len() as isize,
+                values: values.as_ptr().cast(),
+            },
+        },
+    }
+}
 
-    // Create Dart list of strings.
-    let mut dart_msg = RawDartCObject {
+fn array_object(values: &mut [*mut RawDartCObject]) -> RawDartCObject {
+    RawDartCObject {
         type_: RawDartCObject::TYPE_ARRAY,
         value: RawDartCObjectValue {
             as_array: RawDartCObjectArray {
-                length: dart_string_references.len() as isize,
-                values: dart_string_references.as_mut_ptr(),
+                length: values.len() as isize,
+                values: values.as_mut_ptr(),
             },
         },
+    }
+}
+
+/// Sends a `[ids, newNames, rows, reset]` message to each listener.
+///
+/// - `ids` is an `Int32List` of updated table ids.
+/// - `newNames` is a list of table names the listener hasn't seen yet, or `null`. Ids are
+///   assigned sequentially, so the listener appends these to the names it knows about.
+/// - `reset` is true if [TableNames] has been reset since the last message to the listener, which
+///   then needs to forget the names it knows about before appending `newNames`.
+/// - `rows` is `null` unless rows are tracked (in which case `rows` is indexed by table id).
+///   Otherwise, it's a list containing an `[inserted, updated, deleted]` list for each entry in
+///   `ids`. Each of the row sets is an
+///   `Int64List` of inclusive `(start, end)` rowid ranges, or `null` if too many rows were
+///   affected to track them.
+fn send_table_ids(
+    ids: &[i32],
+    rows: Option<&[RowChanges]>,
+    table_names: &Mutex<TableNames>,
+    listeners: &[UpdateListener],
+    functions: &ExternalFunctions,
+) {
+    if listeners.is_empty() {
+        return;
+    }
+
+    fn row_set_object(set: &RowIdSet) -> RawDartCObject {
+        // The length of typed data counts elements, so the ranges need to be flattened.
+        match set.flat_ranges() {
+            Some(ranges) => typed_data_object(RawDartCObjectTypedData::TYPE_INT64, ranges),
+            None => RawDartCObject::null(),
+        }
+    }
+
+    // Dart_PostCObject copies the message, so we only need to keep the objects alive until the
+    // message has been posted.
+    let mut ids_object = typed_data_object(RawDartCObjectTypedData::TYPE_INT32, ids);
+
+    let mut row_objects: Vec<[RawDartCObject; 3]> = ids
+        .iter()
+        .filter_map(|id| rows.map(|rows| &rows[*id as usize]))
+        .map(|changes| {
+            [
+                row_set_object(&changes.inserted),
+                row_set_object(&changes.updated),
+                row_set_object(&changes.deleted),
+            ]
+        })
+        .collect();
+    let mut row_references: Vec<[*mut RawDartCObject; 3]> = row_objects
+        .iter_mut()
+        .map(|[a, b, c]| [a as *mut _, b as *mut _, c as *mut _])
+        .collect();
+    let mut row_arrays: Vec<RawDartCObject> = row_references
+        .iter_mut()
+        .map(|references| array_object(references))
+        .collect();
+    let mut row_array_references: Vec<*mut RawDartCObject> =
+        row_arrays.iter_mut().map(|r| r as *mut _).collect();
+    let mut rows_object = match rows {
+        Some(_) => array_object(&mut row_array_references),
+        None => RawDartCObject::null(),
     };
 
-    // Send to registered update ports.
+    let table_names = table_names.lock().unwrap();
+    let generation = table_names.generation();
+    let names = table_names.names();
+
     for listener in listeners {
-        (functions.dart_post_c_object)(*listener, &mut dart_msg);
+        let reset = listener.generation.get() != generation;
+        let known = if reset {
+            0
+        } else {
+            listener.known_tables.get()
+        };
+        let mut name_objects: Vec<RawDartCObject> = names[known..]
+            .iter()
+            .map(|name| RawDartCObject {
+                type_: RawDartCObject::TYPE_STRING,
+                value: RawDartCObjectValue {
+                    as_string: name.as_ptr(),
+                },
+            })
+            .collect();
+        let mut name_references: Vec<*mut RawDartCObject> =
+            name_objects.iter_mut().map(|n| n as *mut _).collect();
+        let mut names_object = if name_references.is_empty() {
+            RawDartCObject::null()
+        } else {
+            array_object(&mut name_references)
+        };
+
+        let mut reset_object = RawDartCObject::from(reset);
+
+        let mut message_references: [*mut RawDartCObject; 4] = [
+            &mut ids_object,
+            &mut names_object,
+            &mut rows_object,
+            &mut reset_object,
+        ];
+        let mut message = array_object(&mut message_references);
+
+        if (functions.dart_post_c_object)(listener.port, &mut message) {
+            listener.known_tables.set(names.len());
+            listener.generation.set(generation);
+        }
     }
 }
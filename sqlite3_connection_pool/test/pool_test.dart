@@ -13,12 +13,14 @@ void main() {
     int readConnections = 5,
     int preparedStatementCacheSize = 0,
     bool enableUpdateHooks = true,
+    bool trackUpdatedRows = false,
   }) {
     final pool = createPool(
       directory: sandbox,
       readConnections: readConnections,
       preparedStatementCacheSize: preparedStatementCacheSize,
       enableUpdateHooks: enableUpdateHooks,
+      trackUpdatedRows: trackUpdatedRows,
     );
     addTearDown(pool.close);
     return pool;
@@ -145,6 +147,64 @@ void main() {
     }
   });
 
+  group('idle readers', () {
+    test('can be obtained synchronously', () async {
+      final pool = testPool(readConnections: 2);
+      final first = pool.tryReader()!;
+      final second = pool.tryReader()!;
+      expect(pool.tryReader(), isNull);
+
+      expect(await first.select('SELECT 1'), isNotNull);
+      first.returnLease();
+      final third = pool.tryReader()!;
+
+      second.returnLease();
+      third.returnLease();
+    });
+
+    test('are handed to waiting requests', () async {
+      final pool = testPool(readConnections: 1);
+      final first = pool.tryReader()!;
+
+      var hasSecond = false;
+      final secondFuture = pool.reader().whenComplete(() => hasSecond = true);
+      await pumpEventQueue();
+      expect(hasSecond, isFalse);
+
+      // While a request is waiting, the fast path must not bypass it.
+      first.returnLease();
+      expect(pool.tryReader(), isNull);
+
+      final second = await secondFuture;
+      second.returnLease();
+      pool.tryReader()!.returnLease();
+    });
+
+    test('are not available during exclusive access', () async {
+      final pool = testPool(readConnections: 2);
+      final exclusive = await pool.exclusiveAccess();
+      expect(pool.tryReader(), isNull);
+      exclusive.close();
+
+      pool.tryReader()!.returnLease();
+    });
+
+    test('with many readers', () async {
+      final pool = testPool(readConnections: 100);
+      final leases = [
+        for (var i = 0; i < 100; i++) await pool.reader(),
+      ];
+      expect(pool.tryReader(), isNull);
+      for (final lease in leases) {
+        lease.returnLease();
+      }
+
+      final exclusive = await pool.exclusiveAccess();
+      expect(exclusive.readers, hasLength(100));
+      exclusive.close();
+    });
+  });
+
   test('cannot use after closing', () async {
     final pool = testPool();
     pool.close();
@@ -175,6 +235,225 @@ void main() {
     db.returnLease();
   });
 
+  group('group commit', () {
+    test('runs mergeable writes in a shared transaction', () async {
+      final pool = testPool();
+      await pool.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+      final updates = StreamQueue(pool.updatedTables);
+
+      // Hold the writer so that all following writes are grouped.
+      final writer = await pool.writer();
+      final writes = [
+        for (var i = 0; i < 100; i++)
+          pool.execute(
+            'INSERT INTO foo VALUES (?)',
+            parameters: [i],
+            mergeable: true,
+          ),
+      ];
+      await pumpEventQueue();
+      writer.returnLease();
+
+      final results = await Future.wait(writes);
+      for (final (i, result) in results.indexed) {
+        expect(result.lastInsertRowId, i);
+        expect(result.changes, 1);
+        // Results describe the state after the group has been committed.
+        expect(result.autoCommit, isTrue);
+      }
+
+      // All writes should have been committed in a single transaction.
+      await expectLater(updates, emits(['foo']));
+      expect(await pool.readQuery('SELECT * FROM foo'), hasLength(100));
+    });
+
+    test('failing write does not abort others', () async {
+      final pool = testPool();
+      await pool.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+
+      final writer = await pool.writer();
+      final first = pool.execute(
+        'INSERT INTO foo VALUES (1)',
+        mergeable: true,
+      );
+      final duplicate = pool.execute(
+        'INSERT INTO foo VALUES (1), (2)',
+        mergeable: true,
+      );
+      final last = pool.execute('INSERT INTO foo VALUES (3)', mergeable: true);
+      writer.returnLease();
+
+      await first;
+      await expectLater(duplicate, throwsA(isA<SqliteException>()));
+      await last;
+
+      final rows = await pool.readQuery('SELECT id FROM foo ORDER BY id');
+      expect(rows.map((r) => r['id']), [1, 3]);
+    });
+
+    test('fails entire group if transaction is rolled back', () async {
+      final pool = testPool();
+      await pool.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+
+      final writer = await pool.writer();
+      final first = pool.execute(
+        'INSERT INTO foo VALUES (1)',
+        mergeable: true,
+      );
+      final rollback = pool.execute(
+        'INSERT OR ROLLBACK INTO foo VALUES (1)',
+        mergeable: true,
+      );
+      writer.returnLease();
+
+      await expectLater(first, throwsA(isA<SqliteException>()));
+      await expectLater(rollback, throwsA(isA<SqliteException>()));
+      expect(await pool.readQuery('SELECT * FROM foo'), isEmpty);
+
+      // Subsequent groups should work again.
+      await pool.execute('INSERT INTO foo VALUES (1)', mergeable: true);
+      expect(await pool.readQuery('SELECT * FROM foo'), hasLength(1));
+    });
+  });
+
+  group('snapshot group', () {
+    test('readers see consistent state', () async {
+      final pool = testPool(readConnections: 3);
+      await pool.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+      await pool.execute('INSERT INTO foo DEFAULT VALUES');
+
+      final group = await pool.snapshotGroup(2);
+      expect(group.readers, hasLength(2));
+
+      // The writer is available while the group is active, but writes made
+      // after obtaining the group are not visible to it.
+      await pool.execute('INSERT INTO foo DEFAULT VALUES');
+      for (final reader in group.readers) {
+        final (rows, _) = await reader.select('SELECT * FROM foo');
+        expect(rows, hasLength(1));
+      }
+
+      // Other readers see the new state.
+      expect(await pool.readQuery('SELECT * FROM foo'), hasLength(2));
+      group.close();
+
+      final exclusive = await pool.exclusiveAccess();
+      for (final reader in exclusive.readers) {
+        expect(reader.unsafeRawConnection.database.autocommit, isTrue);
+        final (rows, _) = await reader.select('SELECT * FROM foo');
+        expect(rows, hasLength(2));
+      }
+      exclusive.close();
+    });
+
+    test('waits for readers', () async {
+      final pool = testPool(readConnections: 2);
+      final reader = await pool.reader();
+
+      var hasGroup = false;
+      final groupFuture = pool.snapshotGroup(2).whenComplete(
+        () => hasGroup = true,
+      );
+      await pumpEventQueue();
+      expect(hasGroup, isFalse);
+
+      // The pending group must not hold the writer while waiting for readers.
+      await pool.execute('CREATE TABLE foo (bar TEXT);');
+
+      reader.returnLease();
+      (await groupFuture).close();
+    });
+
+    test('checks amount of readers', () async {
+      final pool = testPool(readConnections: 2);
+      expect(() => pool.snapshotGroup(0), throwsRangeError);
+      expect(() => pool.snapshotGroup(3), throwsRangeError);
+    });
+  });
+
+  group('partitioned query', () {
+    Future<void> insertRows(SqliteConnectionPool pool, int count) async {
+      await pool.execute(
+        'CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY, value INTEGER)',
+      );
+      await pool.execute(
+        'WITH RECURSIVE ids(id) AS (SELECT 1 UNION ALL SELECT id + 1 FROM ids '
+        'LIMIT ?) INSERT INTO foo SELECT id, id * 2 FROM ids',
+        parameters: [count],
+      );
+    }
+
+    Future<int> sum(SqliteConnectionPool pool, {int? partitions}) {
+      return pool.partitionedQuery(
+        table: 'foo',
+        sql: 'SELECT sum(value) FROM foo WHERE rowid BETWEEN ? AND ?',
+        map: (rows) => rows.single.columnAt(0) as int? ?? 0,
+        combine: (a, b) => a + b,
+        partitions: partitions,
+      );
+    }
+
+    test('splits query across readers', () async {
+      final pool = testPool(readConnections: 4);
+      await insertRows(pool, 1000);
+      expect(await sum(pool), 1000 * 1001);
+      expect(await sum(pool, partitions: 3), 1000 * 1001);
+    });
+
+    test('only uses idle readers', () async {
+      final pool = testPool(readConnections: 4);
+      await insertRows(pool, 1000);
+
+      final busy = [for (var i = 0; i < 3; i++) await pool.reader()];
+      expect(await sum(pool), 1000 * 1001);
+
+      // Also waits for a reader if none are idle.
+      final last = await pool.reader();
+      final result = sum(pool);
+      busy.first.returnLease();
+      expect(await result, 1000 * 1001);
+
+      for (final reader in [...busy.skip(1), last]) {
+        reader.returnLease();
+      }
+    });
+
+    test('with fewer rows than partitions', () async {
+      final pool = testPool(readConnections: 4);
+      await insertRows(pool, 2);
+      expect(await sum(pool), 6);
+    });
+
+    test('on empty table', () async {
+      final pool = testPool(readConnections: 4);
+      await insertRows(pool, 0);
+      expect(await sum(pool), 0);
+    });
+
+    test('without readers', () async {
+      final pool = testPool(readConnections: 0);
+      await insertRows(pool, 10);
+      expect(await sum(pool), 110);
+    });
+
+    test('rejects keys that are not integers', () async {
+      final pool = testPool(readConnections: 2);
+      await pool.execute('CREATE TABLE foo (name TEXT PRIMARY KEY)');
+      await pool.execute("INSERT INTO foo VALUES ('a'), ('b')");
+
+      await expectLater(
+        pool.partitionedQuery(
+          table: 'foo',
+          keyColumn: 'name',
+          sql: 'SELECT count(*) FROM foo WHERE name BETWEEN ? AND ?',
+          map: (rows) => rows.single.columnAt(0) as int,
+          combine: (a, b) => a + b,
+        ),
+        throwsArgumentError,
+      );
+    });
+  });
+
   group('can add additional readers', () {
     test('completes previous requests', () async {
       final pool = testPool(readConnections: 1);
@@ -243,6 +522,114 @@ void main() {
       await expectLater(updates, emits(['foo']));
     });
 
+    test('resolves table names for new listeners', () async {
+      final pool = testPool();
+      await pool.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+      await pool.execute('CREATE TABLE bar (id INTEGER NOT NULL PRIMARY KEY)');
+
+      var updates = StreamQueue(pool.updatedTables);
+      await pool.execute('INSERT INTO foo DEFAULT VALUES;');
+      await expectLater(updates, emits(['foo']));
+      await updates.cancel();
+
+      // The new listener hasn't seen the name of foo yet.
+      updates = StreamQueue(pool.updatedTables);
+      await pool.execute(
+        'INSERT INTO bar DEFAULT VALUES; INSERT INTO foo DEFAULT VALUES;',
+      );
+      await expectLater(updates, emits(unorderedEquals(['foo', 'bar'])));
+    });
+
+    test('reports affected rows', () async {
+      final pool = testPool(trackUpdatedRows: true);
+      await pool.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+      final updates = StreamQueue(pool.updates);
+
+      await pool.execute(
+        'INSERT INTO foo (id) VALUES (1), (2), (3), (10);'
+        'UPDATE foo SET id = 20 WHERE id = 10;'
+        'DELETE FROM foo WHERE id = 2;',
+      );
+
+      final [update] = await updates.next;
+      expect(update.table, 'foo');
+      final rows = update.rows!;
+      expect(rows.inserted!.ranges, [(1, 3), (10, 10)]);
+      // Updates report the rowid after the update.
+      expect(rows.updated!.ranges, [(20, 20)]);
+      expect(rows.deleted!.ranges, [(2, 2)]);
+      expect(rows.affects(20), isTrue);
+      expect(rows.affects(4), isFalse);
+    });
+
+    test('reports all ranges of affected rows', () async {
+      final pool = testPool(trackUpdatedRows: true);
+      await pool.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+      final updates = StreamQueue(pool.updates);
+
+      await pool.execute(
+        'INSERT INTO foo (id) VALUES (1), (3), (4), (7), (9), (10), (11), (20)',
+      );
+
+      final [update] = await updates.next;
+      final inserted = update.rows!.inserted!;
+      expect(inserted.ranges, [(1, 1), (3, 4), (7, 7), (9, 11), (20, 20)]);
+      for (final id in [1, 4, 7, 10, 20]) {
+        expect(inserted.contains(id), isTrue, reason: '$id');
+      }
+      expect(inserted.contains(8), isFalse);
+      expect(inserted.contains(21), isFalse);
+    });
+
+    test('reports overflowed row sets as null', () async {
+      final pool = testPool(trackUpdatedRows: true);
+      await pool.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+      final updates = StreamQueue(pool.updates);
+
+      await pool.execute('''
+WITH RECURSIVE ids(id) AS (SELECT 0 UNION ALL SELECT id + 2 FROM ids LIMIT 5000)
+INSERT INTO foo SELECT id FROM ids;
+''');
+
+      final [update] = await updates.next;
+      expect(update.rows!.inserted, isNull);
+      expect(update.rows!.updated!.isEmpty, isTrue);
+      expect(update.rows!.affects(1), isTrue);
+    });
+
+    test('reports writes from other processes', () async {
+      // Pools with different names don't share state, so they behave like
+      // pools opened by different processes.
+      SqliteConnectionPool open(String name) {
+        final pool = SqliteConnectionPool.open(
+          name: p.join(sandbox, name),
+          openConnections: () => PoolConnections(
+            openDatabase(sandbox),
+            [openDatabase(sandbox)],
+            crossProcessUpdates: const Duration(milliseconds: 10),
+          ),
+        );
+        addTearDown(pool.close);
+        return pool;
+      }
+
+      final first = open('first');
+      final second = open('second');
+      await first.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+      await first.execute('CREATE TABLE bar (id INTEGER NOT NULL PRIMARY KEY)');
+
+      final updates = StreamQueue(second.updatedTables);
+      await first.execute('INSERT INTO foo DEFAULT VALUES;');
+      await expectLater(updates, emits(['foo']));
+
+      // Local writes are not reported again through the shared file.
+      await second.execute('INSERT INTO bar DEFAULT VALUES;');
+      await expectLater(updates, emits(['bar']));
+      await Future<void>.delayed(const Duration(milliseconds: 50));
+      await first.execute('INSERT INTO foo DEFAULT VALUES;');
+      await expectLater(updates, emits(['foo']));
+    });
+
     test('can disable builtin update tracking', () async {
       final pool = testPool(enableUpdateHooks: false);
       final updates = StreamQueue(pool.updatedTables);
@@ -278,6 +665,24 @@ void main() {
       expect(() => pool.dispatchUpdateNotification([]), throwsStateError);
     });
 
+    test('reassigns table ids after many custom names', () async {
+      final pool = testPool();
+      final updates = StreamQueue(pool.updatedTables);
+      await pool.execute('CREATE TABLE foo (id INTEGER NOT NULL PRIMARY KEY)');
+
+      // More names than the pool keeps ids for, after which it starts over.
+      for (var i = 0; i < 1100; i++) {
+        pool.dispatchUpdateNotification(['custom $i']);
+        await expectLater(updates, emits(['custom $i']));
+      }
+
+      await pool.execute('INSERT INTO foo DEFAULT VALUES;');
+      await expectLater(updates, emits(['foo']));
+      pool.dispatchUpdateNotification(['custom 0']);
+      await expectLater(updates, emits(['custom 0']));
+      pool.close();
+    });
+
     test('emits updates for isolate write', () async {
       final pool = testPool();
       final updates = StreamQueue(pool.updatedTables);
@@ -378,6 +783,75 @@ void main() {
       writer.returnLease();
     });
 
+    test('pins frequently used statements', () async {
+      final pool = testPool(preparedStatementCacheSize: 4);
+      final writer = await pool.writer();
+
+      for (var i = 0; i < 100; i++) {
+        await writer.select('SELECT 1');
+      }
+      // Prepare more statements than the cache can hold.
+      for (var i = 0; i < 8; i++) {
+        await writer.select('SELECT $i AS another');
+      }
+
+      await writer.unsafeAccess((connection) {
+        expect(connection.lookupCachedStatement('SELECT 1'), isNotNull);
+        expect(connection.cachedStatementHits['SELECT 1'], 100);
+      });
+      writer.returnLease();
+
+      expect(await pool.hotStatements(limit: 1), ['SELECT 1']);
+    });
+
+    test('unpins statements that are no longer used', () async {
+      final pool = testPool(preparedStatementCacheSize: 4);
+      final writer = await pool.writer();
+
+      for (var i = 0; i < 100; i++) {
+        await writer.select('SELECT 1');
+      }
+      // Recent hits are halved after each miss following 1024 lookups, so
+      // SELECT 1 is unpinned after the second round.
+      for (var round = 0; round < 2; round++) {
+        for (var i = 0; i < 1024; i++) {
+          await writer.select('SELECT 2');
+        }
+        await writer.select('SELECT $round AS miss');
+      }
+      // Which allows evicting it like any other statement.
+      for (var i = 0; i < 8; i++) {
+        await writer.select('SELECT $i AS another');
+      }
+
+      await writer.unsafeAccess((connection) {
+        expect(connection.lookupCachedStatement('SELECT 1'), isNull);
+        expect(connection.lookupCachedStatement('SELECT 2'), isNotNull);
+      });
+      writer.returnLease();
+    });
+
+    test('prepares warm-up statements', () async {
+      final pool = SqliteConnectionPool.open(
+        name: sandbox,
+        openConnections: () => PoolConnections(
+          openDatabase(sandbox),
+          [openDatabase(sandbox)],
+          preparedStatementCacheSize: 16,
+          warmupStatements: ['SELECT 1', 'SELECT 2; SELECT 3', 'invalid'],
+        ),
+      );
+      addTearDown(pool.close);
+      pool.addReaders([openDatabase(sandbox)]);
+
+      final exclusive = await pool.exclusiveAccess();
+      for (final connection in [exclusive.writer, ...exclusive.readers]) {
+        final raw = connection.unsafeRawConnection;
+        expect(raw.cachedStatementHits, {'SELECT 1': 0});
+      }
+      exclusive.close();
+    });
+
     test('does not cache EXPLAIN statements', () async {
       final pool = testPool(preparedStatementCacheSize: 16);
       final writer = await pool.writer();
@@ -569,6 +1043,7 @@ SqliteConnectionPool createPool({
   int readConnections = 5,
   int preparedStatementCacheSize = 0,
   bool enableUpdateHooks = true,
+  bool trackUpdatedRows = false,
 }) {
   return SqliteConnectionPool.open(
     name: directory,
@@ -577,6 +1052,7 @@ SqliteConnectionPool createPool({
       readConnections,
       preparedStatementCacheSize,
       enableUpdateHooks,
+      trackUpdatedRows: trackUpdatedRows,
     ),
   );
 }
@@ -585,13 +1061,15 @@ PoolConnections Function() poolConnectionOpener(
   String directory,
   int readConnections,
   int preparedStatementCacheSize,
-  bool enableUpdateHooks,
-) {
+  bool enableUpdateHooks, {
+  bool trackUpdatedRows = false,
+}) {
   return () => PoolConnections(
     openDatabase(directory),
     [for (var i = 0; i < readConnections; i++) openDatabase(directory)],
     preparedStatementCacheSize: preparedStatementCacheSize,
     enableNativeUpdateHooks: enableUpdateHooks,
+    trackUpdatedRows: trackUpdatedRows,
   );
 }
 
@@ -102,4 +102,11 @@ const stableFunctions = {
 };
 
 /// Newer functions that aren't available in older WASM bundles.
-const unstable = <String>{};
+const unstable = <String>{
+  'sqlite3_blob_open',
+  'sqlite3_blob_reopen',
+  'sqlite3_blob_close',
+  'sqlite3_blob_bytes',
+  'sqlite3_blob_read',
+  'sqlite3_blob_write',
+};
@@ -4,6 +4,7 @@ import 'package:async/async.dart';
 import 'package:http/http.dart';
 import 'package:jaspr_riverpod/jaspr_riverpod.dart';
 import 'package:jaspr_riverpod/legacy.dart';
+import 'package:sqlite3/wasm.dart' show DurabilityPolicy, FlushStatistics;
 import 'package:sqlite3_web/sqlite3_web.dart';
 import 'package:sqlite3_web/src/locks.dart';
 import 'package:web/web.dart' hide Client;
@@ -13,7 +14,23 @@ import 'message.dart';
 final class BenchmarkConfiguration {
   final DatabaseImplementation implementation;
 
-  const BenchmarkConfiguration({required this.implementation});
+  /// The durability policy used for OPFS databases.
+  final DurabilityPolicy durability;
+
+  const BenchmarkConfiguration({
+    required this.implementation,
+    this.durability = DurabilityPolicy.full,
+  });
+
+  BenchmarkConfiguration copyWith({
+    DatabaseImplementation? implementation,
+    DurabilityPolicy? durability,
+  }) {
+    return BenchmarkConfiguration(
+      implementation: implementation ?? this.implementation,
+      durability: durability ?? this.durability,
+    );
+  }
 
   Future<void> delete(WebSqlite client) async {
     final storage = implementation.storage;
@@ -23,7 +40,11 @@ final class BenchmarkConfiguration {
   }
 
   Future<Database> connect(WebSqlite client) async {
-    return await client.connect(databaseName, implementation);
+    return await client.connect(
+      databaseName,
+      implementation,
+      durability: durability,
+    );
   }
 
   static const defaultConfig = BenchmarkConfiguration(
@@ -70,6 +91,31 @@ final class SingleTabBenchmarkTarget extends BenchmarkTarget {
     'Test 15: A big DELETE followed by many small INSERTs',
     'Test 16: DROP TABLE',
   ];
+
+  /// Benchmarks sending many small requests, which are dominated by the
+  /// latency of the channel to the worker instead of by sqlite3 itself.
+  static final requestBenchmarks = <(String, Future<void> Function(Database))>[
+    (
+      'Test 17: 1000 SELECTs in separate requests',
+      (db) async {
+        for (var i = 0; i < 1000; i++) {
+          await db.select('SELECT ?', parameters: [i]);
+        }
+      },
+    ),
+    (
+      'Test 18: 1000 INSERTs in separate requests',
+      (db) async {
+        await db.execute('CREATE TABLE requests (a INTEGER, b TEXT);');
+        for (var i = 0; i < 1000; i++) {
+          await db.execute(
+            'INSERT INTO requests VALUES (?, ?)',
+            parameters: [i, 'row $i'],
+          );
+        }
+      },
+    ),
+  ];
 }
 
 /// Multi-tab / contention benchmarks are not yet supported.
@@ -92,7 +138,11 @@ final class BenchmarkResult {
   /// Null if the benchmark is currently running.
   final Duration? runtime;
 
-  BenchmarkResult(this.tab, this.name, this.runtime);
+  /// Flushes issued while running the benchmark, if the file system reports
+  /// them.
+  final FlushStatistics? flushes;
+
+  BenchmarkResult(this.tab, this.name, this.runtime, [this.flushes]);
 
   String get description {
     final buffer = StringBuffer();
@@ -105,6 +155,12 @@ final class BenchmarkResult {
       ..write(': ');
     if (runtime case final completedRuntime?) {
       buffer.write('${completedRuntime.inMilliseconds}ms');
+      if (flushes case final flushes?) {
+        buffer.write(
+          ' (${flushes.flushes} flushes for ${flushes.syncs} syncs, '
+          '${flushes.flushTime.inMilliseconds}ms flushing)',
+        );
+      }
     } else {
       buffer.write('running...');
     }
@@ -147,6 +203,34 @@ final class BenchmarkState extends Notifier<Result<List<BenchmarkResult>>> {
 
     final db = await target.configuration.connect(sqlite);
 
+    // Flushes that have been deferred by the durability policy are part of the
+    // benchmark, so we flush them explicitly before stopping the clock.
+    Future<BenchmarkResult> measure(
+      String name,
+      Future<void> Function() body,
+    ) async {
+      final before = await db.fileSystem.flushStatistics();
+      final stopwatch = Stopwatch()..start();
+      await body();
+      await db.fileSystem.flush();
+      stopwatch.stop();
+      final after = await db.fileSystem.flushStatistics();
+
+      return BenchmarkResult(
+        null,
+        name,
+        stopwatch.elapsed,
+        switch ((before, after)) {
+          (final before?, final after?) => FlushStatistics(
+            syncs: after.syncs - before.syncs,
+            flushes: after.flushes - before.flushes,
+            flushTime: after.flushTime - before.flushTime,
+          ),
+          _ => null,
+        },
+      );
+    }
+
     for (final (i, name) in SingleTabBenchmarkTarget.names.indexed) {
       results.add(BenchmarkResult(null, name, null));
       publish();
@@ -154,12 +238,12 @@ final class BenchmarkState extends Notifier<Result<List<BenchmarkResult>>> {
       final sql = await _fetchBenchmarkSql(i);
 
       results.removeLast();
+      results.add(await measure(name, () => db.execute(sql)));
+      publish();
+    }
 
-      final stopwatch = Stopwatch()..start();
-      await db.execute(sql);
-      stopwatch.stop();
-
-      results.add(BenchmarkResult(null, name, stopwatch.elapsed));
+    for (final (name, run) in SingleTabBenchmarkTarget.requestBenchmarks) {
+      results.add(await measure(name, () => run(db)));
       publish();
     }
 
@@ -236,11 +320,18 @@ final class ClientStateNotifier extends Notifier<ClientState?> {
   static final provider = NotifierProvider(ClientStateNotifier.new);
 }
 
+/// Whether to talk to the dedicated worker through shared memory, which
+/// requires the page to be served with cross-origin isolation headers.
+final useSharedMemory = StateProvider((ref) => false);
+
 final sqlite3 = Provider((ref) {
-  return WebSqlite.open(
+  final sqlite = WebSqlite.open(
     workers: _EncapsulatedWorkerConnector(),
     wasmModule: 'sqlite3.wasm',
+    useSharedMemory: ref.watch(useSharedMemory),
   );
+  ref.onDispose(sqlite.close);
+  return sqlite;
 });
 
 final featureDetectionResult = FutureProvider((ref) async {
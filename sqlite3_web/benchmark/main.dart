@@ -2,12 +2,17 @@ import 'package:async/async.dart';
 import 'package:jaspr/client.dart';
 import 'package:jaspr/dom.dart';
 import 'package:jaspr_riverpod/jaspr_riverpod.dart';
+import 'package:sqlite3/wasm.dart' show DurabilityPolicy;
 import 'package:sqlite3_web/sqlite3_web.dart';
 
 import 'benchmark.dart';
 
 /// To run benchmarks: `webdev serve benchmark:8080 --release`, also copy a
 /// `sqlite3.wasm` into this directory.
+///
+/// Comparing the shared memory channel requires a cross-origin isolated page,
+/// so serve it with `Cross-Origin-Opener-Policy: same-origin` and
+/// `Cross-Origin-Embedder-Policy: require-corp` headers (e.g. through a proxy).
 void main() {
   runApp(const ProviderScope(child: BenchmarkApp()), attachTo: '#app');
 }
@@ -73,7 +78,9 @@ final class _BenchmarkSelector extends StatelessComponent {
 
           context.read(selectedTarget.notifier).state = currentSelection
               .changeConfig(
-                BenchmarkConfiguration(implementation: implementation),
+                currentSelection.configuration.copyWith(
+                  implementation: implementation,
+                ),
               );
         },
         [
@@ -81,6 +88,35 @@ final class _BenchmarkSelector extends StatelessComponent {
             option(value: available.name, [Component.text(available.name)]),
         ],
       ),
+      select(
+        value: _durabilityOptions.entries
+            .firstWhere(
+              (e) => e.value == currentSelection.configuration.durability,
+            )
+            .key,
+        onChange: (value) {
+          context.read(selectedTarget.notifier).state = currentSelection
+              .changeConfig(
+                currentSelection.configuration.copyWith(
+                  durability: _durabilityOptions[value[0]],
+                ),
+              );
+        },
+        [
+          for (final name in _durabilityOptions.keys)
+            option(value: name, [Component.text(name)]),
+        ],
+      ),
+      select(
+        value: context.watch(useSharedMemory) ? 'shared' : 'ports',
+        onChange: (value) {
+          context.read(useSharedMemory.notifier).state = value[0] == 'shared';
+        },
+        [
+          const option(value: 'ports', [Component.text('Message ports')]),
+          const option(value: 'shared', [Component.text('Shared memory')]),
+        ],
+      ),
       button(
         onClick: () {
           final loadedSqlite = context.read(sqlite3);
@@ -103,6 +139,13 @@ final class _BenchmarkSelector extends StatelessComponent {
   }
 }
 
+/// Durability policies for OPFS databases that can be selected.
+const _durabilityOptions = {
+  'Flush every sync': DurabilityPolicy.full,
+  'Flush every 100ms': DurabilityPolicy.interval(Duration(milliseconds: 100)),
+  'Flush when idle': DurabilityPolicy.onIdle,
+};
+
 final class _BenchmarkResults extends StatelessComponent {
   const _BenchmarkResults();
 
@@ -443,6 +443,7 @@ export class DatabaseClient implements WebSqlite {
         useMultipleCiphersVfs: options?.enableEncryptedVfs ?? false,
       },
       c: options?.preparedStatementCacheSize ?? 0,
+      l: null,
     });
   }
 
@@ -558,6 +559,9 @@ class RemoteDatabase implements Database {
         z: options?.token ?? null,
         r: includeResultSet,
         c: options?.checkInTransaction ?? false,
+        b: null,
+        k: null,
+        n: null,
         d: this._internal_databaseId,
       },
       typeRowsResponse,
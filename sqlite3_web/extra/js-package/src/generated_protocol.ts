@@ -5,15 +5,25 @@ export const typeConnectRequest = "connect";
 export const typeCustomRequest = "custom";
 export const typeFileSystemExistsQuery = "fileSystemExists";
 export const typeFileSystemFlushRequest = "fileSystemFlush";
+export const typeFileSystemStatisticsRequest = "fileSystemStatistics";
 export const typeFileSystemAccess = "fileSystemAccess";
 export const typeRunQuery = "runQuery";
 export const typeRequestExclusiveLock = "exclusiveLock";
 export const typeReleaseLock = "releaseLock";
 export const typeCloseDatabase = "closeDatabase";
 export const typeOpenAdditionalConnection = "openAdditionalConnection";
+export const typeOpenCursor = "openCursor";
+export const typeFetchCursor = "fetchCursor";
+export const typeCloseCursor = "closeCursor";
+export const typeBatchRequest = "batch";
+export const typePrepareStatement = "prepare";
+export const typeFinalizeStatement = "finalize";
+export const typeWatchQuery = "watch";
+export const typeUnwatchQuery = "unwatch";
 export const typeSimpleSuccessResponse = "simpleSuccessResponse";
 export const typeEndpointResponse = "endpointResponse";
 export const typeRowsResponse = "rowsResponse";
+export const typeBatchResponse = "batchResponse";
 export const typeErrorResponse = "errorResponse";
 export const typeUpdateStreamRequest = "updateRequest";
 export const typeRollbackStreamRequest = "rollbackRequest";
@@ -25,6 +35,7 @@ export const typeDedicatedInSharedCompatibilityCheck =
 export const typeUpdateNotification = "notifyUpdate";
 export const typeCommitNotification = "notifyCommit";
 export const typeRollbackNotification = "notifyRollback";
+export const typeQueryDiffNotification = "notifyQueryDiff";
 export const typeAbortRequest = "abort";
 export type Message =
   | Notification
@@ -35,15 +46,25 @@ export type Message =
   | CustomRequest
   | FileSystemExistsQuery
   | FileSystemFlushRequest
+  | FileSystemStatisticsRequest
   | FileSystemAccess
   | RunQuery
   | RequestExclusiveLock
   | ReleaseLock
   | CloseDatabase
   | OpenAdditionalConnection
+  | OpenCursor
+  | FetchCursor
+  | CloseCursor
+  | BatchRequest
+  | PrepareStatement
+  | FinalizeStatement
+  | WatchQuery
+  | UnwatchQuery
   | SimpleSuccessResponse
   | EndpointResponse
   | RowsResponse
+  | BatchResponse
   | ErrorResponse
   | StreamRequest
   | UpdateStreamRequest
@@ -56,23 +77,34 @@ export type Message =
   | UpdateNotification
   | CommitNotification
   | RollbackNotification
+  | QueryDiffNotification
   | AbortRequest;
 export type Notification =
   | UpdateNotification
   | CommitNotification
-  | RollbackNotification;
+  | RollbackNotification
+  | QueryDiffNotification;
 export type Request =
   | OpenRequest
   | ConnectRequest
   | CustomRequest
   | FileSystemExistsQuery
   | FileSystemFlushRequest
+  | FileSystemStatisticsRequest
   | FileSystemAccess
   | RunQuery
   | RequestExclusiveLock
   | ReleaseLock
   | CloseDatabase
   | OpenAdditionalConnection
+  | OpenCursor
+  | FetchCursor
+  | CloseCursor
+  | BatchRequest
+  | PrepareStatement
+  | FinalizeStatement
+  | WatchQuery
+  | UnwatchQuery
   | StreamRequest
   | UpdateStreamRequest
   | RollbackStreamRequest
@@ -85,6 +117,7 @@ export type Response =
   | SimpleSuccessResponse
   | EndpointResponse
   | RowsResponse
+  | BatchResponse
   | ErrorResponse;
 export interface OpenRequest {
   // Dart name: wasmUri
@@ -99,6 +132,8 @@ export interface OpenRequest {
   a: unknown /* JSAny */ | null;
   // Dart name: preparedStatementCacheSize
   c: number /* int */;
+  // Dart name: flushDelayMs
+  l: number /* int */ | null;
   // Dart name: requestId
   i: number /* int */;
   // Dart name: type
@@ -144,6 +179,14 @@ export interface FileSystemFlushRequest {
   // Dart name: type
   t: "fileSystemFlush";
 }
+export interface FileSystemStatisticsRequest {
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: databaseId
+  d: number /* int */ | null;
+  // Dart name: type
+  t: "fileSystemStatistics";
+}
 export interface FileSystemAccess {
   // Dart name: buffer
   b: ArrayBuffer | null;
@@ -169,6 +212,12 @@ export interface RunQuery {
   r: boolean;
   // Dart name: checkInTransaction
   c: boolean;
+  // Dart name: columnarResults
+  b: boolean | null;
+  // Dart name: statementId
+  k: number /* int */ | null;
+  // Dart name: reportReadTables
+  n: boolean | null;
   // Dart name: requestId
   i: number /* int */;
   // Dart name: databaseId
@@ -210,6 +259,110 @@ export interface OpenAdditionalConnection {
   // Dart name: type
   t: "openAdditionalConnection";
 }
+export interface OpenCursor {
+  // Dart name: sql
+  s: string;
+  // Dart name: parameters
+  p: unknown[];
+  // Dart name: typeVector
+  v: ArrayBuffer;
+  // Dart name: lockId
+  z: number /* int */;
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: databaseId
+  d: number /* int */ | null;
+  // Dart name: type
+  t: "openCursor";
+}
+export interface FetchCursor {
+  // Dart name: cursorId
+  k: number /* int */;
+  // Dart name: rowCount
+  n: number /* int */;
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: databaseId
+  d: number /* int */ | null;
+  // Dart name: type
+  t: "fetchCursor";
+}
+export interface CloseCursor {
+  // Dart name: cursorId
+  k: number /* int */;
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: databaseId
+  d: number /* int */ | null;
+  // Dart name: type
+  t: "closeCursor";
+}
+export interface BatchRequest {
+  // Dart name: statements
+  s: string[];
+  // Dart name: parameters
+  p: unknown[][];
+  // Dart name: typeVector
+  v: ArrayBuffer;
+  // Dart name: lockId
+  z: number /* int */ | null;
+  // Dart name: transaction
+  a: boolean;
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: databaseId
+  d: number /* int */ | null;
+  // Dart name: type
+  t: "batch";
+}
+export interface PrepareStatement {
+  // Dart name: sql
+  s: string;
+  // Dart name: lockId
+  z: number /* int */ | null;
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: databaseId
+  d: number /* int */ | null;
+  // Dart name: type
+  t: "prepare";
+}
+export interface FinalizeStatement {
+  // Dart name: statementId
+  k: number /* int */;
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: databaseId
+  d: number /* int */ | null;
+  // Dart name: type
+  t: "finalize";
+}
+export interface WatchQuery {
+  // Dart name: sql
+  s: string;
+  // Dart name: parameters
+  p: unknown[];
+  // Dart name: typeVector
+  v: ArrayBuffer;
+  // Dart name: watchId
+  k: number /* int */;
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: databaseId
+  d: number /* int */ | null;
+  // Dart name: type
+  t: "watch";
+}
+export interface UnwatchQuery {
+  // Dart name: watchId
+  k: number /* int */;
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: databaseId
+  d: number /* int */ | null;
+  // Dart name: type
+  t: "unwatch";
+}
 export interface SimpleSuccessResponse {
   // Dart name: response
   r: unknown /* JSAny */ | null;
@@ -235,6 +388,10 @@ export interface RowsResponse {
   v: ArrayBuffer | null;
   // Dart name: rows
   r: unknown[][] | null;
+  // Dart name: columnData
+  b: ArrayBuffer | null;
+  // Dart name: readTables
+  a: string[] | null;
   // Dart name: autoCommit
   x: boolean;
   // Dart name: lastInsertRowId
@@ -244,6 +401,14 @@ export interface RowsResponse {
   // Dart name: type
   t: "rowsResponse";
 }
+export interface BatchResponse {
+  // Dart name: results
+  r: RowsResponse[];
+  // Dart name: requestId
+  i: number /* int */;
+  // Dart name: type
+  t: "batchResponse";
+}
 export interface ErrorResponse {
   // Dart name: message
   e: string;
@@ -342,6 +507,22 @@ export interface RollbackNotification {
   // Dart name: type
   t: "notifyRollback";
 }
+export interface QueryDiffNotification {
+  // Dart name: watchId
+  k: number /* int */;
+  // Dart name: diffStart
+  o: number /* int */;
+  // Dart name: removedRows
+  n: number /* int */;
+  // Dart name: columnNames
+  c: string[];
+  // Dart name: columnData
+  b: ArrayBuffer;
+  // Dart name: databaseId
+  d: number /* int */;
+  // Dart name: type
+  t: "notifyQueryDiff";
+}
 export interface AbortRequest {
   // Dart name: requestId
   i: number /* int */;
@@ -364,6 +545,18 @@ export function extractTransferrable(message: Message): Transferable[] {
       result.push((message as RunQuery).v);
       break;
     }
+    case typeOpenCursor: {
+      result.push((message as OpenCursor).v);
+      break;
+    }
+    case typeBatchRequest: {
+      result.push((message as BatchRequest).v);
+      break;
+    }
+    case typeWatchQuery: {
+      result.push((message as WatchQuery).v);
+      break;
+    }
     case typeSimpleSuccessResponse: {
       const responseTmp = (message as SimpleSuccessResponse).r;
       if (responseTmp instanceof ArrayBuffer) result.push(responseTmp);
@@ -376,6 +569,12 @@ export function extractTransferrable(message: Message): Transferable[] {
     case typeRowsResponse: {
       const typeVectorTmp = (message as RowsResponse).v;
       if (typeVectorTmp != null) result.push(typeVectorTmp);
+      const columnDataTmp = (message as RowsResponse).b;
+      if (columnDataTmp != null) result.push(columnDataTmp);
+      break;
+    }
+    case typeQueryDiffNotification: {
+      result.push((message as QueryDiffNotification).b);
       break;
     }
   }
@@ -396,10 +595,12 @@ export function dispatchMessage<T>(
     case typeUpdateNotification:
     case typeCommitNotification:
     case typeRollbackNotification:
+    case typeQueryDiffNotification:
       return cb._internal_whenNotification(msg as Notification);
     case typeSimpleSuccessResponse:
     case typeEndpointResponse:
     case typeRowsResponse:
+    case typeBatchResponse:
     case typeErrorResponse:
       return cb._internal_whenResponse(msg as Response);
     default:
@@ -2,10 +2,13 @@ import 'dart:async';
 import 'dart:js_interop';
 import 'dart:math';
 
+// ignore: implementation_imports
+import 'package:sqlite3/src/wasm/js_interop/atomics.dart';
 import 'package:web/web.dart' hide Request, Response, Notification;
 
 import 'locks.dart';
 import 'protocol.dart';
+import 'shared_memory_channel.dart';
 import 'types.dart';
 
 const _disconnectMessage = '_disconnect';
@@ -17,13 +20,20 @@ extension type WebEndpoint._(JSObject _) implements JSObject {
   external MessagePort get port;
   external String? get lockName;
 
+  /// If set, the buffer for a [SharedMemoryChannel] set up by the other end.
+  external SharedArrayBuffer? get sharedMemory;
+
   external factory WebEndpoint({
     required MessagePort port,
     required String? lockName,
+    SharedArrayBuffer? sharedMemory,
   });
 
   ConnectableChannel connect() {
-    return ConnectableChannel._(port, lockName, null);
+    return ConnectableChannel._(port, lockName, null, switch (sharedMemory) {
+      null => null,
+      final buffer => SharedMemoryChannel(port, buffer, isOwner: false),
+    });
   }
 }
 
@@ -31,12 +41,27 @@ final class ConnectableChannel {
   final MessagePort localPort;
   final String? lockName;
   final HeldLock? lock;
+  final SharedMemoryChannel? sharedMemory;
   EventTarget? injectErrors;
 
-  ConnectableChannel._(this.localPort, this.lockName, this.lock);
+  ConnectableChannel._(
+    this.localPort,
+    this.lockName,
+    this.lock, [
+    this.sharedMemory,
+  ]);
 }
 
-Future<(WebEndpoint, ConnectableChannel)> createChannel() async {
+/// Creates a message channel and returns an endpoint to send to the other
+/// side along with the local end.
+///
+/// When [useSharedMemory] is set and the current context is cross-origin
+/// isolated, the channel also sets up a [SharedMemoryChannel]. Since shared
+/// memory can't be sent to shared workers, this must only be enabled for
+/// endpoints sent to dedicated workers.
+Future<(WebEndpoint, ConnectableChannel)> createChannel({
+  bool useSharedMemory = false,
+}) async {
   final webChannel = MessageChannel();
   final locks = WebLocks.instance;
 
@@ -55,8 +80,28 @@ Future<(WebEndpoint, ConnectableChannel)> createChannel() async {
     lock = await locks.request(lockName);
   }
 
-  final channel = ConnectableChannel._(webChannel.port2, lockName, lock);
-  return (WebEndpoint(port: webChannel.port1, lockName: lockName), channel);
+  final sharedBuffer = useSharedMemory ? SharedMemoryChannel.allocate() : null;
+  final channel = ConnectableChannel._(
+    webChannel.port2,
+    lockName,
+    lock,
+    switch (sharedBuffer) {
+      null => null,
+      final buffer => SharedMemoryChannel(
+        webChannel.port2,
+        buffer,
+        isOwner: true,
+      ),
+    },
+  );
+  return (
+    WebEndpoint(
+      port: webChannel.port1,
+      lockName: lockName,
+      sharedMemory: sharedBuffer,
+    ),
+    channel,
+  );
 }
 
 String _randomLockName() {
@@ -71,6 +116,7 @@ String _randomLockName() {
 
 abstract base class ProtocolChannel extends RequestHandler {
   final MessagePort _port;
+  final SharedMemoryChannel? _sharedMemory;
   final Completer<void> _closed = Completer();
   StreamSubscription<void>? _incomingMessagesSubscription;
   StreamSubscription<void>? _errorSubscription;
@@ -83,8 +129,10 @@ abstract base class ProtocolChannel extends RequestHandler {
   final Map<int, AbortController> _handlingRequests = {};
 
   ProtocolChannel(ConnectableChannel connectable)
-    : _port = connectable.localPort {
+    : _port = connectable.localPort,
+      _sharedMemory = connectable.sharedMemory {
     _port.start();
+    _sharedMemory?.start(_handleIncoming, onClose: _markClosed);
 
     _incomingMessagesSubscription = EventStreamProviders.messageEvent
         .forTarget(_port)
@@ -95,7 +143,11 @@ abstract base class ProtocolChannel extends RequestHandler {
             return;
           }
 
-          _handleIncoming(event.data as Message);
+          if (_sharedMemory case final sharedMemory?) {
+            sharedMemory.handlePortMessage(data as JSObject);
+          } else {
+            _handleIncoming(data as Message);
+          }
         });
 
     if (connectable.injectErrors case final injectErrors?) {
@@ -120,7 +172,11 @@ abstract base class ProtocolChannel extends RequestHandler {
   Future<void> get closed => _closed.future;
 
   void _send(Message message) {
-    message.sendToPort(_port);
+    if (_sharedMemory case final sharedMemory?) {
+      sharedMemory.send(message);
+    } else {
+      message.sendToPort(_port);
+    }
   }
 
   /// Handle an incoming message from the client.
@@ -217,7 +273,15 @@ abstract base class ProtocolChannel extends RequestHandler {
   void _markClosed([Object? error]) {
     if (_closed.isCompleted) return;
 
-    _port.postMessage(_disconnectMessage.toJS);
+    if (_sharedMemory case final sharedMemory?) {
+      // Sent in order with other messages, so that the other end doesn't
+      // close the channel before it has received all of them.
+      sharedMemory
+        ..sendClose()
+        ..close();
+    } else {
+      _port.postMessage(_disconnectMessage.toJS);
+    }
     _incomingMessagesSubscription?.cancel();
     _errorSubscription?.cancel();
 
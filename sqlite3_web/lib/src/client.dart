@@ -11,6 +11,7 @@ import 'types.dart';
 import 'channel.dart';
 import 'database.dart';
 import 'protocol.dart';
+import 'query_cache.dart';
 import 'shared.dart';
 import 'worker_connector.dart';
 
@@ -30,7 +31,16 @@ final class RemoteDatabase implements Database {
   final _CommitOrRollbackStream _commits = _CommitOrRollbackStream();
   final _CommitOrRollbackStream _rollbacks = _CommitOrRollbackStream();
 
-  RemoteDatabase({required this.connection, required this.databaseId}) {
+  int _nextWatchId = 1;
+
+  final QueryCache? _queryCache;
+  StreamSubscription<SqliteUpdate>? _queryCacheInvalidation;
+
+  RemoteDatabase({
+    required this.connection,
+    required this.databaseId,
+    QueryCacheOptions? queryCache,
+  }) : _queryCache = queryCache != null ? QueryCache(queryCache) : null {
     connection.closed.then((_) {
       if (!isClosed) {
         _isClosed.complete();
@@ -95,6 +105,12 @@ final class RemoteDatabase implements Database {
       ),
       MessageType.notifyRollback.name,
     );
+
+    if (_queryCache case final cache?) {
+      _queryCacheInvalidation = _updates.stream.listen(
+        (update) => cache.tableUpdated(update.tableName),
+      );
+    }
   }
 
   void _setupCommitOrRollbackStream(
@@ -137,9 +153,13 @@ final class RemoteDatabase implements Database {
   @override
   Future<void> get closed => _isClosed.future;
 
+  @override
+  QueryCacheStatistics? get queryCacheStatistics => _queryCache?.statistics;
+
   @override
   Future<void> dispose() {
     if (!isClosed) {
+      _queryCacheInvalidation?.cancel();
       _isClosed.complete(
         (
           _updates.close(),
@@ -175,6 +195,44 @@ final class RemoteDatabase implements Database {
     return response.response;
   }
 
+  Future<RowsResponse> _runQuery({
+    required String sql,
+    int? statementId,
+    required List<Object?> parameters,
+    required bool returnRows,
+    required bool checkInTransaction,
+    required LockToken? token,
+    required Future<void>? abortTrigger,
+    bool reportReadTables = false,
+  }) async {
+    final (serializedParameters, typeVector) = TypeCode.encodeValues(
+      parameters,
+    );
+
+    final response = await _invalidateOnError(
+      connection.sendRequest(
+        newRunQuery(
+          requestId: 0,
+          databaseId: databaseId,
+          lockId: token == null ? null : lockTokenToId(token),
+          sql: sql,
+          statementId: statementId,
+          parameters: serializedParameters,
+          typeVector: typeVector,
+          returnRows: returnRows,
+          checkInTransaction: checkInTransaction,
+          columnarResults: returnRows ? true : null,
+          reportReadTables: reportReadTables ? true : null,
+          reportWrittenTables: _queryCache != null ? true : null,
+        ),
+        MessageType.rowsResponse,
+        abortTrigger: abortTrigger,
+      ),
+    );
+    _tablesWritten(response.writtenTables);
+    return response;
+  }
+
   @override
   Future<DatabaseResult<void>> execute(
     String sql, {
@@ -183,21 +241,12 @@ final class RemoteDatabase implements Database {
     LockToken? token,
     Future<void>? abortTrigger,
   }) async {
-    final (serializedParameters, typeVector) = TypeCode.encodeValues(
-      parameters,
-    );
-    final response = await connection.sendRequest(
-      newRunQuery(
-        requestId: 0,
-        databaseId: databaseId,
-        lockId: token == null ? null : lockTokenToId(token),
-        sql: sql,
-        parameters: serializedParameters,
-        typeVector: typeVector,
-        returnRows: false,
-        checkInTransaction: checkInTransaction,
-      ),
-      MessageType.rowsResponse,
+    final response = await _runQuery(
+      sql: sql,
+      parameters: parameters,
+      returnRows: false,
+      checkInTransaction: checkInTransaction,
+      token: token,
       abortTrigger: abortTrigger,
     );
 
@@ -208,25 +257,66 @@ final class RemoteDatabase implements Database {
     );
   }
 
-  @override
-  Future<T> requestLock<T>(
-    Future<T> Function(LockToken token) body, {
-    Future<void>? abortTrigger,
-  }) async {
+  /// Evicts all cached results if [request] fails.
+  ///
+  /// Failing requests don't report the tables they've written to, but they
+  /// may have changed the database before failing (e.g. for batches that
+  /// don't run in a transaction).
+  Future<T> _invalidateOnError<T>(Future<T> request) async {
+    try {
+      return await request;
+    } catch (_) {
+      _queryCache?.invalidateAll();
+      rethrow;
+    }
+  }
+
+  /// Evicts cached results reading from [tables], the tables a request has
+  /// written to.
+  ///
+  /// Tables are invalidated again when updates arrive, but those are reported
+  /// asynchronously and would otherwise allow reads after a write to return
+  /// stale results. If the worker couldn't tell which tables have been
+  /// written, all results are evicted.
+  void _tablesWritten(JSArray<JSString>? tables) {
+    if (_queryCache case final cache?) {
+      if (tables == null) {
+        cache.invalidateAll();
+      } else {
+        for (final table in tables.toDart) {
+          cache.tableUpdated(table.toDart);
+        }
+      }
+    }
+  }
+
+  Future<int> _obtainLock(Future<void>? abortTrigger) async {
     final response = await connection.sendRequest(
       newRequestExclusiveLock(requestId: 0, databaseId: databaseId),
       MessageType.simpleSuccessResponse,
       abortTrigger: abortTrigger,
     );
-    final lockId = (response.response as JSNumber).toDartInt;
+    return (response.response as JSNumber).toDartInt;
+  }
+
+  Future<void> _releaseLock(int lockId) async {
+    await connection.sendRequest(
+      newReleaseLock(requestId: 0, databaseId: databaseId, lockId: lockId),
+      MessageType.simpleSuccessResponse,
+    );
+  }
+
+  @override
+  Future<T> requestLock<T>(
+    Future<T> Function(LockToken token) body, {
+    Future<void>? abortTrigger,
+  }) async {
+    final lockId = await _obtainLock(abortTrigger);
 
     try {
       return await body(lockTokenFromId(lockId));
     } finally {
-      await connection.sendRequest(
-        newReleaseLock(requestId: 0, databaseId: databaseId, lockId: lockId),
-        MessageType.simpleSuccessResponse,
-      );
+      await _releaseLock(lockId);
     }
   }
 
@@ -241,30 +331,283 @@ final class RemoteDatabase implements Database {
     LockToken? token,
     Future<void>? abortTrigger,
   }) async {
-    final (serializedParameters, typeVector) = TypeCode.encodeValues(
-      parameters,
+    if (_queryCache case final cache?
+        when token == null && !checkInTransaction) {
+      return cache.select(sql, parameters, () async {
+        final response = await _runQuery(
+          sql: sql,
+          parameters: parameters,
+          returnRows: true,
+          checkInTransaction: false,
+          token: null,
+          abortTrigger: abortTrigger,
+          reportReadTables: true,
+        );
+
+        return (
+          _readSelectResult(response),
+          response.readTables?.toDart.map((table) => table.toDart).toList(),
+        );
+      });
+    }
+
+    final response = await _runQuery(
+      sql: sql,
+      parameters: parameters,
+      returnRows: true,
+      checkInTransaction: checkInTransaction,
+      token: token,
+      abortTrigger: abortTrigger,
     );
+    return _readSelectResult(response);
+  }
 
+  DatabaseResult<ResultSet> _readSelectResult(RowsResponse response) {
+    return (
+      autocommit: response.autoCommit,
+      lastInsertRowid: response.lastInsertRowId,
+      result: response.readResultSet()!,
+    );
+  }
+
+  @override
+  Future<PreparedStatementHandle> prepare(
+    String sql, {
+    LockToken? token,
+    Future<void>? abortTrigger,
+  }) async {
     final response = await connection.sendRequest(
-      newRunQuery(
+      newPrepareStatement(
         requestId: 0,
         databaseId: databaseId,
+        sql: sql,
         lockId: token == null ? null : lockTokenToId(token),
+      ),
+      MessageType.simpleSuccessResponse,
+      abortTrigger: abortTrigger,
+    );
+
+    return _RemotePreparedStatement(
+      this,
+      sql,
+      (response.response as JSNumber).toDartInt,
+    );
+  }
+
+  @override
+  Future<List<DatabaseResult<ResultSet>>> executeBatch(
+    List<(String, List<Object?>)> statements, {
+    bool transaction = false,
+    LockToken? token,
+    Future<void>? abortTrigger,
+  }) async {
+    final sql = JSArray<JSString>.withLength(statements.length);
+    final parameters = JSArray<JSArray>.withLength(statements.length);
+    final typeVectors = <Uint8List>[];
+    var typeVectorLength = 0;
+
+    for (final (i, (statementSql, statementParameters)) in statements.indexed) {
+      final (serializedParameters, typeVector) = TypeCode.encodeValues(
+        statementParameters,
+      );
+      final types = typeVector.toDart.asUint8List();
+
+      sql[i] = statementSql.toJS;
+      parameters[i] = serializedParameters;
+      typeVectors.add(types);
+      typeVectorLength += types.length;
+    }
+
+    final typeVector = Uint8List(typeVectorLength);
+    var offset = 0;
+    for (final types in typeVectors) {
+      typeVector.setAll(offset, types);
+      offset += types.length;
+    }
+
+    final response = await _invalidateOnError(
+      connection.sendRequest(
+        newBatchRequest(
+          requestId: 0,
+          databaseId: databaseId,
+          lockId: token == null ? null : lockTokenToId(token),
+          statements: sql,
+          parameters: parameters,
+          typeVector: typeVector.buffer.toJS,
+          transaction: transaction,
+          reportWrittenTables: _queryCache != null ? true : null,
+        ),
+        MessageType.batchResponse,
+        abortTrigger: abortTrigger,
+      ),
+    );
+    _tablesWritten(response.writtenTables);
+
+    return [
+      for (final result in response.results.toDart)
+        (
+          autocommit: result.autoCommit,
+          lastInsertRowid: result.lastInsertRowId,
+          result: result.readResultSet()!,
+        ),
+    ];
+  }
+
+  @override
+  Stream<Row> selectCursor(
+    String sql, {
+    List<Object?> parameters = const [],
+    int chunkSize = 256,
+    LockToken? token,
+  }) async* {
+    RangeError.checkValueInInterval(chunkSize, 1, null, 'chunkSize');
+
+    if (token != null) {
+      yield* _streamCursor(lockTokenToId(token), sql, parameters, chunkSize);
+    } else {
+      final lockId = await _obtainLock(null);
+      try {
+        yield* _streamCursor(lockId, sql, parameters, chunkSize);
+      } finally {
+        if (!isClosed) {
+          await _releaseLock(lockId);
+        }
+      }
+    }
+  }
+
+  Stream<Row> _streamCursor(
+    int lockId,
+    String sql,
+    List<Object?> parameters,
+    int chunkSize,
+  ) async* {
+    final (serializedParameters, typeVector) = TypeCode.encodeValues(
+      parameters,
+    );
+    final opened = await connection.sendRequest(
+      newOpenCursor(
+        requestId: 0,
+        databaseId: databaseId,
+        lockId: lockId,
         sql: sql,
         parameters: serializedParameters,
         typeVector: typeVector,
-        returnRows: true,
-        checkInTransaction: checkInTransaction,
       ),
-      MessageType.rowsResponse,
-      abortTrigger: abortTrigger,
+      MessageType.simpleSuccessResponse,
     );
+    final cursorId = (opened.response as JSNumber).toDartInt;
 
-    return (
-      autocommit: response.autoCommit,
-      lastInsertRowid: response.lastInsertRowId,
-      result: response.readResultSet()!,
+    // The worker closes cursors once they're exhausted, so we only need to
+    // close it explicitly if the subscription is cancelled early.
+    var exhausted = false;
+    try {
+      while (!exhausted) {
+        final response = await connection.sendRequest(
+          newFetchCursor(
+            requestId: 0,
+            databaseId: databaseId,
+            cursorId: cursorId,
+            rowCount: chunkSize,
+          ),
+          MessageType.rowsResponse,
+        );
+        final rows = response.readResultSet()!;
+        exhausted = rows.length < chunkSize;
+
+        for (final row in rows) {
+          yield row;
+        }
+      }
+    } finally {
+      if (!exhausted && !isClosed) {
+        await connection.sendRequest(
+          newCloseCursor(
+            requestId: 0,
+            databaseId: databaseId,
+            cursorId: cursorId,
+          ),
+          MessageType.simpleSuccessResponse,
+        );
+      }
+    }
+  }
+
+  @override
+  Stream<ResultSet> watch(
+    String sql, {
+    List<Object?> parameters = const [],
+    LockToken? token,
+  }) {
+    final watchId = _nextWatchId++;
+    final rows = <List<Object?>>[];
+    StreamSubscription<Notification>? diffs;
+    late final StreamController<ResultSet> controller;
+
+    controller = StreamController(
+      onListen: () async {
+        diffs = connection.notifications.stream.listen((notification) {
+          if (notification.type != MessageType.notifyQueryDiff.name ||
+              notification.databaseId != databaseId) {
+            return;
+          }
+
+          final diff = notification as QueryDiffNotification;
+          if (diff.watchId != watchId) {
+            return;
+          }
+
+          rows.replaceRange(
+            diff.diffStart,
+            diff.diffStart + diff.removedRows,
+            ColumnarRows(diff.columnData),
+          );
+          controller.add(
+            ResultSet(
+              [for (final name in diff.columnNames.toDart) name.toDart],
+              null,
+              List.of(rows),
+            ),
+          );
+        });
+
+        final (serializedParameters, typeVector) = TypeCode.encodeValues(
+          parameters,
+        );
+        try {
+          await connection.sendRequest(
+            newWatchQuery(
+              requestId: 0,
+              databaseId: databaseId,
+              sql: sql,
+              parameters: serializedParameters,
+              typeVector: typeVector,
+              watchId: watchId,
+              lockId: token == null ? null : lockTokenToId(token),
+            ),
+            MessageType.simpleSuccessResponse,
+          );
+        } catch (e, s) {
+          controller.addError(e, s);
+          await controller.close();
+        }
+      },
+      onCancel: () async {
+        await diffs?.cancel();
+        if (!isClosed) {
+          await connection.sendRequest(
+            newUnwatchQuery(
+              requestId: 0,
+              databaseId: databaseId,
+              watchId: watchId,
+            ),
+            MessageType.simpleSuccessResponse,
+          );
+        }
+      },
     );
+
+    return controller.stream;
   }
 
   @override
@@ -287,6 +630,90 @@ final class RemoteDatabase implements Database {
   }
 }
 
+final class _RemotePreparedStatement implements PreparedStatementHandle {
+  final RemoteDatabase _database;
+  final int _id;
+  var _isDisposed = false;
+
+  @override
+  final String sql;
+
+  _RemotePreparedStatement(this._database, this.sql, this._id);
+
+  void _checkNotDisposed() {
+    if (_isDisposed) {
+      throw StateError('This prepared statement has already been disposed.');
+    }
+  }
+
+  @override
+  Future<DatabaseResult<void>> execute({
+    List<Object?> parameters = const [],
+    bool checkInTransaction = false,
+    LockToken? token,
+    Future<void>? abortTrigger,
+  }) async {
+    _checkNotDisposed();
+    final response = await _database._runQuery(
+      sql: '',
+      statementId: _id,
+      parameters: parameters,
+      returnRows: false,
+      checkInTransaction: checkInTransaction,
+      token: token,
+      abortTrigger: abortTrigger,
+    );
+
+    return (
+      autocommit: response.autoCommit,
+      lastInsertRowid: response.lastInsertRowId,
+      result: null,
+    );
+  }
+
+  @override
+  Future<DatabaseResult<ResultSet>> select({
+    List<Object?> parameters = const [],
+    bool checkInTransaction = false,
+    LockToken? token,
+    Future<void>? abortTrigger,
+  }) async {
+    _checkNotDisposed();
+    final response = await _database._runQuery(
+      sql: '',
+      statementId: _id,
+      parameters: parameters,
+      returnRows: true,
+      checkInTransaction: checkInTransaction,
+      token: token,
+      abortTrigger: abortTrigger,
+    );
+
+    return (
+      autocommit: response.autoCommit,
+      lastInsertRowid: response.lastInsertRowId,
+      result: response.readResultSet()!,
+    );
+  }
+
+  @override
+  Future<void> dispose() async {
+    if (_isDisposed) return;
+    _isDisposed = true;
+
+    if (!_database.isClosed) {
+      await _database.connection.sendRequest(
+        newFinalizeStatement(
+          requestId: 0,
+          databaseId: _database.databaseId,
+          statementId: _id,
+        ),
+        MessageType.simpleSuccessResponse,
+      );
+    }
+  }
+}
+
 final class RemoteFileSystem implements FileSystem {
   final RemoteDatabase database;
 
@@ -314,6 +741,29 @@ final class RemoteFileSystem implements FileSystem {
     );
   }
 
+  @override
+  Future<FlushStatistics?> flushStatistics() async {
+    final response = await database.connection.sendRequest(
+      newFileSystemStatisticsRequest(
+        databaseId: database.databaseId,
+        requestId: 0,
+      ),
+      MessageType.simpleSuccessResponse,
+    );
+
+    final raw = response.response;
+    if (raw == null) {
+      return null;
+    }
+
+    final [syncs, flushes, flushTime] = (raw as JSArray<JSNumber>).toDart;
+    return FlushStatistics(
+      syncs: syncs.toDartInt,
+      flushes: flushes.toDartInt,
+      flushTime: Duration(microseconds: flushTime.toDartInt),
+    );
+  }
+
   @override
   Future<Uint8List> readFile(FileType type) async {
     final response = await database.connection.sendRequest(
@@ -380,6 +830,8 @@ final class WorkerConnection extends ProtocolChannel {
     required bool onlyOpenVfs,
     required int statementCacheSize,
     required JSAny? additionalOptions,
+    QueryCacheOptions? queryCache,
+    DurabilityPolicy durability = DurabilityPolicy.full,
   }) async {
     final response = await sendRequest(
       newOpenRequest(
@@ -390,6 +842,7 @@ final class WorkerConnection extends ProtocolChannel {
         onlyOpenVfs: onlyOpenVfs,
         additionalData: additionalOptions,
         preparedStatementCacheSize: statementCacheSize,
+        flushDelayMs: durability.flushDelay?.inMilliseconds,
       ),
       MessageType.simpleSuccessResponse,
     );
@@ -397,6 +850,7 @@ final class WorkerConnection extends ProtocolChannel {
     return RemoteDatabase(
       connection: this,
       databaseId: (response.response as JSNumber).toDartInt,
+      queryCache: queryCache,
     );
   }
 }
@@ -406,6 +860,7 @@ final class DatabaseClient implements WebSqlite {
   final String wasmUri;
   final DatabaseController _localController;
   final Future<JSAny?> Function(JSAny?) _handleCustomRequest;
+  final bool _useSharedMemory;
 
   final Mutex _startWorkers = Mutex();
   bool _startedWorkers = false;
@@ -421,12 +876,14 @@ final class DatabaseClient implements WebSqlite {
     this.workers,
     this.wasmUri,
     this._localController,
-    Future<JSAny?> Function(JSAny?)? handleCustomRequest,
-  ) : _handleCustomRequest =
-          handleCustomRequest ??
-          ((_) async {
-            throw StateError('No custom request handler installed');
-          });
+    Future<JSAny?> Function(JSAny?)? handleCustomRequest, {
+    bool useSharedMemory = false,
+  }) : _useSharedMemory = useSharedMemory,
+       _handleCustomRequest =
+           handleCustomRequest ??
+           ((_) async {
+             throw StateError('No custom request handler installed');
+           });
 
   Future<void> startWorkers() {
     return _startWorkers.withCriticalSection(() async {
@@ -457,7 +914,9 @@ final class DatabaseClient implements WebSqlite {
       return;
     }
 
-    final (endpoint, channel) = await createChannel();
+    final (endpoint, channel) = await createChannel(
+      useSharedMemory: _useSharedMemory,
+    );
     channel.injectErrors = dedicated.targetForErrorEvents;
     newConnectRequest(
       endpoint: endpoint,
@@ -689,6 +1148,8 @@ final class DatabaseClient implements WebSqlite {
     bool onlyOpenVfs = false,
     JSAny? additionalOptions,
     int preparedStatementCacheSize = 0,
+    QueryCacheOptions? queryCache,
+    DurabilityPolicy durability = DurabilityPolicy.full,
   }) async {
     await startWorkers();
 
@@ -715,6 +1176,8 @@ final class DatabaseClient implements WebSqlite {
       onlyOpenVfs: onlyOpenVfs,
       additionalOptions: additionalOptions,
       statementCacheSize: preparedStatementCacheSize,
+      queryCache: queryCache,
+      durability: durability,
     );
   }
 
@@ -724,6 +1187,8 @@ final class DatabaseClient implements WebSqlite {
     bool onlyOpenVfs = false,
     JSAny? additionalOptions,
     int preparedStatementCacheSize = 0,
+    QueryCacheOptions? queryCache,
+    DurabilityPolicy durability = DurabilityPolicy.full,
   }) async {
     final probed = await runFeatureDetection(databaseName: name);
 
@@ -754,6 +1219,8 @@ final class DatabaseClient implements WebSqlite {
       onlyOpenVfs: onlyOpenVfs,
       additionalOptions: additionalOptions,
       preparedStatementCacheSize: preparedStatementCacheSize,
+      queryCache: queryCache,
+      durability: durability,
     );
 
     return ConnectToRecommendedResult(
@@ -120,6 +120,10 @@ abstract class Database {
   /// {@macro sqlite3_web_streams}
   Stream<void> get commits;
 
+  /// Statistics on the client-side query cache, or `null` if the database
+  /// has been opened without a [QueryCacheOptions].
+  QueryCacheStatistics? get queryCacheStatistics;
+
   /// A future that resolves when the database is closed.
   ///
   /// Typically, databases are closed because [dispose] is called. For databases
@@ -173,6 +177,79 @@ abstract class Database {
     Future<void>? abortTrigger,
   });
 
+  /// Prepares [sql] on the worker and returns a handle to run it repeatedly.
+  ///
+  /// Running a prepared statement only sends its parameters to the worker, and
+  /// doesn't require the worker to parse [sql] again. Prepared statements
+  /// should be [PreparedStatementHandle.dispose]d when they're no longer used.
+  /// They are disposed automatically when this database is closed.
+  ///
+  /// When called in a [requestLock] block, the [token] must be passed.
+  Future<PreparedStatementHandle> prepare(
+    String sql, {
+    LockToken? token,
+    Future<void>? abortTrigger,
+  });
+
+  /// Runs all [statements] (pairs of SQL and parameters) in a single request.
+  ///
+  /// Each statement must consist of exactly one SQL statement. The returned
+  /// future completes with a result for each statement, in the same order.
+  /// Statements not returning rows report an empty [ResultSet].
+  ///
+  /// All statements run under a single lock on the database, so that no
+  /// statements from other clients run in between. If [transaction] is
+  /// enabled, statements run in a savepoint that is rolled back if any
+  /// statement fails. Otherwise, the effects of statements before the failing
+  /// one are kept.
+  ///
+  /// The [abortTrigger] can be used to abort the request. When it completes
+  /// while the batch is running, remaining statements are skipped.
+  Future<List<DatabaseResult<ResultSet>>> executeBatch(
+    List<(String, List<Object?>)> statements, {
+    bool transaction = false,
+    LockToken? token,
+    Future<void>? abortTrigger,
+  });
+
+  /// Prepares [sql], binds [parameters] and streams rows of the statement.
+  ///
+  /// Unlike [select], rows are not collected into a single [ResultSet].
+  /// Instead, the statement is kept open as a cursor on the worker, from which
+  /// rows are fetched in chunks of [chunkSize] rows. The next chunk is only
+  /// requested once all rows of the previous chunk have been delivered to a
+  /// listener (that is not paused).
+  ///
+  /// Since the statement has to stay valid across multiple requests, a cursor
+  /// keeps the database locked while it's active. When a [token] is given, the
+  /// cursor uses that lock and must complete before the lock is released.
+  /// Otherwise, the stream requests a lock when it's listened to and releases
+  /// it after the last row has been emitted or the subscription was
+  /// cancelled.
+  Stream<Row> selectCursor(
+    String sql, {
+    List<Object?> parameters = const [],
+    int chunkSize = 256,
+    LockToken? token,
+  });
+
+  /// Returns a stream emitting the rows of [sql] whenever they change.
+  ///
+  /// The query is evaluated on the worker, which re-runs it after writes to
+  /// one of the tables it reads from and only sends rows that have changed.
+  /// When multiple clients of a shared worker watch the same query (with the
+  /// same [parameters]), it's only evaluated once for all of them.
+  ///
+  /// The stream emits the initial result once the worker has evaluated the
+  /// query. Changes made in a transaction are reported after it completes.
+  /// When listening to the stream in a [requestLock] block, the [token] must
+  /// be passed.
+  Stream<ResultSet> watch(
+    String sql, {
+    List<Object?> parameters = const [],
+    LockToken? token,
+  });
+
   /// Runs [body] with an exclusive lock on the database.
   ///
   /// This can be used to implement transactions on the database, where multiple
@@ -220,6 +297,104 @@ int lockTokenToId(LockToken token) {
   return token._id;
 }
 
+/// Options for caching results of [Database.select] in the client.
+///
+/// Cached results are keyed by the SQL text and parameters of a query. Along
+/// with each result, the worker reports the tables read by the query. The
+/// entry is invalidated once a statement executed through this client or
+/// [Database.updates] reports a write to one of these tables.
+///
+/// Only read-only queries running outside of [Database.requestLock] blocks
+/// and outside of transactions are cached. Queries reading from virtual
+/// tables or attached databases and queries calling non-deterministic
+/// functions are not cached either. Since update notifications are only sent
+/// by the worker hosting the database, the cache should not be used with
+/// implementations where other tabs write to the same database through their
+/// own workers.
+final class QueryCacheOptions {
+  /// The maximum amount of results to keep. When more results are cached,
+  /// the least recently used entry is evicted.
+  final int maxEntries;
+
+  /// When set, results older than [maxAge] are evicted even if none of the
+  /// tables they depend on have been updated.
+  final Duration? maxAge;
+
+  const QueryCacheOptions({this.maxEntries = 64, this.maxAge});
+}
+
+/// Counters describing the effectiveness of a query cache, available through
+/// [Database.queryCacheStatistics].
+final class QueryCacheStatistics {
+  /// The amount of queries answered from the cache.
+  final int hits;
+
+  /// The amount of queries that had to be sent to the worker.
+  final int misses;
+
+  /// The amount of entries removed due to writes to the database.
+  final int invalidations;
+
+  /// The amount of entries removed due to [QueryCacheOptions.maxEntries] or
+  /// [QueryCacheOptions.maxAge].
+  final int evictions;
+
+  /// The amount of results currently cached.
+  final int entries;
+
+  const QueryCacheStatistics({
+    required this.hits,
+    required this.misses,
+    required this.invalidations,
+    required this.evictions,
+    required this.entries,
+  });
+
+  /// The share of queries answered from the cache, between `0` and `1`.
+  double get hitRate {
+    final total = hits + misses;
+    return total == 0 ? 0 : hits / total;
+  }
+
+  @override
+  String toString() {
+    return 'QueryCacheStatistics(hits: $hits, misses: $misses, '
+        'invalidations: $invalidations, evictions: $evictions, '
+        'entries: $entries)';
+  }
+}
+
+/// A statement prepared on the worker with [Database.prepare].
+abstract class PreparedStatementHandle {
+  /// The SQL text of this statement.
+  String get sql;
+
+  /// Executes this statement with the given [parameters].
+  ///
+  /// The other parameters have the same meaning as in [Database.execute].
+  Future<DatabaseResult<void>> execute({
+    List<Object?> parameters = const [],
+    bool checkInTransaction = false,
+    LockToken? token,
+    Future<void>? abortTrigger,
+  });
+
+  /// Executes this statement with the given [parameters] and returns rows.
+  ///
+  /// The other parameters have the same meaning as in [Database.select].
+  Future<DatabaseResult<ResultSet>> select({
+    List<Object?> parameters = const [],
+    bool checkInTransaction = false,
+    LockToken? token,
+    Future<void>? abortTrigger,
+  });
+
+  /// Finalizes this statement on the worker.
+  ///
+  /// No methods may be called after a call to [dispose].
+  Future<void> dispose();
+}
+
 /// A connection from a client from the perspective of a worker.
 abstract class ClientConnection {
   /// The unique id for this connection.
@@ -312,12 +487,20 @@ abstract class WebSqlite {
   ///
   /// [preparedStatementCacheSize] controls the maximum amount of statements a
   /// worker should cache. It defaults to 0, which disables the cache.
+  ///
+  /// When [queryCache] is set, results of [Database.select] are cached in the
+  /// client until a table they read is updated.
+  ///
+  /// For databases stored in OPFS, [durability] controls when the worker
+  /// flushes changes to storage. By default, each transaction is flushed.
   Future<Database> connect(
     String name,
     DatabaseImplementation implementation, {
     bool onlyOpenVfs = false,
     JSAny? additionalOptions,
     int preparedStatementCacheSize = 0,
+    QueryCacheOptions? queryCache,
+    DurabilityPolicy durability = DurabilityPolicy.full,
   });
 
   /// Starts a feature detection via [runFeatureDetection] and then [connect]s
@@ -336,11 +519,19 @@ abstract class WebSqlite {
   ///
   /// [preparedStatementCacheSize] controls the maximum amount of statements a
   /// worker should cache. It defaults to 0, which disables the cache.
+  ///
+  /// When [queryCache] is set, results of [Database.select] are cached in the
+  /// client until a table they read is updated.
+  ///
+  /// For databases stored in OPFS, [durability] controls when the worker
+  /// flushes changes to storage. By default, each transaction is flushed.
   Future<ConnectToRecommendedResult> connectToRecommended(
     String name, {
     bool onlyOpenVfs = false,
     JSAny? additionalOptions,
     int preparedStatementCacheSize = 0,
+    QueryCacheOptions? queryCache,
+    DurabilityPolicy durability = DurabilityPolicy.full,
   });
 
   /// Closes this instance and associated dedicated workers.
@@ -367,17 +558,23 @@ abstract class WebSqlite {
   /// The optional [handleCustomRequest] function is invoked when the controller
   /// sends a custom request to the client (via [ClientConnection.customRequest]).
   /// If it's absent, the default is to throw an exception when called.
+  ///
+  /// When [useSharedMemory] is enabled and the page is cross-origin isolated,
+  /// requests to the dedicated worker are sent through a `SharedArrayBuffer`
+  /// instead of message ports, which reduces the latency of small queries.
   static WebSqlite open({
     required WorkerConnector workers,
     required String wasmModule,
     DatabaseController? controller,
     Future<JSAny?> Function(JSAny?)? handleCustomRequest,
+    bool useSharedMemory = false,
   }) {
     return DatabaseClient(
       workers,
       wasmModule,
       controller ?? const _DefaultDatabaseController(),
       handleCustomRequest,
+      useSharedMemory: useSharedMemory,
     );
   }
 
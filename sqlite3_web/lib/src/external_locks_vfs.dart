@@ -36,9 +36,10 @@ final class ExternalLocksState {
     required String path,
     required String vfsName,
     required bool readWriteUnsafe,
+    DurabilityPolicy durability = DurabilityPolicy.full,
   }) async {
     final directory = await SimpleOpfsFileSystem.resolveDirectory(path);
-    final vfs = SimpleOpfsFileSystem(vfsName: vfsName);
+    final vfs = SimpleOpfsFileSystem(vfsName: vfsName, durability: durability);
     if (readWriteUnsafe) {
       // We can open this already
       // ignore: experimental_member_use
@@ -1,5 +1,6 @@
 import 'dart:js_interop';
 import 'dart:js_interop_unsafe';
+import 'dart:typed_data';
 
 /// A growing [JSArrayBuffer].
 ///
@@ -43,6 +44,21 @@ final class GrowableArrayBuffer {
     return JSDataView(_buffer, oldLength, size);
   }
 
+  /// The amount of bytes written to this buffer so far.
+  int get length => _length;
+
+  /// Appends [bytes] to this buffer.
+  void addBytes(Uint8List bytes) {
+    final offset = _length;
+    _length = offset + bytes.length;
+
+    if (_length > _capacity) {
+      _grow(_length);
+    }
+
+    JSUint8Array(_buffer, offset, bytes.length).set(bytes.toJS);
+  }
+
   JSArrayBuffer take() {
     if (_supportsTransfer) {
       return _buffer.transfer(_length);
@@ -79,11 +95,15 @@ extension on JSArrayBuffer {
 }
 
 @JS()
-extension on JSTypedArray {
+extension TypedArrayMethods on JSTypedArray {
   external void set(JSAny? sourceArray);
 }
 
 @JS()
 extension DataViewMethods on JSDataView {
   external void setUint8(int byteOffset, int value);
+  external void setUint32(int byteOffset, int value, bool littleEndian);
+  external void setFloat64(int byteOffset, double value, bool littleEndian);
+  external void setBigInt64(int byteOffset, JSBigInt value, bool littleEndian);
+  external JSBigInt getBigInt64(int byteOffset, bool littleEndian);
 }
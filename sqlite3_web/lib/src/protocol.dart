@@ -1,3 +1,4 @@
+export 'protocol/columnar.dart';
 export 'protocol/compatibility_result.dart';
 export 'protocol/extensions.dart';
 export 'protocol/helper.g.dart';
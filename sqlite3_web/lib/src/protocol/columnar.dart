@@ -0,0 +1,340 @@
+import 'dart:collection';
+import 'dart:convert';
+import 'dart:js_interop';
+import 'dart:typed_data';
+
+import '../js_array_buffer.dart';
+import 'messages.dart';
+
+/// Writes rows into the columnar format sent in [RowsResponse.columnData].
+///
+/// The encoded buffer starts with two little-endian `uint32` values storing
+/// the amount of rows and columns. That header is followed by a [TypeCode]
+/// byte for each cell, stored column by column and padded to a multiple of
+/// eight bytes. Next, each cell has an eight-byte slot (again stored column by
+/// column): Integers and doubles are stored as a `float64`, big integers as an
+/// `int64`. For texts (as UTF-8) and blobs, the slot stores the offset and
+/// length of the value in the variable-length data section at the end of the
+/// buffer.
+///
+/// Since all of this is a single [JSArrayBuffer], it can be transferred to the
+/// client instead of structurally cloning each value.
+final class ColumnarRowsWriter {
+  final int columnCount;
+
+  var _rowCapacity = 0;
+  var _rowCount = 0;
+
+  JSArrayBuffer _types = JSArrayBuffer(0);
+  JSDataView _typesView = JSDataView(JSArrayBuffer(0));
+  JSArrayBuffer _values = JSArrayBuffer(0);
+  JSDataView _valuesView = JSDataView(JSArrayBuffer(0));
+  final GrowableArrayBuffer _data = GrowableArrayBuffer();
+
+  ColumnarRowsWriter(this.columnCount);
+
+  /// Starts a new row, which must then be filled by calling a `write` method
+  /// for each column.
+  void addRow() {
+    if (_rowCount == _rowCapacity) {
+      _grow(_rowCapacity == 0 ? 16 : _rowCapacity * 2);
+    }
+    _rowCount++;
+  }
+
+  int _cell(int column) => column * _rowCapacity + _rowCount - 1;
+
+  void writeNull(int column) {
+    _typesView.setUint8(_cell(column), TypeCode.$null.index);
+  }
+
+  /// Writes an integer (if [code] is [TypeCode.integer]) or a double (if it's
+  /// [TypeCode.float]).
+  void writeNumber(int column, TypeCode code, double value) {
+    assert(code == TypeCode.integer || code == TypeCode.float);
+    final cell = _cell(column);
+    _typesView.setUint8(cell, code.index);
+    _valuesView.setFloat64(cell * 8, value, true);
+  }
+
+  void writeBigInt(int column, JSBigInt value) {
+    final cell = _cell(column);
+    _typesView.setUint8(cell, TypeCode.bigInt.index);
+    _valuesView.setBigInt64(cell * 8, value, true);
+  }
+
+  /// Writes a text (if [code] is [TypeCode.text], [bytes] must be UTF-8) or a
+  /// blob (if it's [TypeCode.blob]).
+  void writeBytes(int column, TypeCode code, Uint8List bytes) {
+    assert(code == TypeCode.text || code == TypeCode.blob);
+    final cell = _cell(column);
+    _typesView.setUint8(cell, code.index);
+    _valuesView.setUint32(cell * 8, _data.length, true);
+    _valuesView.setUint32(cell * 8 + 4, bytes.length, true);
+    _data.addBytes(bytes);
+  }
+
+  /// Appends a copy of [row] in [source], which must have [columnCount]
+  /// columns.
+  ///
+  /// Unlike writing the decoded values again, this doesn't have to convert
+  /// texts to UTF-8 or allocate JavaScript big integers.
+  void copyRow(ColumnarRows source, int row) {
+    assert(source.columnCount == columnCount);
+    addRow();
+
+    for (var i = 0; i < columnCount; i++) {
+      final index = source._index(row, i);
+      final slot = source._valuesStart + index * 8;
+
+      switch (source._typeAt(index)) {
+        case final code && (TypeCode.text || TypeCode.blob):
+          writeBytes(i, code, source._slotBytes(slot));
+        case TypeCode.$null:
+          writeNull(i);
+        case final code:
+          // Copy the raw slot to avoid canonicalizing NaNs or reading int64
+          // values as doubles.
+          final cell = _cell(i);
+          _typesView.setUint8(cell, code.index);
+          _valuesView.setUint32(
+            cell * 8,
+            source._view.getUint32(slot, Endian.little),
+            true,
+          );
+          _valuesView.setUint32(
+            cell * 8 + 4,
+            source._view.getUint32(slot + 4, Endian.little),
+            true,
+          );
+      }
+    }
+  }
+
+  void _grow(int rowCapacity) {
+    final types = JSArrayBuffer(rowCapacity * columnCount);
+    final values = JSArrayBuffer(rowCapacity * columnCount * 8);
+
+    for (var i = 0; i < columnCount; i++) {
+      JSUint8Array(
+        types,
+        i * rowCapacity,
+        _rowCount,
+      ).set(JSUint8Array(_types, i * _rowCapacity, _rowCount));
+      JSUint8Array(
+        values,
+        i * rowCapacity * 8,
+        _rowCount * 8,
+      ).set(JSUint8Array(_values, i * _rowCapacity * 8, _rowCount * 8));
+    }
+
+    _rowCapacity = rowCapacity;
+    _types = types;
+    _typesView = JSDataView(types);
+    _values = values;
+    _valuesView = JSDataView(values);
+  }
+
+  /// Returns the encoded buffer, after which this writer must no longer be
+  /// used.
+  JSArrayBuffer take() {
+    final rows = _rowCount;
+    final data = _data.take();
+    final (valuesStart, dataStart) = _sectionOffsets(rows, columnCount);
+    final dataLength = _data.length;
+
+    final buffer = JSArrayBuffer(dataStart + dataLength);
+    final header = JSDataView(buffer, 0, _headerSize);
+    header.setUint32(0, rows, true);
+    header.setUint32(4, columnCount, true);
+
+    for (var i = 0; i < columnCount; i++) {
+      JSUint8Array(
+        buffer,
+        _headerSize + i * rows,
+        rows,
+      ).set(JSUint8Array(_types, i * _rowCapacity, rows));
+      JSUint8Array(
+        buffer,
+        valuesStart + i * rows * 8,
+        rows * 8,
+      ).set(JSUint8Array(_values, i * _rowCapacity * 8, rows * 8));
+    }
+    JSUint8Array(buffer, dataStart, dataLength).set(JSUint8Array(data));
+
+    return buffer;
+  }
+}
+
+/// Lazily decodes rows written by a [ColumnarRowsWriter].
+///
+/// Like [DecodedTypedValues], values are only decoded when they're accessed.
+final class ColumnarRows extends ListBase<List<Object?>> {
+  final JSDataView _jsView;
+  final ByteData _view;
+  final Uint8List _bytes;
+  final int _rowCount;
+  final int columnCount;
+  final int _valuesStart;
+  final int _dataStart;
+
+  ColumnarRows._(
+    this._jsView,
+    this._view,
+    this._bytes,
+    this._rowCount,
+    this.columnCount,
+    this._valuesStart,
+    this._dataStart,
+  );
+
+  factory ColumnarRows(JSArrayBuffer buffer) {
+    final dartBuffer = buffer.toDart;
+    final view = dartBuffer.asByteData();
+    final rows = view.getUint32(0, Endian.little);
+    final columns = view.getUint32(4, Endian.little);
+    final (valuesStart, dataStart) = _sectionOffsets(rows, columns);
+
+    return ColumnarRows._(
+      JSDataView(buffer),
+      view,
+      dartBuffer.asUint8List(),
+      rows,
+      columns,
+      valuesStart,
+      dataStart,
+    );
+  }
+
+  int _index(int row, int column) => column * _rowCount + row;
+
+  TypeCode _typeAt(int index) => TypeCode.of(_bytes[_headerSize + index]);
+
+  /// Decodes the value of the cell at [row] and [column].
+  Object? cell(int row, int column) {
+    final index = _index(row, column);
+    final slot = _valuesStart + index * 8;
+
+    return switch (_typeAt(index)) {
+      TypeCode.integer => _view.getFloat64(slot, Endian.little).toInt(),
+      TypeCode.float => _view.getFloat64(slot, Endian.little),
+      TypeCode.bigInt => TypeCode.bigInt.decodeColumn(
+        _jsView.getBigInt64(slot, true),
+      ),
+      TypeCode.text => utf8.decode(_slotBytes(slot)),
+      TypeCode.blob => _slotBytes(slot),
+      TypeCode.$null => null,
+      TypeCode.boolean ||
+      TypeCode.unknown => throw ArgumentError('Unsupported type code'),
+    };
+  }
+
+  /// Returns whether [row] stores the same values as [otherRow] in [other].
+  ///
+  /// This compares encoded values without decoding them.
+  bool rowEquals(int row, ColumnarRows other, int otherRow) {
+    if (columnCount != other.columnCount) {
+      return false;
+    }
+
+    for (var i = 0; i < columnCount; i++) {
+      final index = _index(row, i);
+      final otherIndex = other._index(otherRow, i);
+      final type = _typeAt(index);
+      if (type != other._typeAt(otherIndex)) {
+        return false;
+      }
+
+      final slot = _valuesStart + index * 8;
+      final otherSlot = other._valuesStart + otherIndex * 8;
+
+      switch (type) {
+        case TypeCode.$null:
+          continue;
+        case TypeCode.text || TypeCode.blob:
+          final bytes = _slotBytes(slot);
+          final otherBytes = other._slotBytes(otherSlot);
+          if (bytes.length != otherBytes.length) {
+            return false;
+          }
+          for (var j = 0; j < bytes.length; j++) {
+            if (bytes[j] != otherBytes[j]) {
+              return false;
+            }
+          }
+        default:
+          if (_view.getUint32(slot) != other._view.getUint32(otherSlot) ||
+              _view.getUint32(slot + 4) !=
+                  other._view.getUint32(otherSlot + 4)) {
+            return false;
+          }
+      }
+    }
+
+    return true;
+  }
+
+  Uint8List _slotBytes(int slot) {
+    final offset = _view.getUint32(slot, Endian.little);
+    final length = _view.getUint32(slot + 4, Endian.little);
+    return Uint8List.sublistView(
+      _bytes,
+      _dataStart + offset,
+      _dataStart + offset + length,
+    );
+  }
+
+  @override
+  int get length => _rowCount;
+
+  @override
+  set length(int value) {
+    throw UnsupportedError('Result rows are unmodifiable');
+  }
+
+  @override
+  List<Object?> operator [](int index) {
+    RangeError.checkValidIndex(index, this);
+    return _ColumnarRow(this, index);
+  }
+
+  @override
+  void operator []=(int index, List<Object?> value) {
+    throw UnsupportedError('Result rows are unmodifiable');
+  }
+}
+
+final class _ColumnarRow extends ListBase<Object?> {
+  final ColumnarRows _rows;
+  final int _row;
+
+  _ColumnarRow(this._rows, this._row);
+
+  @override
+  int get length => _rows.columnCount;
+
+  @override
+  set length(int value) {
+    throw UnsupportedError('Result rows are unmodifiable');
+  }
+
+  @override
+  Object? operator [](int index) {
+    RangeError.checkValidIndex(index, this);
+    return _rows.cell(_row, index);
+  }
+
+  @override
+  void operator []=(int index, Object? value) {
+    throw UnsupportedError('Result rows are unmodifiable');
+  }
+}
+
+const _headerSize = 8;
+
+/// Returns the start offsets of the value slots and the data section.
+(int, int) _sectionOffsets(int rows, int columns) {
+  final cells = rows * columns;
+  final valuesStart = _headerSize + ((cells + 7) & ~7);
+  return (valuesStart, valuesStart + cells * 8);
+}
@@ -7,6 +7,7 @@ import 'package:web/web.dart' show MessagePort;
 import '../js_array_buffer.dart';
 import '../types.dart';
 import '../worker_connector.dart';
+import 'columnar.dart';
 import 'helper.g.dart';
 import 'messages.dart';
 
@@ -181,23 +182,35 @@ extension RowsResponseUtils on RowsResponse {
       tableNames: tableNames,
       typeVector: typeVector.buffer.toJS,
       rows: jsRows,
+      columnData: null,
+      readTables: null,
+      writtenTables: null,
       autoCommit: autoCommit,
       lastInsertRowId: lastInsertRowId,
       requestId: requestId,
     );
   }
 
+  /// Steps through [statement] and encodes all rows into a [RowsResponse].
+  ///
+  /// When [columnar] is set, rows are written into a single transferrable
+  /// buffer (see [ColumnarRowsWriter]) instead of a JavaScript array per row.
   static RowsResponse iterateAndEncodeResults(
     CommonPreparedStatement statement,
-    DecodedTypedValues parameters,
-  ) {
+    DecodedTypedValues parameters, {
+    bool columnar = false,
+  }) {
+    parameters.bindAsParameters(statement);
+
+    if (columnar) {
+      return encodeNextRows(statement).$1;
+    }
+
     final jsRows = JSArray<JSArray<JSAny?>>();
     final types = GrowableArrayBuffer();
     final rawStmt = statement.raw;
     var columnCount = 0;
 
-    parameters.bindAsParameters(statement);
-
     var isFirst = true;
     while (rawStmt.step()) {
       if (isFirst) {
@@ -243,6 +256,93 @@ extension RowsResponseUtils on RowsResponse {
       jsRows.add(row);
     }
 
+    final (columnNames, tableNames) = _columnMetadata(rawStmt, columnCount);
+    return newRowsResponse(
+      columnNames: columnNames,
+      tableNames: tableNames,
+      typeVector: types.take(),
+      rows: jsRows,
+      columnData: null,
+      readTables: null,
+      writtenTables: null,
+      autoCommit: false,
+      lastInsertRowId: 0,
+      requestId: 0,
+    );
+  }
+
+  /// Steps through at most [maxRows] rows of the already-bound [statement]
+  /// and encodes them into [RowsResponse.columnData].
+  ///
+  /// Also returns whether the statement has been exhausted.
+  static (RowsResponse, bool) encodeNextRows(
+    CommonPreparedStatement statement, [
+    int? maxRows,
+  ]) {
+    final rawStmt = statement.raw;
+    ColumnarRowsWriter? writer;
+    var rowCount = 0;
+    var exhausted = false;
+
+    while (maxRows == null || rowCount < maxRows) {
+      if (!rawStmt.step()) {
+        exhausted = true;
+        break;
+      }
+
+      rowCount++;
+      final rows = writer ??= ColumnarRowsWriter(rawStmt.columnCount);
+      rows.addRow();
+
+      for (var i = 0; i < rows.columnCount; i++) {
+        switch (rawStmt.columnType(i)) {
+          case SqlType.SQLITE_INTEGER:
+            final bigInt = rawStmt.columnJSBigInt(i);
+            final asJsNumber = _number(bigInt);
+            if (_numberIsSafeInteger(asJsNumber).toDart) {
+              rows.writeNumber(i, TypeCode.integer, asJsNumber.toDartDouble);
+            } else {
+              rows.writeBigInt(i, bigInt);
+            }
+          case SqlType.SQLITE_FLOAT:
+            rows.writeNumber(i, TypeCode.float, rawStmt.columnDouble(i));
+          case SqlType.SQLITE_TEXT:
+            // sqlite3_column_blob returns the UTF-8 representation for texts,
+            // so we don't have to decode and re-encode the string.
+            rows.writeBytes(i, TypeCode.text, rawStmt.columnBlob(i));
+          case SqlType.SQLITE_BLOB:
+            rows.writeBytes(i, TypeCode.blob, rawStmt.columnBlob(i));
+          case SqlType.SQLITE_NULL:
+          default:
+            rows.writeNull(i);
+        }
+      }
+    }
+
+    writer ??= ColumnarRowsWriter(0);
+    final (columnNames, tableNames) = _columnMetadata(
+      rawStmt,
+      writer.columnCount,
+    );
+    final response = newRowsResponse(
+      columnNames: columnNames,
+      tableNames: tableNames,
+      typeVector: null,
+      rows: null,
+      columnData: writer.take(),
+      readTables: null,
+      writtenTables: null,
+      autoCommit: false,
+      lastInsertRowId: 0,
+      requestId: 0,
+    );
+    return (response, exhausted);
+  }
+
+  static (JSArray<JSString>, JSArray<JSString?>?) _columnMetadata(
+    RawPreparedStatement rawStmt,
+    int columnCount,
+  ) {
     final columnNames = JSArray<JSString>.withLength(columnCount);
     final tableNames = rawStmt.supportsColumnTableName
         ? JSArray<JSString?>.withLength(columnCount)
@@ -254,21 +354,17 @@ extension RowsResponseUtils on RowsResponse {
       }
     }
 
-    return newRowsResponse(
-      columnNames: columnNames,
-      tableNames: tableNames,
-      typeVector: types.take(),
-      rows: jsRows,
-      autoCommit: false,
-      lastInsertRowId: 0,
-      requestId: 0,
-    );
+    return (columnNames, tableNames);
   }
 
   ResultSet? readResultSet() {
     if (columnNames case final rawColumnNames?) {
       final columnNames = rawColumnNames.toDart.map((e) => e.toDart).toList();
       final tableNames = this.tableNames?.toDart.map((e) => e?.toDart).toList();
+      if (columnData case final columnData?) {
+        return ResultSet(columnNames, tableNames, ColumnarRows(columnData));
+      }
+
       final typeVector = this.typeVector?.toDart.asUint8List();
 
       final rows = <List<Object?>>[];
@@ -13,15 +13,25 @@ enum MessageType<T extends Message> {
   custom<CustomRequest>(),
   fileSystemExists<FileSystemExistsQuery>(),
   fileSystemFlush<FileSystemFlushRequest>(),
+  fileSystemStatistics<FileSystemStatisticsRequest>(),
   fileSystemAccess<FileSystemAccess>(),
   runQuery<RunQuery>(),
   exclusiveLock<RequestExclusiveLock>(),
   releaseLock<ReleaseLock>(),
   closeDatabase<CloseDatabase>(),
   openAdditionalConnection<OpenAdditionalConnection>(),
+  openCursor<OpenCursor>(),
+  fetchCursor<FetchCursor>(),
+  closeCursor<CloseCursor>(),
+  batch<BatchRequest>(),
+  prepare<PrepareStatement>(),
+  finalize<FinalizeStatement>(),
+  watch<WatchQuery>(),
+  unwatch<UnwatchQuery>(),
   simpleSuccessResponse<SimpleSuccessResponse>(),
   endpointResponse<EndpointResponse>(),
   rowsResponse<RowsResponse>(),
+  batchResponse<BatchResponse>(),
   errorResponse<ErrorResponse>(),
   updateRequest<UpdateStreamRequest>(),
   rollbackRequest<RollbackStreamRequest>(),
@@ -32,6 +42,7 @@ enum MessageType<T extends Message> {
   notifyUpdate<UpdateNotification>(),
   notifyCommit<CommitNotification>(),
   notifyRollback<RollbackNotification>(),
+  notifyQueryDiff<QueryDiffNotification>(),
   abort<AbortRequest>(),
 }
 
@@ -59,6 +70,11 @@ abstract base class RequestHandler {
     AbortSignal abortSignal,
   ) => _unsupportedRequest(request);
 
+  FutureOr<Response> handleFileSystemStatistics(
+    FileSystemStatisticsRequest request,
+    AbortSignal abortSignal,
+  ) => _unsupportedRequest(request);
+
   FutureOr<Response> handleFileSystemAccess(
     FileSystemAccess request,
     AbortSignal abortSignal,
@@ -89,6 +105,44 @@ abstract base class RequestHandler {
     AbortSignal abortSignal,
   ) => _unsupportedRequest(request);
 
+  FutureOr<Response> handleOpenCursor(
+    OpenCursor request,
+    AbortSignal abortSignal,
+  ) => _unsupportedRequest(request);
+
+  FutureOr<Response> handleFetchCursor(
+    FetchCursor request,
+    AbortSignal abortSignal,
+  ) => _unsupportedRequest(request);
+
+  FutureOr<Response> handleCloseCursor(
+    CloseCursor request,
+    AbortSignal abortSignal,
+  ) => _unsupportedRequest(request);
+
+  FutureOr<Response> handleBatch(
+    BatchRequest request,
+    AbortSignal abortSignal,
+  ) => _unsupportedRequest(request);
+
+  FutureOr<Response> handlePrepare(
+    PrepareStatement request,
+    AbortSignal abortSignal,
+  ) => _unsupportedRequest(request);
+
+  FutureOr<Response> handleFinalize(
+    FinalizeStatement request,
+    AbortSignal abortSignal,
+  ) => _unsupportedRequest(request);
+
+  FutureOr<Response> handleWatch(WatchQuery request, AbortSignal abortSignal) =>
+      _unsupportedRequest(request);
+
+  FutureOr<Response> handleUnwatch(
+    UnwatchQuery request,
+    AbortSignal abortSignal,
+  ) => _unsupportedRequest(request);
+
   FutureOr<Response> handleUpdateRequest(
     UpdateStreamRequest request,
     AbortSignal abortSignal,
@@ -141,6 +195,11 @@ abstract base class RequestHandler {
           request as FileSystemFlushRequest,
           abortSignal,
         );
+      case 'fileSystemStatistics':
+        return handleFileSystemStatistics(
+          request as FileSystemStatisticsRequest,
+          abortSignal,
+        );
       case 'fileSystemAccess':
         return handleFileSystemAccess(request as FileSystemAccess, abortSignal);
       case 'runQuery':
@@ -159,6 +218,22 @@ abstract base class RequestHandler {
           request as OpenAdditionalConnection,
           abortSignal,
         );
+      case 'openCursor':
+        return handleOpenCursor(request as OpenCursor, abortSignal);
+      case 'fetchCursor':
+        return handleFetchCursor(request as FetchCursor, abortSignal);
+      case 'closeCursor':
+        return handleCloseCursor(request as CloseCursor, abortSignal);
+      case 'batch':
+        return handleBatch(request as BatchRequest, abortSignal);
+      case 'prepare':
+        return handlePrepare(request as PrepareStatement, abortSignal);
+      case 'finalize':
+        return handleFinalize(request as FinalizeStatement, abortSignal);
+      case 'watch':
+        return handleWatch(request as WatchQuery, abortSignal);
+      case 'unwatch':
+        return handleUnwatch(request as UnwatchQuery, abortSignal);
       case 'updateRequest':
         return handleUpdateRequest(request as UpdateStreamRequest, abortSignal);
       case 'rollbackRequest':
@@ -201,6 +276,7 @@ extension type _OpenRequest._(OpenRequest _) implements OpenRequest {
     @JS('o') required bool onlyOpenVfs,
     @JS('a') required JSAny? additionalData,
     @JS('c') required int preparedStatementCacheSize,
+    @JS('l') required int? flushDelayMs,
     @JS('i') required int requestId,
     @JS('t') required String type,
   });
@@ -212,6 +288,7 @@ OpenRequest newOpenRequest({
   required bool onlyOpenVfs,
   required JSAny? additionalData,
   required int preparedStatementCacheSize,
+  required int? flushDelayMs,
   required int requestId,
 }) {
   return _OpenRequest(
@@ -221,6 +298,7 @@ OpenRequest newOpenRequest({
     onlyOpenVfs: onlyOpenVfs,
     additionalData: additionalData,
     preparedStatementCacheSize: preparedStatementCacheSize,
+    flushDelayMs: flushDelayMs,
     requestId: requestId,
     type: 'open',
   );
@@ -316,6 +394,26 @@ FileSystemFlushRequest newFileSystemFlushRequest({
   );
 }
 
+@anonymous
+extension type _FileSystemStatisticsRequest._(FileSystemStatisticsRequest _)
+    implements FileSystemStatisticsRequest {
+  external factory _FileSystemStatisticsRequest({
+    @JS('i') required int requestId,
+    @JS('d') required int? databaseId,
+    @JS('t') required String type,
+  });
+}
+FileSystemStatisticsRequest newFileSystemStatisticsRequest({
+  required int requestId,
+  required int? databaseId,
+}) {
+  return _FileSystemStatisticsRequest(
+    requestId: requestId,
+    databaseId: databaseId,
+    type: 'fileSystemStatistics',
+  );
+}
+
 @anonymous
 extension type _FileSystemAccess._(FileSystemAccess _)
     implements FileSystemAccess {
@@ -351,6 +449,10 @@ extension type _RunQuery._(RunQuery _) implements RunQuery {
     @JS('z') required int? lockId,
     @JS('r') required bool returnRows,
     @JS('c') required bool checkInTransaction,
+    @JS('b') required bool? columnarResults,
+    @JS('k') required int? statementId,
+    @JS('n') required bool? reportReadTables,
+    @JS('w') required bool? reportWrittenTables,
     @JS('i') required int requestId,
     @JS('d') required int? databaseId,
     @JS('t') required String type,
@@ -363,6 +465,10 @@ RunQuery newRunQuery({
   required int? lockId,
   required bool returnRows,
   required bool checkInTransaction,
+  required bool? columnarResults,
+  required int? statementId,
+  required bool? reportReadTables,
+  required bool? reportWrittenTables,
   required int requestId,
   required int? databaseId,
 }) {
@@ -373,6 +479,10 @@ RunQuery newRunQuery({
     lockId: lockId,
     returnRows: returnRows,
     checkInTransaction: checkInTransaction,
+    columnarResults: columnarResults,
+    statementId: statementId,
+    reportReadTables: reportReadTables,
+    reportWrittenTables: reportWrittenTables,
     requestId: requestId,
     databaseId: databaseId,
     type: 'runQuery',
@@ -460,6 +570,226 @@ OpenAdditionalConnection newOpenAdditionalConnection({
   );
 }
 
+@anonymous
+extension type _OpenCursor._(OpenCursor _) implements OpenCursor {
+  external factory _OpenCursor({
+    @JS('s') required String sql,
+    @JS('p') required JSArray parameters,
+    @JS('v') required JSArrayBuffer typeVector,
+    @JS('z') required int lockId,
+    @JS('i') required int requestId,
+    @JS('d') required int? databaseId,
+    @JS('t') required String type,
+  });
+}
+OpenCursor newOpenCursor({
+  required String sql,
+  required JSArray parameters,
+  required JSArrayBuffer typeVector,
+  required int lockId,
+  required int requestId,
+  required int? databaseId,
+}) {
+  return _OpenCursor(
+    sql: sql,
+    parameters: parameters,
+    typeVector: typeVector,
+    lockId: lockId,
+    requestId: requestId,
+    databaseId: databaseId,
+    type: 'openCursor',
+  );
+}
+
+@anonymous
+extension type _FetchCursor._(FetchCursor _) implements FetchCursor {
+  external factory _FetchCursor({
+    @JS('k') required int cursorId,
+    @JS('n') required int rowCount,
+    @JS('i') required int requestId,
+    @JS('d') required int? databaseId,
+    @JS('t') required String type,
+  });
+}
+FetchCursor newFetchCursor({
+  required int cursorId,
+  required int rowCount,
+  required int requestId,
+  required int? databaseId,
+}) {
+  return _FetchCursor(
+    cursorId: cursorId,
+    rowCount: rowCount,
+    requestId: requestId,
+    databaseId: databaseId,
+    type: 'fetchCursor',
+  );
+}
+
+@anonymous
+extension type _CloseCursor._(CloseCursor _) implements CloseCursor {
+  external factory _CloseCursor({
+    @JS('k') required int cursorId,
+    @JS('i') required int requestId,
+    @JS('d') required int? databaseId,
+    @JS('t') required String type,
+  });
+}
+CloseCursor newCloseCursor({
+  required int cursorId,
+  required int requestId,
+  required int? databaseId,
+}) {
+  return _CloseCursor(
+    cursorId: cursorId,
+    requestId: requestId,
+    databaseId: databaseId,
+    type: 'closeCursor',
+  );
+}
+
+@anonymous
+extension type _BatchRequest._(BatchRequest _) implements BatchRequest {
+  external factory _BatchRequest({
+    @JS('s') required JSArray<JSString> statements,
+    @JS('p') required JSArray<JSArray> parameters,
+    @JS('v') required JSArrayBuffer typeVector,
+    @JS('z') required int? lockId,
+    @JS('a') required bool transaction,
+    @JS('w') required bool? reportWrittenTables,
+    @JS('i') required int requestId,
+    @JS('d') required int? databaseId,
+    @JS('t') required String type,
+  });
+}
+BatchRequest newBatchRequest({
+  required JSArray<JSString> statements,
+  required JSArray<JSArray> parameters,
+  required JSArrayBuffer typeVector,
+  required int? lockId,
+  required bool transaction,
+  required bool? reportWrittenTables,
+  required int requestId,
+  required int? databaseId,
+}) {
+  return _BatchRequest(
+    statements: statements,
+    parameters: parameters,
+    typeVector: typeVector,
+    lockId: lockId,
+    transaction: transaction,
+    reportWrittenTables: reportWrittenTables,
+    requestId: requestId,
+    databaseId: databaseId,
+    type: 'batch',
+  );
+}
+
+@anonymous
+extension type _PrepareStatement._(PrepareStatement _)
+    implements PrepareStatement {
+  external factory _PrepareStatement({
+    @JS('s') required String sql,
+    @JS('z') required int? lockId,
+    @JS('i') required int requestId,
+    @JS('d') required int? databaseId,
+    @JS('t') required String type,
+  });
+}
+PrepareStatement newPrepareStatement({
+  required String sql,
+  required int? lockId,
+  required int requestId,
+  required int? databaseId,
+}) {
+  return _PrepareStatement(
+    sql: sql,
+    lockId: lockId,
+    requestId: requestId,
+    databaseId: databaseId,
+    type: 'prepare',
+  );
+}
+
+@anonymous
+extension type _FinalizeStatement._(FinalizeStatement _)
+    implements FinalizeStatement {
+  external factory _FinalizeStatement({
+    @JS('k') required int statementId,
+    @JS('i') required int requestId,
+    @JS('d') required int? databaseId,
+    @JS('t') required String type,
+  });
+}
+FinalizeStatement newFinalizeStatement({
+  required int statementId,
+  required int requestId,
+  required int? databaseId,
+}) {
+  return _FinalizeStatement(
+    statementId: statementId,
+    requestId: requestId,
+    databaseId: databaseId,
+    type: 'finalize',
+  );
+}
+
+@anonymous
+extension type _WatchQuery._(WatchQuery _) implements WatchQuery {
+  external factory _WatchQuery({
+    @JS('s') required String sql,
+    @JS('p') required JSArray parameters,
+    @JS('v') required JSArrayBuffer typeVector,
+    @JS('k') required int watchId,
+    @JS('z') required int? lockId,
+    @JS('i') required int requestId,
+    @JS('d') required int? databaseId,
+    @JS('t') required String type,
+  });
+}
+WatchQuery newWatchQuery({
+  required String sql,
+  required JSArray parameters,
+  required JSArrayBuffer typeVector,
+  required int watchId,
+  required int? lockId,
+  required int requestId,
+  required int? databaseId,
+}) {
+  return _WatchQuery(
+    sql: sql,
+    parameters: parameters,
+    typeVector: typeVector,
+    watchId: watchId,
+    lockId: lockId,
+    requestId: requestId,
+    databaseId: databaseId,
+    type: 'watch',
+  );
+}
+
+@anonymous
+extension type _UnwatchQuery._(UnwatchQuery _) implements UnwatchQuery {
+  external factory _UnwatchQuery({
+    @JS('k') required int watchId,
+    @JS('i') required int requestId,
+    @JS('d') required int? databaseId,
+    @JS('t') required String type,
+  });
+}
+UnwatchQuery newUnwatchQuery({
+  required int watchId,
+  required int requestId,
+  required int? databaseId,
+}) {
+  return _UnwatchQuery(
+    watchId: watchId,
+    requestId: requestId,
+    databaseId: databaseId,
+    type: 'unwatch',
+  );
+}
+
 @anonymous
 extension type _SimpleSuccessResponse._(SimpleSuccessResponse _)
     implements SimpleSuccessResponse {
@@ -507,6 +837,9 @@ extension type _RowsResponse._(RowsResponse _) implements RowsResponse {
     @JS('n') required JSArray<JSString?>? tableNames,
     @JS('v') required JSArrayBuffer? typeVector,
     @JS('r') required JSArray<JSArray<JSAny?>>? rows,
+    @JS('b') required JSArrayBuffer? columnData,
+    @JS('a') required JSArray<JSString>? readTables,
+    @JS('w') required JSArray<JSString>? writtenTables,
     @JS('x') required bool autoCommit,
     @JS('y') required int lastInsertRowId,
     @JS('i') required int requestId,
@@ -518,6 +851,9 @@ RowsResponse newRowsResponse({
   required JSArray<JSString?>? tableNames,
   required JSArrayBuffer? typeVector,
   required JSArray<JSArray<JSAny?>>? rows,
+  required JSArrayBuffer? columnData,
+  required JSArray<JSString>? readTables,
+  required JSArray<JSString>? writtenTables,
   required bool autoCommit,
   required int lastInsertRowId,
   required int requestId,
@@ -527,6 +863,9 @@ RowsResponse newRowsResponse({
     tableNames: tableNames,
     typeVector: typeVector,
     rows: rows,
+    columnData: columnData,
+    readTables: readTables,
+    writtenTables: writtenTables,
     autoCommit: autoCommit,
     lastInsertRowId: lastInsertRowId,
     requestId: requestId,
@@ -534,6 +873,28 @@ RowsResponse newRowsResponse({
   );
 }
 
+@anonymous
+extension type _BatchResponse._(BatchResponse _) implements BatchResponse {
+  external factory _BatchResponse({
+    @JS('r') required JSArray<RowsResponse> results,
+    @JS('w') required JSArray<JSString>? writtenTables,
+    @JS('i') required int requestId,
+    @JS('t') required String type,
+  });
+}
+BatchResponse newBatchResponse({
+  required JSArray<RowsResponse> results,
+  required JSArray<JSString>? writtenTables,
+  required int requestId,
+}) {
+  return _BatchResponse(
+    results: results,
+    writtenTables: writtenTables,
+    requestId: requestId,
+    type: 'batchResponse',
+  );
+}
+
 @anonymous
 extension type _ErrorResponse._(ErrorResponse _) implements ErrorResponse {
   external factory _ErrorResponse({
@@ -739,6 +1100,38 @@ RollbackNotification newRollbackNotification({required int databaseId}) {
   return _RollbackNotification(databaseId: databaseId, type: 'notifyRollback');
 }
 
+@anonymous
+extension type _QueryDiffNotification._(QueryDiffNotification _)
+    implements QueryDiffNotification {
+  external factory _QueryDiffNotification({
+    @JS('k') required int watchId,
+    @JS('o') required int diffStart,
+    @JS('n') required int removedRows,
+    @JS('c') required JSArray<JSString> columnNames,
+    @JS('b') required JSArrayBuffer columnData,
+    @JS('d') required int databaseId,
+    @JS('t') required String type,
+  });
+}
+QueryDiffNotification newQueryDiffNotification({
+  required int watchId,
+  required int diffStart,
+  required int removedRows,
+  required JSArray<JSString> columnNames,
+  required JSArrayBuffer columnData,
+  required int databaseId,
+}) {
+  return _QueryDiffNotification(
+    watchId: watchId,
+    diffStart: diffStart,
+    removedRows: removedRows,
+    columnNames: columnNames,
+    columnData: columnData,
+    databaseId: databaseId,
+    type: 'notifyQueryDiff',
+  );
+}
+
 @anonymous
 extension type _AbortRequest._(AbortRequest _) implements AbortRequest {
   external factory _AbortRequest({
@@ -770,6 +1163,21 @@ JSArray<JSAny> extractTransferrable(Message message) {
         result.add((message as RunQuery).typeVector);
         break;
       }
+    case 'openCursor':
+      {
+        result.add((message as OpenCursor).typeVector);
+        break;
+      }
+    case 'batch':
+      {
+        result.add((message as BatchRequest).typeVector);
+        break;
+      }
+    case 'watch':
+      {
+        result.add((message as WatchQuery).typeVector);
+        break;
+      }
     case 'simpleSuccessResponse':
       {
         if ((message as SimpleSuccessResponse).response case JSAny a
@@ -786,6 +1194,12 @@ JSArray<JSAny> extractTransferrable(Message message) {
     case 'rowsResponse':
       {
         if ((message as RowsResponse).typeVector case final e?) result.add(e);
+        if ((message as RowsResponse).columnData case final e?) result.add(e);
+        break;
+      }
+    case 'notifyQueryDiff':
+      {
+        result.add((message as QueryDiffNotification).columnData);
         break;
       }
   }
@@ -805,10 +1219,12 @@ T dispatchMessage<T>(
     case 'notifyUpdate':
     case 'notifyCommit':
     case 'notifyRollback':
+    case 'notifyQueryDiff':
       return whenNotification(msg as Notification);
     case 'simpleSuccessResponse':
     case 'endpointResponse':
     case 'rowsResponse':
+    case 'batchResponse':
     case 'errorResponse':
       return whenResponse(msg as Response);
     default:
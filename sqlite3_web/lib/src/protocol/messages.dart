@@ -92,6 +92,11 @@ extension type OpenRequest._(JSObject _) implements Request {
 
   @JS(_UniqueFieldNames.cacheSize)
   external int preparedStatementCacheSize;
+
+  /// The `DurabilityPolicy.flushDelay` in milliseconds for OPFS databases, or
+  /// `null` to flush on every sync.
+  @JS(_UniqueFieldNames.flushDelay)
+  external int? flushDelayMs;
 }
 
 /// Requests the receiving end of this message to connect to the channel
@@ -135,6 +140,12 @@ extension type FileSystemExistsQuery._(JSObject _) implements Request {
 @MessageTypeName('fileSystemFlush')
 extension type FileSystemFlushRequest._(JSObject _) implements Request {}
 
+/// Requests `FlushStatistics` of the file system hosting a database, which are
+/// encoded as an array of syncs, flushes and the total flush time in
+/// microseconds (or `null` if the file system doesn't report them).
+@MessageTypeName('fileSystemStatistics')
+extension type FileSystemStatisticsRequest._(JSObject _) implements Request {}
+
 @MessageTypeName('fileSystemAccess')
 extension type FileSystemAccess._(JSObject _) implements Request {
   @JS(_UniqueFieldNames.buffer)
@@ -161,6 +172,28 @@ extension type RunQuery._(JSObject _) implements Request {
   external bool returnRows;
   @JS(_UniqueFieldNames.checkInTransaction)
   external bool checkInTransaction;
+
+  /// Whether the client supports reading rows from
+  /// [RowsResponse.columnData].
+  ///
+  /// This is nullable because older clients don't set this field.
+  @JS(_UniqueFieldNames.columnarResults)
+  external bool? columnarResults;
+
+  /// If set, runs the statement prepared with [PrepareStatement] instead of
+  /// preparing [sql].
+  @JS(_UniqueFieldNames.statementId)
+  external int? statementId;
+
+  /// Whether the worker should report the tables read by the statement in
+  /// [RowsResponse.readTables].
+  @JS(_UniqueFieldNames.reportReadTables)
+  external bool? reportReadTables;
+
+  /// Whether the worker should report the tables written by the statement in
+  /// [RowsResponse.writtenTables].
+  @JS(_UniqueFieldNames.reportWrittenTables)
+  external bool? reportWrittenTables;
 }
 
 @MessageTypeName('exclusiveLock')
@@ -178,6 +211,126 @@ extension type CloseDatabase._(JSObject _) implements Request {}
 @MessageTypeName('openAdditionalConnection')
 extension type OpenAdditionalConnection._(JSObject _) implements Request {}
 
+/// Prepares a statement and keeps it open as a cursor.
+///
+/// Cursors are bound to the lock identified by [lockId] (which ensures no other
+/// statements run while the cursor is active) and are closed automatically
+/// when that lock is released. The worker responds with the id of the cursor,
+/// which can then be used to request rows with [FetchCursor].
+@MessageTypeName('openCursor')
+extension type OpenCursor._(JSObject _) implements Request {
+  @JS(_UniqueFieldNames.sql)
+  external String sql;
+
+  @JS(_UniqueFieldNames.parameters)
+  external JSArray parameters;
+  @JS(_UniqueFieldNames.typeVector)
+  @transfer
+  external JSArrayBuffer typeVector;
+
+  @JS(_UniqueFieldNames.lockId)
+  external int lockId;
+}
+
+/// Requests up to [rowCount] rows from a cursor opened with [OpenCursor].
+///
+/// The worker responds with a [RowsResponse] storing the rows in
+/// [RowsResponse.columnData]. When it contains less than [rowCount] rows, the
+/// cursor has been exhausted and was closed by the worker.
+@MessageTypeName('fetchCursor')
+extension type FetchCursor._(JSObject _) implements Request {
+  @JS(_UniqueFieldNames.cursorId)
+  external int cursorId;
+  @JS(_UniqueFieldNames.rowCount)
+  external int rowCount;
+}
+
+/// Closes a cursor opened with [OpenCursor] before it has been exhausted.
+@MessageTypeName('closeCursor')
+extension type CloseCursor._(JSObject _) implements Request {
+  @JS(_UniqueFieldNames.cursorId)
+  external int cursorId;
+}
+
+/// Runs multiple statements in a single request.
+///
+/// The worker responds with a [BatchResponse].
+@MessageTypeName('batch')
+extension type BatchRequest._(JSObject _) implements Request {
+  @JS(_UniqueFieldNames.batchStatements)
+  external JSArray<JSString> statements;
+
+  /// Encoded parameters for each statement in [statements].
+  @JS(_UniqueFieldNames.parameters)
+  external JSArray<JSArray> parameters;
+
+  /// Type codes for all [parameters], concatenated.
+  @JS(_UniqueFieldNames.typeVector)
+  @transfer
+  external JSArrayBuffer typeVector;
+
+  @JS(_UniqueFieldNames.lockId)
+  external int? lockId;
+
+  /// Whether to run statements in a savepoint that is rolled back if one of
+  /// them fails.
+  @JS(_UniqueFieldNames.inTransaction)
+  external bool transaction;
+
+  /// Whether the worker should report the tables written by the batch in
+  /// [BatchResponse.writtenTables].
+  @JS(_UniqueFieldNames.reportWrittenTables)
+  external bool? reportWrittenTables;
+}
+
+/// Prepares a statement that is kept on the worker until it's finalized with
+/// [FinalizeStatement] or until the client disconnects.
+///
+/// The worker responds with an id that can be used as [RunQuery.statementId].
+@MessageTypeName('prepare')
+extension type PrepareStatement._(JSObject _) implements Request {
+  @JS(_UniqueFieldNames.sql)
+  external String sql;
+  @JS(_UniqueFieldNames.lockId)
+  external int? lockId;
+}
+
+@MessageTypeName('finalize')
+extension type FinalizeStatement._(JSObject _) implements Request {
+  @JS(_UniqueFieldNames.statementId)
+  external int statementId;
+}
+
+/// Registers a live query that the worker re-evaluates whenever one of the
+/// tables it reads from changes.
+///
+/// The client picks a [watchId] that is unique for its connection. The worker
+/// then sends [QueryDiffNotification]s with that id, starting with one
+/// containing all rows of the query.
+@MessageTypeName('watch')
+extension type WatchQuery._(JSObject _) implements Request {
+  @JS(_UniqueFieldNames.sql)
+  external String sql;
+  @JS(_UniqueFieldNames.parameters)
+  external JSArray parameters;
+  @JS(_UniqueFieldNames.typeVector)
+  @transfer
+  external JSArrayBuffer typeVector;
+  @JS(_UniqueFieldNames.watchId)
+  external int watchId;
+
+  /// The lock to evaluate the initial result under, if the client is holding
+  /// one.
+  @JS(_UniqueFieldNames.lockId)
+  external int? lockId;
+}
+
+@MessageTypeName('unwatch')
+extension type UnwatchQuery._(JSObject _) implements Request {
+  @JS(_UniqueFieldNames.watchId)
+  external int watchId;
+}
+
 @MessageTypeName('simpleSuccessResponse')
 extension type SimpleSuccessResponse._(JSObject _) implements Response {
   @JS(_UniqueFieldNames.responseData)
@@ -380,12 +533,51 @@ extension type RowsResponse._(JSObject _) implements Response {
   @JS(_UniqueFieldNames.rows)
   external JSArray<JSArray<JSAny?>>? rows;
 
+  /// If the client has requested [RunQuery.columnarResults], the rows encoded
+  /// in the format written by `ColumnarRowsWriter`.
+  ///
+  /// When this is set, [rows] and [typeVector] are null.
+  @JS(_UniqueFieldNames.columnData)
+  @transfer
+  external JSArrayBuffer? columnData;
+
+  /// If the client has requested [RunQuery.reportReadTables], the tables the
+  /// statement reads from.
+  ///
+  /// This is only set if the statement doesn't write to the database, and if
+  /// its results only depend on these tables (so it can't read from virtual
+  /// tables or call non-deterministic functions, for instance).
+  @JS(_UniqueFieldNames.readTables)
+  external JSArray<JSString>? readTables;
+
+  /// If the client has requested [RunQuery.reportWrittenTables], the tables
+  /// the statement has written to.
+  ///
+  /// This is null if the worker can't tell which tables have changed, e.g.
+  /// after schema changes.
+  @JS(_UniqueFieldNames.writtenTables)
+  external JSArray<JSString>? writtenTables;
+
   @JS(_UniqueFieldNames.autocommit)
   external bool autoCommit;
   @JS(_UniqueFieldNames.lastInsertRowid)
   external int lastInsertRowId;
 }
 
+/// The response to a [BatchRequest], storing a [RowsResponse] (with
+/// [RowsResponse.columnData]) for each statement in the batch.
+@MessageTypeName('batchResponse')
+extension type BatchResponse._(JSObject _) implements Response {
+  @JS(_UniqueFieldNames.rows)
+  external JSArray<RowsResponse> results;
+
+  /// If the client has requested [BatchRequest.reportWrittenTables], the
+  /// tables written by any statement in the batch (or null if they're not
+  /// known, see [RowsResponse.writtenTables]).
+  @JS(_UniqueFieldNames.writtenTables)
+  external JSArray<JSString>? writtenTables;
+}
+
 @MessageTypeName('errorResponse')
 extension type ErrorResponse._(JSObject _) implements Response {
   @JS(_UniqueFieldNames.errorMessage)
@@ -452,6 +644,27 @@ extension type CommitNotification._(JSObject _) implements Notification {}
 @MessageTypeName('notifyRollback')
 extension type RollbackNotification._(JSObject _) implements Notification {}
 
+/// Describes how the rows of a [WatchQuery] have changed.
+///
+/// Clients apply the diff by replacing [removedRows] rows starting at
+/// [diffStart] with the rows in [columnData].
+@MessageTypeName('notifyQueryDiff')
+extension type QueryDiffNotification._(JSObject _) implements Notification {
+  @JS(_UniqueFieldNames.watchId)
+  external int watchId;
+  @JS(_UniqueFieldNames.diffStart)
+  external int diffStart;
+  @JS(_UniqueFieldNames.removedRows)
+  external int removedRows;
+  @JS(_UniqueFieldNames.columnNames)
+  external JSArray<JSString> columnNames;
+
+  /// The inserted rows, in the format written by `ColumnarRowsWriter`.
+  @JS(_UniqueFieldNames.columnData)
+  @transfer
+  external JSArrayBuffer columnData;
+}
+
 /// Requests a previously issued request to be cancelled.
 ///
 /// An endpoint will not respond to this message, but it may abort the previous
@@ -469,7 +682,12 @@ extension type AbortRequest._(JSObject _) implements Message {
 class _UniqueFieldNames {
   static const action = 'a'; // Only used in StreamRequest
   static const additionalData = 'a'; // only used in OpenRequest
+  static const inTransaction = 'a'; // only used in BatchRequest
+  static const readTables = 'a'; // only used in RowsResponse
   static const buffer = 'b';
+  // no clash, used in RowsResponse and RunQuery
+  static const columnData = 'b';
+  static const columnarResults = 'b';
   // no clash, used in RowResponse and RunQuery
   static const columnNames = 'c';
   static const checkInTransaction = 'c';
@@ -479,13 +697,22 @@ class _UniqueFieldNames {
   static const errorMessage = 'e';
   static const fileType = 'f';
   static const id = 'i';
+  static const flushDelay = 'l'; // only used in OpenRequest
   static const updateKind = 'k';
+  static const cursorId = 'k'; // no clash, used on different message types
+  static const statementId = 'k';
+  static const watchId = 'k';
   static const tableNames = 'n';
+  static const rowCount = 'n'; // no clash, used on different message types
+  static const reportReadTables = 'n'; // only used in RunQuery
+  static const removedRows = 'n';
   static const onlyOpenVfs = 'o';
+  static const diffStart = 'o'; // only used in QueryDiffNotification
   static const parameters = 'p';
   static const storageMode = 's';
   static const serializedExceptionType = 's';
   static const sql = 's'; // not used in same message
+  static const batchStatements = 's';
   static const type = 't';
   static const wasmUri = 'u';
   static const updateTableName = 'u';
@@ -496,6 +723,8 @@ class _UniqueFieldNames {
   static const rows = 'r'; // no clash, used on different message types
   static const typeVector = 'v';
   static const autocommit = 'x';
+  static const writtenTables = 'w'; // no clash, used on different types
+  static const reportWrittenTables = 'w';
   static const lastInsertRowid = 'y';
   static const lockId = 'z';
 }
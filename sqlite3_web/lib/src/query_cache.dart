@@ -0,0 +1,127 @@
+import 'dart:collection';
+
+import 'package:sqlite3/common.dart';
+
+import 'database.dart';
+import 'shared.dart';
+
+/// Caches results of [Database.select] in the client, see
+/// [QueryCacheOptions].
+final class QueryCache {
+  final QueryCacheOptions options;
+
+  /// Cached results in least-recently used order.
+  final LinkedHashMap<String, _CacheEntry> _entries = LinkedHashMap();
+
+  /// For each table, the value of [_updateCounter] after its last update.
+  final Map<String, int> _lastUpdate = {};
+
+  /// The value of [_updateCounter] after the last call to [invalidateAll].
+  var _lastInvalidateAll = 0;
+  var _updateCounter = 0;
+
+  final Stopwatch _clock = Stopwatch()..start();
+
+  var _hits = 0;
+  var _misses = 0;
+  var _invalidations = 0;
+  var _evictions = 0;
+
+  QueryCache(this.options) : assert(options.maxEntries > 0);
+
+  QueryCacheStatistics get statistics {
+    return QueryCacheStatistics(
+      hits: _hits,
+      misses: _misses,
+      invalidations: _invalidations,
+      evictions: _evictions,
+      entries: _entries.length,
+    );
+  }
+
+  /// Returns a cached result for [sql] and [parameters], or calls [run] to
+  /// evaluate the query on the worker.
+  ///
+  /// [run] returns the result along with the tables read by the query. If it
+  /// doesn't report tables (because the results may change without these
+  /// tables being written) or if the query doesn't read from any table, the
+  /// result is not cached.
+  Future<DatabaseResult<ResultSet>> select(
+    String sql,
+    List<Object?> parameters,
+    Future<(DatabaseResult<ResultSet>, List<String>?)> Function() run,
+  ) async {
+    final key = queryKey(sql, parameters);
+    if (_lookup(key) case final cached?) {
+      _hits++;
+      return cached;
+    }
+
+    _misses++;
+    final startedAt = _updateCounter;
+    final (result, tables) = await run();
+
+    // Results read in a transaction may be rolled back, and results read
+    // while one of their tables was updated may be outdated already.
+    if (tables != null &&
+        tables.isNotEmpty &&
+        result.autocommit &&
+        _lastInvalidateAll <= startedAt &&
+        !tables.any((table) => (_lastUpdate[table] ?? 0) > startedAt)) {
+      _entries[key] = _CacheEntry(result, tables.toSet(), _clock.elapsed);
+      while (_entries.length > options.maxEntries) {
+        _entries.remove(_entries.keys.first);
+        _evictions++;
+      }
+    }
+
+    return result;
+  }
+
+  DatabaseResult<ResultSet>? _lookup(String key) {
+    final entry = _entries.remove(key);
+    if (entry == null) {
+      return null;
+    }
+
+    if (options.maxAge case final maxAge?
+        when _clock.elapsed - entry.createdAt > maxAge) {
+      _evictions++;
+      return null;
+    }
+
+    // Re-insert to mark the entry as most recently used.
+    _entries[key] = entry;
+    return entry.result;
+  }
+
+  /// Evicts results reading from [table].
+  void tableUpdated(String table) {
+    _lastUpdate[table] = ++_updateCounter;
+    _entries.removeWhere((_, entry) {
+      if (entry.tables.contains(table)) {
+        _invalidations++;
+        return true;
+      }
+
+      return false;
+    });
+  }
+
+  /// Evicts all results.
+  ///
+  /// This is called after requests that have written to unknown tables.
+  void invalidateAll() {
+    _lastInvalidateAll = ++_updateCounter;
+    _invalidations += _entries.length;
+    _entries.clear();
+  }
+}
+
+final class _CacheEntry {
+  final DatabaseResult<ResultSet> result;
+  final Set<String> tables;
+  final Duration createdAt;
+
+  _CacheEntry(this.result, this.tables, this.createdAt);
+}
@@ -88,6 +88,15 @@ Future<List<String>> opfsDatabases() async {
   ];
 }
 
+/// Identifies a query with bound [parameters], for instance to share live
+/// queries between clients or to cache results.
+String queryKey(String sql, List<Object?> parameters) {
+  return [
+    sql,
+    for (final value in parameters) '${value.runtimeType}$value',
+  ].join('\u0000');
+}
+
 /// Constructs the path used by drift to store a database in the origin-private
 /// section of the agent's file system.
 String pathForOpfs(String databaseName) {
@@ -0,0 +1,531 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:js_interop';
+import 'dart:js_interop_unsafe';
+import 'dart:typed_data';
+
+// ignore: implementation_imports
+import 'package:sqlite3/src/wasm/js_interop/atomics.dart';
+import 'package:web/web.dart' show MessagePort;
+
+import 'js_array_buffer.dart';
+import 'protocol.dart';
+
+/// A faster path for messages between a client and a dedicated worker, used
+/// when the page is cross-origin isolated.
+///
+/// `postMessage` schedules a task on the receiving end for each message, which
+/// dominates the latency of small requests. With a [SharedArrayBuffer], both
+/// ends instead write messages into a ring buffer (one for each direction) and
+/// wake the receiver with `Atomics.notify`. The receiver waits for messages
+/// with `Atomics.waitAsync`, so it doesn't block its event loop.
+///
+/// Messages that can't be written into shared memory (because they contain
+/// message ports or are larger than the ring buffer) are sent over the message
+/// port instead. To keep messages ordered, each message is tagged with a
+/// sequence number and the receiver delivers them in that order. For the same
+/// reason, the request to close the channel is sent as a sequenced message
+/// with [sendClose].
+final class SharedMemoryChannel {
+  final MessagePort _port;
+  final _RingWriter _writer;
+  final _RingReader _reader;
+
+  var _nextOutgoing = 0;
+  var _nextIncoming = 0;
+  /// Received messages that can't be delivered yet, with `null` marking the
+  /// request to close the channel.
+  final Map<int, Message?> _pending = {};
+
+  void Function(Message)? _onMessage;
+  void Function()? _onClose;
+  var _closed = false;
+
+  SharedMemoryChannel._(this._port, this._writer, this._reader);
+
+  /// Opens the channel on a [buffer] obtained from [allocate].
+  ///
+  /// The end that allocated the buffer must pass `true` for [isOwner], the
+  /// other end must pass `false`.
+  factory SharedMemoryChannel(
+    MessagePort port,
+    SharedArrayBuffer buffer, {
+    required bool isOwner,
+  }) {
+    final control = buffer.asInt32List();
+    final first = buffer.asUint8ListSlice(_controlSize, _ringCapacity);
+    final second = buffer.asUint8ListSlice(
+      _controlSize + _ringCapacity,
+      _ringCapacity,
+    );
+
+    // The owner writes into the first ring and reads from the second one.
+    final (writeIndex, writeRing, readIndex, readRing) = isOwner
+        ? (0, first, 2, second)
+        : (2, second, 0, first);
+
+    return SharedMemoryChannel._(
+      port,
+      _RingWriter(control, writeIndex, writeRing),
+      _RingReader(control, readIndex, readRing),
+    );
+  }
+
+  /// Allocates a buffer for a new channel, or returns null if shared memory
+  /// can't be used in this context.
+  static SharedArrayBuffer? allocate() {
+    if (!isSupported) {
+      return null;
+    }
+
+    return SharedArrayBuffer(_controlSize + 2 * _ringCapacity);
+  }
+
+  /// Whether this context is cross-origin isolated and supports waiting on
+  /// shared memory asynchronously.
+  static bool get isSupported {
+    if (globalContext['crossOriginIsolated'] case JSBoolean isolated
+        when isolated.toDart) {
+      return globalContext.has('Atomics') &&
+          (globalContext['Atomics'] as JSObject).has('waitAsync');
+    }
+
+    return false;
+  }
+
+  /// Starts delivering received messages to [onMessage].
+  ///
+  /// [onClose] is invoked once all messages sent before the other end called
+  /// [sendClose] have been delivered.
+  void start(
+    void Function(Message) onMessage, {
+    required void Function() onClose,
+  }) {
+    _onMessage = onMessage;
+    _onClose = onClose;
+    unawaited(_readLoop());
+  }
+
+  void send(Message message) {
+    _sendSequenced(message);
+  }
+
+  /// Asks the other end to close the channel after it has received all
+  /// messages sent before.
+  void sendClose() {
+    _sendSequenced(null);
+  }
+
+  void _sendSequenced(Message? message) {
+    final sequence = _nextOutgoing++;
+    final encoded = _MessageEncoder.tryEncode(sequence, message);
+
+    if (encoded == null || !_writer.tryWrite(encoded)) {
+      final wrapped = JSObject()
+        ..[_sequenceField] = sequence.toJS
+        ..[_messageField] = message;
+      _port.postMessage(
+        wrapped,
+        message == null ? JSArray() : extractTransferrable(message),
+      );
+    }
+  }
+
+  /// Handles a message sent by [send] or [sendClose] over the message port.
+  void handlePortMessage(JSObject wrapped) {
+    _deliver(
+      (wrapped[_sequenceField] as JSNumber).toDartInt,
+      wrapped[_messageField] as Message?,
+    );
+  }
+
+  void close() {
+    _closed = true;
+    // Wake up the pending Atomics.waitAsync in _readLoop.
+    _reader.wake();
+  }
+
+  Future<void> _readLoop() async {
+    while (!_closed) {
+      if (_reader.tryRead() case final frame?) {
+        try {
+          final (sequence, message) = _MessageDecoder(frame).decodeFrame();
+          _deliver(sequence, message);
+        } catch (e, s) {
+          // Keep reading, an exception here would otherwise stop all further
+          // messages from being delivered.
+          Zone.current.handleUncaughtError(e, s);
+        }
+      } else {
+        await _reader.waitForData();
+      }
+    }
+  }
+
+  void _deliver(int sequence, Message? message) {
+    _pending[sequence] = message;
+
+    while (!_closed && _pending.containsKey(_nextIncoming)) {
+      switch (_pending.remove(_nextIncoming++)) {
+        case final message?:
+          try {
+            _onMessage!(message);
+          } catch (e, s) {
+            Zone.current.handleUncaughtError(e, s);
+          }
+        case null:
+          _onClose!();
+      }
+    }
+  }
+
+  /// Each ring has a head (the write offset) and a tail (the read offset),
+  /// stored as int32 values at the start of the buffer.
+  static const _controlSize = 4 * 4;
+
+  /// The size of each ring buffer.
+  ///
+  /// Results larger than this are better served by transferring buffers over
+  /// message ports anyway.
+  static const _ringCapacity = 256 * 1024;
+
+  static const _sequenceField = 'q';
+  static const _messageField = 'm';
+}
+
+/// Frames in a ring are prefixed with their length and padded to four bytes.
+/// When a frame doesn't fit before the end of the ring, the writer stores this
+/// marker instead of the length and continues at the start.
+const _wrapMarker = 0xFFFFFFFF;
+
+int _frameSize(int payloadLength) => 4 + ((payloadLength + 3) & ~3);
+
+final class _RingWriter {
+  final Int32List _control;
+  final int _headIndex;
+  final Uint8List _bytes;
+  final ByteData _view;
+
+  var _head = 0;
+
+  _RingWriter(this._control, this._headIndex, this._bytes)
+    : _view = ByteData.sublistView(_bytes);
+
+  int get _tailIndex => _headIndex + 1;
+
+  /// Writes [payload] into the ring and wakes the reader. Returns false if the
+  /// ring doesn't have enough space left.
+  bool tryWrite(Uint8List payload) {
+    final capacity = _bytes.length;
+    final size = _frameSize(payload.length);
+    final tail = Atomics.load(_control, _tailIndex);
+
+    // Keep a gap of four bytes so that a full ring can be told apart from an
+    // empty one.
+    var free = capacity - (_head - tail) % capacity - 4;
+    var start = _head;
+    if (start + size > capacity) {
+      free -= capacity - start;
+      start = 0;
+    }
+
+    if (size > free) {
+      return false;
+    }
+
+    if (start != _head) {
+      _view.setUint32(_head, _wrapMarker, Endian.little);
+    }
+    _view.setUint32(start, payload.length, Endian.little);
+    _bytes.setRange(start + 4, start + 4 + payload.length, payload);
+
+    _head = (start + size) % capacity;
+    Atomics.store(_control, _headIndex, _head);
+    Atomics.notify(_control, _headIndex);
+    return true;
+  }
+}
+
+final class _RingReader {
+  final Int32List _control;
+  final int _headIndex;
+  final Uint8List _bytes;
+  final ByteData _view;
+
+  var _tail = 0;
+
+  _RingReader(this._control, this._headIndex, this._bytes)
+    : _view = ByteData.sublistView(_bytes);
+
+  int get _tailIndex => _headIndex + 1;
+
+  /// Copies the next frame out of shared memory, or returns null if the ring
+  /// is empty.
+  Uint8List? tryRead() {
+    if (Atomics.load(_control, _headIndex) == _tail) {
+      return null;
+    }
+
+    var length = _view.getUint32(_tail, Endian.little);
+    if (length == _wrapMarker) {
+      _tail = 0;
+      length = _view.getUint32(0, Endian.little);
+    }
+
+    // Copy, since decoding texts from shared memory is not allowed and the
+    // writer will reuse this range.
+    final frame = Uint8List.fromList(
+      Uint8List.sublistView(_bytes, _tail + 4, _tail + 4 + length),
+    );
+
+    _tail = (_tail + _frameSize(length)) % _bytes.length;
+    Atomics.store(_control, _tailIndex, _tail);
+    return frame;
+  }
+
+  /// Completes once the writer has added a frame (or after [wake] is called).
+  Future<void> waitForData() async {
+    final result = _waitAsync(_control.toJS, _headIndex, _tail);
+    if (result.isAsync) {
+      await (result.value as JSPromise).toDart;
+    }
+  }
+
+  void wake() {
+    Atomics.notify(_control, _headIndex);
+  }
+}
+
+@JS('Atomics.waitAsync')
+external _WaitAsyncResult _waitAsync(JSInt32Array array, int index, int value);
+
+extension type _WaitAsyncResult._(JSObject _) implements JSObject {
+  @JS('async')
+  external bool get isAsync;
+
+  /// A promise if [isAsync] is true, a string describing the result otherwise.
+  external JSAny get value;
+}
+
+@JS('Array.isArray')
+external bool _isArray(JSAny? value);
+
+@JS('Object.getPrototypeOf')
+external JSAny? _prototypeOf(JSAny value);
+
+@JS('Object.prototype')
+external JSAny get _objectPrototype;
+
+@JS('Object.keys')
+external JSArray<JSString> _objectKeys(JSObject object);
+
+enum _ValueTag {
+  undefined,
+  $null,
+  $false,
+  $true,
+  number,
+  string,
+  bigInt,
+  arrayBuffer,
+  uint8Array,
+  array,
+  object,
+}
+
+/// Thrown when a value can't be serialized into shared memory, in which case
+/// the message is sent over the port.
+final class _UnsupportedValue implements Exception {
+  const _UnsupportedValue();
+}
+
+/// Serializes protocol messages, which are trees of plain JavaScript objects,
+/// arrays and primitives.
+final class _MessageEncoder {
+  Uint8List _bytes = Uint8List(256);
+  late ByteData _view = ByteData.sublistView(_bytes);
+  var _length = 0;
+
+  final JSArrayBuffer _bigIntBuffer = JSArrayBuffer(8);
+  late final JSDataView _bigIntView = JSDataView(_bigIntBuffer);
+  late final Uint8List _bigIntBytes = _bigIntBuffer.toDart.asUint8List();
+
+  static final _MessageEncoder _instance = _MessageEncoder();
+
+  /// Encodes [message] with a [sequence] number, or returns null if it
+  /// contains values that need a structured clone.
+  ///
+  /// The returned list is only valid until the next call.
+  static Uint8List? tryEncode(int sequence, Message? message) {
+    final encoder = _instance.._length = 0;
+    try {
+      encoder
+        .._uint32(sequence)
+        .._value(message);
+    } on _UnsupportedValue {
+      return null;
+    }
+
+    return Uint8List.sublistView(encoder._bytes, 0, encoder._length);
+  }
+
+  void _reserve(int bytes) {
+    final needed = _length + bytes;
+    if (needed > _bytes.length) {
+      var capacity = _bytes.length * 2;
+      while (capacity < needed) {
+        capacity *= 2;
+      }
+
+      _bytes = Uint8List(capacity)..setRange(0, _length, _bytes);
+      _view = ByteData.sublistView(_bytes);
+    }
+  }
+
+  void _tag(_ValueTag tag) {
+    _reserve(1);
+    _bytes[_length++] = tag.index;
+  }
+
+  void _uint32(int value) {
+    _reserve(4);
+    _view.setUint32(_length, value, Endian.little);
+    _length += 4;
+  }
+
+  void _rawBytes(Uint8List bytes) {
+    _uint32(bytes.length);
+    _reserve(bytes.length);
+    _bytes.setRange(_length, _length + bytes.length, bytes);
+    _length += bytes.length;
+  }
+
+  void _value(JSAny? value) {
+    if (value.isUndefined) {
+      _tag(_ValueTag.undefined);
+    } else if (value.isNull) {
+      _tag(_ValueTag.$null);
+    } else if (value!.typeofEquals('boolean')) {
+      _tag((value as JSBoolean).toDart ? _ValueTag.$true : _ValueTag.$false);
+    } else if (value.typeofEquals('number')) {
+      _tag(_ValueTag.number);
+      _reserve(8);
+      _view.setFloat64(
+        _length,
+        (value as JSNumber).toDartDouble,
+        Endian.little,
+      );
+      _length += 8;
+    } else if (value.typeofEquals('string')) {
+      _tag(_ValueTag.string);
+      _rawBytes(utf8.encode((value as JSString).toDart));
+    } else if (value.typeofEquals('bigint')) {
+      _tag(_ValueTag.bigInt);
+      _bigIntView.setBigInt64(0, value as JSBigInt, true);
+      _reserve(8);
+      _bytes.setRange(_length, _length + 8, _bigIntBytes);
+      _length += 8;
+    } else if (value.instanceOfString('ArrayBuffer')) {
+      _tag(_ValueTag.arrayBuffer);
+      _rawBytes((value as JSArrayBuffer).toDart.asUint8List());
+    } else if (value.instanceOfString('Uint8Array')) {
+      _tag(_ValueTag.uint8Array);
+      _rawBytes((value as JSUint8Array).toDart);
+    } else if (_isArray(value)) {
+      final array = (value as JSArray<JSAny?>).toDart;
+      _tag(_ValueTag.array);
+      _uint32(array.length);
+      for (final element in array) {
+        _value(element);
+      }
+    } else if (value.typeofEquals('object') &&
+        _isPlainObject(value as JSObject)) {
+      final keys = _objectKeys(value).toDart;
+      _tag(_ValueTag.object);
+      _uint32(keys.length);
+      for (final key in keys) {
+        _rawBytes(utf8.encode(key.toDart));
+        _value(value[key.toDart]);
+      }
+    } else {
+      // Message ports, errors and other objects need a structured clone.
+      throw const _UnsupportedValue();
+    }
+  }
+
+  static bool _isPlainObject(JSObject object) {
+    final prototype = _prototypeOf(object);
+    return prototype == null || prototype.strictEquals(_objectPrototype).toDart;
+  }
+}
+
+final class _MessageDecoder {
+  final Uint8List _bytes;
+  final ByteData _view;
+  var _offset = 0;
+
+  _MessageDecoder(this._bytes) : _view = ByteData.sublistView(_bytes);
+
+  (int, Message?) decodeFrame() {
+    final sequence = _uint32();
+    return (sequence, _value() as Message?);
+  }
+
+  int _uint32() {
+    final value = _view.getUint32(_offset, Endian.little);
+    _offset += 4;
+    return value;
+  }
+
+  Uint8List _rawBytes() {
+    final length = _uint32();
+    final bytes = Uint8List.sublistView(_bytes, _offset, _offset + length);
+    _offset += length;
+    return bytes;
+  }
+
+  JSAny? _value() {
+    final tag = _ValueTag.values[_bytes[_offset++]];
+    switch (tag) {
+      case _ValueTag.undefined:
+        return null;
+      case _ValueTag.$null:
+        return null;
+      case _ValueTag.$false:
+        return false.toJS;
+      case _ValueTag.$true:
+        return true.toJS;
+      case _ValueTag.number:
+        final value = _view.getFloat64(_offset, Endian.little);
+        _offset += 8;
+        return value.toJS;
+      case _ValueTag.string:
+        return utf8.decode(_rawBytes()).toJS;
+      case _ValueTag.bigInt:
+        final buffer = JSArrayBuffer(8);
+        JSUint8Array(buffer).toDart.setRange(0, 8, _bytes, _offset);
+        _offset += 8;
+        return JSDataView(buffer).getBigInt64(0, true);
+      case _ValueTag.arrayBuffer:
+        // Copy, so that receivers can transfer the buffer again.
+        return Uint8List.fromList(_rawBytes()).buffer.toJS;
+      case _ValueTag.uint8Array:
+        return Uint8List.fromList(_rawBytes()).toJS;
+      case _ValueTag.array:
+        final length = _uint32();
+        final array = JSArray<JSAny?>.withLength(length);
+        for (var i = 0; i < length; i++) {
+          array[i] = _value();
+        }
+        return array;
+      case _ValueTag.object:
+        final length = _uint32();
+        final object = JSObject();
+        for (var i = 0; i < length; i++) {
+          final key = utf8.decode(_rawBytes());
+          object[key] = _value();
+        }
+        return object;
+    }
+  }
+}
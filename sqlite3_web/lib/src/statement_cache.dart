@@ -53,3 +53,73 @@ final class PreparedStatementCache {
     _cachedStatements.clear();
   }
 }
+
+/// Statements prepared by a client with explicit prepare requests.
+///
+/// Handles stay valid until they're finalized, but only the [size] most
+/// recently used handles keep a prepared statement. Other handles only keep
+/// their SQL, and are prepared again the next time they're used.
+final class PreparedStatementHandles {
+  /// The maximum amount of statements to keep prepared.
+  final int size;
+
+  final Map<int, String> _sql = {};
+  // Like in the PreparedStatementCache, the first entry is the least recently
+  // used one.
+  final LinkedHashMap<int, CommonPreparedStatement> _prepared =
+      LinkedHashMap();
+  var _nextId = 1;
+
+  PreparedStatementHandles({required this.size}) : assert(size > 0);
+
+  /// Registers a new handle for the [statement] and returns its id.
+  int add(CommonPreparedStatement statement) {
+    final id = _nextId++;
+    _sql[id] = statement.sql;
+    _insert(id, statement);
+    return id;
+  }
+
+  /// Returns the statement for the handle [id], preparing it again in [db] if
+  /// it has been evicted.
+  CommonPreparedStatement use(int id, CommonDatabase db) {
+    if (_prepared.remove(id) case final statement?) {
+      _prepared[id] = statement;
+      return statement;
+    }
+
+    final sql = _sql[id];
+    if (sql == null) {
+      throw StateError('Prepared statement $id has been finalized.');
+    }
+
+    final statement = db.prepare(sql, checkNoTail: true);
+    _insert(id, statement);
+    return statement;
+  }
+
+  void _insert(int id, CommonPreparedStatement statement) {
+    if (_prepared.length == size) {
+      final lru = _prepared.remove(_prepared.keys.first)!;
+      lru.close();
+    }
+
+    _prepared[id] = statement;
+  }
+
+  /// Closes the statement for handle [id], which can't be used afterwards.
+  void finalize(int id) {
+    _sql.remove(id);
+    _prepared.remove(id)?.close();
+  }
+
+  /// Finalizes all handles.
+  void disposeAll() {
+    for (final statement in _prepared.values) {
+      statement.close();
+    }
+
+    _prepared.clear();
+    _sql.clear();
+  }
+}
@@ -3,6 +3,7 @@ library;
 
 import 'dart:typed_data';
 import 'package:sqlite3/common.dart';
+import 'package:sqlite3/wasm.dart' show DurabilityPolicy, FlushStatistics;
 
 /// A [StorageMode], name pair representing an existing database already stored
 /// by the current browsing context.
@@ -178,7 +179,14 @@ abstract class FileSystem {
 
   /// If the file system hosting the database in the worker is not synchronous,
   /// flushes pending writes.
+  ///
+  /// For OPFS databases opened with a [DurabilityPolicy] deferring flushes,
+  /// this flushes files synced since the last flush.
   Future<void> flush();
+
+  /// Returns how often the file system has flushed files, or `null` if it
+  /// doesn't track flushes (only OPFS file systems do).
+  Future<FlushStatistics?> flushStatistics();
 }
 
 /// An enumeration of features not supported by the current browsers.
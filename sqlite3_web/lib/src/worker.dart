@@ -49,8 +49,160 @@ class _StreamState {
   }
 }
 
+/// A statement opened through an [OpenCursor] request.
+final class _Cursor {
+  /// The lock this cursor is bound to.
+  final int lockId;
+  final CommonPreparedStatement statement;
+
+  _Cursor(this.lockId, this.statement);
+}
+
+/// Collects the tables written while running a request, so that clients can
+/// evict cached results reading from them.
+final class _WrittenTables {
+  final CommonDatabase _db;
+  final Set<String> _tables = {};
+  late final StreamSubscription<SqliteUpdate> _updates;
+  var _updateCount = 0;
+
+  final (int, int) _countersBefore;
+
+  _WrittenTables(this._db) : _countersBefore = _changeCounters(_db) {
+    _updates = _db.updatesSync.listen((update) {
+      _updateCount++;
+      _tables.add(update.tableName);
+    });
+  }
+
+  /// Returns the total amount of changed rows and the schema version.
+  static (int, int) _changeCounters(CommonDatabase db) {
+    int single(String sql) => db.select(sql).single.columnAt(0) as int;
+
+    return (
+      single('SELECT total_changes()'),
+      // Temporary tables have their own schema cookie.
+      single('PRAGMA schema_version') + single('PRAGMA temp.schema_version'),
+    );
+  }
+
+  /// Returns the written tables.
+  ///
+  /// The update hook doesn't report schema changes or rows deleted with the
+  /// truncate optimization. In those cases, this returns null.
+  JSArray<JSString>? finish() {
+    final (changesBefore, schemaBefore) = _countersBefore;
+    final (changes, schema) = _changeCounters(_db);
+    // total_changes() doesn't count rows changed by triggers, so it can only
+    // exceed the amount of reported updates if some of them are missing.
+    if (schema != schemaBefore || changes - changesBefore > _updateCount) {
+      return null;
+    }
+
+    return [for (final table in _tables) table.toJS].toJS;
+  }
+
+  void close() {
+    _updates.cancel();
+  }
+}
+
+/// A query registered by one or more clients with a [WatchQuery] request.
+final class _LiveQuery {
+  final String sql;
+  final DecodedTypedValues parameters;
+
+  /// Tables read by this query, which trigger a re-evaluation when they
+  /// change.
+  ///
+  /// If this is null, the query is evaluated again after every change.
+  final Set<String>? tables;
+
+  /// Clients watching this query, along with the [WatchQuery.watchId] they've
+  /// chosen.
+  final Set<(_ConnectionDatabase, int)> subscribers = {};
+
+  JSArray<JSString> columnNames;
+  ColumnarRows rows;
+
+  _LiveQuery(this.sql, this.parameters, this.tables, RowsResponse initial)
+    : columnNames = initial.columnNames ?? JSArray(),
+      rows = ColumnarRows(initial.columnData!);
+
+  /// Stores a new result and sends the rows that have changed to subscribers.
+  void update(RowsResponse response) {
+    final previous = rows;
+    final next = rows = ColumnarRows(response.columnData!);
+    columnNames = response.columnNames ?? JSArray();
+
+    if (previous.columnCount != next.columnCount) {
+      for (final subscriber in subscribers) {
+        _sendDiff(subscriber, 0, previous.length, 0, next.length);
+      }
+      return;
+    }
+
+    // Skip unchanged rows at the start and end of the result, the rows in
+    // between are replaced.
+    var start = 0;
+    while (start < previous.length &&
+        start < next.length &&
+        previous.rowEquals(start, next, start)) {
+      start++;
+    }
+
+    var previousEnd = previous.length;
+    var nextEnd = next.length;
+    while (previousEnd > start &&
+        nextEnd > start &&
+        previous.rowEquals(previousEnd - 1, next, nextEnd - 1)) {
+      previousEnd--;
+      nextEnd--;
+    }
+
+    if (previousEnd == start && nextEnd == start) {
+      return;
+    }
+
+    for (final subscriber in subscribers) {
+      _sendDiff(subscriber, start, previousEnd - start, start, nextEnd);
+    }
+  }
+
+  void sendInitialRows((_ConnectionDatabase, int) subscriber) {
+    _sendDiff(subscriber, 0, 0, 0, rows.length);
+  }
+
+  void _sendDiff(
+    (_ConnectionDatabase, int) subscriber,
+    int diffStart,
+    int removedRows,
+    int from,
+    int to,
+  ) {
+    // Each subscriber gets its own buffer since it's transferred.
+    final writer = ColumnarRowsWriter(rows.columnCount);
+    for (var i = from; i < to; i++) {
+      writer.copyRow(rows, i);
+    }
+
+    final (connection, watchId) = subscriber;
+    connection.client.sendNotification(
+      newQueryDiffNotification(
+        watchId: watchId,
+        diffStart: diffStart,
+        removedRows: removedRows,
+        columnNames: columnNames,
+        columnData: writer.take(),
+        databaseId: connection.id,
+      ),
+    );
+  }
+}
+
 /// A database opened by a client.
 final class _ConnectionDatabase {
+  final _ClientConnection client;
   final DatabaseState database;
   final int id;
 
@@ -64,7 +216,22 @@ final class _ConnectionDatabase {
   int _nextLockId = 1;
   final List<AbortController> _activeAbortableOperations = [];
 
-  _ConnectionDatabase(this.database, [int? id]) : id = id ?? database.id;
+  /// Statements prepared by this client, which are finalized when the client
+  /// disconnects.
+  final PreparedStatementHandles statements = PreparedStatementHandles(
+    size: maxPreparedStatements,
+  );
+
+  /// Cursors opened in the context of [_heldLock].
+  final Map<int, _Cursor> _cursors = {};
+  int _nextCursorId = 1;
+
+  _ConnectionDatabase(this.client, this.database, [int? id])
+    : id = id ?? database.id;
+
+  /// The amount of statements from [statements] kept prepared for each
+  /// connection.
+  static const maxPreparedStatements = 32;
 
   Future<void> close() async {
     updates.cancel();
@@ -76,6 +243,9 @@ final class _ConnectionDatabase {
     }
     _activeAbortableOperations.clear();
 
+    _closeCursors();
+    statements.disposeAll();
+    database.unwatchAll(this);
     _heldLock?.$2.complete();
     await database.decrementRefCount();
   }
@@ -155,9 +325,37 @@ final class _ConnectionDatabase {
       throw StateError('Lock to be released is not active.');
     }
 
+    _closeCursors();
     _heldLock!.$2.complete();
     _heldLock = null;
   }
+
+  int openCursor(int lockId, CommonPreparedStatement statement) {
+    final id = _nextCursorId++;
+    _cursors[id] = _Cursor(lockId, statement);
+    return id;
+  }
+
+  _Cursor cursorById(int id) {
+    if (_cursors[id] case final cursor?) {
+      return cursor;
+    }
+
+    throw StateError('Cursor $id does not exist or has been closed.');
+  }
+
+  void closeCursor(int id) {
+    _cursors.remove(id)?.statement.close();
+  }
+
+  /// Closes all cursors, which must happen before the lock they're bound to is
+  /// released.
+  void _closeCursors() {
+    for (final cursor in _cursors.values) {
+      cursor.statement.close();
+    }
+    _cursors.clear();
+  }
 }
 
 final class _ClientConnection extends ProtocolChannel
@@ -287,11 +485,15 @@ final class _ClientConnection extends ProtocolChannel
           FileSystemImplementation.fromJS(request.storageMode),
           request.preparedStatementCacheSize,
           request.additionalData,
+          DurabilityPolicy.fromFlushDelay(switch (request.flushDelayMs) {
+            null => null,
+            final ms => Duration(milliseconds: ms),
+          }),
         );
 
         await (request.onlyOpenVfs ? database.vfs : database.opened);
 
-        connectionDatabase = _ConnectionDatabase(database);
+        connectionDatabase = _ConnectionDatabase(this, database);
         _openedDatabases.add(connectionDatabase);
 
         return newSimpleSuccessResponse(
@@ -315,7 +517,6 @@ final class _ClientConnection extends ProtocolChannel
     AbortSignal abortSignal,
   ) async {
     final database = _requireDatabase(request);
-    final state = database.database;
     final openedDatabase = await database.database.opened;
 
     return database.useLock(request.lockId, abortSignal, () {
@@ -329,29 +530,266 @@ final class _ClientConnection extends ProtocolChannel
         request.parameters,
         request.typeVector,
       );
+      final columnar = request.columnarResults ?? false;
+      final writtenTables = (request.reportWrittenTables ?? false)
+          ? _WrittenTables(db)
+          : null;
+      final RowsResponse rowsResponse;
 
-      if (request.returnRows) {
-        final rowsResponse = state.select(db, request.sql, parameters);
-        rowsResponse.requestId = request.requestId;
-        rowsResponse.autoCommit = db.autocommit;
-        rowsResponse.lastInsertRowId = db.lastInsertRowId;
-        return rowsResponse;
-      } else {
-        state.execute(db, request.sql, parameters);
+      try {
+        rowsResponse = _runQuery(request, database, db, parameters, columnar);
+        rowsResponse.writtenTables = writtenTables?.finish();
+      } finally {
+        writtenTables?.close();
+      }
 
-        return newRowsResponse(
+      rowsResponse.requestId = request.requestId;
+      rowsResponse.autoCommit = db.autocommit;
+      rowsResponse.lastInsertRowId = db.lastInsertRowId;
+      return rowsResponse;
+    });
+  }
+
+  RowsResponse _runQuery(
+    RunQuery request,
+    _ConnectionDatabase database,
+    CommonDatabase db,
+    DecodedTypedValues parameters,
+    bool columnar,
+  ) {
+    final state = database.database;
+    RowsResponse? rowsResponse;
+
+    if (request.statementId case final id?) {
+      final stmt = database.statements.use(id, db);
+      try {
+        if (request.returnRows) {
+          rowsResponse = RowsResponseUtils.iterateAndEncodeResults(
+            stmt,
+            parameters,
+            columnar: columnar,
+          );
+        } else {
+          stmt.executeWith(parameters.asParameters);
+        }
+      } finally {
+        stmt.reset();
+      }
+    } else if (request.returnRows) {
+      rowsResponse = state.select(
+        db,
+        request.sql,
+        parameters,
+        columnar: columnar,
+      );
+
+      if (request.reportReadTables ?? false) {
+        if (state._readTables(db, request.sql) case final tables?) {
+          rowsResponse.readTables = [
+            for (final table in tables) table.toJS,
+          ].toJS;
+        }
+      }
+    } else {
+      state.execute(db, request.sql, parameters);
+    }
+
+    return rowsResponse ??
+        newRowsResponse(
           columnNames: null,
           tableNames: null,
           typeVector: null,
           rows: null,
-          autoCommit: db.autocommit,
-          lastInsertRowId: db.lastInsertRowId,
+          columnData: null,
+          readTables: null,
+          writtenTables: null,
+          autoCommit: false,
+          lastInsertRowId: 0,
+          requestId: 0,
+        );
+  }
+
+  @override
+  Future<Response> handlePrepare(
+    PrepareStatement request,
+    AbortSignal abortSignal,
+  ) async {
+    final database = _requireDatabase(request);
+    final openedDatabase = await database.database.opened;
+
+    final id = await database.useLock(request.lockId, abortSignal, () {
+      final stmt = openedDatabase.database.prepare(
+        request.sql,
+        checkNoTail: true,
+      );
+      return database.statements.add(stmt);
+    });
+
+    return newSimpleSuccessResponse(
+      response: id.toJS,
+      requestId: request.requestId,
+    );
+  }
+
+  @override
+  Response handleFinalize(FinalizeStatement request, AbortSignal abortSignal) {
+    final database = _requireDatabase(request);
+    database.statements.finalize(request.statementId);
+    return newSimpleSuccessResponse(
+      response: null,
+      requestId: request.requestId,
+    );
+  }
+
+  @override
+  Future<Response> handleBatch(
+    BatchRequest request,
+    AbortSignal abortSignal,
+  ) async {
+    final database = _requireDatabase(request);
+    final state = database.database;
+    final openedDatabase = await state.opened;
+
+    return database.useLock(request.lockId, abortSignal, () {
+      final db = openedDatabase.database;
+      final statements = request.statements.toDart;
+      final parameters = request.parameters.toDart;
+      final types = request.typeVector.toDart.asUint8List();
+      final results = JSArray<RowsResponse>.withLength(statements.length);
+
+      void runStatements() {
+        var typeOffset = 0;
+        for (var i = 0; i < statements.length; i++) {
+          if (abortSignal.aborted) {
+            throw const AbortException();
+          }
+
+          final itemParameters = parameters[i];
+          final typesStart = typeOffset;
+          typeOffset += itemParameters.length;
+          final itemTypes = types.sublist(typesStart, typeOffset);
+
+          final result = state.select(
+            db,
+            statements[i].toDart,
+            TypeCode.decodeValues(itemParameters, itemTypes.buffer.toJS),
+            columnar: true,
+          );
+          result.autoCommit = db.autocommit;
+          result.lastInsertRowId = db.lastInsertRowId;
+          results[i] = result;
+        }
+      }
+
+      final writtenTables = (request.reportWrittenTables ?? false)
+          ? _WrittenTables(db)
+          : null;
+      try {
+        if (request.transaction) {
+          // Using a savepoint allows batches to run in an outer transaction.
+          db.execute('SAVEPOINT pkg_sqlite3_web_batch');
+          try {
+            runStatements();
+          } catch (_) {
+            // Some errors (or a ROLLBACK statement in the batch) end the
+            // transaction, which also removes the savepoint.
+            if (!db.autocommit) {
+              try {
+                db.execute('ROLLBACK TO pkg_sqlite3_web_batch');
+                db.execute('RELEASE pkg_sqlite3_web_batch');
+              } on SqliteException {
+                // Report the error that caused the rollback instead.
+              }
+            }
+            rethrow;
+          }
+          db.execute('RELEASE pkg_sqlite3_web_batch');
+        } else {
+          runStatements();
+        }
+
+        return newBatchResponse(
+          results: results,
+          writtenTables: writtenTables?.finish(),
           requestId: request.requestId,
         );
+      } finally {
+        writtenTables?.close();
       }
     });
   }
 
+  @override
+  Future<Response> handleOpenCursor(
+    OpenCursor request,
+    AbortSignal abortSignal,
+  ) async {
+    final database = _requireDatabase(request);
+    final openedDatabase = await database.database.opened;
+
+    final cursorId = await database.useLock(request.lockId, abortSignal, () {
+      // Cursors outlive this request, so they can't use statements from the
+      // shared statement cache.
+      final stmt = openedDatabase.database.prepare(
+        request.sql,
+        checkNoTail: true,
+      );
+
+      try {
+        TypeCode.decodeValues(
+          request.parameters,
+          request.typeVector,
+        ).bindAsParameters(stmt);
+      } catch (_) {
+        stmt.close();
+        rethrow;
+      }
+
+      return database.openCursor(request.lockId, stmt);
+    });
+
+    return newSimpleSuccessResponse(
+      response: cursorId.toJS,
+      requestId: request.requestId,
+    );
+  }
+
+  @override
+  Future<Response> handleFetchCursor(
+    FetchCursor request,
+    AbortSignal abortSignal,
+  ) async {
+    final database = _requireDatabase(request);
+    final cursor = database.cursorById(request.cursorId);
+    final openedDatabase = await database.database.opened;
+
+    return database.useLock(cursor.lockId, abortSignal, () {
+      final db = openedDatabase.database;
+      final (response, exhausted) = RowsResponseUtils.encodeNextRows(
+        cursor.statement,
+        request.rowCount,
+      );
+      if (exhausted) {
+        database.closeCursor(request.cursorId);
+      }
+
+      response.requestId = request.requestId;
+      response.autoCommit = db.autocommit;
+      response.lastInsertRowId = db.lastInsertRowId;
+      return response;
+    });
+  }
+
+  @override
+  Response handleCloseCursor(CloseCursor request, AbortSignal abortSignal) {
+    final database = _requireDatabase(request);
+    database.closeCursor(request.cursorId);
+    return newSimpleSuccessResponse(
+      response: null,
+      requestId: request.requestId,
+    );
+  }
+
   @override
   Future<Response> handleExclusiveLock(
     RequestExclusiveLock request,
@@ -451,6 +889,44 @@ final class _ClientConnection extends ProtocolChannel
     }
   }
 
+  @override
+  Future<Response> handleWatch(
+    WatchQuery request,
+    AbortSignal abortSignal,
+  ) async {
+    final database = _requireDatabase(request);
+    final openedDatabase = await database.database.opened;
+    final parameters = TypeCode.decodeValues(
+      request.parameters,
+      request.typeVector,
+    );
+
+    await database.useLock(request.lockId, abortSignal, () {
+      database.database.watch(
+        openedDatabase.database,
+        (database, request.watchId),
+        request.sql,
+        parameters,
+      );
+    });
+
+    return newSimpleSuccessResponse(
+      response: null,
+      requestId: request.requestId,
+    );
+  }
+
+  @override
+  Response handleUnwatch(UnwatchQuery request, AbortSignal abortSignal) {
+    final database = _requireDatabase(request);
+    database.database.unwatch((database, request.watchId));
+
+    return newSimpleSuccessResponse(
+      response: null,
+      requestId: request.requestId,
+    );
+  }
+
   @override
   Future<Response> handleOpenAdditionalConnection(
     OpenAdditionalConnection request,
@@ -461,7 +937,7 @@ final class _ClientConnection extends ProtocolChannel
     final (endpoint, channel) = await createChannel();
 
     final client = _runner._accept(channel);
-    client._openedDatabases.add(_ConnectionDatabase(database, 0));
+    client._openedDatabases.add(_ConnectionDatabase(client, database, 0));
 
     return newEndpointResponse(
       requestId: request.requestId,
@@ -488,9 +964,11 @@ final class _ClientConnection extends ProtocolChannel
     FileSystemFlushRequest request,
     AbortSignal abortSignal,
   ) async {
-    if (await _requireDatabase(request).database.vfs
-        case IndexedDbFileSystem idb) {
-      await idb.flush();
+    switch (await _requireDatabase(request).database.vfs) {
+      case IndexedDbFileSystem idb:
+        await idb.flush();
+      case SimpleOpfsFileSystem opfs:
+        opfs.flush();
     }
 
     return newSimpleSuccessResponse(
@@ -499,6 +977,28 @@ final class _ClientConnection extends ProtocolChannel
     );
   }
 
+  @override
+  Future<Response> handleFileSystemStatistics(
+    FileSystemStatisticsRequest request,
+    AbortSignal abortSignal,
+  ) async {
+    JSArray<JSNumber>? response;
+    if (await _requireDatabase(request).database.vfs
+        case SimpleOpfsFileSystem opfs) {
+      final statistics = opfs.flushStatistics;
+      response = [
+        statistics.syncs.toJS,
+        statistics.flushes.toJS,
+        statistics.flushTime.inMicroseconds.toJS,
+      ].toJS;
+    }
+
+    return newSimpleSuccessResponse(
+      response: response,
+      requestId: request.requestId,
+    );
+  }
+
   @override
   Future<Response> handleFileSystemAccess(
     FileSystemAccess request,
@@ -616,6 +1116,9 @@ final class DatabaseState {
   final String name;
   final FileSystemImplementation mode;
   final JSAny? additionalOptions;
+
+  /// When OPFS file systems flush files synced by sqlite3.
+  final DurabilityPolicy durability;
   final DatabaseLocks locks;
   final PreparedStatementCache? statementCache;
   int refCount = 1;
@@ -628,12 +1131,24 @@ final class DatabaseState {
   /// the database is closed.
   FutureOr<void> Function()? closeHandler;
 
+  /// Queries registered with [WatchQuery] requests, keyed by their SQL and
+  /// parameters so that clients watching the same query share a single
+  /// evaluation.
+  final Map<String, _LiveQuery> _liveQueries = {};
+  final _StreamState _liveQueryUpdates = _StreamState();
+  final _StreamState _liveQueryCommits = _StreamState();
+
+  /// Tables changed since live queries have last been evaluated.
+  final Set<String> _changedTables = {};
+  var _liveQueryRefreshScheduled = false;
+
   DatabaseState({
     required this.id,
     required this.runner,
     required this.name,
     required this.mode,
     required this.additionalOptions,
+    required this.durability,
     required int statementCacheSize,
   }) : locks = DatabaseLocks('pkg-sqlite3-web-$name', mode.needsExternalLocks),
        assert(statementCacheSize >= 0),
@@ -651,6 +1166,7 @@ final class DatabaseState {
               await SimpleOpfsFileSystem.loadFromStorage(
                 pathForOpfs(name),
                 vfsName: vfsName,
+                durability: durability,
               );
           closeHandler = simple.close;
         case FileSystemImplementation.opfsExternalLocks:
@@ -659,6 +1175,7 @@ final class DatabaseState {
             path: pathForOpfs(name),
             vfsName: vfsName,
             readWriteUnsafe: mode == .opfsExternalLocks,
+            durability: durability,
           );
           locks.attachVfs(state);
 
@@ -710,6 +1227,10 @@ final class DatabaseState {
   }
 
   Future<void> close() async {
+    _liveQueries.clear();
+    _liveQueryUpdates.cancel();
+    _liveQueryCommits.cancel();
+
     final sqlite3 = await runner._sqlite3!;
     if (_database case final dbFuture?) {
       final database = await dbFuture;
@@ -725,6 +1246,187 @@ final class DatabaseState {
     unawaited(locks.releaseNavigatorLocks());
   }
 
+  /// Adds [subscriber] to the live query for [sql] and [parameters], creating
+  /// it if no other client is watching it yet.
+  ///
+  /// This must be called while holding a lock on the database.
+  void watch(
+    CommonDatabase db,
+    (_ConnectionDatabase, int) subscriber,
+    String sql,
+    DecodedTypedValues parameters,
+  ) {
+    final key = queryKey(sql, parameters);
+    final query = _liveQueries[key] ??= _LiveQuery(
+      sql,
+      parameters,
+      _readTables(db, sql),
+      select(db, sql, parameters, columnar: true),
+    );
+
+    query.subscribers.add(subscriber);
+    query.sendInitialRows(subscriber);
+
+    _liveQueryUpdates.subscription ??= db.updates.listen((update) {
+      _changedTables.add(update.tableName);
+      _scheduleLiveQueryRefresh(db);
+    });
+    // Changes made in a transaction are only visible to live queries once the
+    // transaction completes.
+    _liveQueryCommits.subscription ??= db.commits.listen((_) {
+      _scheduleLiveQueryRefresh(db);
+    });
+  }
+
+  void unwatch((_ConnectionDatabase, int) subscriber) {
+    _removeLiveQuerySubscribers((s) => s == subscriber);
+  }
+
+  void unwatchAll(_ConnectionDatabase connection) {
+    _removeLiveQuerySubscribers((s) => s.$1 == connection);
+  }
+
+  void _removeLiveQuerySubscribers(
+    bool Function((_ConnectionDatabase, int)) test,
+  ) {
+    _liveQueries.removeWhere((_, query) {
+      query.subscribers.removeWhere(test);
+      return query.subscribers.isEmpty;
+    });
+
+    if (_liveQueries.isEmpty) {
+      _liveQueryUpdates.cancel();
+      _liveQueryCommits.cancel();
+      _changedTables.clear();
+    }
+  }
+
+  void _scheduleLiveQueryRefresh(CommonDatabase db) {
+    if (_liveQueryRefreshScheduled || _changedTables.isEmpty) {
+      return;
+    }
+
+    _liveQueryRefreshScheduled = true;
+    unawaited(locks.lock(() {
+      _liveQueryRefreshScheduled = false;
+      if (!db.autocommit) {
+        // A client is in a transaction, we'll refresh after it commits.
+        return;
+      }
+
+      final changed = {..._changedTables};
+      _changedTables.clear();
+
+      for (final query in [..._liveQueries.values]) {
+        if (query.tables case final tables?
+            when !tables.any(changed.contains)) {
+          continue;
+        }
+
+        try {
+          query.update(
+            select(db, query.sql, query.parameters, columnar: true),
+          );
+        } on SqliteException {
+          // The query may have become invalid after a schema change. Keep
+          // it registered, it's evaluated again after the next change.
+        }
+      }
+    }, null));
+  }
+
+  /// Finds the tables (or the tables of indexes) that [sql] reads from, by
+  /// looking at the `OpenRead` instructions in its bytecode.
+  ///
+  /// Returns null if the results of [sql] may change without one of these
+  /// tables being updated, or if the tables can't be determined reliably.
+  /// That is the case for statements writing to the database, statements
+  /// reading from virtual tables or attached databases and statements calling
+  /// non-deterministic functions.
+  Set<String>? _readTables(CommonDatabase db, String sql) {
+    final (stmt, isCached) = _prepareStatement(db, sql);
+    final isReadOnly = stmt.isReadOnly;
+    if (!isCached) {
+      stmt.close();
+    }
+    if (!isReadOnly) {
+      return null;
+    }
+
+    final rootPages = <(int, int)>{};
+    final functions = <String>{};
+    for (final row in db.select('EXPLAIN $sql')) {
+      switch (row['opcode']) {
+        case 'OpenRead':
+          rootPages.add((row['p3'] as int, row['p2'] as int));
+        case 'VOpen':
+          return null;
+        case 'Function' || 'PureFunc':
+          // The name is formatted as `name(argCount)`.
+          final name = row['p4'] as String;
+          functions.add(name.substring(0, name.indexOf('(')).toLowerCase());
+      }
+    }
+
+    for (final function in functions) {
+      if (_timeFunctions.contains(function)) {
+        // These are marked as deterministic, but depend on the current time
+        // when called with 'now'.
+        return null;
+      }
+
+      final nonDeterministic = db.select(
+        'SELECT 1 FROM pragma_function_list '
+        'WHERE name = ? COLLATE NOCASE AND flags & ? = 0',
+        [function, _sqliteDeterministic],
+      );
+      if (nonDeterministic.isNotEmpty) {
+        return null;
+      }
+    }
+
+    final tables = <String>{};
+    for (final (schema, rootPage) in rootPages) {
+      final schemaTable = switch (schema) {
+        0 => 'main.sqlite_schema',
+        1 => 'temp.sqlite_schema',
+        // Attached databases are not supported by this package.
+        _ => null,
+      };
+      if (schemaTable == null) return null;
+
+      final result = db.select(
+        'SELECT tbl_name FROM $schemaTable WHERE rootpage = ?',
+        [rootPage],
+      );
+      if (result.isEmpty) {
+        // Probably a read from the schema table itself.
+        return null;
+      }
+      for (final row in result) {
+        tables.add(row.columnAt(0) as String);
+      }
+    }
+
+    return tables;
+  }
+
+  /// The `SQLITE_DETERMINISTIC` flag reported by `pragma_function_list`.
+  static const _sqliteDeterministic = 0x800;
+
+  static const _timeFunctions = {
+    'date',
+    'time',
+    'datetime',
+    'julianday',
+    'unixepoch',
+    'strftime',
+    'timediff',
+    'current_date',
+    'current_time',
+    'current_timestamp',
+  };
+
   /// Returns a prepared statement for [sql] and reports whether this statement
   /// was cached.
   (CommonPreparedStatement, bool) _prepareStatement(
@@ -769,11 +1471,16 @@ final class DatabaseState {
   RowsResponse select(
     CommonDatabase db,
     String sql,
-    DecodedTypedValues parameters,
-  ) {
+    DecodedTypedValues parameters, {
+    bool columnar = false,
+  }) {
     final (stmt, isCached) = _prepareStatement(db, sql);
     try {
-      return RowsResponseUtils.iterateAndEncodeResults(stmt, parameters);
+      return RowsResponseUtils.iterateAndEncodeResults(
+        stmt,
+        parameters,
+        columnar: columnar,
+      );
     } finally {
       if (isCached) {
         stmt.reset();
@@ -937,6 +1644,7 @@ final class WorkerRunner {
     FileSystemImplementation mode,
     int cacheSize,
     JSAny? additionalOptions,
+    DurabilityPolicy durability,
   ) {
     for (final existing in openedDatabases.values) {
       if (existing.refCount != 0 &&
@@ -954,6 +1662,7 @@ final class WorkerRunner {
       name: name,
       mode: mode,
       additionalOptions: additionalOptions,
+      durability: durability,
       statementCacheSize: cacheSize,
     );
   }
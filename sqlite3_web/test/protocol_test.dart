@@ -2,13 +2,16 @@
 library;
 
 import 'dart:async';
+import 'dart:convert';
 import 'dart:js_interop';
 import 'dart:typed_data';
 
 import 'package:sqlite3/common.dart';
+import 'package:sqlite3/src/wasm/js_interop/core.dart';
 import 'package:sqlite3_web/sqlite3_web.dart';
 import 'package:sqlite3_web/src/channel.dart';
 import 'package:sqlite3_web/src/protocol.dart';
+import 'package:sqlite3_web/src/shared_memory_channel.dart';
 import 'package:test/test.dart';
 import 'package:web/src/dom/dom.dart';
 
@@ -81,6 +84,10 @@ void main() {
         databaseId: 0,
         sql: 'sql',
         checkInTransaction: false,
+        columnarResults: null,
+        statementId: null,
+        reportReadTables: null,
+        reportWrittenTables: null,
         lockId: null,
         parameters: serializedParams,
         typeVector: typeVector,
@@ -119,6 +126,10 @@ void main() {
         typeVector: JSArrayBuffer(0),
         returnRows: true,
         checkInTransaction: false,
+        columnarResults: null,
+        statementId: null,
+        reportReadTables: null,
+        reportWrittenTables: null,
       ),
       MessageType.rowsResponse,
     );
@@ -133,6 +144,69 @@ void main() {
     ]);
   });
 
+  test('serializes columnar rows in response', () async {
+    server.handleRequestFunction = expectAsync1((request) async {
+      expect((request as RunQuery).columnarResults, isTrue);
+
+      final writer = ColumnarRowsWriter(2);
+      for (var i = 0; i < 100; i++) {
+        writer
+          ..addRow()
+          ..writeNumber(0, TypeCode.integer, i.toDouble())
+          ..writeBytes(1, TypeCode.text, utf8.encode('row $i'));
+      }
+      writer
+        ..addRow()
+        ..writeNumber(0, TypeCode.float, 1.0)
+        ..writeBytes(1, TypeCode.blob, Uint8List(10))
+        ..addRow()
+        ..writeBigInt(0, JsBigInt.fromInt(1))
+        ..writeNull(1);
+
+      return newRowsResponse(
+        columnNames: ['a'.toJS, 'b'.toJS].toJS,
+        tableNames: null,
+        typeVector: null,
+        rows: null,
+        columnData: writer.take(),
+        readTables: null,
+        writtenTables: null,
+        autoCommit: false,
+        lastInsertRowId: 0,
+        requestId: request.requestId,
+      );
+    });
+
+    final response = await client.sendRequest(
+      newRunQuery(
+        requestId: 0,
+        databaseId: 0,
+        sql: 'sql',
+        lockId: null,
+        parameters: JSArray(),
+        typeVector: JSArrayBuffer(0),
+        returnRows: true,
+        checkInTransaction: false,
+        columnarResults: true,
+        statementId: null,
+        reportReadTables: null,
+        reportWrittenTables: null,
+      ),
+      MessageType.rowsResponse,
+    );
+    final resultSet = response.readResultSet()!;
+
+    expect(resultSet.length, 102);
+    expect(resultSet[42], {'a': 42, 'b': 'row 42'});
+    expect(resultSet[100]['a'], 1.0);
+    expect(resultSet[100]['b'], Uint8List(10));
+    expect(resultSet[101], {'a': isDart2Wasm ? 1 : BigInt.one, 'b': null});
+    if (isDart2Wasm) {
+      expect(resultSet[0]['a'].runtimeType, int);
+      expect(resultSet[100]['a'].runtimeType, double);
+    }
+  });
+
   test('can serialize SqliteExceptions', () async {
     server.handleRequestFunction = expectAsync1((req) {
       throw SqliteException(
@@ -157,6 +231,10 @@ void main() {
           typeVector: JSArrayBuffer(0),
           returnRows: true,
           checkInTransaction: false,
+          columnarResults: null,
+          statementId: null,
+          reportReadTables: null,
+          reportWrittenTables: null,
         ),
         MessageType.rowsResponse,
       ),
@@ -185,6 +263,91 @@ void main() {
     );
   });
 
+  test(
+    'keeps messages ordered over shared memory',
+    () async {
+      final (endpoint, channel) = await createChannel(useSharedMemory: true);
+      expect(endpoint.sharedMemory, isNotNull);
+
+      final sharedServer = TestServer(channel);
+      final sharedClient = TestClient(endpoint.connect());
+      addTearDown(() async {
+        await sharedServer.close();
+        await sharedClient.close();
+      });
+
+      final received = <int>[];
+      sharedServer.handleRequestFunction = (request) async {
+        final sql = (request as RunQuery).sql;
+        received.add(sql.length);
+        return newSimpleSuccessResponse(
+          requestId: request.requestId,
+          response: sql.length.toJS,
+        );
+      };
+
+      // The large statement doesn't fit into the ring buffer and is sent over
+      // the message port instead.
+      final lengths = [for (var i = 1; i < 10; i++) i == 5 ? 1024 * 1024 : i];
+      final responses = await Future.wait([
+        for (final length in lengths)
+          sharedClient.sendRequest(
+            newRunQuery(
+              requestId: 0,
+              databaseId: 0,
+              sql: 'x' * length,
+              checkInTransaction: false,
+              columnarResults: null,
+              statementId: null,
+              reportReadTables: null,
+              reportWrittenTables: null,
+              lockId: null,
+              parameters: [1.toJS, 'a'.toJS, Uint8List(3).toJS].toJS,
+              typeVector: JSArrayBuffer(3),
+              returnRows: false,
+            ),
+            MessageType.simpleSuccessResponse,
+          ),
+      ]);
+
+      expect(received, lengths);
+      expect(
+        [for (final r in responses) (r.response as JSNumber).toDartInt],
+        lengths,
+      );
+    },
+    skip: SharedMemoryChannel.isSupported
+        ? false
+        : 'Requires a cross-origin isolated context',
+  );
+
+  test(
+    'delivers messages sent before closing over shared memory',
+    () async {
+      final (endpoint, channel) = await createChannel(useSharedMemory: true);
+      final sharedServer = TestServer(channel);
+      final sharedClient = TestClient(endpoint.connect());
+      addTearDown(sharedServer.close);
+
+      final received = <int>[];
+      sharedServer.notification.listen((notification) {
+        received.add(notification.databaseId);
+      });
+
+      for (var i = 0; i < 10; i++) {
+        sharedClient.sendNotification(newCommitNotification(databaseId: i));
+      }
+      await sharedClient.close();
+      await sharedServer.closed;
+      await pumpEventQueue();
+
+      expect(received, [for (var i = 0; i < 10; i++) i]);
+    },
+    skip: SharedMemoryChannel.isSupported
+        ? false
+        : 'Requires a cross-origin isolated context',
+  );
+
   test('propagate close', () async {
     await server.close();
     // Closing the server should close the client.
@@ -218,6 +381,10 @@ void main() {
           databaseId: 0,
           sql: 'sql',
           checkInTransaction: false,
+          columnarResults: null,
+          statementId: null,
+          reportReadTables: null,
+          reportWrittenTables: null,
           lockId: null,
           parameters: JSArray(),
           typeVector: JSArrayBuffer(0),
@@ -38,13 +38,19 @@ void main() {
 
   Future<RemoteDatabase> requestDatabase(
     String name,
-    DatabaseImplementation implementation,
-  ) async {
+    DatabaseImplementation implementation, {
+    QueryCacheOptions? queryCache,
+  }) async {
     final client = WebSqlite.open(
       workers: _FakeWorkerConnector(fakeWorkers),
       wasmModule: sqlite3WasmUri,
     );
-    return (await client.connect(name, implementation)) as RemoteDatabase;
+    return (await client.connect(
+          name,
+          implementation,
+          queryCache: queryCache,
+        ))
+        as RemoteDatabase;
   }
 
   test('can open database', () async {
@@ -181,6 +187,402 @@ void main() {
     }
   });
 
+  group('prepared statements', () {
+    late RemoteDatabase database;
+
+    setUp(() async {
+      database = await requestDatabase(
+        'foo',
+        DatabaseImplementation.inMemoryShared,
+      );
+      await database.execute('CREATE TABLE foo (bar INTEGER);');
+    });
+
+    test('can run repeatedly', () async {
+      final insert = await database.prepare('INSERT INTO foo VALUES (?)');
+      for (var i = 0; i < 10; i++) {
+        await insert.execute(parameters: [i]);
+      }
+      await insert.dispose();
+
+      final select = await database.prepare('SELECT sum(bar) AS s FROM foo');
+      expect((await select.select()).result, [
+        {'s': 45},
+      ]);
+      await select.dispose();
+    });
+
+    test('are prepared again after eviction', () async {
+      final statements = [
+        for (var i = 0; i < 40; i++)
+          await database.prepare('SELECT $i AS r'),
+      ];
+
+      for (final (i, statement) in statements.indexed) {
+        expect((await statement.select()).result, [
+          {'r': i},
+        ]);
+      }
+    });
+
+    test('cannot be used after dispose', () async {
+      final statement = await database.prepare('SELECT 1');
+      await statement.dispose();
+
+      expect(() => statement.select(), throwsStateError);
+    });
+  });
+
+  group('batches', () {
+    late RemoteDatabase database;
+
+    setUp(() async {
+      database = await requestDatabase(
+        'foo',
+        DatabaseImplementation.inMemoryShared,
+      );
+      await database.execute('CREATE TABLE foo (bar TEXT UNIQUE);');
+    });
+
+    test('return results for each statement', () async {
+      final results = await database.executeBatch([
+        for (var i = 0; i < 100; i++)
+          ('INSERT INTO foo (bar) VALUES (?)', ['row $i']),
+        ('SELECT count(*) AS c FROM foo', []),
+      ]);
+
+      expect(results, hasLength(101));
+      expect(results[0].result, isEmpty);
+      expect(results[99].lastInsertRowid, 100);
+      expect(results[100].result, [
+        {'c': 100},
+      ]);
+    });
+
+    test('keep previous statements without transaction', () async {
+      await expectLater(
+        database.executeBatch([
+          ('INSERT INTO foo (bar) VALUES (?)', ['a']),
+          ('INSERT INTO foo (bar) VALUES (?)', ['a']),
+        ]),
+        throwsA(isA<RemoteException>()),
+      );
+
+      final result = await database.select('SELECT * FROM foo');
+      expect(result.result, hasLength(1));
+    });
+
+    test('can roll back in transaction', () async {
+      await expectLater(
+        database.executeBatch([
+          ('INSERT INTO foo (bar) VALUES (?)', ['a']),
+          ('INSERT INTO foo (bar) VALUES (?)', ['a']),
+        ], transaction: true),
+        throwsA(isA<RemoteException>()),
+      );
+
+      final result = await database.select('SELECT * FROM foo');
+      expect(result.result, isEmpty);
+      expect(result.autocommit, isTrue);
+    });
+
+    test('report original error if transaction has ended', () async {
+      await expectLater(
+        database.executeBatch([
+          ('INSERT INTO foo (bar) VALUES (?)', ['a']),
+          ('ROLLBACK', []),
+          ('SELECT * FROM does_not_exist', []),
+        ], transaction: true),
+        throwsA(
+          isA<RemoteException>().having(
+            (e) => e.message,
+            'message',
+            contains('no such table'),
+          ),
+        ),
+      );
+
+      final result = await database.select('SELECT * FROM foo');
+      expect(result.result, isEmpty);
+      expect(result.autocommit, isTrue);
+    });
+  });
+
+  group('live queries', () {
+    late RemoteDatabase database;
+
+    setUp(() async {
+      database = await requestDatabase(
+        'foo',
+        DatabaseImplementation.inMemoryShared,
+      );
+      await database.execute('CREATE TABLE foo (bar TEXT);');
+      await database.execute('CREATE TABLE other (bar TEXT);');
+    });
+
+    test('emit initial rows and changes', () async {
+      final rows = StreamIterator(
+        database.watch('SELECT bar FROM foo ORDER BY bar'),
+      );
+      expect(await rows.moveNext(), isTrue);
+      expect(rows.current, isEmpty);
+
+      await database.execute("INSERT INTO foo VALUES ('b')");
+      expect(await rows.moveNext(), isTrue);
+      expect(rows.current, [
+        {'bar': 'b'},
+      ]);
+
+      await database.execute("INSERT INTO foo VALUES ('a'), ('c')");
+      expect(await rows.moveNext(), isTrue);
+      expect(rows.current, [
+        {'bar': 'a'},
+        {'bar': 'b'},
+        {'bar': 'c'},
+      ]);
+
+      await database.execute("DELETE FROM foo WHERE bar = 'b'");
+      expect(await rows.moveNext(), isTrue);
+      expect(rows.current, [
+        {'bar': 'a'},
+        {'bar': 'c'},
+      ]);
+
+      await rows.cancel();
+    });
+
+    test('ignore changes to other tables', () async {
+      final rows = StreamIterator(
+        database.watch('SELECT * FROM foo WHERE bar = ?', parameters: ['x']),
+      );
+      expect(await rows.moveNext(), isTrue);
+
+      await database.execute("INSERT INTO other VALUES ('x')");
+      await database.execute("INSERT INTO foo VALUES ('y')");
+      await database.execute("INSERT INTO foo VALUES ('x')");
+      expect(await rows.moveNext(), isTrue);
+      expect(rows.current, [
+        {'bar': 'x'},
+      ]);
+
+      await rows.cancel();
+    });
+
+    test('re-run on any update if tables are unknown', () async {
+      // random() is non-deterministic, so the result may change without any
+      // table being updated.
+      final rows = StreamIterator(database.watch('SELECT random() AS r'));
+      expect(await rows.moveNext(), isTrue);
+      final initial = rows.current.single['r'];
+
+      await database.execute("INSERT INTO other VALUES ('x')");
+      expect(await rows.moveNext(), isTrue);
+      expect(rows.current.single['r'], isNot(initial));
+
+      await rows.cancel();
+    });
+
+    test('can be started while holding a lock', () async {
+      final rows = await database.requestLock((token) async {
+        await database.execute("INSERT INTO foo VALUES ('a')", token: token);
+
+        final rows = StreamIterator(
+          database.watch('SELECT bar FROM foo', token: token),
+        );
+        expect(await rows.moveNext(), isTrue);
+        expect(rows.current, [
+          {'bar': 'a'},
+        ]);
+        return rows;
+      });
+
+      await rows.cancel();
+    });
+
+    test('are shared between clients', () async {
+      final other = await requestDatabase(
+        'foo',
+        DatabaseImplementation.inMemoryShared,
+      );
+      final a = StreamIterator(database.watch('SELECT count(*) AS c FROM foo'));
+      final b = StreamIterator(other.watch('SELECT count(*) AS c FROM foo'));
+      expect(await a.moveNext(), isTrue);
+      expect(await b.moveNext(), isTrue);
+
+      await other.execute("INSERT INTO foo VALUES ('a')");
+      for (final rows in [a, b]) {
+        expect(await rows.moveNext(), isTrue);
+        expect(rows.current, [
+          {'c': 1},
+        ]);
+      }
+
+      // Cancelling one watcher must not affect the other one.
+      await a.cancel();
+      await database.execute("INSERT INTO foo VALUES ('b')");
+      expect(await b.moveNext(), isTrue);
+      expect(b.current, [
+        {'c': 2},
+      ]);
+      await b.cancel();
+    });
+  });
+
+  group('query cache', () {
+    late RemoteDatabase database;
+
+    setUp(() async {
+      database = await requestDatabase(
+        'foo',
+        DatabaseImplementation.inMemoryShared,
+        queryCache: const QueryCacheOptions(maxEntries: 2),
+      );
+      await database.execute('CREATE TABLE foo (bar TEXT);');
+      await database.execute('CREATE TABLE other (bar TEXT);');
+
+      // Wait for the update notification so that it doesn't invalidate
+      // results cached by tests.
+      final updated = database.updates.first;
+      await database.execute("INSERT INTO foo VALUES ('a')");
+      await updated;
+    });
+
+    test('returns cached results', () async {
+      final first = await database.select('SELECT * FROM foo');
+      final second = await database.select('SELECT * FROM foo');
+      expect(second.result, first.result);
+      expect(database.queryCacheStatistics!.hits, 1);
+      expect(database.queryCacheStatistics!.misses, 1);
+
+      // Parameters of different types don't share a cache entry.
+      const sql = 'SELECT * FROM foo WHERE bar = ?';
+      await database.select(sql, parameters: [1]);
+      await database.select(sql, parameters: ['1']);
+      expect(database.queryCacheStatistics!.misses, 3);
+      expect(database.queryCacheStatistics!.evictions, 1);
+    });
+
+    test('invalidates results after writes', () async {
+      await database.select('SELECT * FROM foo');
+      await database.execute("INSERT INTO foo VALUES ('b')");
+      expect(database.queryCacheStatistics!.invalidations, 1);
+
+      // Writes are visible right away, without waiting for updates.
+      var result = await database.select('SELECT * FROM foo');
+      expect(result.result, hasLength(2));
+
+      await database.executeBatch([("INSERT INTO foo VALUES ('c')", [])]);
+      result = await database.select('SELECT * FROM foo');
+      expect(result.result, hasLength(3));
+
+      final statement = await database.prepare("INSERT INTO foo VALUES ('d')");
+      await statement.execute();
+      await statement.dispose();
+      result = await database.select('SELECT * FROM foo');
+      expect(result.result, hasLength(4));
+
+      expect(database.queryCacheStatistics!.hits, 0);
+    });
+
+    test('only evicts results reading from written tables', () async {
+      await database.select('SELECT * FROM foo');
+      await database.execute("INSERT INTO other VALUES ('a')");
+      await database.select('SELECT * FROM foo');
+      expect(database.queryCacheStatistics!.hits, 1);
+
+      // Schema changes evict all results.
+      await database.execute('CREATE TABLE third (bar TEXT)');
+      await database.select('SELECT * FROM foo');
+      expect(database.queryCacheStatistics!.hits, 1);
+    });
+
+    test('does not cache results that may change', () async {
+      for (final sql in [
+        'SELECT random()',
+        'SELECT bar, changes() FROM foo',
+        "SELECT datetime('now') FROM foo",
+        'SELECT * FROM sqlite_schema',
+        "INSERT INTO foo VALUES ('b') RETURNING *",
+      ]) {
+        await database.select(sql);
+        await database.select(sql);
+      }
+
+      expect(database.queryCacheStatistics!.hits, 0);
+      expect(database.queryCacheStatistics!.entries, 0);
+      final result = await database.select('SELECT count(*) AS c FROM foo');
+      expect(result.result, [
+        {'c': 3},
+      ]);
+    });
+
+    test('does not cache in transactions', () async {
+      await database.requestLock((token) async {
+        await database.execute('BEGIN', token: token);
+        await database.select('SELECT * FROM foo', token: token);
+        await database.execute('COMMIT', token: token);
+      });
+      await database.select('SELECT * FROM foo');
+
+      expect(database.queryCacheStatistics!.hits, 0);
+    });
+  });
+
+  group('cursors', () {
+    late RemoteDatabase database;
+
+    setUp(() async {
+      database = await requestDatabase(
+        'foo',
+        DatabaseImplementation.inMemoryShared,
+      );
+    });
+
+    test('stream rows in chunks', () async {
+      final rows = await database
+          .selectCursor(
+            'WITH RECURSIVE s(x) AS (VALUES(1) UNION ALL SELECT x+1 FROM s '
+            'WHERE x < ?) SELECT x, ? AS y FROM s',
+            parameters: [1000, 'a'],
+            chunkSize: 100,
+          )
+          .toList();
+
+      expect(rows, hasLength(1000));
+      expect(rows.first, {'x': 1, 'y': 'a'});
+      expect(rows.last, {'x': 1000, 'y': 'a'});
+    });
+
+    test('hold lock until cancelled', () async {
+      final stream = database.selectCursor(
+        'WITH RECURSIVE s(x) AS (VALUES(1) UNION ALL SELECT x+1 FROM s) '
+        'SELECT x FROM s',
+        chunkSize: 10,
+      );
+      final rows = await stream.take(25).toList();
+      expect(rows.last['x'], 25);
+
+      // The lock should have been released after cancelling the stream.
+      final result = await database.select('SELECT 1 AS r');
+      expect(result.result, [
+        {'r': 1},
+      ]);
+    });
+
+    test('can use existing lock', () async {
+      await database.requestLock((token) async {
+        final rows = await database
+            .selectCursor('SELECT 1 AS r', token: token)
+            .toList();
+        expect(rows, [
+          {'r': 1},
+        ]);
+
+        await database.execute('SELECT 1', token: token);
+      });
+    });
+  });
+
   group('locks', () {
     late RemoteDatabase a, b;
 
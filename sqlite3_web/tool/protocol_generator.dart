@@ -620,7 +620,8 @@ final class TypeScriptCodeGenerator extends BaseCodeGenerator {
       'JSArrayBuffer' => 'ArrayBuffer',
       'JSArray<JSString>' => 'string[]',
       'JSArray<JSString?>' => '(string | null)[]',
-      'JSArray<JSArray<JSAny?>>' => 'unknown[][]',
+      'JSArray<JSArray<JSAny?>>' || 'JSArray<JSArray>' => 'unknown[][]',
+      'JSArray<RowsResponse>' => 'RowsResponse[]',
       'JSArray' => 'unknown[]',
       _ => 'unknown /* $dartTypeName */',
     };
@@ -58,10 +58,24 @@ hooks:
     sqlite3:
       source: test-sqlcipher
       directory: $outPath/
+''');
+      case 'source-uring':
+        final sourcePath = p.relative(
+          'sqlite-src/sqlite3/sqlite3.c',
+          from: p.dirname(path),
+        );
+
+        out.write('''
+hooks:
+  user_defines:
+    sqlite3:
+      source: source
+      path: $sourcePath
+      uring_vfs: true
 ''');
       default:
         throw 'Unsupported mode, can use system, system-os-specific, '
-            'compiled, compiled-ciphers';
+            'compiled, compiled-ciphers, compiled-sqlcipher, source-uring';
     }
 
     await out.flush();